@@ -94,7 +94,9 @@ typedef struct
 // lookup table is hugely easier than writing code to do the same
 //
 
-#define LOOKUP_TABLE 1
+#ifndef LOOKUP_TABLE
+    #define LOOKUP_TABLE 1
+#endif
 
 #if LOOKUP_TABLE
 static const t_gain_table gain_table[] =
@@ -20,6 +20,8 @@
 //  #include "ARMCM0.h"
 //#endif
 
+#include <stddef.h>
+
 #include "app/aircopy.h"
 #include "audio.h"
 #include "driver/bk4819.h"
@@ -28,6 +30,7 @@
 #include "frequencies.h"
 #include "misc.h"
 #include "radio.h"
+#include "settings.h"
 #include "ui/helper.h"
 #include "ui/inputbox.h"
 #include "ui/ui.h"
@@ -134,7 +137,12 @@ void AIRCOPY_StorePacket(void)
 
     const uint16_t *pData = &g_FSK_Buffer[2];
     for (unsigned int i = 0; i < 8; i++) {
+        uint32_t Address;
+        uint16_t Size;
+
         EEPROM_WriteBuffer(Offset, pData);
+        EEPROM_Translate(Offset, 8, &Address, &Size, NULL);
+        SETTINGS_UpdateChannelIndex(Address, Size);
         pData += 4;
         Offset += 8;
     }
@@ -44,6 +44,9 @@
 #include "py32f0xx.h"
 #include "audio.h"
 #include "board.h"
+#ifdef ENABLE_CHANNEL_DB
+    #include "chdb.h"
+#endif
 #ifdef ENABLE_FEAT_F4HWN_SLEEP
     // #include "bsp/dp32g030/pwmplus.h"
 #endif
@@ -54,6 +57,7 @@
 #include "driver/bk4819.h"
 #include "driver/gpio.h"
 #include "driver/keyboard.h"
+#include "driver/py25q16.h"
 #include "driver/st7565.h"
 #include "driver/system.h"
 #include "dtmf.h"
@@ -61,7 +65,9 @@
 #include "frequencies.h"
 #include "functions.h"
 #include "helper/battery.h"
+#include "memstats.h"
 #include "misc.h"
+#include "profile.h"
 #include "radio.h"
 #include "settings.h"
 
@@ -653,7 +659,9 @@ static void DualwatchAlternate(void)
 
 static void CheckRadioInterrupts(void)
 {
-    while (BK4819_ReadRegister(BK4819_REG_0C) & 1u) { // BK chip interrupt request
+    PROFILE_ENTER(PROFILE_RADIO_INTERRUPTS);
+
+    while (BK4819_IsInterruptPending()) { // BK chip interrupt request
         // clear interrupts
         BK4819_WriteRegister(BK4819_REG_02, 0);
         // fetch interrupt status bits
@@ -809,6 +817,8 @@ static void CheckRadioInterrupts(void)
             }
         }
     }
+
+    PROFILE_EXIT(PROFILE_RADIO_INTERRUPTS);
 }
 
 void APP_EndTransmission(void)
@@ -900,6 +910,13 @@ static void HandleVox(void)
 
 void APP_Update(void)
 {
+#ifdef ENABLE_BK4819_IRQ_EXTI
+    // The line is a pin read, so serve requests on every pass instead of
+    // waiting for the next 10 ms slice
+    if (!gReducedService && (gCurrentFunction != FUNCTION_POWER_SAVE || !gRxIdleMode))
+        CheckRadioInterrupts();
+#endif
+
 #ifdef ENABLE_VOICE
     if (gFlagPlayQueuedVoice) {
             AUDIO_PlayQueuedVoice();
@@ -908,11 +925,19 @@ void APP_Update(void)
 #endif
 
 #ifdef ENABLE_USB
-    if (UART_IsCommandAvailable(UART_PORT_VCP)) {
-        // SCHEDULER_Disable();
-        UART_HandleCommand(UART_PORT_VCP);
-        // SCHEDULER_Enable();
-    }
+    #ifdef ENABLE_UART_BULK
+        UART_SendBulk(UART_PORT_VCP);
+    #endif
+    #ifdef ENABLE_UART_PIPELINE
+        for (unsigned int i = 0; i < UART_COMMANDS_PER_PASS && UART_IsCommandAvailable(UART_PORT_VCP); i++)
+            UART_HandleCommand(UART_PORT_VCP);
+    #else
+        if (UART_IsCommandAvailable(UART_PORT_VCP)) {
+            // SCHEDULER_Disable();
+            UART_HandleCommand(UART_PORT_VCP);
+            // SCHEDULER_Enable();
+        }
+    #endif
 #endif
 
 #ifdef ENABLE_FEAT_F4HWN
@@ -1381,11 +1406,23 @@ void APP_TimeSlice10ms(void)
 #endif
 
 #ifdef ENABLE_UART
-    if (UART_IsCommandAvailable(UART_PORT_UART)) {
-        // SCHEDULER_Disable();
-        UART_HandleCommand(UART_PORT_UART);
-        // SCHEDULER_Enable();
-    }
+    #ifdef ENABLE_UART_BULK
+        UART_SendBulk(UART_PORT_UART);
+    #endif
+    #ifdef ENABLE_UART_PIPELINE
+        for (unsigned int i = 0; i < UART_COMMANDS_PER_PASS && UART_IsCommandAvailable(UART_PORT_UART); i++)
+            UART_HandleCommand(UART_PORT_UART);
+    #else
+        if (UART_IsCommandAvailable(UART_PORT_UART)) {
+            // SCHEDULER_Disable();
+            UART_HandleCommand(UART_PORT_UART);
+            // SCHEDULER_Enable();
+        }
+    #endif
+#endif
+
+#ifdef ENABLE_FLASH_WRITE_BACK
+    PY25Q16_TimeSlice10ms();
 #endif
 
     if (gReducedService)
@@ -1553,6 +1590,27 @@ void APP_TimeSlice500ms(void)
 
     // Skipped authentic device check
 
+#ifdef ENABLE_MEMORY_STATS
+    MEMSTATS_Update();
+#endif
+
+#if defined(ENABLE_FLASH_WRITE_BACK) || defined(ENABLE_BOOT_SNAPSHOT)
+    PY25Q16_TimeSlice500ms();
+#endif
+
+#ifdef ENABLE_FLASH_COMMIT
+    if (gCurrentFunction == FUNCTION_FOREGROUND || gCurrentFunction == FUNCTION_POWER_SAVE)
+        PY25Q16_EraseSpares();
+#endif
+
+#ifdef ENABLE_CHANNEL_DB
+    CHDB_TimeSlice500ms();
+#endif
+
+#if defined(ENABLE_UART) && defined(ENABLE_UART_HIGH_SPEED)
+    UART_TimeSlice500ms();
+#endif
+
     if (gKeypadLocked > 0)
         if (--gKeypadLocked == 0)
             gUpdateDisplay = true;
@@ -1648,6 +1706,10 @@ void APP_TimeSlice500ms(void)
             // PWM_PLUS0_CH0_COMP = 0;
             BACKLIGHT_SetBrightness(0);
             ST7565_ShutDown();
+            #ifdef ENABLE_FLASH_WRITE_BACK
+                // Switched off, the user may pull the battery now
+                PY25Q16_Flush();
+            #endif
         }
         else if(gSleepModeCountdown_500ms != 0 && gSleepModeCountdown_500ms < 21 && gSetting_set_off != 0)
         {
@@ -1681,6 +1743,9 @@ void APP_TimeSlice500ms(void)
 
         if (gBatteryCurrent > 500 || gBatteryCalibration[3] < gBatteryCurrentVoltage)
         {
+            #ifdef ENABLE_FLASH_WRITE_BACK
+                PY25Q16_Flush();
+            #endif
             #ifdef ENABLE_OVERLAY
                 overlay_FLASH_RebootToBootloader();
             #else
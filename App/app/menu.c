@@ -30,6 +30,7 @@
 #include "driver/eeprom.h"
 #include "driver/gpio.h"
 #include "driver/keyboard.h"
+#include "driver/py25q16.h"
 #include "frequencies.h"
 #include "helper/battery.h"
 #include "misc.h"
@@ -1759,6 +1760,10 @@ static void MENU_Key_MENU(const bool bKeyPressed, const bool bKeyHeld)
 
                         MENU_AcceptSetting();
 
+                        #ifdef ENABLE_FLASH_WRITE_BACK
+                            PY25Q16_Flush();
+                        #endif
+
                         #if defined(ENABLE_OVERLAY)
                             overlay_FLASH_RebootToBootloader();
                         #else
@@ -2037,6 +2042,9 @@ void MENU_ProcessKeys(KEY_Code_t Key, bool bKeyPressed, bool bKeyHeld)
             #ifdef ENABLE_F_CAL_MENU
                 UI_MENU_GetCurrentMenuId() == MENU_F_CALI ||
             #endif
+            #ifdef ENABLE_MEMORY_STATS
+                UI_MENU_GetCurrentMenuId() == MENU_MEM_INF ||
+            #endif
             UI_MENU_GetCurrentMenuId() == MENU_BATCAL)
         {
             gMenuCountdown = menu_timeout_long_500ms;
@@ -17,6 +17,7 @@
 #include "am_fix.h"
 #include "audio.h"
 #include "misc.h"
+#include "profile.h"
 
 #ifdef ENABLE_SCAN_RANGES
 #include "chFrScanner.h"
@@ -33,6 +34,9 @@
 
 #ifdef ENABLE_FEAT_F4HWN_SPECTRUM
 #include "driver/py25q16.h"
+#ifdef ENABLE_CHANNEL_DB
+#include "chdb.h"
+#endif
 #endif
 
 struct FrequencyBandInfo
@@ -377,7 +381,7 @@ static void ResetPeak()
     {
       uint16_t interrupt_status_bits;
       // if interrupt waiting to be handled
-      if(BK4819_ReadRegister(BK4819_REG_0C) & 1u) {
+      if(BK4819_IsInterruptPending()) {
         // reset the interrupt
         BK4819_WriteRegister(BK4819_REG_02, 0);
         // fetch the interrupt status bits
@@ -1042,19 +1046,19 @@ static void ShowChannelName(uint32_t f)
     {
         if (f != channelF) {
             channelF = f;
-            unsigned int i;
             memset(channelName, 0, sizeof(channelName));
-            for (i = 0; IS_MR_CHANNEL(i); i++)
+            const int channel = SETTINGS_FindChannel(channelF);
+            if (channel >= 0)
+                SETTINGS_FetchChannelName(channelName, channel);
+#ifdef ENABLE_CHANNEL_DB
+            else
             {
-                if (RADIO_CheckValidChannel(i, false, 0))
-                {
-                    if (SETTINGS_FetchChannelFrequency(i) == channelF)
-                    {
-                        SETTINGS_FetchChannelName(channelName, i);
-                        break;
-                    }
-                }
+                // the other banks, left out while their index waits for a rebuild
+                uint16_t id;
+                if (CHDB_FindFrequency(channelF, channelF, &id, 1))
+                    CHDB_FetchName(channelName, id);
             }
+#endif
         }
         if (channelName[0] != 0) {
             UI_PrintStringSmallBufferNormal(channelName, gStatusLine + 36);
@@ -1839,6 +1843,8 @@ void APP_RunSpectrum()
 
     while (isInitialized)
     {
+        PROFILE_ENTER(PROFILE_SPECTRUM_TICK);
         Tick();
+        PROFILE_EXIT(PROFILE_SPECTRUM_TICK);
     }
 }
\ No newline at end of file
@@ -15,6 +15,7 @@
  *     limitations under the License.
  */
 
+#include <assert.h>
 #include <string.h>
 
 #if !defined(ENABLE_OVERLAY)
@@ -25,12 +26,19 @@
 #endif
 #include "app/uart.h"
 #include "board.h"
+#ifdef ENABLE_CHANNEL_DB
+    #include "chdb.h"
+#endif
 #include "py32f071_ll_dma.h"
 #include "driver/backlight.h"
 #include "driver/bk4819.h"
 #include "driver/crc.h"
 #include "driver/eeprom.h"
 #include "driver/gpio.h"
+#ifdef ENABLE_UART_DELTA
+    #include "driver/lz.h"
+#endif
+#include "driver/py25q16.h"
 
 #if defined(ENABLE_UART)
 #include "driver/uart.h"
@@ -41,7 +49,9 @@
 #endif
 
 #include "functions.h"
+#include "memstats.h"
 #include "misc.h"
+#include "profile.h"
 #include "settings.h"
 #include "version.h"
 
@@ -142,6 +152,48 @@ typedef struct {
     Header_t Header;
     uint32_t Response[4];
 } CMD_052D_t;
+
+#ifdef ENABLE_PROFILER
+typedef struct {
+    Header_t Header;
+    bool     bReset;
+    uint8_t  Padding[3];
+} CMD_052B_t;
+
+typedef struct {
+    Header_t Header;
+    struct {
+        PROFILE_Stats_t Probes[PROFILE_COUNT];
+    } Data;
+} REPLY_052B_t;
+
+static_assert(sizeof(REPLY_052B_t) <= MAX_REPLY_SIZE);
+
+typedef struct {
+    Header_t Header;
+    bool     bReset;
+    uint8_t  Padding[3];
+} CMD_0531_t;
+
+typedef struct {
+    Header_t         Header;
+    PROFILE_Jitter_t Data;
+} REPLY_0531_t;
+#endif
+
+#ifdef ENABLE_MEMORY_STATS
+typedef struct {
+    Header_t   Header;
+    MEMSTATS_t Data;
+} REPLY_0533_t;
+#endif
+
+#if defined(ENABLE_UART) && defined(ENABLE_UART_TX_DMA)
+typedef struct {
+    Header_t       Header;
+    UART_TxStats_t Data;
+} REPLY_0535_t;
+#endif
 #endif
 
 typedef struct {
@@ -160,6 +212,160 @@ typedef struct {
 } CMD_052F_t;
 #endif
 
+#if defined(ENABLE_UART) && defined(ENABLE_UART_HIGH_SPEED)
+typedef struct {
+    Header_t Header;
+    uint32_t BaudRate;
+} CMD_0537_t;
+
+typedef struct {
+    Header_t Header;
+    struct {
+        uint32_t BaudRate;  // the rate from now on
+        bool     bAccepted;
+        uint8_t  Padding[3];
+    } Data;
+} REPLY_0537_t;
+#endif
+
+#ifdef ENABLE_UART_BULK
+// Whole flash sectors of the EEPROM emulation, in one frame each way
+#define BULK_SECTOR_SIZE 0x1000
+#define BULK_END         0x011000
+
+typedef struct {
+    Header_t Header;
+    uint32_t Timestamp;
+    uint32_t Address;   // of the first sector
+    uint16_t Count;     // sectors, 0 stops a read going on
+    uint8_t  Padding[2];
+} CMD_0539_t;
+
+typedef struct {
+    Header_t Header;
+    uint32_t Address;
+    // BULK_SECTOR_SIZE bytes follow, none if the read is refused
+} REPLY_0539_t;
+
+typedef struct {
+    Header_t Header;
+    uint32_t Timestamp;
+    uint32_t Address;   // of Data[0], a sector is written from its start on, in order
+    uint8_t  Data[0];
+} CMD_053B_t;
+
+typedef struct {
+    Header_t Header;
+    struct {
+        uint32_t Address;   // where the next chunk is expected
+        bool     bAccepted;
+        uint8_t  Padding[3];
+    } Data;
+} REPLY_053B_t;
+
+typedef struct {
+    uint32_t     Address;   // sector being sent
+    uint16_t     Count;     // sectors left, that one included
+    uint16_t     Size;      // of its frame
+    uint16_t     Offset;    // bytes of the sector read so far
+    uint16_t     Position;  // bytes of the frame payload sent, 0 before the header
+    uint16_t     Crc;       // of the payload sent
+#ifdef ENABLE_UART_DELTA
+    bool         bPacked;   // LZ encoded, for 0x0543
+    LZ_Encoder_t Encoder;
+#endif
+} BulkRead_t;
+#endif
+
+#ifdef ENABLE_UART_DELTA
+#if !defined(ENABLE_UART_BULK)
+    #error ENABLE_UART_DELTA needs ENABLE_UART_BULK
+#endif
+// Sector hashes, for the host to move only the sectors that differ, and
+// the bulk commands again with the data LZ encoded (driver/lz.h):
+// 0x053F is laid out as 0x0539, 0x0543 and its replies 0x0544 as 0x0539
+// and 0x053A, 0x0541 and 0x0542 as 0x053B and 0x053C. The Address of a
+// 0x0541 counts decoded bytes, its tokens do not run on into the next one.
+#define HASH_COUNT (BULK_END / BULK_SECTOR_SIZE)
+
+typedef struct {
+    Header_t Header;
+    uint32_t Address;
+    uint32_t Hash[HASH_COUNT];  // FNV-1a of each sector asked for, none if refused
+} REPLY_053F_t;
+
+static_assert(sizeof(REPLY_053F_t) <= MAX_REPLY_SIZE);
+#endif
+
+#ifdef ENABLE_CHANNEL_DB
+// Records of the channel database (chdb.h), CHDB_PAGE of them per frame
+// each way, and its lookups
+#define CHDB_PAGE 4
+
+typedef struct {
+    Header_t Header;
+    uint32_t Timestamp;
+    uint16_t Id;        // of the first record
+    uint16_t Count;     // CHDB_PAGE at most
+} CMD_0545_t;
+
+typedef struct {
+    Header_t      Header;
+    uint16_t      Id;
+    uint16_t      Count;    // records that follow, none if refused
+    CHDB_Record_t Records[CHDB_PAGE];
+} REPLY_0545_t;
+
+typedef struct {
+    Header_t      Header;
+    uint32_t      Timestamp;
+    uint16_t      Id;
+    uint16_t      Count;
+    CHDB_Record_t Records[CHDB_PAGE];   // one not used deletes the channel
+} CMD_0547_t;
+
+typedef struct {
+    Header_t Header;
+    struct {
+        uint16_t Id;
+        uint16_t Count;     // records written, those of bank 0 are refused
+    } Data;
+} REPLY_0547_t;
+
+typedef struct {
+    Header_t Header;
+    uint32_t Timestamp;
+    uint32_t Lower;         // RX frequency range, 10 Hz
+    uint32_t Upper;
+    char     Prefix[12];    // names starting with it instead, if not empty
+} CMD_0549_t;
+
+typedef struct {
+    Header_t Header;
+    uint16_t Count;
+    uint16_t Ids[CHDB_FIND_MAX];
+} REPLY_0549_t;
+
+static_assert(sizeof(REPLY_0545_t) <= MAX_REPLY_SIZE);
+static_assert(sizeof(CMD_0547_t) <= 256 - 4);
+static_assert(sizeof(REPLY_0549_t) <= MAX_REPLY_SIZE);
+#endif
+
+#ifdef ENABLE_UART_PIPELINE
+// A command wrapped with a sequence number, the whole frame of it follows.
+// The reply to it comes wrapped the same way (0x053E) with the number
+// echoed, so the host can keep several commands in flight and match the
+// replies whatever their order. Bulk sector frames are not wrapped, they
+// carry their address.
+#define NO_SEQUENCE 0x10000
+
+typedef struct {
+    Header_t Header;
+    uint16_t Sequence;
+    uint8_t  Padding[2];
+} Sequenced_t;
+#endif
+
 static const uint8_t Obfuscation[16] =
 {
     0x16, 0x6C, 0x14, 0xE6, 0x2E, 0x91, 0x0D, 0x40, 0x21, 0x35, 0xD5, 0x40, 0x13, 0x03, 0xE9, 0x80
@@ -181,19 +387,70 @@ typedef union
     static UART_Command_t UART_Command;
     static uint16_t gUART_WriteIndex;
 #endif
+#if defined(ENABLE_UART) && defined(ENABLE_UART_HIGH_SPEED)
+    // Above UART_BAUD_RATE the link falls back to it unless a valid frame
+    // arrives at least every HIGH_SPEED_TIMEOUT_500MS
+    #define HIGH_SPEED_TIMEOUT_500MS 6
+    static uint32_t UART_BaudRate = UART_BAUD_RATE;
+    static uint8_t  UART_HighSpeedCountdown_500ms;
+#endif
 #if defined(ENABLE_USB)
     static uint32_t VCP_Timestamp;
     static UART_Command_t VCP_Command;
     static uint16_t VCP_ReadIndex;
 #endif
+#if defined(ENABLE_UART) && defined(ENABLE_UART_BULK)
+    static BulkRead_t UART_BulkRead;
+#endif
+#if defined(ENABLE_USB) && defined(ENABLE_UART_BULK)
+    static BulkRead_t VCP_BulkRead;
+#endif
+#ifdef ENABLE_UART_BULK
+    static uint32_t BulkWriteAddress = 0xFFFFFFFF; // next byte of the sector being written
+#endif
+#ifdef ENABLE_UART_DELTA
+    static LZ_Decoder_t BulkDecoder;
+#endif
+#ifdef ENABLE_UART_PIPELINE
+    static uint32_t ReplySequence = NO_SEQUENCE; // of the command being handled
+#endif
 
 // static bool     bIsEncrypted = true;
 #define bIsEncrypted true
 
+static void Obfuscate(uint8_t *pBytes, uint32_t Position, uint32_t Size)
+{
+    for (unsigned int i = 0; i < Size; i++)
+        pBytes[i] ^= Obfuscation[(Position + i) % 16];
+}
+
+#ifdef ENABLE_UART_PIPELINE
+// Fills in the wrapper that goes before a reply of Size bytes, if the
+// command was sequenced. Returns the size of it.
+static uint16_t WrapReply(Sequenced_t *pWrap, uint16_t Size)
+{
+    if (NO_SEQUENCE == ReplySequence)
+    {
+        return 0;
+    }
+
+    pWrap->Header.ID   = 0x053E;
+    pWrap->Header.Size = sizeof(Sequenced_t) - sizeof(Header_t) + Size;
+    pWrap->Sequence    = ReplySequence;
+    pWrap->Padding[0]  = 0;
+    pWrap->Padding[1]  = 0;
+    return sizeof(Sequenced_t);
+}
+#endif
+
 #ifdef ENABLE_USB
 static void SendReply_VCP(void *pReply, uint16_t Size)
 {
+#ifdef ENABLE_UART_PIPELINE
+    static uint8_t VCP_ReplyBuf[MAX_REPLY_SIZE + sizeof(Header_t) + sizeof(Sequenced_t) + sizeof(Footer_t)];
+#else
     static uint8_t VCP_ReplyBuf[MAX_REPLY_SIZE + sizeof(Header_t) + sizeof(Footer_t)];
+#endif
 
     // !!
     if (Size > MAX_REPLY_SIZE)
@@ -201,7 +458,13 @@ static void SendReply_VCP(void *pReply, uint16_t Size)
         return;
     }
 
+#ifdef ENABLE_UART_PIPELINE
+    const uint16_t WrapSize = WrapReply((Sequenced_t *)(VCP_ReplyBuf + sizeof(Header_t)), Size);
+    memcpy(VCP_ReplyBuf + sizeof(Header_t) + WrapSize, pReply, Size);
+    Size += WrapSize;
+#else
     memcpy(VCP_ReplyBuf + sizeof(Header_t), pReply, Size);
+#endif
 
     Header_t *pHeader = (Header_t *)VCP_ReplyBuf;
     Footer_t *pFooter = (Footer_t *)(VCP_ReplyBuf + sizeof(Header_t) + Size);
@@ -209,10 +472,7 @@ static void SendReply_VCP(void *pReply, uint16_t Size)
 
     if (bIsEncrypted)
     {
-        uint8_t     *pBytes = (uint8_t *)pReply;
-        unsigned int i;
-        for (i = 0; i < Size; i++)
-            pBytes[i] ^= Obfuscation[i % 16];
+        Obfuscate(pReply, 0, Size);
     }
 
     pHeader->ID = 0xCDAB;
@@ -251,20 +511,31 @@ static void SendReply(uint32_t Port, void *pReply, uint16_t Size)
 
     Header_t Header;
     Footer_t Footer;
+    uint16_t WrapSize = 0;
 
+#ifdef ENABLE_UART_PIPELINE
+    Sequenced_t Wrap;
+    WrapSize = WrapReply(&Wrap, Size);
     if (bIsEncrypted)
     {
-        uint8_t     *pBytes = (uint8_t *)pReply;
-        unsigned int i;
-        for (i = 0; i < Size; i++)
-            pBytes[i] ^= Obfuscation[i % 16];
+        Obfuscate((uint8_t *)&Wrap, 0, WrapSize);
     }
+#endif
 
+    if (bIsEncrypted)
+    {
+        Obfuscate(pReply, WrapSize, Size);
+    }
+
+    Size += WrapSize;
     Header.ID = 0xCDAB;
     Header.Size = Size;
 
     UART_Send(&Header, sizeof(Header));
-    UART_Send(pReply, Size);
+#ifdef ENABLE_UART_PIPELINE
+    UART_Send(&Wrap, WrapSize);
+#endif
+    UART_Send(pReply, Size - WrapSize);
 
     if (bIsEncrypted)
     {
@@ -281,6 +552,177 @@ static void SendReply(uint32_t Port, void *pReply, uint16_t Size)
     UART_Send(&Footer, sizeof(Footer));
 }
 
+#ifdef ENABLE_UART_BULK
+static void SendRaw(uint32_t Port, const void *pData, uint16_t Size)
+{
+#if defined(ENABLE_USB)
+    if (Port == UART_PORT_VCP)
+    {
+        VCP_Send(pData, Size);
+        return;
+    }
+#endif
+#if defined(ENABLE_UART)
+    UART_Send(pData, Size);
+#endif
+}
+
+// A sector does not fit any reply buffer, it is read and sent in pieces of
+// BULK_PIECE bytes, as many per pass as the port takes without waiting.
+// Unlike the other replies the footer carries the CRC of the payload.
+#define BULK_PIECE 128
+#ifdef ENABLE_UART_DELTA
+    #define BULK_PIECE_MAX LZ_ENCODED_MAX(BULK_PIECE)
+#else
+    #define BULK_PIECE_MAX BULK_PIECE
+#endif
+
+static void SendFrameStart(uint32_t Port, uint16_t ID, uint32_t Address, uint16_t Size, uint16_t *pCrc)
+{
+    REPLY_0539_t Reply;
+    Header_t     Header;
+
+    Header.ID   = 0xCDAB;
+    Header.Size = Size;
+    SendRaw(Port, &Header, sizeof(Header));
+
+    Reply.Header.ID   = ID;
+    Reply.Header.Size = Size - sizeof(Header_t);
+    Reply.Address     = Address;
+    *pCrc = CRC_Calculate(&Reply, sizeof(Reply));
+    Obfuscate((uint8_t *)&Reply, 0, sizeof(Reply));
+    SendRaw(Port, &Reply, sizeof(Reply));
+}
+
+static void SendFrameEnd(uint32_t Port, uint16_t Size, uint16_t Crc)
+{
+    Footer_t Footer;
+
+    Footer.Padding[0] = Obfuscation[(Size + 0) % 16] ^ (Crc & 0xFF);
+    Footer.Padding[1] = Obfuscation[(Size + 1) % 16] ^ (Crc >> 8);
+    Footer.ID = 0xBADC;
+    SendRaw(Port, &Footer, sizeof(Footer));
+}
+
+// The frame of a refused read, with no data
+static void SendRefused(uint32_t Port, uint16_t ID, uint32_t Address)
+{
+    uint16_t Crc;
+
+    SendFrameStart(Port, ID, Address, sizeof(REPLY_0539_t), &Crc);
+    SendFrameEnd(Port, sizeof(REPLY_0539_t), Crc);
+}
+
+#ifdef ENABLE_UART_DELTA
+// The sector is read twice, the first time for the size of the frame,
+// which goes first
+static uint16_t PackedSize(uint32_t Address, uint8_t *pBuffer, uint8_t *pPacked)
+{
+    LZ_Encoder_t Encoder;
+    uint16_t     Size = 0;
+
+    LZ_EncodeStart(&Encoder);
+    for (uint32_t Offset = 0; Offset < BULK_SECTOR_SIZE; Offset += BULK_PIECE)
+    {
+        PY25Q16_ReadBuffer(Address + Offset, pBuffer, BULK_PIECE);
+        Size += LZ_Encode(&Encoder, pBuffer, BULK_PIECE, pPacked, Offset + BULK_PIECE == BULK_SECTOR_SIZE);
+    }
+
+    return Size;
+}
+#endif
+
+// Sends the next piece of the sector frame, returns its size
+static uint32_t SendPiece(uint32_t Port, BulkRead_t *pRead)
+{
+    uint8_t  Buffer[BULK_PIECE];
+#ifdef ENABLE_UART_DELTA
+    uint8_t  Packed[BULK_PIECE_MAX];
+#endif
+    uint8_t *pOut  = Buffer;
+    uint32_t Count = BULK_PIECE;
+
+    if (0 == pRead->Position)
+    {
+        uint16_t ID = 0x053A;
+
+        pRead->Size = sizeof(REPLY_0539_t) + BULK_SECTOR_SIZE;
+#ifdef ENABLE_UART_DELTA
+        if (pRead->bPacked)
+        {
+            ID = 0x0544;
+            pRead->Size = sizeof(REPLY_0539_t) + PackedSize(pRead->Address, Buffer, Packed);
+            LZ_EncodeStart(&pRead->Encoder);
+        }
+#endif
+        SendFrameStart(Port, ID, pRead->Address, pRead->Size, &pRead->Crc);
+        pRead->Offset   = 0;
+        pRead->Position = sizeof(REPLY_0539_t);
+        return sizeof(Header_t) + sizeof(REPLY_0539_t);
+    }
+
+    if (pRead->Offset == BULK_SECTOR_SIZE)
+    {
+        SendFrameEnd(Port, pRead->Size, pRead->Crc);
+        pRead->Position = 0;
+        pRead->Address += BULK_SECTOR_SIZE;
+        pRead->Count--;
+        return sizeof(Footer_t);
+    }
+
+    PY25Q16_ReadBuffer(pRead->Address + pRead->Offset, Buffer, BULK_PIECE);
+    pRead->Offset += BULK_PIECE;
+#ifdef ENABLE_UART_DELTA
+    if (pRead->bPacked)
+    {
+        Count = LZ_Encode(&pRead->Encoder, Buffer, BULK_PIECE, Packed, pRead->Offset == BULK_SECTOR_SIZE);
+        pOut  = Packed;
+    }
+#endif
+
+    pRead->Crc = CRC_Update(pRead->Crc, pOut, Count);
+    Obfuscate(pOut, pRead->Position, Count);
+    SendRaw(Port, pOut, Count);
+    pRead->Position += Count;
+    return Count;
+}
+
+// Bytes the port takes now without waiting
+static uint32_t BulkRoom(uint32_t Port)
+{
+#if defined(ENABLE_USB)
+    if (Port == UART_PORT_VCP)
+    {
+        // USB keeps up, the whole frame goes at once
+        return VCP_IsSendBusy() ? 0 : UINT32_MAX;
+    }
+#endif
+#if defined(ENABLE_UART) && defined(ENABLE_UART_TX_DMA)
+    return UART_TxRoom();
+#else
+    // UART_Send() waits on each byte, a piece per pass
+    return BULK_PIECE_MAX;
+#endif
+}
+
+#ifdef ENABLE_UART_DELTA
+static uint32_t HashSector(uint32_t Address)
+{
+    uint8_t  Buffer[128];
+    uint32_t Hash = 2166136261u;
+
+    for (uint32_t Offset = 0; Offset < BULK_SECTOR_SIZE; Offset += sizeof(Buffer))
+    {
+        PY25Q16_ReadBuffer(Address + Offset, Buffer, sizeof(Buffer));
+        for (unsigned int i = 0; i < sizeof(Buffer); i++)
+            Hash = (Hash ^ Buffer[i]) * 16777619u;
+    }
+
+    return Hash;
+}
+#endif
+#endif
+
 static void SendVersion(uint32_t Port)
 {
     REPLY_0514_t Reply;
@@ -466,6 +908,11 @@ static void CMD_051D(uint32_t Port, const uint8_t *pBuffer)
             if ((Offset < 0x0E98 || Offset >= 0x0EA0) || !bIsInLockScreen || pCmd->bAllowPassword)
             {    
                 EEPROM_WriteBuffer(Offset, &pCmd->Data[i * 8U]);
+
+                uint32_t Address;
+                uint16_t Size;
+                EEPROM_Translate(Offset, 8, &Address, &Size, NULL);
+                SETTINGS_UpdateChannelIndex(Address, Size);
             }
         }
 
@@ -505,6 +952,70 @@ static void CMD_0529(uint32_t Port)
     SendReply(Port, &Reply, sizeof(Reply));
 }
 
+#ifdef ENABLE_PROFILER
+// read the hot-path profiler table, optionally starting a new measurement
+static void CMD_052B(uint32_t Port, const uint8_t *pBuffer)
+{
+    const CMD_052B_t *pCmd = (const CMD_052B_t *)pBuffer;
+    REPLY_052B_t      Reply;
+
+    Reply.Header.ID   = 0x052C;
+    Reply.Header.Size = sizeof(Reply.Data);
+    memcpy(Reply.Data.Probes, gProfileStats, sizeof(Reply.Data.Probes));
+
+    if (pCmd->bReset)
+        PROFILE_Reset();
+
+    SendReply(Port, &Reply, sizeof(Reply));
+}
+
+// read the main loop timeslice jitter histogram
+static void CMD_0531(uint32_t Port, const uint8_t *pBuffer)
+{
+    const CMD_0531_t *pCmd = (const CMD_0531_t *)pBuffer;
+    REPLY_0531_t      Reply;
+
+    Reply.Header.ID   = 0x0532;
+    Reply.Header.Size = sizeof(Reply.Data);
+    Reply.Data        = gProfileJitter;
+
+    if (pCmd->bReset)
+        PROFILE_ResetJitter();
+
+    SendReply(Port, &Reply, sizeof(Reply));
+}
+#endif
+
+#ifdef ENABLE_MEMORY_STATS
+// read the RAM layout and the stack high-water mark
+static void CMD_0533(uint32_t Port)
+{
+    REPLY_0533_t Reply;
+
+    MEMSTATS_Update();
+
+    Reply.Header.ID   = 0x0534;
+    Reply.Header.Size = sizeof(Reply.Data);
+    Reply.Data        = gMemStats;
+
+    SendReply(Port, &Reply, sizeof(Reply));
+}
+#endif
+
+#if defined(ENABLE_UART) && defined(ENABLE_UART_TX_DMA)
+// read the transmit buffer counters
+static void CMD_0535(uint32_t Port)
+{
+    REPLY_0535_t Reply;
+
+    Reply.Header.ID   = 0x0536;
+    Reply.Header.Size = sizeof(Reply.Data);
+    Reply.Data        = gUART_TxStats;
+
+    SendReply(Port, &Reply, sizeof(Reply));
+}
+#endif
+
 #ifndef ENABLE_FEAT_F4HWN
 static void CMD_052D(uint32_t Port, const uint8_t *pBuffer)
 {
@@ -600,6 +1111,334 @@ static void CMD_052F(uint32_t Port, const uint8_t *pBuffer)
 }
 #endif
 
+#if defined(ENABLE_UART) && defined(ENABLE_UART_HIGH_SPEED)
+static bool IsSupportedBaudRate(uint32_t BaudRate)
+{
+    static const uint32_t Rates[] = {UART_BAUD_RATE, 115200, 230400, 460800, 921600};
+
+    for (unsigned int i = 0; i < ARRAY_SIZE(Rates); i++)
+        if (Rates[i] == BaudRate)
+            return true;
+
+    return false;
+}
+
+// switch the link to another baud rate once the reply to this is out
+static void CMD_0537(uint32_t Port, const uint8_t *pBuffer)
+{
+    const CMD_0537_t *pCmd = (const CMD_0537_t *)pBuffer;
+    REPLY_0537_t      Reply;
+
+    const bool bAccepted = Port == UART_PORT_UART && IsSupportedBaudRate(pCmd->BaudRate);
+
+    memset(&Reply, 0, sizeof(Reply));
+    Reply.Header.ID      = 0x0538;
+    Reply.Header.Size    = sizeof(Reply.Data);
+    Reply.Data.BaudRate  = bAccepted ? pCmd->BaudRate : UART_BaudRate;
+    Reply.Data.bAccepted = bAccepted;
+
+    SendReply(Port, &Reply, sizeof(Reply));
+
+    if (!bAccepted)
+        return;
+
+    if (pCmd->BaudRate != UART_BaudRate)
+    {
+        UART_SetBaudRate(pCmd->BaudRate);
+        UART_BaudRate = pCmd->BaudRate;
+    }
+
+    UART_HighSpeedCountdown_500ms = UART_BaudRate == UART_BAUD_RATE ? 0 : HIGH_SPEED_TIMEOUT_500MS;
+}
+
+void UART_TimeSlice500ms(void)
+{
+    if (UART_HighSpeedCountdown_500ms == 0 || --UART_HighSpeedCountdown_500ms != 0)
+        return;
+
+    UART_SetBaudRate(UART_BAUD_RATE);
+    UART_BaudRate = UART_BAUD_RATE;
+}
+#endif
+
+#if defined(ENABLE_UART_BULK) || defined(ENABLE_CHANNEL_DB)
+static bool IsSession(uint32_t Port, uint32_t Timestamp)
+{
+#if defined(ENABLE_UART)
+    if (Port == UART_PORT_UART)
+        return Timestamp == UART_Timestamp;
+#endif
+#if defined(ENABLE_USB)
+    if (Port == UART_PORT_VCP)
+        return Timestamp == VCP_Timestamp;
+#endif
+    return false;
+}
+#endif
+
+#ifdef ENABLE_UART_BULK
+static BulkRead_t *GetBulkRead(uint32_t Port)
+{
+#if defined(ENABLE_UART)
+    if (Port == UART_PORT_UART)
+        return &UART_BulkRead;
+#endif
+#if defined(ENABLE_USB)
+    if (Port == UART_PORT_VCP)
+        return &VCP_BulkRead;
+#endif
+    return NULL;
+}
+
+// read flash sectors, one reply frame per sector sent by UART_SendBulk(),
+// also 0x0543 for them LZ encoded
+static void CMD_0539(uint32_t Port, const uint8_t *pBuffer)
+{
+    const CMD_0539_t *pCmd  = (const CMD_0539_t *)pBuffer;
+    BulkRead_t       *pRead = GetBulkRead(Port);
+
+    if (!pRead || !IsSession(Port, pCmd->Timestamp))
+        return;
+
+    gSerialConfigCountDown_500ms = 12; // 6 sec
+
+    #ifdef ENABLE_FMRADIO
+        gFmRadioCountdown_500ms = fm_radio_countdown_500ms;
+    #endif
+
+    pRead->Count    = 0;
+    pRead->Position = 0;
+#ifdef ENABLE_UART_DELTA
+    pRead->bPacked = pCmd->Header.ID == 0x0543;
+#endif
+
+    if ((bHasCustomAesKey && gIsLocked) || (pCmd->Address % BULK_SECTOR_SIZE) != 0 ||
+        pCmd->Address >= BULK_END || pCmd->Count > (BULK_END - pCmd->Address) / BULK_SECTOR_SIZE)
+    {
+        SendRefused(Port, pCmd->Header.ID + 1, pCmd->Address);
+        return;
+    }
+
+    pRead->Address = pCmd->Address;
+    pRead->Count   = pCmd->Count;
+}
+
+void UART_SendBulk(uint32_t Port)
+{
+    BulkRead_t *pRead = GetBulkRead(Port);
+
+    if (!pRead || !pRead->Count)
+        return;
+
+    gSerialConfigCountDown_500ms = 12; // 6 sec
+
+    // Never more than one frame, the port gets a chance to take commands
+    // between them
+    uint32_t Room = BulkRoom(Port);
+    while (pRead->Count && Room >= BULK_PIECE_MAX)
+    {
+        Room -= SendPiece(Port, pRead);
+        if (0 == pRead->Position)
+            break;
+    }
+}
+
+// write flash sectors, each erased once and programmed once as its chunks come,
+// also 0x0541 for them LZ encoded
+static void CMD_053B(uint32_t Port, const uint8_t *pBuffer)
+{
+    const CMD_053B_t *pCmd = (const CMD_053B_t *)pBuffer;
+    REPLY_053B_t      Reply;
+#ifdef ENABLE_UART_DELTA
+    const bool        bPacked = pCmd->Header.ID == 0x0541;
+#else
+    const bool        bPacked = false;
+#endif
+
+    if (!IsSession(Port, pCmd->Timestamp))
+        return;
+
+    gSerialConfigCountDown_500ms = 12; // 6 sec
+
+    #ifdef ENABLE_FMRADIO
+        gFmRadioCountdown_500ms = fm_radio_countdown_500ms;
+    #endif
+
+    const uint32_t Address = pCmd->Address;
+    const uint32_t Size    = pCmd->Header.Size > 8 ? pCmd->Header.Size - 8u : 0;
+    bool           bAccepted = !(bHasCustomAesKey && gIsLocked) && Size && Address < BULK_END;
+
+    if (bAccepted && (Address % BULK_SECTOR_SIZE) == 0)
+    {
+        PY25Q16_BeginSector(Address);
+        BulkWriteAddress = Address;
+#ifdef ENABLE_UART_DELTA
+        LZ_DecodeStart(&BulkDecoder);
+#endif
+    }
+
+    bAccepted = bAccepted && Address == BulkWriteAddress &&
+                (bPacked || Size <= BULK_SECTOR_SIZE - (Address % BULK_SECTOR_SIZE));
+
+#ifdef ENABLE_UART_DELTA
+    if (bAccepted && bPacked)
+    {
+        // Broken tokens leave the sector half written, it has to start over
+        bAccepted = LZ_Decode(&BulkDecoder, pCmd->Data, Size, BULK_SECTOR_SIZE, PY25Q16_WriteSector);
+        BulkWriteAddress = bAccepted ? Address - (Address % BULK_SECTOR_SIZE) + BulkDecoder.Position : 0xFFFFFFFF;
+    }
+#endif
+    if (bAccepted && !bPacked)
+    {
+        PY25Q16_WriteSector(pCmd->Data, Size);
+        BulkWriteAddress += Size;
+    }
+
+    // The sector is in place with its last byte
+    if (bAccepted && (BulkWriteAddress % BULK_SECTOR_SIZE) == 0)
+        SETTINGS_UpdateChannelIndex(BulkWriteAddress - BULK_SECTOR_SIZE, BULK_SECTOR_SIZE);
+
+    memset(&Reply, 0, sizeof(Reply));
+    Reply.Header.ID      = bPacked ? 0x0542 : 0x053C;
+    Reply.Header.Size    = sizeof(Reply.Data);
+    Reply.Data.Address   = BulkWriteAddress;
+    Reply.Data.bAccepted = bAccepted;
+
+    SendReply(Port, &Reply, sizeof(Reply));
+}
+#endif
+
+#ifdef ENABLE_UART_DELTA
+// hash flash sectors, for the host to tell which ones to move
+static void CMD_053F(uint32_t Port, const uint8_t *pBuffer)
+{
+    const CMD_0539_t *pCmd = (const CMD_0539_t *)pBuffer;
+    REPLY_053F_t      Reply;
+    uint16_t          Count = pCmd->Count;
+
+    if (!IsSession(Port, pCmd->Timestamp))
+        return;
+
+    gSerialConfigCountDown_500ms = 12; // 6 sec
+
+    #ifdef ENABLE_FMRADIO
+        gFmRadioCountdown_500ms = fm_radio_countdown_500ms;
+    #endif
+
+    if ((bHasCustomAesKey && gIsLocked) || (pCmd->Address % BULK_SECTOR_SIZE) != 0 ||
+        pCmd->Address >= BULK_END || Count > (BULK_END - pCmd->Address) / BULK_SECTOR_SIZE)
+    {
+        Count = 0;
+    }
+
+    Reply.Header.ID   = 0x0540;
+    Reply.Header.Size = sizeof(Reply.Address) + Count * sizeof(Reply.Hash[0]);
+    Reply.Address     = pCmd->Address;
+    for (unsigned int i = 0; i < Count; i++)
+        Reply.Hash[i] = HashSector(pCmd->Address + i * BULK_SECTOR_SIZE);
+
+    SendReply(Port, &Reply, sizeof(Header_t) + Reply.Header.Size);
+}
+#endif
+
+#ifdef ENABLE_CHANNEL_DB
+// read channel database records
+static void CMD_0545(uint32_t Port, const uint8_t *pBuffer)
+{
+    const CMD_0545_t *pCmd = (const CMD_0545_t *)pBuffer;
+    REPLY_0545_t      Reply;
+    uint16_t          Count = pCmd->Count;
+
+    if (!IsSession(Port, pCmd->Timestamp))
+        return;
+
+    gSerialConfigCountDown_500ms = 12; // 6 sec
+
+    #ifdef ENABLE_FMRADIO
+        gFmRadioCountdown_500ms = fm_radio_countdown_500ms;
+    #endif
+
+    if ((bHasCustomAesKey && gIsLocked) || Count > CHDB_PAGE || pCmd->Id >= CHDB_COUNT ||
+        Count > CHDB_COUNT - pCmd->Id)
+    {
+        Count = 0;
+    }
+
+    CHDB_LoadPage(pCmd->Id, Reply.Records, Count);
+
+    Reply.Header.ID   = 0x0546;
+    Reply.Header.Size = 4 + Count * sizeof(CHDB_Record_t);
+    Reply.Id          = pCmd->Id;
+    Reply.Count       = Count;
+
+    SendReply(Port, &Reply, sizeof(Header_t) + Reply.Header.Size);
+}
+
+// write channel database records, banks 1 and up
+static void CMD_0547(uint32_t Port, const uint8_t *pBuffer)
+{
+    const CMD_0547_t *pCmd = (const CMD_0547_t *)pBuffer;
+    REPLY_0547_t      Reply;
+    uint16_t          Count = 0;
+
+    if (!IsSession(Port, pCmd->Timestamp))
+        return;
+
+    gSerialConfigCountDown_500ms = 12; // 6 sec
+
+    #ifdef ENABLE_FMRADIO
+        gFmRadioCountdown_500ms = fm_radio_countdown_500ms;
+    #endif
+
+    if (!(bHasCustomAesKey && gIsLocked) && pCmd->Count <= CHDB_PAGE &&
+        pCmd->Header.Size >= 8 + pCmd->Count * sizeof(CHDB_Record_t))
+    {
+        while (Count < pCmd->Count && CHDB_Write(pCmd->Id + Count, &pCmd->Records[Count]))
+            Count++;
+    }
+
+    memset(&Reply, 0, sizeof(Reply));
+    Reply.Header.ID   = 0x0548;
+    Reply.Header.Size = sizeof(Reply.Data);
+    Reply.Data.Id     = pCmd->Id;
+    Reply.Data.Count  = Count;
+
+    SendReply(Port, &Reply, sizeof(Reply));
+}
+
+// look channels up by frequency or name, in any bank
+static void CMD_0549(uint32_t Port, const uint8_t *pBuffer)
+{
+    const CMD_0549_t *pCmd = (const CMD_0549_t *)pBuffer;
+    REPLY_0549_t      Reply;
+    char              Prefix[sizeof(pCmd->Prefix)];
+
+    if (!IsSession(Port, pCmd->Timestamp))
+        return;
+
+    gSerialConfigCountDown_500ms = 12; // 6 sec
+
+    #ifdef ENABLE_FMRADIO
+        gFmRadioCountdown_500ms = fm_radio_countdown_500ms;
+    #endif
+
+    memcpy(Prefix, pCmd->Prefix, sizeof(Prefix));
+    Prefix[sizeof(Prefix) - 1] = 0;
+
+    Reply.Count = 0;
+    if (!(bHasCustomAesKey && gIsLocked))
+    {
+        Reply.Count = Prefix[0] ? CHDB_FindName(Prefix, Reply.Ids, CHDB_FIND_MAX)
+                                : CHDB_FindFrequency(pCmd->Lower, pCmd->Upper, Reply.Ids, CHDB_FIND_MAX);
+    }
+
+    Reply.Header.ID   = 0x054A;
+    Reply.Header.Size = 2 + Reply.Count * sizeof(Reply.Ids[0]);
+
+    SendReply(Port, &Reply, sizeof(Header_t) + Reply.Header.Size);
+}
+#endif
+
 #ifdef ENABLE_UART_RW_BK_REGS
 static void CMD_0601_ReadBK4819Reg(uint32_t Port, const uint8_t *pBuffer)
 {
@@ -651,6 +1490,13 @@ bool UART_IsCommandAvailable(uint32_t Port)
     uint16_t *pReadPointer;
     UART_Command_t *pUART_Command;
 
+#ifdef ENABLE_UART_BULK
+    // Nothing else may go out in the middle of a sector frame
+    const BulkRead_t *pRead = GetBulkRead(Port);
+    if (pRead && pRead->Position)
+        return false;
+#endif
+
     if(0){}
 #if defined(ENABLE_UART)
     else if (Port == UART_PORT_UART)
@@ -665,6 +1511,12 @@ bool UART_IsCommandAvailable(uint32_t Port)
 #if defined(ENABLE_USB)
     else if (Port == UART_PORT_VCP)
     {
+#ifdef ENABLE_UART_PIPELINE
+        // Commands come faster than one per pass now, the next one waits
+        // till the reply buffer is free again
+        if (VCP_IsSendBusy())
+            return false;
+#endif
         DmaLength = VCP_RxBufPointer;
         ReadBuf = VCP_RxBuf;
         ReadBufSize = sizeof(VCP_RxBuf);
@@ -785,6 +1637,30 @@ void UART_HandleCommand(uint32_t Port)
         return;
     }
 
+#if defined(ENABLE_UART) && defined(ENABLE_UART_HIGH_SPEED)
+    if (Port == UART_PORT_UART && UART_HighSpeedCountdown_500ms)
+        UART_HighSpeedCountdown_500ms = HIGH_SPEED_TIMEOUT_500MS;
+#endif
+
+#ifdef ENABLE_UART_PIPELINE
+    if (pUART_Command->Header.ID == 0x053D)
+    {
+        const Sequenced_t *pWrap = (const Sequenced_t *)pUART_Command->Buffer;
+        const uint16_t     Size  = pWrap->Header.Size + sizeof(Header_t) - sizeof(Sequenced_t);
+        const Header_t    *pInner = (const Header_t *)(pUART_Command->Buffer + sizeof(Sequenced_t));
+
+        if (pWrap->Header.Size < sizeof(Sequenced_t) ||
+            Size > sizeof(pUART_Command->Buffer) - sizeof(Sequenced_t) ||
+            Size != sizeof(Header_t) + pInner->Size)
+        {
+            return;
+        }
+
+        ReplySequence = pWrap->Sequence;
+        memmove(pUART_Command->Buffer, pInner, Size);
+    }
+#endif
+
     switch (pUART_Command->Header.ID)
     {
         case 0x0514:
@@ -814,6 +1690,28 @@ void UART_HandleCommand(uint32_t Port)
             CMD_0529(Port);
             break;
 
+        #ifdef ENABLE_PROFILER
+            case 0x052B:
+                CMD_052B(Port, pUART_Command->Buffer);
+                break;
+
+            case 0x0531:
+                CMD_0531(Port, pUART_Command->Buffer);
+                break;
+        #endif
+
+        #ifdef ENABLE_MEMORY_STATS
+            case 0x0533:
+                CMD_0533(Port);
+                break;
+        #endif
+
+        #if defined(ENABLE_UART) && defined(ENABLE_UART_TX_DMA)
+            case 0x0535:
+                CMD_0535(Port);
+                break;
+        #endif
+
         #ifndef ENABLE_FEAT_F4HWN
             case 0x052D:
                 CMD_052D(Port, pUART_Command->Buffer);
@@ -825,7 +1723,57 @@ void UART_HandleCommand(uint32_t Port)
             break;
 #endif
 
+#if defined(ENABLE_UART) && defined(ENABLE_UART_HIGH_SPEED)
+        case 0x0537:
+            CMD_0537(Port, pUART_Command->Buffer);
+            break;
+#endif
+
+#ifdef ENABLE_UART_BULK
+        case 0x0539:
+            CMD_0539(Port, pUART_Command->Buffer);
+            break;
+
+        case 0x053B:
+            CMD_053B(Port, pUART_Command->Buffer);
+            break;
+#endif
+
+#ifdef ENABLE_UART_DELTA
+        case 0x053F:
+            CMD_053F(Port, pUART_Command->Buffer);
+            break;
+
+        case 0x0541:
+            CMD_053B(Port, pUART_Command->Buffer);
+            break;
+
+        case 0x0543:
+            CMD_0539(Port, pUART_Command->Buffer);
+            break;
+#endif
+
+#ifdef ENABLE_CHANNEL_DB
+        case 0x0545:
+            CMD_0545(Port, pUART_Command->Buffer);
+            break;
+
+        case 0x0547:
+            CMD_0547(Port, pUART_Command->Buffer);
+            break;
+
+        case 0x0549:
+            CMD_0549(Port, pUART_Command->Buffer);
+            break;
+#endif
+
         case 0x05DD: // reset
+            #ifdef ENABLE_FLASH_WRITE_BACK
+                PY25Q16_Flush();
+            #endif
+            #if defined(ENABLE_UART) && defined(ENABLE_UART_TX_DMA)
+                UART_Flush();
+            #endif
             #if defined(ENABLE_OVERLAY)
                 overlay_FLASH_RebootToBootloader();
             #else
@@ -844,6 +1792,10 @@ void UART_HandleCommand(uint32_t Port)
 #endif
     } // switch
 
+#ifdef ENABLE_UART_PIPELINE
+    ReplySequence = NO_SEQUENCE;
+#endif
+
     #ifdef ENABLE_FEAT_F4HWN_SCREENSHOT
         gUART_LockScreenshot = 20; // lock screenshot
     #endif
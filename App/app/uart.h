@@ -33,5 +33,21 @@ enum
 bool UART_IsCommandAvailable(uint32_t Port);
 void UART_HandleCommand(uint32_t Port);
 
+#if defined(ENABLE_UART) && defined(ENABLE_UART_HIGH_SPEED)
+    // Falls back to UART_BAUD_RATE once the host has gone quiet
+    void UART_TimeSlice500ms(void);
+#endif
+
+#ifdef ENABLE_UART_BULK
+    // Sends what the port takes without waiting of the next sector of a
+    // bulk read, if one is going on
+    void UART_SendBulk(uint32_t Port);
+#endif
+
+#ifdef ENABLE_UART_PIPELINE
+    // Commands queued in a receive ring handled in one pass at most
+    #define UART_COMMANDS_PER_PASS 8
+#endif
+
 #endif
 
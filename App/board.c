@@ -25,6 +25,9 @@
 #include "py32f071_ll_gpio.h"
 #include "py32f071_ll_rcc.h"
 #include "py32f071_ll_adc.h"
+#ifdef ENABLE_BK4819_IRQ_EXTI
+    #include "py32f071_ll_exti.h"
+#endif
 #include "driver/voice.h"
 #include "driver/backlight.h"
 #ifdef ENABLE_FMRADIO
@@ -87,6 +90,20 @@ void BOARD_GPIO_Init(void)
     InitStruct.Pin = LL_GPIO_PIN_10;
     LL_GPIO_Init(GPIOB, &InitStruct);
 
+#ifdef ENABLE_BK4819_IRQ_EXTI
+    // BK4819 interrupt request: PB7, active high, not fitted on stock boards
+    InitStruct.Pin = GPIO_PIN_MASK(GPIO_PIN_BK4819_IRQ);
+    InitStruct.Pull = LL_GPIO_PULL_DOWN;
+    LL_GPIO_Init(GPIOB, &InitStruct);
+    InitStruct.Pull = LL_GPIO_PULL_UP;
+
+    LL_EXTI_SetEXTISource(LL_EXTI_CONFIG_PORTB, LL_EXTI_CONFIG_LINE7);
+    LL_EXTI_EnableRisingTrig(LL_EXTI_LINE_7);
+    LL_EXTI_ClearFlag(LL_EXTI_LINE_7);
+    LL_EXTI_EnableIT(LL_EXTI_LINE_7);
+    NVIC_EnableIRQ(EXTI4_15_IRQn);
+#endif
+
     // -----------------------
     //  Output pins
 
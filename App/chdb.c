@@ -0,0 +1,696 @@
+#include <assert.h>
+#include <string.h>
+
+#include "app/chFrScanner.h"
+#include "chdb.h"
+#include "driver/py25q16.h"
+#include "functions.h"
+#include "settings.h"
+
+// Flash layout, between the boot snapshot (0x016000) and the voice
+// prompts (0x14c000):
+//
+//   STORE_ADDR     banks 1 and up, one CHDB_Record_t per channel
+//   FREQ_ADDR      frequency index, entries sorted by key
+//   NAME_ADDR      name index, entries sorted by key
+//   SCRATCH_ADDR   unsorted entries while an index is rebuilt
+//   LOG_ADDR       entries added since the last rebuild, appended
+//   MARK_ADDR      log of index state marks, appended, the last one counts
+//
+// An index entry is a 6 byte key and an Id. The key of the frequency index
+// is the RX frequency big endian, that of the name index the first 6 chars
+// of the name in upper case. The indexes only hold the used channels of
+// banks 1 and up. Bank 0 is looked up in gMR_ChannelIndex, so the settings
+// code and CHIRP do not have to keep them up to date.
+//
+// Lookups are binary searches in the flash, 8 byte reads, and a pass over
+// the log. Each entry found is checked against its record, so an edit only
+// appends the entries of the new record to the log before writing it: the
+// entries of the old one no longer match. When the log is full the indexes
+// are marked dirty and rebuilt from the records once the edits stop, a bank
+// or a selection pass per 500 ms slice. Until then lookups leave banks 1 and
+// up out.
+
+#define SECTOR_SIZE         0x1000
+#define SECTORS(Size)       (((Size) + SECTOR_SIZE - 1) / SECTOR_SIZE * SECTOR_SIZE)
+
+#define KEY_SIZE            6
+
+typedef struct {
+    uint8_t  Key[KEY_SIZE];
+    uint16_t Id;
+} Entry_t;
+
+typedef struct {
+    uint8_t  State;
+    uint8_t  Layout;
+    uint16_t Reserved;
+    uint16_t FreqCount;
+    uint16_t NameCount;
+} Mark_t;
+
+#define MARK_DIRTY          0x5A
+#define MARK_CLEAN          0xA5
+#define MARK_LAYOUT         2
+#define MARK_SLOTS          (SECTOR_SIZE / sizeof(Mark_t))
+
+// Log entries of the name index have this bit set in their Id
+#define NAME_FLAG           0x8000
+
+// Every lookup reads the log, so it is kept short: some 64 edits
+#define LOG_SLOTS           128
+
+#define STORE_ADDR          0x020000
+#define STORE_SIZE          SECTORS((CHDB_COUNT - CHDB_BANK_SIZE) * sizeof(CHDB_Record_t))
+#define INDEX_SIZE          SECTORS((CHDB_COUNT - CHDB_BANK_SIZE) * sizeof(Entry_t))
+#define FREQ_ADDR           (STORE_ADDR + STORE_SIZE)
+#define NAME_ADDR           (FREQ_ADDR + INDEX_SIZE)
+#define SCRATCH_ADDR        (NAME_ADDR + INDEX_SIZE)
+#define LOG_ADDR            (SCRATCH_ADDR + INDEX_SIZE)
+#define MARK_ADDR           (LOG_ADDR + SECTOR_SIZE)
+
+// Entries per scratch or log read and per selection pass of a rebuild
+#define CHUNK               16
+#define SELECT              32
+
+#define REBUILD_IDLE_500MS  4
+
+typedef struct {
+    bool        bName;
+    uint8_t     Lower[KEY_SIZE];
+    uint8_t     Upper[KEY_SIZE];
+    const char *pPrefix;    // names are checked in full, the key only holds their start
+} Query_t;
+
+typedef struct {
+    Entry_t  Entries[CHDB_FIND_MAX];   // sorted
+    uint16_t Count;
+    uint16_t Max;
+} Found_t;
+
+static_assert(sizeof(CHDB_Record_t) == 32);
+static_assert(sizeof(Entry_t) == 8);
+static_assert(sizeof(Mark_t) == 8);
+static_assert(CHDB_COUNT < NAME_FLAG);
+static_assert(MARK_ADDR + SECTOR_SIZE <= 0x14c000);
+static_assert(SELECT * sizeof(Entry_t) <= SECTOR_SIZE);
+static_assert(LOG_SLOTS * sizeof(Entry_t) <= SECTOR_SIZE);
+
+static bool     Ready;      // the indexes and the log cover every record
+static uint8_t  Idle_500ms;
+static uint16_t NextMark;   // first blank slot
+static uint16_t NextLog;    // first blank slot
+static uint16_t FreqCount;
+static uint16_t NameCount;
+
+// A rebuild in progress, one step per 500 ms slice
+static struct {
+    bool     bName;     // the index being built
+    uint16_t Id;        // next record to collect
+    uint16_t Count;     // entries collected
+    uint16_t Out;       // entries sorted
+    Entry_t  Last;      // the largest one sorted
+} Job;
+
+static inline uint32_t RecordAddr(uint16_t Id)
+{
+    return STORE_ADDR + (Id - CHDB_BANK_SIZE) * sizeof(CHDB_Record_t);
+}
+
+static inline char ToUpper(char c)
+{
+    return (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+}
+
+static bool HasPrefix(const char *pName, const char *pPrefix)
+{
+    for (; *pPrefix; pName++, pPrefix++)
+        if (ToUpper(*pName) != ToUpper(*pPrefix))
+            return false;
+    return true;
+}
+
+static void FrequencyKey(uint32_t Frequency, uint8_t *pKey)
+{
+    pKey[0] = Frequency >> 24;
+    pKey[1] = Frequency >> 16;
+    pKey[2] = Frequency >> 8;
+    pKey[3] = Frequency;
+    pKey[4] = 0;
+    pKey[5] = 0;
+}
+
+static void NameKey(const char *pName, uint8_t *pKey)
+{
+    memset(pKey, 0, KEY_SIZE);
+    for (unsigned int i = 0; i < KEY_SIZE && pName[i]; i++)
+        pKey[i] = ToUpper(pName[i]);
+}
+
+static void RecordName(const CHDB_Record_t *pRecord, char *pName)
+{
+    memcpy(pName, pRecord->Name, sizeof(pRecord->Name));
+    SETTINGS_TrimChannelName(pName);
+}
+
+// The entry of a used record in one of the indexes, false if it has none
+static bool MakeEntry(bool bName, const CHDB_Record_t *pRecord, Entry_t *pEntry)
+{
+    if (!bName)
+    {
+        FrequencyKey(pRecord->Frequency, pEntry->Key);
+        return true;
+    }
+
+    char Name[11];
+    RecordName(pRecord, Name);
+    if (Name[0] == 0)
+        return false;
+
+    NameKey(Name, pEntry->Key);
+    return true;
+}
+
+static int Compare(const Entry_t *pA, const Entry_t *pB)
+{
+    const int Order = memcmp(pA->Key, pB->Key, KEY_SIZE);
+    if (Order)
+        return Order;
+    return (int)pA->Id - (int)pB->Id;
+}
+
+// Sorted insert into a list of Max entries at most, the largest drops out
+// when it is full
+static void Insert(Entry_t *pList, uint16_t *pCount, uint16_t Max, const Entry_t *pEntry)
+{
+    if (*pCount == Max && Compare(pEntry, &pList[Max - 1]) >= 0)
+        return;
+
+    unsigned int j = (*pCount < Max) ? (*pCount)++ : Max - 1u;
+    for (; j > 0 && Compare(pEntry, &pList[j - 1]) < 0; j--)
+        pList[j] = pList[j - 1];
+    pList[j] = *pEntry;
+}
+
+// Writes entries [Pos, Pos + Count) of a region, erasing each sector as the
+// first write reaches it
+static void WriteEntries(uint32_t Addr, uint16_t Pos, const Entry_t *pEntries, uint16_t Count)
+{
+    Addr += Pos * sizeof(Entry_t);
+
+    const uint32_t Start = SECTORS(Addr);
+    if (Start < Addr + Count * sizeof(Entry_t))
+        PY25Q16_SectorErase(Start);
+    PY25Q16_WriteBuffer(Addr, pEntries, Count * sizeof(Entry_t), false);
+}
+
+static void ReadEntry(uint32_t Addr, uint16_t Pos, Entry_t *pEntry)
+{
+    PY25Q16_ReadBuffer(Addr + Pos * sizeof(Entry_t), pEntry, sizeof(Entry_t));
+}
+
+// First position whose key is not below pKey
+static uint16_t LowerBound(uint32_t Addr, uint16_t Count, const uint8_t *pKey)
+{
+    uint16_t Lo = 0;
+    uint16_t Hi = Count;
+
+    while (Lo < Hi)
+    {
+        const uint16_t Mid = (Lo + Hi) / 2;
+        Entry_t Entry;
+        ReadEntry(Addr, Mid, &Entry);
+        if (memcmp(Entry.Key, pKey, KEY_SIZE) < 0)
+            Lo = Mid + 1;
+        else
+            Hi = Mid;
+    }
+
+    return Lo;
+}
+
+// Slots of 8 bytes are appended in order, the first blank one
+static uint16_t FirstBlank(uint32_t Addr, uint16_t Slots)
+{
+    uint16_t Lo = 0;
+    uint16_t Hi = Slots;
+
+    while (Lo < Hi)
+    {
+        const uint16_t Mid = (Lo + Hi) / 2;
+        uint8_t Slot[8];
+        bool    bBlank = true;
+
+        PY25Q16_ReadBuffer(Addr + Mid * sizeof(Slot), Slot, sizeof(Slot));
+        for (unsigned int i = 0; i < sizeof(Slot); i++)
+            bBlank = bBlank && Slot[i] == 0xFF;
+
+        if (bBlank)
+            Hi = Mid;
+        else
+            Lo = Mid + 1;
+    }
+
+    return Lo;
+}
+
+// The entries of the used channels of the next bank, in Id order, to the
+// scratch area
+static void CollectBank(void)
+{
+    Entry_t        Batch[CHUNK];
+    uint16_t       n = 0;
+    const uint16_t End = Job.Id + CHDB_BANK_SIZE;
+
+    for (; Job.Id < End; Job.Id += 4)
+    {
+        CHDB_Record_t Page[4];
+        CHDB_LoadPage(Job.Id, Page, 4);
+
+        for (unsigned int i = 0; i < 4; i++)
+        {
+            if (!CHDB_IsUsed(&Page[i]) || !MakeEntry(Job.bName, &Page[i], &Batch[n]))
+                continue;
+
+            Batch[n].Id = Job.Id + i;
+            if (++n == CHUNK)
+            {
+                WriteEntries(SCRATCH_ADDR, Job.Count, Batch, n);
+                Job.Count += n;
+                n = 0;
+            }
+        }
+    }
+
+    if (n)
+    {
+        WriteEntries(SCRATCH_ADDR, Job.Count, Batch, n);
+        Job.Count += n;
+    }
+}
+
+// Sorts the scratch area into an index with the RAM of a few entries: each
+// pass over the scratch area picks the next SELECT smallest entries
+static void SortPass(uint32_t Addr)
+{
+    Entry_t  Best[SELECT];
+    uint16_t n = 0;
+
+    for (uint16_t Pos = 0; Pos < Job.Count; Pos += CHUNK)
+    {
+        Entry_t        Chunk[CHUNK];
+        const uint16_t Size = MIN(CHUNK, Job.Count - Pos);
+
+        PY25Q16_ReadBuffer(SCRATCH_ADDR + Pos * sizeof(Entry_t), Chunk, Size * sizeof(Entry_t));
+
+        for (unsigned int i = 0; i < Size; i++)
+        {
+            if (Job.Out && Compare(&Chunk[i], &Job.Last) <= 0)
+                continue;   // output by an earlier pass
+            Insert(Best, &n, SELECT, &Chunk[i]);
+        }
+    }
+
+    WriteEntries(Addr, Job.Out, Best, n);
+    Job.Out += n;
+    Job.Last = Best[n - 1];
+}
+
+static void StartJob(bool bName)
+{
+    Job.bName = bName;
+    Job.Id    = CHDB_BANK_SIZE;
+    Job.Count = 0;
+    Job.Out   = 0;
+}
+
+static void AppendMark(const Mark_t *pMark)
+{
+    if (NextMark >= MARK_SLOTS)
+    {
+        PY25Q16_SectorErase(MARK_ADDR);
+        NextMark = 0;
+    }
+
+    PY25Q16_WriteBuffer(MARK_ADDR + NextMark * sizeof(Mark_t), pMark, sizeof(Mark_t), false);
+    NextMark++;
+}
+
+static void MarkDirty(void)
+{
+    const Mark_t Mark = {
+        .State  = MARK_DIRTY,
+        .Layout = MARK_LAYOUT,
+    };
+
+    AppendMark(&Mark);
+#ifdef ENABLE_FLASH_WRITE_BACK
+    // The mark has to be in the flash before the change it covers
+    PY25Q16_Flush();
+#endif
+
+    Ready      = false;
+    Idle_500ms = 0;
+    StartJob(false);
+}
+
+// One step of a rebuild: a bank collected, a selection pass or the end
+static void Rebuild(void)
+{
+    if (Job.Id < CHDB_COUNT)
+    {
+        CollectBank();
+        return;
+    }
+
+    if (Job.Out < Job.Count)
+    {
+        SortPass(Job.bName ? NAME_ADDR : FREQ_ADDR);
+        return;
+    }
+
+    if (!Job.bName)
+    {
+        FreqCount = Job.Count;
+        StartJob(true);
+        return;
+    }
+
+    NameCount = Job.Count;
+    PY25Q16_SectorErase(LOG_ADDR);
+    NextLog = 0;
+#ifdef ENABLE_FLASH_WRITE_BACK
+    // And the indexes before the mark that says they are good
+    PY25Q16_Flush();
+#endif
+
+    const Mark_t Mark = {
+        .State     = MARK_CLEAN,
+        .Layout    = MARK_LAYOUT,
+        .Reserved  = 0xFFFF,
+        .FreqCount = FreqCount,
+        .NameCount = NameCount,
+    };
+    AppendMark(&Mark);
+
+    Ready = true;
+}
+
+// Adds an entry of the index or the log if its record still has that key
+// and matches the query
+static void Check(const Query_t *pQuery, const Entry_t *pEntry, Found_t *pFound)
+{
+    CHDB_Record_t Record;
+    Entry_t       Current;
+    char          Name[11];
+
+    if (pEntry->Id < CHDB_BANK_SIZE || pEntry->Id >= CHDB_COUNT)
+        return;
+
+    if (!CHDB_Read(pEntry->Id, &Record) || !MakeEntry(pQuery->bName, &Record, &Current) ||
+        memcmp(Current.Key, pEntry->Key, KEY_SIZE) != 0)
+        return;
+
+    if (pQuery->bName)
+    {
+        RecordName(&Record, Name);
+        if (!HasPrefix(Name, pQuery->pPrefix))
+            return;
+    }
+
+    // An edit that kept the key leaves the entry in the index and the log
+    for (unsigned int i = 0; i < pFound->Count; i++)
+        if (pFound->Entries[i].Id == pEntry->Id)
+            return;
+
+    Current.Id = pEntry->Id;
+    Insert(pFound->Entries, &pFound->Count, pFound->Max, &Current);
+}
+
+// Whether an entry with that key could still make it into the list
+static bool IsCandidate(const Query_t *pQuery, const Entry_t *pEntry, const Found_t *pFound)
+{
+    if (memcmp(pEntry->Key, pQuery->Lower, KEY_SIZE) < 0 || memcmp(pEntry->Key, pQuery->Upper, KEY_SIZE) > 0)
+        return false;
+
+    return pFound->Count < pFound->Max || Compare(pEntry, &pFound->Entries[pFound->Max - 1]) < 0;
+}
+
+// Bank 0, from RAM but for the names
+static void FindLegacy(const Query_t *pQuery, Found_t *pFound)
+{
+    for (uint16_t Id = 0; Id < CHDB_BANK_SIZE; Id++)
+    {
+        Entry_t Entry;
+        char    Name[11];
+
+        if (gMR_ChannelAttributes[Id].band > BAND7_470MHz)
+            continue;
+
+        if (pQuery->bName)
+        {
+            SETTINGS_FetchChannelName(Name, Id);
+            if (Name[0] == 0 || !HasPrefix(Name, pQuery->pPrefix))
+                continue;
+            NameKey(Name, Entry.Key);
+        }
+        else
+        {
+            FrequencyKey(gMR_ChannelIndex.Frequency[Id], Entry.Key);
+        }
+
+        Entry.Id = Id;
+        if (IsCandidate(pQuery, &Entry, pFound))
+            Insert(pFound->Entries, &pFound->Count, pFound->Max, &Entry);
+    }
+}
+
+static void FindIndexed(const Query_t *pQuery, Found_t *pFound)
+{
+    const uint32_t Addr  = pQuery->bName ? NAME_ADDR : FREQ_ADDR;
+    const uint16_t Count = pQuery->bName ? NameCount : FreqCount;
+    const uint16_t Flag  = pQuery->bName ? NAME_FLAG : 0;
+
+    for (uint16_t Pos = LowerBound(Addr, Count, pQuery->Lower); Pos < Count; Pos++)
+    {
+        Entry_t Entry;
+        ReadEntry(Addr, Pos, &Entry);
+        if (!IsCandidate(pQuery, &Entry, pFound))
+            break;  // and so are the ones after it
+        Check(pQuery, &Entry, pFound);
+    }
+
+    for (uint16_t Pos = 0; Pos < NextLog; Pos += CHUNK)
+    {
+        Entry_t        Chunk[CHUNK];
+        const uint16_t Size = MIN(CHUNK, NextLog - Pos);
+
+        PY25Q16_ReadBuffer(LOG_ADDR + Pos * sizeof(Entry_t), Chunk, Size * sizeof(Entry_t));
+
+        for (unsigned int i = 0; i < Size; i++)
+        {
+            if ((Chunk[i].Id & NAME_FLAG) != Flag)
+                continue;
+
+            Chunk[i].Id &= ~NAME_FLAG;
+            if (IsCandidate(pQuery, &Chunk[i], pFound))
+                Check(pQuery, &Chunk[i], pFound);
+        }
+    }
+}
+
+static uint16_t Find(const Query_t *pQuery, uint16_t *pIds, uint16_t Max)
+{
+    Found_t Found = {
+        .Count = 0,
+        .Max   = MIN(Max, CHDB_FIND_MAX),
+    };
+
+    if (Found.Max == 0)
+        return 0;
+
+    FindLegacy(pQuery, &Found);
+    if (Ready)
+        FindIndexed(pQuery, &Found);
+
+    for (unsigned int i = 0; i < Found.Count; i++)
+        pIds[i] = Found.Entries[i].Id;
+
+    return Found.Count;
+}
+
+void CHDB_Init(void)
+{
+    NextMark = FirstBlank(MARK_ADDR, MARK_SLOTS);
+    NextLog  = FirstBlank(LOG_ADDR, LOG_SLOTS);
+
+    Mark_t Mark = { 0 };
+    if (NextMark)
+        PY25Q16_ReadBuffer(MARK_ADDR + (NextMark - 1) * sizeof(Mark_t), &Mark, sizeof(Mark));
+
+    FreqCount = Mark.FreqCount;
+    NameCount = Mark.NameCount;
+    Ready     = Mark.State == MARK_CLEAN && Mark.Layout == MARK_LAYOUT;
+    StartJob(false);
+}
+
+void CHDB_TimeSlice500ms(void)
+{
+    // Rebuild once the edits stop and the radio has nothing better to do
+    if (Ready)
+        return;
+
+    if (Idle_500ms < REBUILD_IDLE_500MS)
+    {
+        Idle_500ms++;
+        return;
+    }
+
+    if (gCurrentFunction == FUNCTION_TRANSMIT || FUNCTION_IsRx() || gScanStateDir != SCAN_OFF)
+        return;
+
+    Rebuild();
+}
+
+bool CHDB_Read(uint16_t Id, CHDB_Record_t *pRecord)
+{
+    if (Id >= CHDB_COUNT)
+    {
+        memset(pRecord, 0xFF, sizeof(*pRecord));
+        return false;
+    }
+
+    if (Id < CHDB_BANK_SIZE)
+    {
+        // 0x0000 and 0x0F50 of the legacy layout
+        PY25Q16_ReadBuffer(Id * 16, pRecord, 16);
+        PY25Q16_ReadBuffer(0x00e000 + (Id * 16), pRecord->Name, sizeof(pRecord->Name));
+        pRecord->Attributes = gMR_ChannelAttributes[Id];
+        memset(pRecord->Reserved, 0xFF, sizeof(pRecord->Reserved));
+    }
+    else
+    {
+        PY25Q16_ReadBuffer(RecordAddr(Id), pRecord, sizeof(*pRecord));
+    }
+
+    return CHDB_IsUsed(pRecord);
+}
+
+void CHDB_LoadPage(uint16_t FirstId, CHDB_Record_t *pRecords, uint16_t Count)
+{
+    for (; Count && FirstId < CHDB_BANK_SIZE; Count--)
+        CHDB_Read(FirstId++, pRecords++);
+
+    // The store is read in one go
+    const uint16_t Size = (FirstId < CHDB_COUNT) ? MIN(Count, CHDB_COUNT - FirstId) : 0;
+    if (Size)
+        PY25Q16_ReadBuffer(RecordAddr(FirstId), pRecords, Size * sizeof(CHDB_Record_t));
+    memset(pRecords + Size, 0xFF, (Count - Size) * sizeof(CHDB_Record_t));
+}
+
+void CHDB_FetchName(char *s, uint16_t Id)
+{
+    if (Id < CHDB_BANK_SIZE)
+    {
+        SETTINGS_FetchChannelName(s, Id);
+        return;
+    }
+
+    CHDB_Record_t Record;
+    s[0] = 0;
+    if (!CHDB_Read(Id, &Record))
+        return;
+
+    RecordName(&Record, s);
+}
+
+bool CHDB_Write(uint16_t Id, const CHDB_Record_t *pRecord)
+{
+    if (Id < CHDB_BANK_SIZE || Id >= CHDB_COUNT)
+        return false;
+
+    CHDB_Record_t Record;
+    const bool    bWasUsed = CHDB_Read(Id, &Record);
+
+    CHDB_Record_t New;
+    if (CHDB_IsUsed(pRecord))
+        New = *pRecord;
+    else
+        memset(&New, 0xFF, sizeof(New));
+
+    if (memcmp(&Record, &New, sizeof(New)) == 0)
+        return true;
+
+    if (!Ready)
+    {
+        // The rebuild waits till the edits stop, and starts over as what
+        // it collected may be stale
+        Idle_500ms = 0;
+        StartJob(false);
+    }
+    else if (CHDB_IsUsed(&New))
+    {
+        // The new entries go to the log before the record, those of a key
+        // that stays are in it or the index already
+        Entry_t  Entries[2];
+        uint16_t n = 0;
+
+        for (unsigned int i = 0; i < 2; i++)
+        {
+            const bool bName = i == 1;
+            Entry_t    Old;
+
+            if (!MakeEntry(bName, &New, &Entries[n]))
+                continue;
+            if (bWasUsed && MakeEntry(bName, &Record, &Old) && memcmp(Old.Key, Entries[n].Key, KEY_SIZE) == 0)
+                continue;
+
+            Entries[n++].Id = Id | (bName ? NAME_FLAG : 0);
+        }
+
+        if (NextLog + n > LOG_SLOTS)
+        {
+            MarkDirty();
+        }
+        else if (n)
+        {
+            PY25Q16_WriteBuffer(LOG_ADDR + NextLog * sizeof(Entry_t), Entries, n * sizeof(Entry_t), false);
+            NextLog += n;
+#ifdef ENABLE_FLASH_WRITE_BACK
+            PY25Q16_Flush();
+#endif
+        }
+    }
+
+    PY25Q16_WriteBuffer(RecordAddr(Id), &New, sizeof(New), false);
+    return true;
+}
+
+uint16_t CHDB_FindFrequency(uint32_t Lower, uint32_t Upper, uint16_t *pIds, uint16_t Max)
+{
+    Query_t Query = {
+        .bName   = false,
+        .pPrefix = "",
+    };
+
+    FrequencyKey(Lower, Query.Lower);
+    FrequencyKey(Upper, Query.Upper);
+    return Find(&Query, pIds, Max);
+}
+
+uint16_t CHDB_FindName(const char *pPrefix, uint16_t *pIds, uint16_t Max)
+{
+    const unsigned int Len = strlen(pPrefix);
+    Query_t            Query = {
+        .bName   = true,
+        .pPrefix = pPrefix,
+    };
+
+    // Keys of names starting with the prefix, the key is padded with 0
+    NameKey(pPrefix, Query.Lower);
+    memcpy(Query.Upper, Query.Lower, KEY_SIZE);
+    for (unsigned int i = Len; i < KEY_SIZE; i++)
+        Query.Upper[i] = 0xFF;
+
+    return Find(&Query, pIds, Max);
+}
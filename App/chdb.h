@@ -0,0 +1,59 @@
+#ifndef CHDB_H
+#define CHDB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "frequencies.h"
+#include "misc.h"
+
+// Extended channel database in the SPI flash, see chdb.c.
+//
+// Channels are numbered by Id and grouped in banks of 200. Bank 0 is the
+// legacy memory channels (0x0000 - 0x0C80 and friends, what CHIRP sees),
+// read through their usual layout and edited as before. The other banks
+// live in the database store. The channel screens only show bank 0, the
+// others are reached by the serial commands and the spectrum's names.
+
+#define CHDB_BANK_SIZE  (MR_CHANNEL_LAST + 1)
+#define CHDB_BANKS      20
+#define CHDB_COUNT      (CHDB_BANK_SIZE * CHDB_BANKS)
+
+// A channel as stored, the legacy 16 byte channel followed by the legacy
+// 16 byte name slot that also carries the attributes
+typedef struct {
+    uint32_t            Frequency;  // RX, 10 Hz
+    uint32_t            Offset;
+    uint8_t             Data[8];    // codes, modulation, power, step... as in a legacy channel
+    char                Name[10];   // not terminated
+    ChannelAttributes_t Attributes; // 0xFF when the slot is free
+    uint8_t             Reserved[5];
+} CHDB_Record_t;
+
+static inline bool CHDB_IsUsed(const CHDB_Record_t *pRecord)
+{
+    return pRecord->Attributes.band <= BAND7_470MHz;
+}
+
+// Most Ids a lookup returns
+#define CHDB_FIND_MAX   16
+
+void     CHDB_Init(void);
+void     CHDB_TimeSlice500ms(void);
+
+bool     CHDB_Read(uint16_t Id, CHDB_Record_t *pRecord);
+// Count records from FirstId on in one go, for a page of a list
+void     CHDB_LoadPage(uint16_t FirstId, CHDB_Record_t *pRecords, uint16_t Count);
+void     CHDB_FetchName(char *s, uint16_t Id);
+// Banks 1 and up only, a record that is not used deletes the channel
+bool     CHDB_Write(uint16_t Id, const CHDB_Record_t *pRecord);
+
+// Ids of the used channels with an RX frequency in [Lower, Upper], in
+// frequency order, or whose name starts with pPrefix (any case), in name
+// order. Both return how many were put in pIds, at most Max and
+// CHDB_FIND_MAX. Banks 1 and up are left out while their indexes wait for
+// a rebuild, a lookup never does one.
+uint16_t CHDB_FindFrequency(uint32_t Lower, uint32_t Upper, uint16_t *pIds, uint16_t Max);
+uint16_t CHDB_FindName(const char *pPrefix, uint16_t *pIds, uint16_t Max);
+
+#endif
@@ -11,7 +11,7 @@
 
 static inline void LogUart(const char *const str)
 {
-    UART_Send(str, strlen(str));
+    UART_TrySend(str, strlen(str));
 }
 
 static inline void LogUartf(const char* format, ...)
@@ -21,7 +21,7 @@ static inline void LogUartf(const char* format, ...)
     va_start(va, format);
     vsnprintf(buffer, (size_t)-1, format, va);
     va_end(va);
-    UART_Send(buffer, strlen(buffer));
+    UART_TrySend(buffer, strlen(buffer));
 }
 
 static inline void LogRegUart(uint16_t reg)
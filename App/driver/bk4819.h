@@ -63,6 +63,18 @@ enum BK4819_CssScanResult_t
 
 typedef enum BK4819_CssScanResult_t BK4819_CssScanResult_t;
 
+// One step of a register script: Register = (Register & ~Mask) | (Value & Mask).
+// A full mask writes the value as is, without reading the register first.
+typedef struct
+{
+    uint8_t  Register;
+    uint16_t Value;
+    uint16_t Mask;
+} BK4819_ScriptStep_t;
+
+#define BK4819_SCRIPT_SET(Register, Value)          { (Register), (Value), 0xFFFF }
+#define BK4819_SCRIPT_MODIFY(Register, Value, Mask) { (Register), (Value), (Mask) }
+
 // radio is asleep, not listening
 extern bool gRxIdleMode;
 
@@ -70,6 +82,8 @@ void     BK4819_Init(void);
 uint16_t BK4819_ReadRegister(BK4819_REGISTER_t Register);
 void     BK4819_WriteRegister(BK4819_REGISTER_t Register, uint16_t Data);
 void     BK4819_SetRegValue(RegisterSpec s, uint16_t v);
+void     BK4819_ApplyScript(const BK4819_ScriptStep_t *pScript, unsigned int Count);
+bool     BK4819_IsInterruptPending(void);
 void     BK4819_WriteU8(uint8_t Data);
 void     BK4819_WriteU16(uint16_t Data);
 
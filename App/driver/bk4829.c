@@ -27,6 +27,14 @@
 #include "driver/system.h"
 #include "driver/systick.h"
 
+#ifdef ENABLE_BK4819_IRQ_EXTI
+    #include "py32f071_ll_exti.h"
+#endif
+#ifdef ENABLE_BK4819_SHADOW_CHECK
+    #include "driver/uart.h"
+    #include "external/printf/printf.h"
+#endif
+
 
 #ifndef ARRAY_SIZE
     #define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
@@ -43,6 +51,20 @@ static const uint16_t FSK_RogerTable[7] = {0xF1A2, 0x7446, 0x61A4, 0x6544, 0x4E8
 
 static uint16_t gBK4819_GpioOutState;
 
+#ifdef ENABLE_BK4819_IRQ_EXTI
+    static volatile bool gBK4819_IrqEdge;
+#endif
+
+// Write-through shadow of the register file. Every bit-banged transaction
+// costs ~100 us, and RADIO_SetupRegisters() rewrites dozens of mostly
+// unchanged registers on each channel hop while scanning.
+static uint16_t gBK4819_ShadowRegs[128];
+static uint32_t gBK4819_ShadowValid[128 / 32];
+
+#ifdef ENABLE_BK4819_SHADOW_CHECK
+    static uint16_t gBK4819_ShadowMismatches;
+#endif
+
 bool gRxIdleMode;
 
 static inline void CS_Assert()
@@ -85,37 +107,58 @@ static inline uint32_t SDA_ReadInput()
     return GPIO_IsInputPinSet(PIN_SDA) ? 1 : 0;
 }
 
+#ifdef ENABLE_BK4819_FAST_BUS
+    // Busy-wait lengths tried by BK4819_CalibrateBus(), fastest first.
+    // An iteration is ~4 cycles, 83 ns at 48 MHz.
+    static const uint8_t BK4819_BusDelays[] = {0, 1, 2, 4, 8, 16};
+
+    #define BK4819_BUS_DELAY_SYSTICK 0xFF
+
+    static uint8_t gBK4819_BusDelay = BK4819_BUS_DELAY_SYSTICK;
+
+    static void BK4819_CalibrateBus(void);
+#endif
+
+// Gap between edges on the 3-wire bus. The chip needs far less than the
+// 1 us SYSTICK_DelayUs() default, which alone is most of a transaction.
+static inline void BK4819_BusDelay(void)
+{
+#ifdef ENABLE_BK4819_FAST_BUS
+    if (gBK4819_BusDelay != BK4819_BUS_DELAY_SYSTICK)
+    {
+        for (unsigned int i = gBK4819_BusDelay; i > 0; i--)
+            __NOP();
+        return;
+    }
+#endif
+    SYSTICK_DelayUs(1);
+}
+
 static inline uint16_t scale_freq(const uint16_t freq)
 {
 //  return (((uint32_t)freq * 1032444u) + 50000u) / 100000u;   // with rounding
     return (((uint32_t)freq * 1353245u) + (1u << 16)) >> 17;   // with rounding
 }
 
-void BK4819_Init(void)
+// Power-on register set, applied right after the soft reset
+static const BK4819_ScriptStep_t BK4819_InitScript[] =
 {
-    CS_Release();
-    SCL_Set();
-    SDA_Set();
-
-    BK4819_WriteRegister(BK4819_REG_00, 0x8000);
-    BK4819_WriteRegister(BK4819_REG_00, 0x0000);
-
-    BK4819_WriteRegister(BK4819_REG_37, 0x9D1F);
-    BK4819_WriteRegister(BK4819_REG_36, 0x0022);
+    BK4819_SCRIPT_SET(BK4819_REG_37, 0x9D1F),
+    BK4819_SCRIPT_SET(BK4819_REG_36, 0x0022),
 
     // BK4819_InitAGC(false);
     // BK4819_SetAGC(true);
-    BK4819_WriteRegister(BK4819_REG_10, 0x0318);
-    BK4819_WriteRegister(BK4819_REG_11, 0x033A);
-    BK4819_WriteRegister(BK4819_REG_12, 0x03DB);
-    BK4819_WriteRegister(BK4819_REG_13, 0x03DF);
-    BK4819_WriteRegister(BK4819_REG_14, 0x0210);
-    BK4819_WriteRegister(BK4819_REG_49, 0x2AB2);
-    BK4819_WriteRegister(BK4819_REG_7B, 0x73DC);
+    BK4819_SCRIPT_SET(BK4819_REG_10, 0x0318),
+    BK4819_SCRIPT_SET(BK4819_REG_11, 0x033A),
+    BK4819_SCRIPT_SET(BK4819_REG_12, 0x03DB),
+    BK4819_SCRIPT_SET(BK4819_REG_13, 0x03DF),
+    BK4819_SCRIPT_SET(BK4819_REG_14, 0x0210),
+    BK4819_SCRIPT_SET(BK4819_REG_49, 0x2AB2),
+    BK4819_SCRIPT_SET(BK4819_REG_7B, 0x73DC),
 
-    // BK4819_WriteRegister(BK4819_REG_19, 0b0001000001000001);   // <15> MIC AGC  1 = disable  0 = enable
+    // BK4819_SCRIPT_SET(BK4819_REG_19, 0b0001000001000001),   // <15> MIC AGC  1 = disable  0 = enable
 
-    BK4819_WriteRegister(BK4819_REG_7D, 0xE920);
+    BK4819_SCRIPT_SET(BK4819_REG_7D, 0xE920),
 
     // REG_48 .. RX AF level
     //
@@ -135,64 +178,130 @@ void BK4819_Init(void)
     //         15 = max
     //          0 = min
     //
-    BK4819_WriteRegister(BK4819_REG_48, //  0xB3A8);     // 1011 00 111010 1000
+    BK4819_SCRIPT_SET(BK4819_REG_48, //  0xB3A8);     // 1011 00 111010 1000
         // (11u << 12) |     // ??? 0..15
         // ( 0u << 10) |     // AF Rx Gain-1
         // (58u <<  4) |     // AF Rx Gain-2
         // ( 8u <<  0));     // AF DAC Gain (after Gain-1 and Gain-2)
-        0x33A8);
+        0x33A8),
+
+    BK4819_SCRIPT_SET(0x40, 0x3516),
+
+    // DTMF coefficients, <15:12> table index, <7:0> coefficient
+    BK4819_SCRIPT_SET(BK4819_REG_09, 0x006F),  // 111
+    BK4819_SCRIPT_SET(BK4819_REG_09, 0x106B),  // 107
+    BK4819_SCRIPT_SET(BK4819_REG_09, 0x2067),  // 103
+    BK4819_SCRIPT_SET(BK4819_REG_09, 0x3062),  //  98
+    BK4819_SCRIPT_SET(BK4819_REG_09, 0x4050),  //  80
+    BK4819_SCRIPT_SET(BK4819_REG_09, 0x5047),  //  71
+    BK4819_SCRIPT_SET(BK4819_REG_09, 0x603A),  //  58
+    BK4819_SCRIPT_SET(BK4819_REG_09, 0x702C),  //  44
+    BK4819_SCRIPT_SET(BK4819_REG_09, 0x8041),  //  65
+    BK4819_SCRIPT_SET(BK4819_REG_09, 0x9037),  //  55
+    BK4819_SCRIPT_SET(BK4819_REG_09, 0xA025),  //  37
+    BK4819_SCRIPT_SET(BK4819_REG_09, 0xB017),  //  23
+    BK4819_SCRIPT_SET(BK4819_REG_09, 0xC0E4),  // 228
+    BK4819_SCRIPT_SET(BK4819_REG_09, 0xD0CB),  // 203
+    BK4819_SCRIPT_SET(BK4819_REG_09, 0xE0B5),  // 181
+    BK4819_SCRIPT_SET(BK4819_REG_09, 0xF09F),  // 159
+
+    BK4819_SCRIPT_SET(0x1C, 0x07C0),
+    BK4819_SCRIPT_SET(0x1D, 0xE555),
+    BK4819_SCRIPT_SET(0x1E, 0x4C58),
+
+    BK4819_SCRIPT_SET(BK4819_REG_1F, 0xC65A),
+    BK4819_SCRIPT_SET(BK4819_REG_3E, 0x94C6),
+
+    BK4819_SCRIPT_SET(0x73, 0x4691),
+    BK4819_SCRIPT_SET(0x77, 0x88EF),
+    BK4819_SCRIPT_SET(BK4819_REG_19, 0x104E),
+    BK4819_SCRIPT_SET(BK4819_REG_28, 0x0B40),
+    BK4819_SCRIPT_SET(BK4819_REG_29, 0xAA00),
+    BK4819_SCRIPT_SET(0x2A, 0x6600),
+    BK4819_SCRIPT_SET(0x2C, 0x1822),
+    BK4819_SCRIPT_SET(0x2F, 0x9890),
+    BK4819_SCRIPT_SET(0x53, 0x2028),
+    BK4819_SCRIPT_SET(BK4819_REG_7E, 0x303E),
+    BK4819_SCRIPT_SET(BK4819_REG_46, 0x600A),
+    BK4819_SCRIPT_SET(0x4A, 0x5430),
+    BK4819_SCRIPT_SET(BK4819_REG_07, 0x61CE),
+
+    BK4819_SCRIPT_SET(BK4819_REG_33, 0x9000),  // gBK4819_GpioOutState
+    BK4819_SCRIPT_SET(BK4819_REG_3F, 0),
+};
 
-    BK4819_WriteRegister(0x40, 0x3516);
+void BK4819_Init(void)
+{
+    CS_Release();
+    SCL_Set();
+    SDA_Set();
 
-#if 1
-    const uint8_t dtmf_coeffs[] = {111, 107, 103, 98, 80, 71, 58, 44, 65, 55, 37, 23, 228, 203, 181, 159};
-    for (unsigned int i = 0; i < ARRAY_SIZE(dtmf_coeffs); i++)
-        BK4819_WriteRegister(BK4819_REG_09, (i << 12) | dtmf_coeffs[i]);
-#else
-    // original code
-    BK4819_WriteRegister(BK4819_REG_09, 0x006F);  // 6F
-    BK4819_WriteRegister(BK4819_REG_09, 0x106B);  // 6B
-    BK4819_WriteRegister(BK4819_REG_09, 0x2067);  // 67
-    BK4819_WriteRegister(BK4819_REG_09, 0x3062);  // 62
-    BK4819_WriteRegister(BK4819_REG_09, 0x4050);  // 50
-    BK4819_WriteRegister(BK4819_REG_09, 0x5047);  // 47
-    BK4819_WriteRegister(BK4819_REG_09, 0x603A);  // 3A
-    BK4819_WriteRegister(BK4819_REG_09, 0x702C);  // 2C
-    BK4819_WriteRegister(BK4819_REG_09, 0x8041);  // 41
-    BK4819_WriteRegister(BK4819_REG_09, 0x9037);  // 37
-    BK4819_WriteRegister(BK4819_REG_09, 0xA025);  // 25
-    BK4819_WriteRegister(BK4819_REG_09, 0xB017);  // 17
-    BK4819_WriteRegister(BK4819_REG_09, 0xC0E4);  // E4
-    BK4819_WriteRegister(BK4819_REG_09, 0xD0CB);  // CB
-    BK4819_WriteRegister(BK4819_REG_09, 0xE0B5);  // B5
-    BK4819_WriteRegister(BK4819_REG_09, 0xF09F);  // 9F
+#ifdef ENABLE_BK4819_FAST_BUS
+    BK4819_CalibrateBus();
 #endif
 
-    BK4819_WriteRegister(0x1C, 0x07C0);
-    BK4819_WriteRegister(0x1D, 0xE555);
-    BK4819_WriteRegister(0x1E, 0x4C58);
-
-    BK4819_WriteRegister(BK4819_REG_1F, 0xC65A);
-    BK4819_WriteRegister(BK4819_REG_3E, 0x94C6);
-
-    BK4819_WriteRegister(0x73, 0x4691);
-    BK4819_WriteRegister(0x77, 0x88EF);
-    BK4819_WriteRegister(BK4819_REG_19, 0x104E);
-    BK4819_WriteRegister(BK4819_REG_28, 0x0B40);
-    BK4819_WriteRegister(BK4819_REG_29, 0xAA00);
-    BK4819_WriteRegister(0x2A, 0x6600);
-    BK4819_WriteRegister(0x2C, 0x1822);
-    BK4819_WriteRegister(0x2F, 0x9890);
-    BK4819_WriteRegister(0x53, 0x2028);
-    BK4819_WriteRegister(BK4819_REG_7E, 0x303E);
-    BK4819_WriteRegister(BK4819_REG_46, 0x600A);
-    BK4819_WriteRegister(0x4A, 0x5430);
-    BK4819_WriteRegister(BK4819_REG_07, 0x61CE);
+    BK4819_WriteRegister(BK4819_REG_00, 0x8000);
+    BK4819_WriteRegister(BK4819_REG_00, 0x0000);
 
     gBK4819_GpioOutState = 0x9000;
 
-    BK4819_WriteRegister(BK4819_REG_33, 0x9000);
-    BK4819_WriteRegister(BK4819_REG_3F, 0);
+    BK4819_ApplyScript(BK4819_InitScript, ARRAY_SIZE(BK4819_InitScript));
+}
+
+// Registers the chip updates by itself, or where the write is the command
+// (reset, interrupt acknowledge, indexed tables, FIFOs). These always go
+// to the bus.
+static bool BK4819_IsVolatile(BK4819_REGISTER_t Register)
+{
+    switch ((unsigned int)Register)
+    {
+        case BK4819_REG_00:     // soft reset
+        case BK4819_REG_02:     // interrupt flags, a write acknowledges
+        case BK4819_REG_09:     // DTMF coefficient table, indexed
+        case BK4819_REG_0B:     // DTMF/5-tone code received
+        case BK4819_REG_0C:     // interrupt request, CTCSS/CDCSS/VOX status
+        case BK4819_REG_0D:     // frequency scan result
+        case BK4819_REG_0E:
+        case BK4819_REG_59:     // FSK FIFO clear
+        case BK4819_REG_5F:     // FSK FIFO data
+        case BK4819_REG_63:     // glitch indicator
+        case BK4819_REG_64:     // voice amplitude
+        case BK4819_REG_65:     // noise indicator
+        case 0x66:
+        case BK4819_REG_67:     // RSSI
+        case BK4819_REG_68:     // CTCSS/CDCSS scan result
+        case BK4819_REG_69:
+        case BK4819_REG_6A:
+        case BK4819_REG_6F:     // AF level
+        case BK4819_REG_7E:     // AGC gain index and signal strength
+            return true;
+        default:
+            return false;
+    }
+}
+
+static inline bool BK4819_IsShadowValid(BK4819_REGISTER_t Register)
+{
+    return (gBK4819_ShadowValid[Register / 32] >> (Register % 32)) & 1u;
+}
+
+static inline void BK4819_SetShadow(BK4819_REGISTER_t Register, uint16_t Value)
+{
+    gBK4819_ShadowRegs[Register] = Value;
+    gBK4819_ShadowValid[Register / 32] |= 1u << (Register % 32);
+}
+
+static void BK4819_InvalidateShadow(void)
+{
+    for (unsigned int i = 0; i < ARRAY_SIZE(gBK4819_ShadowValid); i++)
+        gBK4819_ShadowValid[i] = 0;
+}
+
+// Last value written, for read-modify-write of registers that mix control
+// bits with status bits, such as REG_7E
+static uint16_t BK4819_ReadShadow(BK4819_REGISTER_t Register)
+{
+    return BK4819_IsShadowValid(Register) ? gBK4819_ShadowRegs[Register] : BK4819_ReadRegister(Register);
 }
 
 static uint16_t BK4819_ReadU16(void)
@@ -201,37 +310,37 @@ static uint16_t BK4819_ReadU16(void)
     uint16_t     Value;
 
     SDA_SetDir(false);
-    SYSTICK_DelayUs(1);
+    BK4819_BusDelay();
     Value = 0;
     for (i = 0; i < 16; i++)
     {
         Value <<= 1;
         Value |= SDA_ReadInput();
         SCL_Set();
-        SYSTICK_DelayUs(1);
+        BK4819_BusDelay();
         SCL_Reset();
-        SYSTICK_DelayUs(1);
+        BK4819_BusDelay();
     }
     SDA_SetDir(true);
 
     return Value;
 }
 
-uint16_t BK4819_ReadRegister(BK4819_REGISTER_t Register)
+static uint16_t BK4819_ReadBus(BK4819_REGISTER_t Register)
 {
     uint16_t Value;
 
     CS_Release();
     SCL_Reset();
 
-    SYSTICK_DelayUs(1);
+    BK4819_BusDelay();
 
     CS_Assert();
     BK4819_WriteU8(Register | 0x80);
     Value = BK4819_ReadU16();
     CS_Release();
 
-    SYSTICK_DelayUs(1);
+    BK4819_BusDelay();
 
     SCL_Set();
     SDA_Set();
@@ -239,30 +348,234 @@ uint16_t BK4819_ReadRegister(BK4819_REGISTER_t Register)
     return Value;
 }
 
-void BK4819_WriteRegister(BK4819_REGISTER_t Register, uint16_t Data)
+static void BK4819_WriteBus(BK4819_REGISTER_t Register, uint16_t Data)
 {
     CS_Release();
     SCL_Reset();
 
-    SYSTICK_DelayUs(1);
+    BK4819_BusDelay();
 
     CS_Assert();
     BK4819_WriteU8(Register);
 
-    SYSTICK_DelayUs(1);
+    BK4819_BusDelay();
 
     BK4819_WriteU16(Data);
 
-    SYSTICK_DelayUs(1);
+    BK4819_BusDelay();
 
     CS_Release();
 
-    SYSTICK_DelayUs(1);
+    BK4819_BusDelay();
 
     SCL_Set();
     SDA_Set();
 }
 
+#ifdef ENABLE_BK4819_FAST_BUS
+    // Find the shortest bus delay that reads a scratch register back
+    // exactly, then keep one step of margin for temperature and supply.
+    // Runs ahead of the soft reset in BK4819_Init(), which restores the
+    // scratch register (REG_38, frequency low word).
+    static void BK4819_CalibrateBus(void)
+    {
+        static const uint16_t Patterns[] = {0xA55A, 0x5AA5, 0xFFFF, 0x0001, 0x8000};
+
+        unsigned int Fastest = ARRAY_SIZE(BK4819_BusDelays);
+
+        for (unsigned int i = 0; i < ARRAY_SIZE(BK4819_BusDelays) && Fastest == ARRAY_SIZE(BK4819_BusDelays); i++)
+        {
+            bool Ok = true;
+
+            gBK4819_BusDelay = BK4819_BusDelays[i];
+
+            for (unsigned int j = 0; j < ARRAY_SIZE(Patterns) && Ok; j++)
+            {
+                BK4819_WriteBus(BK4819_REG_38, Patterns[j]);
+                Ok = BK4819_ReadBus(BK4819_REG_38) == Patterns[j];
+            }
+
+            if (Ok)
+                Fastest = i;
+        }
+
+        if (Fastest == ARRAY_SIZE(BK4819_BusDelays))
+            gBK4819_BusDelay = BK4819_BUS_DELAY_SYSTICK;
+        else if (Fastest + 1 < ARRAY_SIZE(BK4819_BusDelays))
+            gBK4819_BusDelay = BK4819_BusDelays[Fastest + 1];
+    }
+#endif
+
+#ifdef ENABLE_BK4819_SHADOW_CHECK
+    // The chip is authoritative: report the register and adopt its value.
+    // A register that keeps showing up here belongs in BK4819_IsVolatile().
+    static void BK4819_CheckShadow(BK4819_REGISTER_t Register)
+    {
+        const uint16_t Value = BK4819_ReadBus(Register);
+
+        if (Value == gBK4819_ShadowRegs[Register])
+            return;
+
+        gBK4819_ShadowMismatches++;
+
+        #ifdef ENABLE_UART
+        {
+            char String[48];
+            const int Len = sprintf(String, "BK4819 shadow #%u REG_%02X %04X != %04X\r\n",
+                gBK4819_ShadowMismatches, Register, gBK4819_ShadowRegs[Register], Value);
+            UART_LogSend(String, Len);
+        }
+        #endif
+
+        gBK4819_ShadowRegs[Register] = Value;
+    }
+#endif
+
+uint16_t BK4819_ReadRegister(BK4819_REGISTER_t Register)
+{
+    Register &= 0x7F;
+
+    if (BK4819_IsVolatile(Register))
+        return BK4819_ReadBus(Register);
+
+    if (BK4819_IsShadowValid(Register))
+    {
+        #ifdef ENABLE_BK4819_SHADOW_CHECK
+            BK4819_CheckShadow(Register);
+        #endif
+        return gBK4819_ShadowRegs[Register];
+    }
+
+    const uint16_t Value = BK4819_ReadBus(Register);
+    BK4819_SetShadow(Register, Value);
+
+    return Value;
+}
+
+void BK4819_WriteRegister(BK4819_REGISTER_t Register, uint16_t Data)
+{
+    Register &= 0x7F;
+
+    if (!BK4819_IsVolatile(Register) && BK4819_IsShadowValid(Register) && gBK4819_ShadowRegs[Register] == Data)
+    {
+        #ifdef ENABLE_BK4819_SHADOW_CHECK
+            BK4819_CheckShadow(Register);
+            if (gBK4819_ShadowRegs[Register] == Data)
+                return;
+        #else
+            return;
+        #endif
+    }
+
+    BK4819_WriteBus(Register, Data);
+
+    if (Register == BK4819_REG_00)
+        BK4819_InvalidateShadow();  // soft reset restores the defaults
+    else
+        BK4819_SetShadow(Register, Data);
+}
+
+// The chip latches each word when CSN goes high, so a burst keeps SCL low
+// and only pulses CSN between words. The idle state and its guard delays
+// are restored once, at the end.
+static void BK4819_BurstWrite(BK4819_REGISTER_t Register, uint16_t Data, bool Open)
+{
+    CS_Release();
+    if (!Open)
+        SCL_Reset();
+
+    BK4819_BusDelay();
+
+    CS_Assert();
+    BK4819_WriteU8(Register);
+    BK4819_WriteU16(Data);
+}
+
+static void BK4819_BurstEnd(void)
+{
+    BK4819_BusDelay();
+
+    CS_Release();
+
+    BK4819_BusDelay();
+
+    SCL_Set();
+    SDA_Set();
+}
+
+void BK4819_ApplyScript(const BK4819_ScriptStep_t *pScript, unsigned int Count)
+{
+    bool Open = false;
+
+    for (unsigned int i = 0; i < Count; i++)
+    {
+        const BK4819_REGISTER_t Register = pScript[i].Register & 0x7F;
+        const uint16_t          Mask     = pScript[i].Mask;
+        uint16_t                Data     = pScript[i].Value;
+
+        if (Mask != 0xFFFF)
+        {
+            if (Open && (BK4819_IsVolatile(Register) || !BK4819_IsShadowValid(Register)))
+            {
+                BK4819_BurstEnd();
+                Open = false;
+            }
+
+            Data = (BK4819_ReadShadow(Register) & ~Mask) | (Data & Mask);
+        }
+
+        if (!BK4819_IsVolatile(Register) && BK4819_IsShadowValid(Register) && gBK4819_ShadowRegs[Register] == Data)
+        {
+            #ifdef ENABLE_BK4819_SHADOW_CHECK
+                if (Open)
+                {
+                    BK4819_BurstEnd();
+                    Open = false;
+                }
+
+                BK4819_WriteRegister(Register, Data);
+            #endif
+            continue;
+        }
+
+        BK4819_BurstWrite(Register, Data, Open);
+        Open = true;
+
+        if (Register == BK4819_REG_00)
+            BK4819_InvalidateShadow();
+        else
+            BK4819_SetShadow(Register, Data);
+    }
+
+    if (Open)
+        BK4819_BurstEnd();
+}
+
+#ifdef ENABLE_BK4819_IRQ_EXTI
+    void EXTI4_15_IRQHandler(void)
+    {
+        if (LL_EXTI_IsActiveFlag(LL_EXTI_LINE_7))
+        {
+            LL_EXTI_ClearFlag(LL_EXTI_LINE_7);
+            gBK4819_IrqEdge = true;
+        }
+    }
+#endif
+
+// REG_0C<0>, the chip's interrupt request. With the IRQ line wired this is
+// a pin read, so callers can check it every pass without using the bus.
+bool BK4819_IsInterruptPending(void)
+{
+#ifdef ENABLE_BK4819_IRQ_EXTI
+    const bool Edge = gBK4819_IrqEdge;
+    gBK4819_IrqEdge = false;
+
+    return Edge || GPIO_IsInputPinSet(GPIO_PIN_BK4819_IRQ);
+#else
+    return (BK4819_ReadRegister(BK4819_REG_0C) & 1u) != 0;
+#endif
+}
+
 void BK4819_WriteU8(uint8_t Data)
 {
     unsigned int i;
@@ -275,14 +588,14 @@ void BK4819_WriteU8(uint8_t Data)
         else
             SDA_Set();
 
-        SYSTICK_DelayUs(1);
+        BK4819_BusDelay();
         SCL_Set();
-        SYSTICK_DelayUs(1);
+        BK4819_BusDelay();
 
         Data <<= 1;
 
         SCL_Reset();
-        SYSTICK_DelayUs(1);
+        BK4819_BusDelay();
     }
 }
 
@@ -298,20 +611,20 @@ void BK4819_WriteU16(uint16_t Data)
         else
             SDA_Set();
 
-        SYSTICK_DelayUs(1);
+        BK4819_BusDelay();
         SCL_Set();
 
         Data <<= 1;
 
-        SYSTICK_DelayUs(1);
+        BK4819_BusDelay();
         SCL_Reset();
-        SYSTICK_DelayUs(1);
+        BK4819_BusDelay();
     }
 }
 
 void BK4819_SetAGC(bool enable)
 {
-    uint16_t regVal = BK4819_ReadRegister(BK4819_REG_7E);
+    uint16_t regVal = BK4819_ReadShadow(BK4819_REG_7E);
     if(!(regVal & (1 << 15)) == enable)
         return;
 
@@ -377,21 +690,30 @@ void BK4819_InitAGC(bool amModulation)
     //         0 = -33dB
     //
 
-    BK4819_WriteRegister(BK4819_REG_13, 0x03BE);  // 0x03BE / 000000 11 101 11 110 /  -7dB
-    BK4819_WriteRegister(BK4819_REG_12, 0x037B);  // 0x037B / 000000 11 011 11 011 / -24dB
-    BK4819_WriteRegister(BK4819_REG_11, 0x027B);  // 0x027B / 000000 10 011 11 011 / -43dB
-    BK4819_WriteRegister(BK4819_REG_10, 0x007A);  // 0x007A / 000000 00 011 11 010 / -58dB
-    if(amModulation) {
-        BK4819_WriteRegister(BK4819_REG_14, 0x0000);
-        BK4819_WriteRegister(BK4819_REG_49, (0 << 14) | (50 << 7) | (32 << 0));
-    }
-    else{
-        BK4819_WriteRegister(BK4819_REG_14, 0x0019);  // 0x0019 / 000000 00 000 11 001 / -79dB
-        BK4819_WriteRegister(BK4819_REG_49, (0 << 14) | (84 << 7) | (56 << 0)); //0x2A38 / 00 1010100 0111000 / 84, 56
-    }
 
-    BK4819_WriteRegister(BK4819_REG_7B, 0x8420);
+    static const BK4819_ScriptStep_t Script[2][7] =
+    {
+        {   // FM
+            BK4819_SCRIPT_SET(BK4819_REG_13, 0x03BE),  // 0x03BE / 000000 11 101 11 110 /  -7dB
+            BK4819_SCRIPT_SET(BK4819_REG_12, 0x037B),  // 0x037B / 000000 11 011 11 011 / -24dB
+            BK4819_SCRIPT_SET(BK4819_REG_11, 0x027B),  // 0x027B / 000000 10 011 11 011 / -43dB
+            BK4819_SCRIPT_SET(BK4819_REG_10, 0x007A),  // 0x007A / 000000 00 011 11 010 / -58dB
+            BK4819_SCRIPT_SET(BK4819_REG_14, 0x0019),  // 0x0019 / 000000 00 000 11 001 / -79dB
+            BK4819_SCRIPT_SET(BK4819_REG_49, (0 << 14) | (84 << 7) | (56 << 0)), //0x2A38 / 00 1010100 0111000 / 84, 56
+            BK4819_SCRIPT_SET(BK4819_REG_7B, 0x8420),
+        },
+        {   // AM
+            BK4819_SCRIPT_SET(BK4819_REG_13, 0x03BE),
+            BK4819_SCRIPT_SET(BK4819_REG_12, 0x037B),
+            BK4819_SCRIPT_SET(BK4819_REG_11, 0x027B),
+            BK4819_SCRIPT_SET(BK4819_REG_10, 0x007A),
+            BK4819_SCRIPT_SET(BK4819_REG_14, 0x0000),
+            BK4819_SCRIPT_SET(BK4819_REG_49, (0 << 14) | (50 << 7) | (32 << 0)),
+            BK4819_SCRIPT_SET(BK4819_REG_7B, 0x8420),
+        },
+    };
 
+    BK4819_ApplyScript(Script[amModulation], ARRAY_SIZE(Script[amModulation]));
 }
 
 int8_t BK4819_GetRxGain_dB(void)
@@ -770,75 +1092,80 @@ void BK4819_SetupSquelch(
         uint8_t SquelchCloseGlitchThresh,
         uint8_t SquelchOpenGlitchThresh)
 {
-    // REG_70
-    //
-    // <15>   0 Enable TONE1
-    //        1 = Enable
-    //        0 = Disable
-    //
-    // <14:8> 0 TONE1 tuning gain
-    //        0 ~ 127
-    //
-    // <7>    0 Enable TONE2
-    //        1 = Enable
-    //        0 = Disable
-    //
-    // <6:0>  0 TONE2/FSK tuning gain
-    //        0 ~ 127
-    //
-    BK4819_WriteRegister(BK4819_REG_70, 0);
+    const BK4819_ScriptStep_t Script[] =
+    {
+        // REG_70
+        //
+        // <15>   0 Enable TONE1
+        //        1 = Enable
+        //        0 = Disable
+        //
+        // <14:8> 0 TONE1 tuning gain
+        //        0 ~ 127
+        //
+        // <7>    0 Enable TONE2
+        //        1 = Enable
+        //        0 = Disable
+        //
+        // <6:0>  0 TONE2/FSK tuning gain
+        //        0 ~ 127
+        //
+        BK4819_SCRIPT_SET(BK4819_REG_70, 0),
 
-    // Glitch threshold for Squelch = close
-    //
-    // 0 ~ 255
-    //
-    BK4819_WriteRegister(BK4819_REG_4D, 0xA000 | SquelchCloseGlitchThresh);
+        // Glitch threshold for Squelch = close
+        //
+        // 0 ~ 255
+        //
+        BK4819_SCRIPT_SET(BK4819_REG_4D, 0xA000 | SquelchCloseGlitchThresh),
 
-    // REG_4E
-    //
-    // <15:14> 1 ???
-    //
-    // <13:11> 5 Squelch = open  Delay Setting
-    //         0 ~ 7
-    //
-    // <10:9>  7 Squelch = close Delay Setting
-    //         0 ~ 3
-    //
-    // <8>     0 ???
-    //
-    // <7:0>   8 Glitch threshold for Squelch = open
-    //         0 ~ 255
-    //
-    BK4819_WriteRegister(BK4819_REG_4E,  // 01 101 11 1 00000000
+        // REG_4E
+        //
+        // <15:14> 1 ???
+        //
+        // <13:11> 5 Squelch = open  Delay Setting
+        //         0 ~ 7
+        //
+        // <10:9>  7 Squelch = close Delay Setting
+        //         0 ~ 3
+        //
+        // <8>     0 ???
+        //
+        // <7:0>   8 Glitch threshold for Squelch = open
+        //         0 ~ 255
+        //
+        BK4819_SCRIPT_SET(BK4819_REG_4E,  // 01 101 11 1 00000000
 
-        // original (*)
-    (1u << 14) |                  //  1 ???
-    (5u << 11) |                  // *5  squelch = open  delay .. 0 ~ 7
-    (6u <<  9) |                  // *3  squelch = close delay .. 0 ~ 3
-    SquelchOpenGlitchThresh);     //  0 ~ 255
+                // original (*)
+            (1u << 14) |                  //  1 ???
+            (5u << 11) |                  // *5  squelch = open  delay .. 0 ~ 7
+            (6u <<  9) |                  // *3  squelch = close delay .. 0 ~ 3
+            SquelchOpenGlitchThresh),     //  0 ~ 255
 
+        // REG_4F
+        //
+        // <14:8> 47 Ex-noise threshold for Squelch = close
+        //        0 ~ 127
+        //
+        // <7>    ???
+        //
+        // <6:0>  46 Ex-noise threshold for Squelch = open
+        //        0 ~ 127
+        //
+        BK4819_SCRIPT_SET(BK4819_REG_4F, ((uint16_t)SquelchCloseNoiseThresh << 8) | SquelchOpenNoiseThresh),
 
-    // REG_4F
-    //
-    // <14:8> 47 Ex-noise threshold for Squelch = close
-    //        0 ~ 127
-    //
-    // <7>    ???
-    //
-    // <6:0>  46 Ex-noise threshold for Squelch = open
-    //        0 ~ 127
-    //
-    BK4819_WriteRegister(BK4819_REG_4F, ((uint16_t)SquelchCloseNoiseThresh << 8) | SquelchOpenNoiseThresh);
+        // REG_78
+        //
+        // <15:8> 72 RSSI threshold for Squelch = open    0.5dB/step
+        //
+        // <7:0>  70 RSSI threshold for Squelch = close   0.5dB/step
+        //
+        BK4819_SCRIPT_SET(BK4819_REG_78, ((uint16_t)SquelchOpenRSSIThresh   << 8) | SquelchCloseRSSIThresh),
 
-    // REG_78
-    //
-    // <15:8> 72 RSSI threshold for Squelch = open    0.5dB/step
-    //
-    // <7:0>  70 RSSI threshold for Squelch = close   0.5dB/step
-    //
-    BK4819_WriteRegister(BK4819_REG_78, ((uint16_t)SquelchOpenRSSIThresh   << 8) | SquelchCloseRSSIThresh);
+        // BK4819_SetAF(BK4819_AF_MUTE)
+        BK4819_SCRIPT_SET(BK4819_REG_47, 0x6042 | (BK4819_AF_MUTE << 8)),
+    };
 
-    BK4819_SetAF(BK4819_AF_MUTE);
+    BK4819_ApplyScript(Script, ARRAY_SIZE(Script));
 
     BK4819_RX_TurnOn();
 }
@@ -860,37 +1187,41 @@ void BK4819_SetRegValue(RegisterSpec s, uint16_t v) {
 
 void BK4819_RX_TurnOn(void)
 {
-    // DSP Voltage Setting = 1
-    // ANA LDO = 2.7v
-    // VCO LDO = 2.7v
-    // RF LDO  = 2.7v
-    // PLL LDO = 2.7v
-    // ANA LDO bypass
-    // VCO LDO bypass
-    // RF LDO  bypass
-    // PLL LDO bypass
-    // Reserved bit is 1 instead of 0
-    // Enable  DSP
-    // Enable  XTAL
-    // Enable  Band Gap
-    //
-    BK4819_WriteRegister(BK4819_REG_37, 0x9F1F);  // 0001111100001111
-
-    // Turn off everything
-    BK4819_WriteRegister(BK4819_REG_30, 0);
-
+    static const BK4819_ScriptStep_t Script[] =
+    {
+        // DSP Voltage Setting = 1
+        // ANA LDO = 2.7v
+        // VCO LDO = 2.7v
+        // RF LDO  = 2.7v
+        // PLL LDO = 2.7v
+        // ANA LDO bypass
+        // VCO LDO bypass
+        // RF LDO  bypass
+        // PLL LDO bypass
+        // Reserved bit is 1 instead of 0
+        // Enable  DSP
+        // Enable  XTAL
+        // Enable  Band Gap
+        //
+        BK4819_SCRIPT_SET(BK4819_REG_37, 0x9F1F),  // 0001111100001111
+
+        // Turn off everything
+        BK4819_SCRIPT_SET(BK4819_REG_30, 0),
+
+        BK4819_SCRIPT_SET(BK4819_REG_30, 0xBFF1),
+            // BK4819_REG_30_ENABLE_VCO_CALIB |
+            // BK4819_REG_30_DISABLE_UNKNOWN |
+            // BK4819_REG_30_ENABLE_RX_LINK |
+            // BK4819_REG_30_ENABLE_AF_DAC |
+            // BK4819_REG_30_ENABLE_DISC_MODE |
+            // BK4819_REG_30_ENABLE_PLL_VCO |
+            // BK4819_REG_30_DISABLE_PA_GAIN |
+            // BK4819_REG_30_DISABLE_MIC_ADC |
+            // BK4819_REG_30_DISABLE_TX_DSP |
+            // BK4819_REG_30_ENABLE_RX_DSP );
+    };
 
-    BK4819_WriteRegister(BK4819_REG_30, 0xBFF1);
-        // BK4819_REG_30_ENABLE_VCO_CALIB |
-        // BK4819_REG_30_DISABLE_UNKNOWN |
-        // BK4819_REG_30_ENABLE_RX_LINK |
-        // BK4819_REG_30_ENABLE_AF_DAC |
-        // BK4819_REG_30_ENABLE_DISC_MODE |
-        // BK4819_REG_30_ENABLE_PLL_VCO |
-        // BK4819_REG_30_DISABLE_PA_GAIN |
-        // BK4819_REG_30_DISABLE_MIC_ADC |
-        // BK4819_REG_30_DISABLE_TX_DSP |
-        // BK4819_REG_30_ENABLE_RX_DSP );
+    BK4819_ApplyScript(Script, ARRAY_SIZE(Script));
 }
 
 void BK4819_PickRXFilterPathBasedOnFrequency(uint32_t Frequency)
@@ -967,10 +1298,10 @@ void BK4819_SetCompander(const unsigned int mode)
     const uint16_t compress_0dB      = 86;
     const uint16_t compress_noise_dB = 64;
 //  AB40  10 1010110 1000000
-    BK4819_WriteRegister(BK4819_REG_29, // (BK4819_ReadRegister(BK4819_REG_29) & ~(3u << 14)) | (compress_ratio << 14));
+    const uint16_t r29 = // (BK4819_ReadRegister(BK4819_REG_29) & ~(3u << 14)) | (compress_ratio << 14));
         (compress_ratio    << 14) |
         (compress_0dB      <<  7) |
-        (compress_noise_dB <<  0));
+        (compress_noise_dB <<  0);
 
     // REG_28
     //
@@ -988,13 +1319,19 @@ void BK4819_SetCompander(const unsigned int mode)
     const uint16_t expand_0dB      = 86;
     const uint16_t expand_noise_dB = 56;
 //  6B38  01 1010110 0111000
-    BK4819_WriteRegister(BK4819_REG_28, // (BK4819_ReadRegister(BK4819_REG_28) & ~(3u << 14)) | (expand_ratio << 14));
+    const uint16_t r28 = // (BK4819_ReadRegister(BK4819_REG_28) & ~(3u << 14)) | (expand_ratio << 14));
         (expand_ratio    << 14) |
         (expand_0dB      <<  7) |
-        (expand_noise_dB <<  0));
+        (expand_noise_dB <<  0);
+
+    const BK4819_ScriptStep_t Script[] =
+    {
+        BK4819_SCRIPT_SET(BK4819_REG_29, r29),
+        BK4819_SCRIPT_SET(BK4819_REG_28, r28),
+        BK4819_SCRIPT_MODIFY(BK4819_REG_31, 1u << 3, 1u << 3),  // enable
+    };
 
-    // enable
-    BK4819_WriteRegister(BK4819_REG_31, r31 | (1u << 3));
+    BK4819_ApplyScript(Script, ARRAY_SIZE(Script));
 }
 
 void BK4819_DisableVox(void)
@@ -1189,7 +1526,7 @@ void BK4819_ExitBypass(void)
     //         0 = bypass DC filter
     //
 
-    uint16_t regVal = BK4819_ReadRegister(BK4819_REG_7E);
+    uint16_t regVal = BK4819_ReadShadow(BK4819_REG_7E);
 
     // 0x302E / 0 011 000000 101 110
     BK4819_WriteRegister(BK4819_REG_7E, (regVal & ~(0b111 << 3))
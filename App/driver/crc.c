@@ -22,11 +22,15 @@ void CRC_Init(void)
 }
 
 uint16_t CRC_Calculate(const void *pBuffer, uint16_t Size)
+{
+    return CRC_Update(0, pBuffer, Size);
+}
+
+uint16_t CRC_Update(uint16_t Crc, const void *pBuffer, uint16_t Size)
 {
     const uint8_t *pData = (const uint8_t *)pBuffer;
-    uint16_t i, Crc;
+    uint16_t i;
 
-    Crc = 0;
     for (i = 0; i < Size; i++)
     {
         Crc ^= (pData[i] << 8);
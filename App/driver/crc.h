@@ -21,6 +21,8 @@
 
 void CRC_Init(void);
 uint16_t CRC_Calculate(const void *pBuffer, uint16_t Size);
+// Continues a CRC over more data, CRC_Calculate() starts from 0
+uint16_t CRC_Update(uint16_t Crc, const void *pBuffer, uint16_t Size);
 
 #endif
 
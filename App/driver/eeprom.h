@@ -17,10 +17,15 @@
 #ifndef DRIVER_EEPROM_H
 #define DRIVER_EEPROM_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 void EEPROM_ReadBuffer(uint16_t Address, void *pBuffer, uint8_t Size);
 void EEPROM_WriteBuffer(uint16_t Address, const void *pBuffer);
 
+// Flash address of an EEPROM address (0x1000000 in a hole) and how many of
+// Size bytes stay in that mapping. *pEnd tells whether they reach its end.
+void EEPROM_Translate(uint16_t Address, uint16_t Size, uint32_t *pFlashAddr, uint16_t *pSize, bool *pEnd);
+
 #endif
 
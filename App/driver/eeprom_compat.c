@@ -35,36 +35,59 @@ typedef struct
     uint16_t Size;
 } AddrMapping_t;
 
-#define _MK_MAPPING(PY25Q16_Addr, EEPROM_From, EEPROM_To) {PY25Q16_Addr, EEPROM_From, EEPROM_To - EEPROM_From}
+// Sorted by EEPROM addr, contiguous from 0x0000 to EEPROM_SIZE
+#define ADDR_MAPPING_LIST(X)          \
+    X(0x000000, 0x0000, 0x0c80)       \
+    X(0x001000, 0x0c80, 0x0d60)       \
+    X(0x002000, 0x0d60, 0x0e30)       \
+    X(HOLE_ADDR, 0x0e30, 0x0e40)      \
+    X(0x003000, 0x0e40, 0x0e68)       \
+    X(HOLE_ADDR, 0x0e68, 0x0e70)      \
+    X(0x004000, 0x0e70, 0x0e80)       \
+    X(0x005000, 0x0e80, 0x0e88)       \
+    X(0x006000, 0x0e88, 0x0e90)       \
+    X(0x007000, 0x0e90, 0x0ee0)       \
+    X(0x008000, 0x0ee0, 0x0f18)       \
+    X(0x009000, 0x0f18, 0x0f20)       \
+    X(HOLE_ADDR, 0x0f20, 0x0f30)      \
+    X(0x00a000, 0x0f30, 0x0f40)       \
+    X(0x00b000, 0x0f40, 0x0f48)       \
+    X(HOLE_ADDR, 0x0f48, 0x0f50)      \
+    X(0x00e000, 0x0f50, 0x1bd0)       \
+    X(HOLE_ADDR, 0x1bd0, 0x1c00)      \
+    X(0x00f000, 0x1c00, 0x1d00)       \
+    X(HOLE_ADDR, 0x1d00, 0x1e00)      \
+    X(0x010000, 0x1e00, 0x1f90)       \
+    X(HOLE_ADDR, 0x1f90, 0x1ff0)      \
+    X(0x00c000, 0x1ff0, 0x2000)
+
+#define EEPROM_SIZE 0x2000
+#define PAGE_SHIFT 5
+
+#define _MK_ENUM(PY25Q16_Addr, EEPROM_From, EEPROM_To) MAPPING_##EEPROM_From,
+#define _MK_MAPPING(PY25Q16_Addr, EEPROM_From, EEPROM_To) {PY25Q16_Addr, EEPROM_From, EEPROM_To - EEPROM_From},
+// Pages shared by several mappings get the last one, EEPROM_Translate() steps back
+#define _MK_PAGES(PY25Q16_Addr, EEPROM_From, EEPROM_To) \
+    [(EEPROM_From) >> PAGE_SHIFT ... ((EEPROM_To) - 1) >> PAGE_SHIFT] = MAPPING_##EEPROM_From,
+
+enum
+{
+    ADDR_MAPPING_LIST(_MK_ENUM)
+};
 
 static const AddrMapping_t ADDR_MAPPINGS[] = {
-    // Sorted by EEPROM addr
-    _MK_MAPPING(0x000000, 0x0000, 0x0c80),  //
-    _MK_MAPPING(0x001000, 0x0c80, 0x0d60),  //
-    _MK_MAPPING(0x002000, 0x0d60, 0x0e30),  //
-    _MK_MAPPING(HOLE_ADDR, 0x0e30, 0x0e40), //
-    _MK_MAPPING(0x003000, 0x0e40, 0x0e68),  //
-    _MK_MAPPING(HOLE_ADDR, 0x0e68, 0x0e70), //
-    _MK_MAPPING(0x004000, 0x0e70, 0x0e80),  //
-    _MK_MAPPING(0x005000, 0x0e80, 0x0e88),  //
-    _MK_MAPPING(0x006000, 0x0e88, 0x0e90),  //
-    _MK_MAPPING(0x007000, 0x0e90, 0x0ee0),  //
-    _MK_MAPPING(0x008000, 0x0ee0, 0x0f18),  //
-    _MK_MAPPING(0x009000, 0x0f18, 0x0f20),  //
-    _MK_MAPPING(HOLE_ADDR, 0x0f20, 0x0f30), //
-    _MK_MAPPING(0x00a000, 0x0f30, 0x0f40),  //
-    _MK_MAPPING(0x00b000, 0x0f40, 0x0f48),  //
-    _MK_MAPPING(HOLE_ADDR, 0x0f48, 0x0f50), //
-    _MK_MAPPING(0x00e000, 0x0f50, 0x1bd0),  //
-    _MK_MAPPING(HOLE_ADDR, 0x1bd0, 0x1c00), //
-    _MK_MAPPING(0x00f000, 0x1c00, 0x1d00),  //
-    _MK_MAPPING(HOLE_ADDR, 0x1d00, 0x1e00), //
-    _MK_MAPPING(0x010000, 0x1e00, 0x1f90),  //
-    _MK_MAPPING(HOLE_ADDR, 0x1f90, 0x1ff0), //
-    _MK_MAPPING(0x00c000, 0x1ff0, 0x2000),  //
+    ADDR_MAPPING_LIST(_MK_MAPPING)
 };
 
-static void AddrTranslate(uint16_t EEPROM_Addr, uint16_t Size, uint32_t *PY25Q16_Addr_out, uint16_t *Size_out, bool *End_out);
+// EEPROM address >> PAGE_SHIFT -> index in ADDR_MAPPINGS. The ranges of
+// neighbouring mappings overlap on the pages they share, and the later
+// initializer is the one meant to win there.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Woverride-init"
+static const uint8_t PAGE_MAPPINGS[EEPROM_SIZE >> PAGE_SHIFT] = {
+    ADDR_MAPPING_LIST(_MK_PAGES)
+};
+#pragma GCC diagnostic pop
 
 void EEPROM_ReadBuffer(uint16_t Address, void *pBuffer, uint8_t Size)
 {
@@ -72,7 +95,7 @@ void EEPROM_ReadBuffer(uint16_t Address, void *pBuffer, uint8_t Size)
     {
         uint32_t PY_Addr;
         uint16_t PY_Size;
-        AddrTranslate(Address, Size, &PY_Addr, &PY_Size, NULL);
+        EEPROM_Translate(Address, Size, &PY_Addr, &PY_Size, NULL);
         if (PY_Addr >= HOLE_ADDR)
         {
             memset(pBuffer, 0xff, PY_Size);
@@ -97,7 +120,7 @@ void EEPROM_WriteBuffer(uint16_t Address, const void *pBuffer)
         uint32_t PY_Addr;
         uint16_t PY_Size;
         bool AppendFlag;
-        AddrTranslate(Address, Size, &PY_Addr, &PY_Size, &AppendFlag);
+        EEPROM_Translate(Address, Size, &PY_Addr, &PY_Size, &AppendFlag);
         if (PY_Addr < HOLE_ADDR)
         {
             PY25Q16_WriteBuffer(PY_Addr, pBuffer, PY_Size, AppendFlag);
@@ -108,23 +131,21 @@ void EEPROM_WriteBuffer(uint16_t Address, const void *pBuffer)
     }
 }
 
-static void AddrTranslate(uint16_t EEPROM_Addr, uint16_t Size, uint32_t *PY25Q16_Addr_out, uint16_t *Size_out, bool *End_out)
+void EEPROM_Translate(uint16_t EEPROM_Addr, uint16_t Size, uint32_t *PY25Q16_Addr_out, uint16_t *Size_out, bool *End_out)
 {
-    const AddrMapping_t *p = NULL;
-    for (uint32_t i = 0, N = sizeof(ADDR_MAPPINGS) / sizeof(AddrMapping_t); i < N; i++)
+    if (EEPROM_Addr >= EEPROM_SIZE)
     {
-        p = ADDR_MAPPINGS + i;
-        if (p->EEPROM_Addr <= EEPROM_Addr && EEPROM_Addr < (p->EEPROM_Addr + p->Size))
-        {
-            goto HIT;
-        }
+        *PY25Q16_Addr_out = HOLE_ADDR;
+        *Size_out = Size;
+        return;
     }
 
-    *PY25Q16_Addr_out = HOLE_ADDR;
-    *Size_out = Size;
-    return;
+    const AddrMapping_t *p = ADDR_MAPPINGS + PAGE_MAPPINGS[EEPROM_Addr >> PAGE_SHIFT];
+    while (EEPROM_Addr < p->EEPROM_Addr)
+    {
+        p--;
+    }
 
-HIT:
     const uint16_t Off = EEPROM_Addr - p->EEPROM_Addr;
     const uint16_t Rem = p->Size - Off;
     if (Size > Rem)
@@ -32,6 +32,9 @@ enum GPIO_PINS
     GPIO_PIN_BACKLIGHT      = GPIO_MAKE_PIN(GPIOF, LL_GPIO_PIN_8),
     GPIO_PIN_FLASHLIGHT     = GPIO_MAKE_PIN(GPIOC, LL_GPIO_PIN_13),
     GPIO_PIN_AUDIO_PATH     = GPIO_MAKE_PIN(GPIOA, LL_GPIO_PIN_8),
+#ifdef ENABLE_BK4819_IRQ_EXTI
+    GPIO_PIN_BK4819_IRQ     = GPIO_MAKE_PIN(GPIOB, LL_GPIO_PIN_7),
+#endif
 };
 
 static inline void GPIO_SetOutputPin(uint32_t Pin)
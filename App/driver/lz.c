@@ -0,0 +1,187 @@
+#include "driver/lz.h"
+
+// Runs shorter than this go into literals
+#define MIN_FILL 4
+
+static void Flush(LZ_Decoder_t *pDecoder, LZ_Sink_t Sink)
+{
+    const uint32_t Start = pDecoder->Flushed % LZ_WINDOW;
+    const uint32_t Count = pDecoder->Position - pDecoder->Flushed;
+
+    if (Count)
+    {
+        Sink(pDecoder->Ring + Start, Count);
+        pDecoder->Flushed = pDecoder->Position;
+    }
+}
+
+static void Put(LZ_Decoder_t *pDecoder, uint8_t Byte, LZ_Sink_t Sink)
+{
+    pDecoder->Ring[pDecoder->Position % LZ_WINDOW] = Byte;
+    pDecoder->Position++;
+
+    // The ring is full up to its end, the next byte overwrites its start
+    if ((pDecoder->Position % LZ_WINDOW) == 0)
+    {
+        Flush(pDecoder, Sink);
+    }
+}
+
+void LZ_DecodeStart(LZ_Decoder_t *pDecoder)
+{
+    pDecoder->Position = 0;
+    pDecoder->Flushed  = 0;
+}
+
+bool LZ_Decode(LZ_Decoder_t *pDecoder, const uint8_t *pIn, uint32_t Size, uint32_t Limit, LZ_Sink_t Sink)
+{
+    const uint8_t *pEnd = pIn + Size;
+    bool           bOk  = true;
+
+    while (pIn < pEnd)
+    {
+        const uint8_t Control = *pIn++;
+        uint32_t      Count;
+
+        if (Control < 0x80)
+        {
+            Count = Control + 1u;
+            if (Count > (uint32_t)(pEnd - pIn) || Count > Limit - pDecoder->Position)
+            {
+                bOk = false;
+                break;
+            }
+            while (Count--)
+            {
+                Put(pDecoder, *pIn++, Sink);
+            }
+        }
+        else if (Control < 0xC0)
+        {
+            if (pEnd - pIn < 2)
+            {
+                bOk = false;
+                break;
+            }
+            Count = (((Control & 0x3Fu) << 8) | pIn[0]) + 1u;
+            if (Count > Limit - pDecoder->Position)
+            {
+                bOk = false;
+                break;
+            }
+            const uint8_t Value = pIn[1];
+            pIn += 2;
+            while (Count--)
+            {
+                Put(pDecoder, Value, Sink);
+            }
+        }
+        else
+        {
+            if (pEnd - pIn < 1)
+            {
+                bOk = false;
+                break;
+            }
+            const uint32_t Distance = *pIn++ + 1u;
+            Count = (Control & 0x3Fu) + LZ_MIN_MATCH;
+            if (Distance > pDecoder->Position || Count > Limit - pDecoder->Position)
+            {
+                bOk = false;
+                break;
+            }
+            while (Count--)
+            {
+                Put(pDecoder, pDecoder->Ring[(pDecoder->Position - Distance) % LZ_WINDOW], Sink);
+            }
+        }
+    }
+
+    Flush(pDecoder, Sink);
+    return bOk;
+}
+
+void LZ_EncodeStart(LZ_Encoder_t *pEncoder)
+{
+    pEncoder->Fill = 0;
+}
+
+static uint32_t PutFill(LZ_Encoder_t *pEncoder, uint8_t *pOut)
+{
+    const uint32_t n = pEncoder->Fill - 1;
+
+    pOut[0] = 0x80 | (n >> 8);
+    pOut[1] = n & 0xFF;
+    pOut[2] = pEncoder->Value;
+    pEncoder->Fill = 0;
+    return 3;
+}
+
+// Length of the run at p, up to Max
+static uint32_t RunLength(const uint8_t *p, uint32_t Max)
+{
+    uint32_t i = 1;
+    while (i < Max && p[i] == p[0])
+    {
+        i++;
+    }
+    return i;
+}
+
+uint32_t LZ_Encode(LZ_Encoder_t *pEncoder, const uint8_t *pIn, uint32_t Size, uint8_t *pOut, bool bEnd)
+{
+    uint32_t i   = 0;
+    uint32_t Out = 0;
+
+    while (i < Size)
+    {
+        if (pEncoder->Fill)
+        {
+            if (pIn[i] == pEncoder->Value && pEncoder->Fill < LZ_MAX_FILL)
+            {
+                pEncoder->Fill++;
+                i++;
+                continue;
+            }
+            Out += PutFill(pEncoder, pOut + Out);
+        }
+
+        const uint32_t Run = RunLength(pIn + i, Size - i);
+        if (Run >= MIN_FILL)
+        {
+            pEncoder->Fill  = Run;
+            pEncoder->Value = pIn[i];
+            i += Run;
+            continue;
+        }
+
+        // Literals up to the next run worth a fill
+        uint32_t j = i + Run;
+        while (j < Size && j - i < LZ_MAX_LITERAL)
+        {
+            const uint32_t Next = RunLength(pIn + j, Size - j);
+            if (Next >= MIN_FILL)
+            {
+                break;
+            }
+            j += Next;
+        }
+        if (j - i > LZ_MAX_LITERAL)
+        {
+            j = i + LZ_MAX_LITERAL;
+        }
+
+        pOut[Out++] = j - i - 1;
+        while (i < j)
+        {
+            pOut[Out++] = pIn[i++];
+        }
+    }
+
+    if (bEnd && pEncoder->Fill)
+    {
+        Out += PutFill(pEncoder, pOut + Out);
+    }
+
+    return Out;
+}
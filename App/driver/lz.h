@@ -0,0 +1,57 @@
+#ifndef DRIVER_LZ_H
+#define DRIVER_LZ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// A byte oriented LZ77 with run fills, for flash sectors going over the
+// serial link. Each token starts with a control byte:
+//
+//   0nnnnnnn                    literal, n + 1 bytes follow
+//   10nnnnnn nnnnnnnn vvvvvvvv  fill, n + 1 bytes of v
+//   11nnnnnn dddddddd           match, n + 3 bytes from d + 1 back
+//
+// Matches reach back LZ_WINDOW bytes at most, so the decoder gets by with
+// a ring of that size, which also buffers the output on its way to flash.
+// The encoder here only emits literals and fills, it is cheap enough to
+// run per 128 bytes as a sector is read.
+
+#define LZ_WINDOW      256
+
+#define LZ_MAX_LITERAL 128
+#define LZ_MAX_FILL    0x4000
+#define LZ_MIN_MATCH   3
+
+// Worst case output of LZ_Encode() for Size bytes in
+#define LZ_ENCODED_MAX(Size) ((Size) + (Size) / LZ_MAX_LITERAL + 4)
+
+typedef void (*LZ_Sink_t)(const void *pData, uint32_t Size);
+
+typedef struct
+{
+    uint8_t  Ring[LZ_WINDOW];
+    uint32_t Position;  // bytes decoded
+    uint32_t Flushed;   // bytes of them handed to the sink
+} LZ_Decoder_t;
+
+typedef struct
+{
+    uint32_t Fill;      // length of the run still open
+    uint8_t  Value;
+} LZ_Encoder_t;
+
+void LZ_DecodeStart(LZ_Decoder_t *pDecoder);
+
+// Decodes whole tokens, passing the output on as it goes, up to Limit
+// bytes in all. False if the input is broken, the output is then only
+// good up to where it went wrong.
+bool LZ_Decode(LZ_Decoder_t *pDecoder, const uint8_t *pIn, uint32_t Size, uint32_t Limit, LZ_Sink_t Sink);
+
+void LZ_EncodeStart(LZ_Encoder_t *pEncoder);
+
+// Encodes the next Size bytes into pOut, LZ_ENCODED_MAX(Size) at most. A
+// run reaching the end is kept open for the next call, bEnd closes it.
+// Returns the number of bytes written.
+uint32_t LZ_Encode(LZ_Encoder_t *pEncoder, const uint8_t *pIn, uint32_t Size, uint8_t *pOut, bool bEnd);
+
+#endif
@@ -14,9 +14,18 @@
  *     limitations under the License.
  */
 
+#include <assert.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "driver/py25q16.h"
+#ifdef ENABLE_SETTINGS_JOURNAL
+    #include "driver/py25q16_journal.h"
+#endif
+#include "driver/py25q16_snapshot.h"
+#ifdef ENABLE_FLASH_COMMIT
+    #include "driver/crc.h"
+#endif
 #include "driver/gpio.h"
 #include "py32f071_ll_bus.h"
 #include "py32f071_ll_system.h"
@@ -37,11 +46,154 @@
 #define SECTOR_SIZE 0x1000
 #define PAGE_SIZE 0x100
 
+// Read data (0x03) is good up to 55 MHz. SPI2 runs at PCLK / 2 = 24 MHz,
+// the highest it can, so Fast read (0x0B) would only add a dummy byte.
+#define READ_CMD 0x03
+// Reads shorter than this are polled, DMA setup costs more than it saves
+#define DMA_MIN_SIZE 16
+// Largest gap between two scatter segments that is clocked through rather
+// than paid for with a new command (CS cycle, command and address bytes)
+#define SCATTER_GAP 8
+
 static uint32_t SectorCacheAddr = 0x1000000;
 static uint8_t SectorCache[SECTOR_SIZE];
 static uint8_t BlackHole[1];
 static volatile bool TC_Flag;
 
+#ifdef ENABLE_FLASH_WRITE_BACK
+// Write-back cache: dirty 16 byte lines from any sector. A sector is
+// flushed with one erase and one program (or programs only, if no byte
+// needs an erase) by PY25Q16_Flush(), once writes stop for a while, once
+// the oldest change gets too old, or when no line is left.
+#define LINE_SIZE 16
+#define LINE_COUNT 16
+#define FLUSH_IDLE_500MS 2 // after the last write
+#define FLUSH_AGE_500MS 10 // after the first unflushed write
+
+typedef struct
+{
+    uint32_t Addr;
+    uint8_t Data[LINE_SIZE];
+} Line_t;
+
+static Line_t Lines[LINE_COUNT]; // Lines[0 .. DirtyLines - 1] are in use
+static uint8_t DirtyLines;
+static uint8_t FlushIdle_500ms;
+static uint8_t FlushAge_500ms;
+
+// A sector flush that needs an erase runs as a job: the erase is issued
+// and PY25Q16_TimeSlice10ms() then polls WIP and programs the non-blank
+// pages of SectorCache, one per tick. Until the job is done SectorCache
+// holds the content of JobHome (the sector itself, or the logical sector
+// a commit writes to a spare), and reads of it are served from there.
+typedef enum
+{
+    JOB_IDLE,
+    JOB_ERASE,
+    JOB_PROGRAM,
+} JobState_t;
+
+static JobState_t JobState;
+static uint32_t JobSector;
+static uint32_t JobHome;
+static uint32_t JobOffset; // next page to program
+#endif
+
+#ifdef ENABLE_FLASH_COMMIT
+#if !defined(ENABLE_FLASH_WRITE_BACK)
+    #error ENABLE_FLASH_COMMIT needs ENABLE_FLASH_WRITE_BACK
+#endif
+// Commits: the sectors of the EEPROM emulation (channels, names,
+// attributes, VFOs, calibration) are flushed all or nothing, up to
+// COMMIT_SECTORS of them at a time. They are not rewritten in place: a
+// flush writes the new content to spares, then appends a commit record to
+// a log that maps the sectors there. A power cut before the record is
+// complete leaves the old map. While the radio is idle, each mapped
+// sector is copied back home (a record marks the home as being rewritten,
+// another maps the sector home once done) and its spare is erased, so
+// that a flush finds erased spares and costs page programs only, and the
+// homes hold the current content for builds without commits.
+//
+// A record also keeps the CRC of each home it maps away. A home that no
+// longer matches at boot was rewritten by such a build meanwhile, and
+// then the homes win over the spares.
+//
+// Two log sectors are used like the journal pool: slot 0 holds a sequence
+// number and the whole map, the one with the highest valid sequence is
+// the active log. When it fills up, the map goes to the other one. The
+// magic there also marks the logs and spares as taken: they are only
+// taken over if a log has it (of any layout) or if all of them are blank,
+// else commits stay off and the flush is the plain one.
+#define COMMIT_END 0x011000
+#define COMMIT_SECTORS 8
+#define LOGICAL_COUNT (COMMIT_END / SECTOR_SIZE)
+#define SPARE_MASK 0xff000000u // sector numbers 0x18 to 0x1f
+#define LOG_A 0x11
+#define LOG_B 0x17
+#define FOLD 0x80 // in a record: the home is rewritten from this sector
+#define LAYOUT 2  // of the log, a checkpoint of another one is started over
+#define MAP_MAGIC 0x50414D43u    // "CMAP"
+#define COMMIT_MAGIC 0x54494D43u // "CMIT"
+
+typedef struct
+{
+    uint32_t Magic;
+    uint32_t Sequence;
+    uint16_t HomeCrc[LOGICAL_COUNT]; // of the homes mapped away
+    uint8_t Map[LOGICAL_COUNT];      // sector of each logical sector, | FOLD
+    uint8_t Layout;
+    uint8_t Reserved[2];
+    uint16_t Crc; // over the fields above
+} Checkpoint_t;
+
+typedef struct
+{
+    uint32_t Magic;
+    uint16_t HomeCrc[COMMIT_SECTORS]; // of the homes, as they are left
+    uint8_t Count;
+    uint8_t Home[COMMIT_SECTORS];   // logical sectors
+    uint8_t Sector[COMMIT_SECTORS]; // where they are from now on, | FOLD
+    uint8_t Reserved[25];
+    uint16_t Crc; // over the fields above
+} Commit_t;
+
+#define COMMIT_SLOTS (SECTOR_SIZE / sizeof(Commit_t))
+
+static bool Enabled; // the logs and spares are ours
+static uint8_t Map[LOGICAL_COUNT];
+static uint16_t HomeCrc[LOGICAL_COUNT];
+static uint32_t HomeKnown; // logical sectors with a HomeCrc[] to trust
+static uint32_t Folding;   // logical sectors whose home is being rewritten
+static uint8_t FoldSector = LOGICAL_COUNT; // the one a job rewrites
+static uint32_t Clean; // sectors known to be erased, by number
+static uint32_t Dirty; // unused sectors that may need an erase
+static uint8_t LogSector;
+static uint32_t LogSequence;
+static uint16_t NextRecord;
+
+static Commit_t Commit;
+static bool Committing;
+static uint8_t CommitIndex; // the sector being written, those before it are done
+
+static_assert(sizeof(Checkpoint_t) == 64);
+static_assert(sizeof(Commit_t) == 64);
+static_assert(0 == (SPARE_MASK & ((1u << LOG_A) | (1u << LOG_B))));
+#endif
+
+#ifdef ENABLE_UART_BULK
+// Sector writes: the new content of a whole sector comes in order, over
+// several calls, and each byte of it is programmed once as it comes. The
+// sector is erased up front; in the commit area a spare takes it instead
+// (one erased in the background already, as a rule) and a commit record
+// maps it once its last byte is in, so a write left unfinished keeps the
+// old content.
+#define BULK_IDLE 0x1000000
+
+static uint32_t BulkSector = BULK_IDLE; // the logical sector being written
+static uint32_t BulkTarget;             // where it goes
+static uint32_t BulkOffset;             // bytes written so far
+#endif
+
 static inline void CS_Assert()
 {
     GPIO_ResetOutputPin(CS_PIN);
@@ -210,6 +362,51 @@ static uint8_t SPI_WriteByte(uint8_t Value)
     return LL_SPI_ReceiveData8(SPIx);
 }
 
+// Polled transfer that keeps the next byte queued in the TX FIFO while the
+// current one shifts, so the bus does not idle between bytes. Tx or Rx may
+// be NULL to send 0xff or drop what is received.
+static void SPI_Transfer(const uint8_t *Tx, uint8_t *Rx, uint32_t Size)
+{
+    uint32_t Sent = 0;
+    uint32_t Received = 0;
+
+    while (Received < Size)
+    {
+        if (Sent < Size && Sent - Received < 2 && LL_SPI_IsActiveFlag_TXE(SPIx))
+        {
+            LL_SPI_TransmitData8(SPIx, Tx ? Tx[Sent] : 0xff);
+            Sent++;
+        }
+        if (Received < Sent && LL_SPI_IsActiveFlag_RXNE(SPIx))
+        {
+            const uint8_t Value = LL_SPI_ReceiveData8(SPIx);
+            if (Rx)
+            {
+                Rx[Received] = Value;
+            }
+            Received++;
+        }
+    }
+}
+
+static void SendReadCmd(uint32_t Addr)
+{
+    const uint8_t Cmd[4] = {READ_CMD, 0xff & (Addr >> 16), 0xff & (Addr >> 8), 0xff & Addr};
+    SPI_Transfer(Cmd, NULL, sizeof(Cmd));
+}
+
+static void ReadData(uint8_t *Buf, uint32_t Size)
+{
+    if (Size >= DMA_MIN_SIZE)
+    {
+        SPI_ReadBuf(Buf, Size);
+    }
+    else
+    {
+        SPI_Transfer(NULL, Buf, Size);
+    }
+}
+
 static void WriteAddr(uint32_t Addr);
 static uint8_t ReadStatusReg(uint32_t Which);
 static void WaitWIP();
@@ -217,198 +414,1487 @@ static void WriteEnable();
 static void SectorErase(uint32_t Addr);
 static void SectorProgram(uint32_t Addr, const uint8_t *Buf, uint32_t Size);
 static void PageProgram(uint32_t Addr, const uint8_t *Buf, uint32_t Size);
+static void StartSectorErase(uint32_t Addr);
+static void StartPageProgram(uint32_t Addr, const uint8_t *Buf, uint32_t Size);
+static void ReadBuffer(uint32_t Address, void *pBuffer, uint32_t Size);
+static bool IsDirect(uint32_t Address, uint32_t Size);
+static void EraseSector(uint32_t Address);
+#if defined(ENABLE_FLASH_WRITE_BACK) || defined(ENABLE_UART_BULK)
+static bool IsBlank(const uint8_t *p, uint32_t Size);
+#endif
+#ifdef ENABLE_FLASH_WRITE_BACK
+static void Overlay(uint32_t Address, uint8_t *pBuffer, uint32_t Size);
+static void FlushSector(uint32_t SecAddr, bool Async);
+static void FinishJob();
+static void DropLines(uint32_t SecAddr);
+#endif
+#ifdef ENABLE_FLASH_COMMIT
+static void LoadMap(void);
+static uint32_t Locate(uint32_t Address);
+static void CommitStep(void);
+static void FoldDone(void);
+static void AppendCommit(Commit_t *pCommit);
+#endif
+#if defined(ENABLE_FLASH_COMMIT) && defined(ENABLE_UART_BULK)
+static uint8_t TakeSpare(bool *pErase);
+static void FreeSpares(uint32_t Count);
+static uint16_t HomeCrcOf(uint8_t Logical);
+#endif
+static void WriteBuffer(uint32_t Address, const void *pBuffer, uint32_t Size, bool Append);
 
 void PY25Q16_Init()
 {
     CS_Release();
     SPI_Init();
+#ifdef ENABLE_FLASH_COMMIT
+    LoadMap();
+#endif
+#ifdef ENABLE_BOOT_SNAPSHOT
+    // SectorCache is free until the first flush, the snapshot restores
+    // the journal too
+    if (SNAPSHOT_Load(SectorCache))
+    {
+        return;
+    }
+#else
+    SNAPSHOT_Probe();
+#endif
+#ifdef ENABLE_SETTINGS_JOURNAL
+    JOURNAL_Mount();
+#endif
 }
 
 void PY25Q16_ReadBuffer(uint32_t Address, void *pBuffer, uint32_t Size)
 {
-#ifdef DEBUG
-    printf("spi flash read: %06x %ld\n", Address, Size);
-#endif
-    CS_Assert();
-
-    SPI_WriteByte(0x03); // Fast read
-    WriteAddr(Address);
-
-    if (Size >= 16)
+#ifdef ENABLE_BOOT_SNAPSHOT
+    if (SNAPSHOT_Read(Address, pBuffer, Size))
     {
-        SPI_ReadBuf((uint8_t *)pBuffer, Size);
+        return;
     }
-    else
+#endif
+#ifdef ENABLE_FLASH_WRITE_BACK
+    const uint32_t ReadAddr = Address;
+    uint8_t *const pRead = pBuffer;
+    const uint32_t ReadSize = Size;
+#endif
+#ifdef ENABLE_SETTINGS_JOURNAL
+    while (Size)
     {
-        for (uint32_t i = 0; i < Size; i++)
+        bool Journaled;
+        const uint32_t Span = JOURNAL_Span(Address, Size, &Journaled);
+        if (Journaled)
+        {
+            JOURNAL_Read(Address, pBuffer, Span);
+        }
+        else
         {
-            ((uint8_t *)(pBuffer))[i] = SPI_WriteByte(0xff);
+            ReadBuffer(Address, pBuffer, Span);
         }
+        Address += Span;
+        pBuffer += Span;
+        Size -= Span;
     }
-
-    CS_Release();
+#else
+    ReadBuffer(Address, pBuffer, Size);
+#endif
+#ifdef ENABLE_FLASH_WRITE_BACK
+    Overlay(ReadAddr, pRead, ReadSize);
+#endif
 }
 
 void PY25Q16_WriteBuffer(uint32_t Address, const void *pBuffer, uint32_t Size, bool Append)
 {
-#ifdef DEBUG
-    printf("spi flash write: %06x %ld %d\n", Address, Size, Append);
-#endif
-    uint32_t SecIndex = Address / SECTOR_SIZE;
-    uint32_t SecAddr = SecIndex * SECTOR_SIZE;
-    uint32_t SecOffset = Address % SECTOR_SIZE;
-    uint32_t SecSize = SECTOR_SIZE - SecOffset;
-
+    SNAPSHOT_Write(Address, pBuffer, Size);
+#ifdef ENABLE_SETTINGS_JOURNAL
+    // Append does not apply to the journal, it keeps the rest of the window
     while (Size)
     {
-        if (Size < SecSize)
+        bool Journaled;
+        const uint32_t Span = JOURNAL_Span(Address, Size, &Journaled);
+        if (Journaled)
         {
-            SecSize = Size;
+            JOURNAL_Write(Address, pBuffer, Span);
         }
-
-        if (SecAddr != SectorCacheAddr)
+        else
         {
-            PY25Q16_ReadBuffer(SecAddr, SectorCache, SECTOR_SIZE);
-            SectorCacheAddr = SecAddr;
+            WriteBuffer(Address, pBuffer, Span, Append);
         }
+        Address += Span;
+        pBuffer += Span;
+        Size -= Span;
+    }
+#else
+    WriteBuffer(Address, pBuffer, Size, Append);
+#endif
+}
 
-        if (0 != memcmp(pBuffer, (char *)SectorCache + SecOffset, SecSize))
-        {
-            bool Erase = false;
-            for (uint32_t i = 0; i < SecSize; i++)
-            {
-                if (0xff != SectorCache[SecOffset + i])
-                {
-                    Erase = true;
-                    break;
-                }
-            }
+void PY25Q16_SectorErase(uint32_t Address)
+{
+    SNAPSHOT_Write(Address - (Address % SECTOR_SIZE), NULL, SECTOR_SIZE);
+#ifdef ENABLE_SETTINGS_JOURNAL
+    if (JOURNAL_SectorErase(Address))
+    {
+        return;
+    }
+#endif
+#ifdef ENABLE_FLASH_WRITE_BACK
+    DropLines(Address - (Address % SECTOR_SIZE));
+#endif
+    EraseSector(Address);
+}
 
-            memcpy(SectorCache + SecOffset, pBuffer, SecSize);
+void PY25Q16_ReadScatter(const PY25Q16_Segment_t *pSegments, uint32_t Count)
+{
+    uint32_t i = 0;
+    while (i < Count)
+    {
+        const uint32_t From = pSegments[i].Address;
+        uint32_t To = From + pSegments[i].Size;
+        uint32_t j = i + 1;
 
-            if (Erase)
-            {
-                SectorErase(SecAddr);
-                if (Append)
-                {
-                    SectorProgram(SecAddr, SectorCache, SecOffset + SecSize);
-                    memset(SectorCache + SecOffset + SecSize, 0xff, SECTOR_SIZE - SecOffset - SecSize);
-                }
-                else
-                {
-                    SectorProgram(SecAddr, SectorCache, SECTOR_SIZE);
-                }
-            }
-            else
+        while (j < Count && pSegments[j].Address >= To && pSegments[j].Address - To <= SCATTER_GAP)
+        {
+            To = pSegments[j].Address + pSegments[j].Size;
+            j++;
+        }
+
+        if (j - i == 1 || !IsDirect(From, To - From))
+        {
+            for (; i < j; i++)
             {
-                SectorProgram(Address, pBuffer, SecSize);
+                PY25Q16_ReadBuffer(pSegments[i].Address, pSegments[i].pBuffer, pSegments[i].Size);
             }
+            continue;
         }
 
-        Address += SecSize;
-        pBuffer += SecSize;
-        Size -= SecSize;
+#ifdef DEBUG
+        printf("spi flash scatter read: %06x %ld %ld\n", From, To - From, j - i);
+#endif
+#ifdef ENABLE_FLASH_WRITE_BACK
+        if (JOB_IDLE != JobState)
+        {
+            WaitWIP();
+        }
+#endif
+        CS_Assert();
+#ifdef ENABLE_FLASH_COMMIT
+        SendReadCmd(Locate(From));
+#else
+        SendReadCmd(From);
+#endif
+        for (uint32_t Addr = From, k = i; k < j; k++)
+        {
+            SPI_Transfer(NULL, NULL, pSegments[k].Address - Addr);
+            ReadData(pSegments[k].pBuffer, pSegments[k].Size);
+            Addr = pSegments[k].Address + pSegments[k].Size;
+        }
+        CS_Release();
 
-        SecAddr += SECTOR_SIZE;
-        SecOffset = 0;
-        SecSize = SECTOR_SIZE;
-    } // while
+#ifdef ENABLE_FLASH_WRITE_BACK
+        for (; i < j; i++)
+        {
+            Overlay(pSegments[i].Address, pSegments[i].pBuffer, pSegments[i].Size);
+        }
+#endif
+        i = j;
+    }
 }
 
-void PY25Q16_SectorErase(uint32_t Address)
+#ifdef ENABLE_FLASH_WRITE_BACK
+void PY25Q16_ReserveLines(uint8_t Count)
 {
-    Address -= (Address % SECTOR_SIZE);
-    SectorErase(Address);
-    if (SectorCacheAddr == Address)
+    bool Flush = DirtyLines + Count > LINE_COUNT;
+#ifdef ENABLE_FLASH_COMMIT
+    // Count lines touch at most Count more sectors, all of them have to
+    // fit in the next commit
+    uint32_t Sectors = 0;
+    for (uint32_t i = 0; i < DirtyLines; i++)
     {
-        memset(SectorCache, 0xff, SECTOR_SIZE);
+        const uint32_t SecAddr = Lines[i].Addr - (Lines[i].Addr % SECTOR_SIZE);
+        uint32_t j = 0;
+        while (Lines[j].Addr - (Lines[j].Addr % SECTOR_SIZE) != SecAddr)
+        {
+            j++;
+        }
+        if (j == i && SecAddr < COMMIT_END)
+        {
+            Sectors++;
+        }
+    }
+    Flush = Flush || Sectors + Count > COMMIT_SECTORS;
+#endif
+    if (Flush)
+    {
+        PY25Q16_Flush();
     }
 }
 
-static inline void WriteAddr(uint32_t Addr)
+void PY25Q16_Flush(void)
 {
-    SPI_WriteByte(0xff & (Addr >> 16));
-    SPI_WriteByte(0xff & (Addr >> 8));
-    SPI_WriteByte(0xff & Addr);
+    FinishJob();
+    while (DirtyLines)
+    {
+        FlushSector(Lines[0].Addr - (Lines[0].Addr % SECTOR_SIZE), false);
+    }
+    FlushIdle_500ms = 0;
+    FlushAge_500ms = 0;
 }
 
-static uint8_t ReadStatusReg(uint32_t Which)
+void PY25Q16_TimeSlice10ms(void)
 {
-    uint8_t Cmd;
-    switch (Which)
+    if (JOB_IDLE == JobState || (1 & ReadStatusReg(0)))
     {
-    case 0:
-        Cmd = 0x5;
-        break;
-    case 1:
-        Cmd = 0x35;
-        break;
-    case 2:
-        Cmd = 0x15;
-        break;
-    default:
-        return 0;
+        return;
     }
 
-    CS_Assert();
-    SPI_WriteByte(Cmd);
-    uint8_t Value = SPI_WriteByte(0xff);
-    CS_Release();
+    if (JOB_ERASE == JobState)
+    {
+        JobState = JOB_PROGRAM;
+    }
 
-    return Value;
+    while (JobOffset < SECTOR_SIZE && IsBlank(SectorCache + JobOffset, PAGE_SIZE))
+    {
+        JobOffset += PAGE_SIZE;
+    }
+
+    if (JobOffset >= SECTOR_SIZE)
+    {
+        JobState = JOB_IDLE;
+#ifdef ENABLE_FLASH_COMMIT
+        if (Committing)
+        {
+            CommitStep();
+        }
+        else if (FoldSector < LOGICAL_COUNT)
+        {
+            FoldDone();
+        }
+#endif
+        return;
+    }
+
+    StartPageProgram(JobSector + JobOffset, SectorCache + JobOffset, PAGE_SIZE);
+    JobOffset += PAGE_SIZE;
 }
 
-static void WaitWIP()
+static void FlushTimeSlice(void)
 {
-    for (int i = 0; i < 1000000; i++)
+    if (!DirtyLines)
     {
-        uint8_t Status = ReadStatusReg(0);
-        if (1 & Status) // WIP
+        return;
+    }
+
+    if (FlushIdle_500ms)
+    {
+        FlushIdle_500ms--;
+    }
+    if (FlushAge_500ms)
+    {
+        FlushAge_500ms--;
+    }
+
+    // One sector per tick, in the background
+    if ((!FlushIdle_500ms || !FlushAge_500ms) && JOB_IDLE == JobState)
+    {
+        FlushSector(Lines[0].Addr - (Lines[0].Addr % SECTOR_SIZE), true);
+        if (DirtyLines)
         {
-            SYSTICK_DelayUs(10);
-            continue;
+            FlushIdle_500ms = 1;
+        }
+        else
+        {
+            FlushAge_500ms = 0;
         }
-        break;
     }
 }
+#endif
 
-static void WriteEnable()
+#if defined(ENABLE_FLASH_WRITE_BACK) || defined(ENABLE_BOOT_SNAPSHOT)
+void PY25Q16_TimeSlice500ms(void)
 {
-    CS_Assert();
-    SPI_WriteByte(0x6);
-    CS_Release();
+#ifdef ENABLE_FLASH_WRITE_BACK
+    FlushTimeSlice();
+    if (DirtyLines || JOB_IDLE != JobState)
+    {
+        return; // the snapshot has to match the flash
+    }
+#endif
+#ifdef ENABLE_BOOT_SNAPSHOT
+    if (SNAPSHOT_Due())
+    {
+        SectorCacheAddr = 0x1000000;
+        SNAPSHOT_Save(SectorCache);
+    }
+#endif
 }
+#endif
 
-static void SectorErase(uint32_t Addr)
+void PY25Q16_RawRead(uint32_t Address, void *pBuffer, uint32_t Size)
 {
-#ifdef DEBUG
-    printf("spi flash sector erase: %06x\n", Addr);
-#endif
-    WriteEnable();
-    WaitWIP();
+    ReadBuffer(Address, pBuffer, Size);
+}
 
-    CS_Assert();
-    SPI_WriteByte(0x20);
-    WriteAddr(Addr);
-    CS_Release();
+void PY25Q16_RawProgram(uint32_t Address, const void *pBuffer, uint32_t Size)
+{
+    if (SectorCacheAddr == Address - (Address % SECTOR_SIZE))
+    {
+        SectorCacheAddr = 0x1000000;
+    }
+    SectorProgram(Address, pBuffer, Size);
+}
 
-    WaitWIP();
+void PY25Q16_RawSectorErase(uint32_t Address)
+{
+    EraseSector(Address);
 }
 
-static void SectorProgram(uint32_t Addr, const uint8_t *Buf, uint32_t Size)
+#ifdef ENABLE_UART_BULK
+void PY25Q16_BeginSector(uint32_t Address)
 {
-    uint32_t Size1 = PAGE_SIZE - (Addr % PAGE_SIZE);
+    Address -= Address % SECTOR_SIZE;
+#ifdef ENABLE_FLASH_WRITE_BACK
+    FinishJob();
+    DropLines(Address);
+#endif
+#ifdef ENABLE_FLASH_COMMIT
+    if (BulkTarget != BulkSector && BULK_IDLE != BulkSector)
+    {
+        // The write left unfinished gives its spare back
+        Dirty |= 1u << (BulkTarget / SECTOR_SIZE);
+    }
+#endif
+    SNAPSHOT_Write(Address, NULL, SECTOR_SIZE);
+    if (SectorCacheAddr == Address)
+    {
+        SectorCacheAddr = 0x1000000;
+    }
 
-    while (Size)
+    BulkSector = Address;
+    BulkOffset = 0;
+#ifdef ENABLE_FLASH_COMMIT
+    if (Enabled && Address < COMMIT_END)
     {
-        if (Size < Size1)
+        bool Erase;
+        FreeSpares(1);
+        BulkTarget = TakeSpare(&Erase) * SECTOR_SIZE;
+        if (Erase)
         {
-            Size1 = Size;
+            SectorErase(BulkTarget);
         }
+        return;
+    }
+#endif
+    BulkTarget = Address;
+    SectorErase(Address);
+}
 
-        PageProgram(Addr, Buf, Size1);
-
-        Addr += Size1;
+void PY25Q16_WriteSector(const void *pBuffer, uint32_t Size)
+{
+    if (BULK_IDLE == BulkSector)
+    {
+        return;
+    }
+
+    if (Size > SECTOR_SIZE - BulkOffset)
+    {
+        Size = SECTOR_SIZE - BulkOffset;
+    }
+
+#ifdef ENABLE_FLASH_WRITE_BACK
+    // Writes to the sector meanwhile are overruled, they must not flush
+    // over it
+    DropLines(BulkSector);
+#endif
+
+    const uint8_t *pData = pBuffer;
+#ifdef ENABLE_SETTINGS_JOURNAL
+    for (uint32_t Off = 0; Off < Size;)
+    {
+        bool Journaled;
+        const uint32_t Span = JOURNAL_Span(BulkSector + BulkOffset + Off, Size - Off, &Journaled);
+        if (Journaled)
+        {
+            JOURNAL_Write(BulkSector + BulkOffset + Off, pData + Off, Span);
+        }
+        Off += Span;
+    }
+#endif
+
+    // Page by page, blank runs stay as erased
+    while (Size)
+    {
+        uint32_t Count = PAGE_SIZE - (BulkOffset % PAGE_SIZE);
+        if (Count > Size)
+        {
+            Count = Size;
+        }
+        if (!IsBlank(pData, Count))
+        {
+            PageProgram(BulkTarget + BulkOffset, pData, Count);
+        }
+        BulkOffset += Count;
+        pData += Count;
+        Size -= Count;
+    }
+
+    if (BulkOffset < SECTOR_SIZE)
+    {
+        return;
+    }
+
+#ifdef ENABLE_FLASH_COMMIT
+    if (BulkTarget != BulkSector)
+    {
+        Commit_t Record;
+        memset(&Record, 0xff, sizeof(Record));
+        Record.Magic = COMMIT_MAGIC;
+        Record.Count = 1;
+        Record.Home[0] = BulkSector / SECTOR_SIZE;
+        Record.Sector[0] = BulkTarget / SECTOR_SIZE;
+        FinishJob();
+        Record.HomeCrc[0] = HomeCrcOf(Record.Home[0]);
+        AppendCommit(&Record);
+    }
+#endif
+    // A save may have come in between
+    SNAPSHOT_Write(BulkSector, NULL, SECTOR_SIZE);
+    BulkSector = BULK_IDLE;
+}
+#endif
+
+// SectorErase() keeping SectorCache in step
+static void EraseSector(uint32_t Address)
+{
+    Address -= (Address % SECTOR_SIZE);
+#ifdef ENABLE_FLASH_COMMIT
+    FinishJob();
+    if (Address < COMMIT_END && Map[Address / SECTOR_SIZE] == Address / SECTOR_SIZE)
+    {
+        HomeKnown &= ~(1u << (Address / SECTOR_SIZE));
+    }
+    SectorErase(Locate(Address));
+#else
+    SectorErase(Address);
+#endif
+    if (SectorCacheAddr == Address)
+    {
+        memset(SectorCache, 0xff, SECTOR_SIZE);
+    }
+}
+
+static void FlashRead(uint32_t Address, void *pBuffer, uint32_t Size)
+{
+    CS_Assert();
+    SendReadCmd(Address);
+    ReadData(pBuffer, Size);
+    CS_Release();
+}
+
+#ifdef ENABLE_FLASH_COMMIT
+// Where a sector of the commit area is: the sectors a running commit has
+// written already are read from there
+static uint32_t Locate(uint32_t Address)
+{
+    if (Address >= COMMIT_END)
+    {
+        return Address;
+    }
+
+    const uint8_t Logical = Address / SECTOR_SIZE;
+    uint32_t Sector = Map[Logical];
+    for (uint32_t i = 0; Committing && i < CommitIndex; i++)
+    {
+        if (Commit.Home[i] == Logical)
+        {
+            Sector = Commit.Sector[i];
+        }
+    }
+    return Sector * SECTOR_SIZE + (Address % SECTOR_SIZE);
+}
+#endif
+
+static void ReadSpan(uint32_t Address, void *pBuffer, uint32_t Size)
+{
+#ifdef DEBUG
+    printf("spi flash read: %06x %ld\n", Address, Size);
+#endif
+#ifdef ENABLE_FLASH_WRITE_BACK
+    // The flash cannot be read while a job erases or programs it
+    if (JOB_IDLE != JobState)
+    {
+        if (JobHome <= Address && Address + Size <= JobHome + SECTOR_SIZE)
+        {
+            memcpy(pBuffer, SectorCache + (Address - JobHome), Size);
+            return;
+        }
+        if (Address < JobHome + SECTOR_SIZE && JobHome < Address + Size)
+        {
+            FinishJob();
+        }
+        else
+        {
+            WaitWIP();
+        }
+    }
+#endif
+#ifdef ENABLE_FLASH_COMMIT
+    Address = Locate(Address);
+#endif
+    FlashRead(Address, pBuffer, Size);
+}
+
+static void ReadBuffer(uint32_t Address, void *pBuffer, uint32_t Size)
+{
+#ifdef ENABLE_FLASH_COMMIT
+    // The commit area is mapped sector by sector
+    while (Address < COMMIT_END && Size > SECTOR_SIZE - (Address % SECTOR_SIZE))
+    {
+        const uint32_t Span = SECTOR_SIZE - (Address % SECTOR_SIZE);
+        ReadSpan(Address, pBuffer, Span);
+        Address += Span;
+        pBuffer += Span;
+        Size -= Span;
+    }
+#endif
+    ReadSpan(Address, pBuffer, Size);
+}
+
+// Whether a range can be read straight from the flash: not journaled, not
+// in the sector a background job is rewriting nor across two mapped ones
+static bool IsDirect(uint32_t Address, uint32_t Size)
+{
+#ifdef ENABLE_SETTINGS_JOURNAL
+    bool Journaled;
+    if (JOURNAL_Span(Address, Size, &Journaled) != Size || Journaled)
+    {
+        return false;
+    }
+#endif
+#ifdef ENABLE_FLASH_WRITE_BACK
+    if (JOB_IDLE != JobState && Address < JobHome + SECTOR_SIZE && JobHome < Address + Size)
+    {
+        return false;
+    }
+#endif
+#ifdef ENABLE_FLASH_COMMIT
+    if (Address < COMMIT_END && Address / SECTOR_SIZE != (Address + Size - 1) / SECTOR_SIZE)
+    {
+        return false;
+    }
+#endif
+    return true;
+}
+
+#if defined(ENABLE_FLASH_WRITE_BACK) || defined(ENABLE_UART_BULK)
+static bool IsBlank(const uint8_t *p, uint32_t Size)
+{
+    for (uint32_t i = 0; i < Size; i++)
+    {
+        if (0xff != p[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+#ifdef ENABLE_FLASH_WRITE_BACK
+static Line_t *FindLine(uint32_t LineAddr)
+{
+    for (uint32_t i = 0; i < DirtyLines; i++)
+    {
+        if (Lines[i].Addr == LineAddr)
+        {
+            return Lines + i;
+        }
+    }
+    return NULL;
+}
+
+static void Overlay(uint32_t Address, uint8_t *pBuffer, uint32_t Size)
+{
+    for (uint32_t i = 0; i < DirtyLines; i++)
+    {
+        const Line_t *pLine = Lines + i;
+        if (pLine->Addr + LINE_SIZE <= Address || Address + Size <= pLine->Addr)
+        {
+            continue;
+        }
+
+        const uint32_t From = pLine->Addr > Address ? pLine->Addr : Address;
+        const uint32_t To = (pLine->Addr + LINE_SIZE) < (Address + Size) ? (pLine->Addr + LINE_SIZE) : (Address + Size);
+        memcpy(pBuffer + (From - Address), pLine->Data + (From - pLine->Addr), To - From);
+    }
+}
+
+static void DropLines(uint32_t SecAddr)
+{
+    for (uint32_t i = 0; i < DirtyLines;)
+    {
+        if (Lines[i].Addr - (Lines[i].Addr % SECTOR_SIZE) == SecAddr)
+        {
+            Lines[i] = Lines[--DirtyLines];
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+// The sector with the most dirty lines, the one a flush frees most lines of
+static uint32_t BusiestSector()
+{
+    uint32_t Best = 0;
+    uint32_t BestCount = 0;
+
+    for (uint32_t i = 0; i < DirtyLines; i++)
+    {
+        const uint32_t SecAddr = Lines[i].Addr - (Lines[i].Addr % SECTOR_SIZE);
+        uint32_t Count = 0;
+        for (uint32_t j = 0; j < DirtyLines; j++)
+        {
+            if (Lines[j].Addr - (Lines[j].Addr % SECTOR_SIZE) == SecAddr)
+            {
+                Count++;
+            }
+        }
+        if (Count > BestCount)
+        {
+            Best = SecAddr;
+            BestCount = Count;
+        }
+    }
+
+    return Best;
+}
+
+static void FinishJob()
+{
+    while (JOB_IDLE != JobState)
+    {
+        PY25Q16_TimeSlice10ms();
+        SYSTICK_DelayUs(10);
+    }
+}
+
+static void StartJob(uint32_t Sector, uint32_t Home, bool Erase)
+{
+    JobSector = Sector;
+    JobHome = Home;
+    JobOffset = 0;
+    if (Erase)
+    {
+        StartSectorErase(Sector);
+        JobState = JOB_ERASE;
+    }
+    else
+    {
+        JobState = JOB_PROGRAM;
+    }
+}
+
+// Loads the sector into SectorCache, merges its dirty lines into it and
+// drops them. Returns whether the flash needs an erase for the result,
+// pChanged (if not NULL) gets a bit per line that differs.
+static bool MergeLines(uint32_t SecAddr, uint32_t *pChanged)
+{
+    if (SecAddr != SectorCacheAddr)
+    {
+#ifdef ENABLE_BOOT_SNAPSHOT
+        SNAPSHOT_Release();
+#endif
+        ReadBuffer(SecAddr, SectorCache, SECTOR_SIZE);
+        SectorCacheAddr = SecAddr;
+    }
+
+    bool Erase = false;
+    for (uint32_t i = 0; i < DirtyLines && !Erase; i++)
+    {
+        if (Lines[i].Addr - (Lines[i].Addr % SECTOR_SIZE) != SecAddr)
+        {
+            continue;
+        }
+
+        const uint8_t *pOld = SectorCache + (Lines[i].Addr % SECTOR_SIZE);
+        for (uint32_t j = 0; j < LINE_SIZE; j++)
+        {
+            if (pOld[j] != Lines[i].Data[j] && 0xff != pOld[j])
+            {
+                Erase = true;
+                break;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < DirtyLines; i++)
+    {
+        if (Lines[i].Addr - (Lines[i].Addr % SECTOR_SIZE) != SecAddr)
+        {
+            continue;
+        }
+
+        const uint32_t Line = (Lines[i].Addr % SECTOR_SIZE) / LINE_SIZE;
+        uint8_t *pOld = SectorCache + (Lines[i].Addr % SECTOR_SIZE);
+        if (pChanged && 0 != memcmp(pOld, Lines[i].Data, LINE_SIZE))
+        {
+            pChanged[Line / 32] |= 1u << (Line % 32);
+        }
+        memcpy(pOld, Lines[i].Data, LINE_SIZE);
+    }
+
+    DropLines(SecAddr);
+
+    return Erase;
+}
+
+#ifdef ENABLE_FLASH_COMMIT
+static bool IsErased(uint32_t Address)
+{
+    bool Erased = true;
+
+    CS_Assert();
+    SendReadCmd(Address);
+    for (uint32_t i = 0; i < SECTOR_SIZE && Erased; i += LINE_SIZE)
+    {
+        uint8_t Data[LINE_SIZE];
+        SPI_Transfer(NULL, Data, LINE_SIZE);
+        Erased = IsBlank(Data, LINE_SIZE);
+    }
+    CS_Release();
+
+    return Erased;
+}
+
+static uint16_t SectorCrc(uint32_t Address)
+{
+    uint16_t Crc = 0;
+
+    CS_Assert();
+    SendReadCmd(Address);
+    for (uint32_t i = 0; i < SECTOR_SIZE; i += LINE_SIZE)
+    {
+        uint8_t Data[LINE_SIZE];
+        SPI_Transfer(NULL, Data, LINE_SIZE);
+        Crc = CRC_Update(Crc, Data, LINE_SIZE);
+    }
+    CS_Release();
+
+    return Crc;
+}
+
+// The CRC of a home, read once per boot unless a fold has left it known
+static uint16_t HomeCrcOf(uint8_t Logical)
+{
+    if (!(HomeKnown & (1u << Logical)))
+    {
+        HomeCrc[Logical] = SectorCrc(Logical * SECTOR_SIZE);
+        HomeKnown |= 1u << Logical;
+    }
+    return HomeCrc[Logical];
+}
+
+// A spare for the sector being committed, an erased one if there is one
+static uint8_t TakeSpare(bool *pErase)
+{
+    uint32_t Mask = Clean & SPARE_MASK;
+    *pErase = !Mask;
+    if (!Mask)
+    {
+        Mask = Dirty & SPARE_MASK;
+    }
+
+    const uint8_t Sector = __builtin_ctz(Mask);
+    Clean &= ~(1u << Sector);
+    Dirty &= ~(1u << Sector);
+    return Sector;
+}
+
+static void ApplyCommit(const Commit_t *pCommit)
+{
+    for (uint32_t i = 0; i < pCommit->Count; i++)
+    {
+        const uint8_t Logical = pCommit->Home[i];
+        const uint32_t Bit = 1u << Logical;
+
+        if (pCommit->Sector[i] & FOLD)
+        {
+            // Nothing to check the home against until the fold is done
+            Folding |= Bit;
+            HomeKnown &= ~Bit;
+            continue;
+        }
+
+        if (Map[Logical] != Logical)
+        {
+            Dirty |= 1u << Map[Logical];
+        }
+        Map[Logical] = pCommit->Sector[i];
+        if (Map[Logical] == Logical)
+        {
+            Folding &= ~Bit;
+        }
+        HomeCrc[Logical] = pCommit->HomeCrc[i];
+        HomeKnown |= Bit;
+    }
+}
+
+// A sector can be mapped to its home or to a spare
+static bool IsValidSector(uint8_t Logical, uint8_t Sector)
+{
+    return Logical < LOGICAL_COUNT && (Sector == Logical || (Sector < 32 && (SPARE_MASK & (1u << Sector))));
+}
+
+static bool IsValidCommit(const Commit_t *pCommit)
+{
+    if (COMMIT_MAGIC != pCommit->Magic || !pCommit->Count || pCommit->Count > COMMIT_SECTORS ||
+        CRC_Calculate(pCommit, offsetof(Commit_t, Crc)) != pCommit->Crc)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < pCommit->Count; i++)
+    {
+        if (!IsValidSector(pCommit->Home[i], pCommit->Sector[i] & ~FOLD))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The log is full: the map starts the other log sector, the full one is
+// erased later
+static void SwitchLog(void)
+{
+    const uint8_t Next = LOG_A + LOG_B - LogSector;
+    if (!(Clean & (1u << Next)))
+    {
+        SectorErase(Next * SECTOR_SIZE);
+    }
+    Clean &= ~(1u << Next);
+    Dirty &= ~(1u << Next);
+
+    Checkpoint_t Checkpoint;
+    memset(&Checkpoint, 0xff, sizeof(Checkpoint));
+    Checkpoint.Magic = MAP_MAGIC;
+    Checkpoint.Sequence = ++LogSequence;
+    Checkpoint.Layout = LAYOUT;
+    memcpy(Checkpoint.HomeCrc, HomeCrc, sizeof(HomeCrc));
+    for (uint32_t i = 0; i < LOGICAL_COUNT; i++)
+    {
+        Checkpoint.Map[i] = Map[i] | ((Folding & (1u << i)) ? FOLD : 0);
+    }
+    Checkpoint.Crc = CRC_Calculate(&Checkpoint, offsetof(Checkpoint_t, Crc));
+    PageProgram(Next * SECTOR_SIZE, (const uint8_t *)&Checkpoint, sizeof(Checkpoint));
+
+    Dirty |= 1u << LogSector;
+    LogSector = Next;
+    NextRecord = 1;
+}
+
+// A record for one sector, Sector may carry FOLD
+static void AppendOne(uint8_t Logical, uint8_t Sector, uint16_t Crc)
+{
+    Commit_t Record;
+
+    memset(&Record, 0xff, sizeof(Record));
+    Record.Magic = COMMIT_MAGIC;
+    Record.Count = 1;
+    Record.Home[0] = Logical;
+    Record.Sector[0] = Sector;
+    Record.HomeCrc[0] = Crc;
+    AppendCommit(&Record);
+}
+
+// Copies a sector back home from its spare. A record marks the home as
+// being rewritten first, SectorCache serves the sector meanwhile.
+static void StartFold(uint8_t Logical)
+{
+    if (!(Folding & (1u << Logical)))
+    {
+        AppendOne(Logical, Map[Logical] | FOLD, HomeCrc[Logical]);
+    }
+
+#ifdef ENABLE_BOOT_SNAPSHOT
+    SNAPSHOT_Release();
+#endif
+    FlashRead(Map[Logical] * SECTOR_SIZE, SectorCache, SECTOR_SIZE);
+    SectorCacheAddr = Logical * SECTOR_SIZE;
+    FoldSector = Logical;
+    StartJob(Logical * SECTOR_SIZE, Logical * SECTOR_SIZE, true);
+}
+
+// Called once the job of a fold is done: the sector is mapped home again
+static void FoldDone(void)
+{
+    const uint8_t Logical = FoldSector;
+
+    FoldSector = LOGICAL_COUNT;
+    AppendOne(Logical, Logical, CRC_Calculate(SectorCache, SECTOR_SIZE));
+}
+
+// Folds sectors home until there are Count spares
+static void FreeSpares(uint32_t Count)
+{
+    while ((uint32_t)__builtin_popcount((Clean | Dirty) & SPARE_MASK) < Count)
+    {
+        uint8_t Logical = 0;
+        while (Map[Logical] == Logical)
+        {
+            Logical++;
+        }
+        StartFold(Logical);
+        FinishJob();
+    }
+}
+
+// Merges the lines of the current sector and writes the result to a
+// spare, SectorCache serves the sector meanwhile
+static void StartSector(void)
+{
+    const uint32_t Home = Commit.Home[CommitIndex] * SECTOR_SIZE;
+    bool Erase;
+
+    Commit.HomeCrc[CommitIndex] = HomeCrcOf(Commit.Home[CommitIndex]);
+    MergeLines(Home, NULL);
+    Commit.Sector[CommitIndex] = TakeSpare(&Erase);
+    StartJob(Commit.Sector[CommitIndex] * SECTOR_SIZE, Home, Erase);
+}
+
+// The sector and the other dirty sectors of the commit area, as one commit
+static void StartCommit(uint32_t SecAddr)
+{
+    if (NextRecord >= COMMIT_SLOTS)
+    {
+        SwitchLog();
+    }
+
+    // There are COMMIT_SECTORS spares, a sector write may hold one
+    uint8_t Limit = COMMIT_SECTORS;
+#ifdef ENABLE_UART_BULK
+    if (BulkSector < COMMIT_END)
+    {
+        Limit--;
+    }
+#endif
+
+    memset(&Commit, 0xff, sizeof(Commit));
+    Commit.Magic = COMMIT_MAGIC;
+    Commit.Count = 1;
+    Commit.Home[0] = SecAddr / SECTOR_SIZE;
+    for (uint32_t i = 0; i < DirtyLines && Commit.Count < Limit; i++)
+    {
+        const uint8_t Logical = Lines[i].Addr / SECTOR_SIZE;
+        uint32_t j = 0;
+        while (j < Commit.Count && Commit.Home[j] != Logical)
+        {
+            j++;
+        }
+        if (j == Commit.Count && Lines[i].Addr < COMMIT_END)
+        {
+            Commit.Home[Commit.Count++] = Logical;
+        }
+    }
+
+    // Back to back flushes may find the spares still mapped
+    FreeSpares(Commit.Count);
+
+    Committing = true;
+    CommitIndex = 0;
+    StartSector();
+}
+
+// Called once the job of the current sector is done
+static void CommitStep(void)
+{
+    if (++CommitIndex < Commit.Count)
+    {
+        StartSector();
+        return;
+    }
+
+    // All sectors are written, the record switches to them
+    AppendCommit(&Commit);
+    Committing = false;
+}
+
+static void AppendCommit(Commit_t *pCommit)
+{
+    if (NextRecord >= COMMIT_SLOTS)
+    {
+        SwitchLog();
+    }
+
+    pCommit->Crc = CRC_Calculate(pCommit, offsetof(Commit_t, Crc));
+    PageProgram(LogSector * SECTOR_SIZE + NextRecord * sizeof(Commit_t), (const uint8_t *)pCommit, sizeof(*pCommit));
+    NextRecord++;
+    ApplyCommit(pCommit);
+}
+
+static bool ReadCheckpoint(uint8_t Sector, Checkpoint_t *pCheckpoint)
+{
+    FlashRead(Sector * SECTOR_SIZE, pCheckpoint, sizeof(*pCheckpoint));
+    if (MAP_MAGIC != pCheckpoint->Magic || CRC_Calculate(pCheckpoint, offsetof(Checkpoint_t, Crc)) != pCheckpoint->Crc ||
+        LAYOUT != pCheckpoint->Layout)
+    {
+        return false;
+    }
+
+    uint32_t Used = 0;
+    for (uint8_t i = 0; i < LOGICAL_COUNT; i++)
+    {
+        const uint8_t Sector = pCheckpoint->Map[i] & ~FOLD;
+        if (!IsValidSector(i, Sector) || (Used & (1u << Sector)))
+        {
+            return false;
+        }
+        Used |= 1u << Sector;
+    }
+    return true;
+}
+
+// Whether the logs and spares can be taken without a valid checkpoint:
+// a log has the magic, the log to start is then the other one, or they
+// are all blank
+static bool IsClaimable(void)
+{
+    uint32_t Magic;
+
+    FlashRead(LOG_A * SECTOR_SIZE, &Magic, sizeof(Magic));
+    if (MAP_MAGIC == Magic)
+    {
+        LogSector = LOG_A;
+        return true;
+    }
+    FlashRead(LOG_B * SECTOR_SIZE, &Magic, sizeof(Magic));
+    if (MAP_MAGIC == Magic)
+    {
+        return true;
+    }
+
+    const uint32_t Region = SPARE_MASK | (1u << LOG_A) | (1u << LOG_B);
+    for (uint32_t Sector = 0; Sector < 32; Sector++)
+    {
+        if ((Region & (1u << Sector)) && !IsErased(Sector * SECTOR_SIZE))
+        {
+            return false;
+        }
+    }
+    Clean = Region;
+    return true;
+}
+
+// The map of the active log and the commits after it. A commit cut short
+// left its record incomplete, so the spares it wrote are not in the map
+// and just get erased again. A fold cut short is done again.
+static void LoadMap(void)
+{
+    Checkpoint_t A;
+    Checkpoint_t B;
+    const bool ValidA = ReadCheckpoint(LOG_A, &A);
+    const bool ValidB = ReadCheckpoint(LOG_B, &B);
+
+    for (uint32_t i = 0; i < LOGICAL_COUNT; i++)
+    {
+        Map[i] = i;
+    }
+    Folding = 0;
+    Clean = 0;
+    Dirty = (1u << LOG_A) | (1u << LOG_B);
+
+    LogSector = LOG_B;
+    LogSequence = 0;
+    NextRecord = COMMIT_SLOTS;
+
+    if (!ValidA && !ValidB)
+    {
+        Enabled = IsClaimable();
+        if (!Enabled)
+        {
+            Dirty = 0;
+            return;
+        }
+
+        // The checkpoint goes out before anything is erased, so that the
+        // region stays marked
+        SwitchLog();
+    }
+    else
+    {
+        Enabled = true;
+        const Checkpoint_t *pActive = ValidA && (!ValidB || (int32_t)(A.Sequence - B.Sequence) > 0) ? &A : &B;
+        LogSector = pActive == &A ? LOG_A : LOG_B;
+        LogSequence = pActive->Sequence;
+        memcpy(HomeCrc, pActive->HomeCrc, sizeof(HomeCrc));
+        for (uint32_t i = 0; i < LOGICAL_COUNT; i++)
+        {
+            Map[i] = pActive->Map[i] & ~FOLD;
+            if (pActive->Map[i] & FOLD)
+            {
+                Folding |= 1u << i;
+            }
+        }
+        Dirty &= ~(1u << LogSector);
+
+        FlashRead(LogSector * SECTOR_SIZE, SectorCache, SECTOR_SIZE);
+        while (NextRecord > 1 && IsBlank(SectorCache + (NextRecord - 1) * sizeof(Commit_t), sizeof(Commit_t)))
+        {
+            NextRecord--;
+        }
+        for (uint32_t i = 1; i < NextRecord; i++)
+        {
+            Commit_t Record;
+            memcpy(&Record, SectorCache + i * sizeof(Commit_t), sizeof(Record));
+            if (IsValidCommit(&Record))
+            {
+                ApplyCommit(&Record);
+            }
+        }
+    }
+
+    // Every spare that is not mapped is free
+    uint32_t Used = 0;
+    for (uint32_t i = 0; i < LOGICAL_COUNT; i++)
+    {
+        Used |= 1u << Map[i];
+    }
+    Dirty = (Dirty & ~SPARE_MASK) | (SPARE_MASK & ~Used & ~Clean);
+
+    // A build without commits may have rewritten homes meanwhile. It only
+    // saw the homes, so if one changed, they all win over the spares.
+    uint32_t Away = 0;
+    bool Changed = false;
+    for (uint8_t i = 0; i < LOGICAL_COUNT; i++)
+    {
+        if (Map[i] != i && !(Folding & (1u << i)))
+        {
+            Away |= 1u << i;
+            Changed = Changed || SectorCrc(i * SECTOR_SIZE) != HomeCrc[i];
+        }
+    }
+
+    HomeKnown = Away;
+    for (uint8_t i = 0; Changed && i < LOGICAL_COUNT; i++)
+    {
+        if (Away & (1u << i))
+        {
+            AppendOne(i, i, SectorCrc(i * SECTOR_SIZE));
+        }
+    }
+}
+
+void PY25Q16_EraseSpares(void)
+{
+    if (JOB_IDLE != JobState)
+    {
+        return;
+    }
+
+    // One fold or one erase per call
+    for (uint8_t i = 0; i < LOGICAL_COUNT; i++)
+    {
+        if (Map[i] != i)
+        {
+            StartFold(i);
+            return;
+        }
+    }
+
+    if (!Dirty)
+    {
+        return;
+    }
+
+    // A blank check (a 4 KB read), and an erase in the background if it
+    // is not blank
+    const uint8_t Sector = __builtin_ctz(Dirty);
+    Dirty &= ~(1u << Sector);
+    Clean |= 1u << Sector;
+    if (!IsErased(Sector * SECTOR_SIZE))
+    {
+        StartJob(Sector * SECTOR_SIZE, 0x1000000, true);
+        JobOffset = SECTOR_SIZE; // nothing to program
+    }
+}
+#endif
+
+static void FlushSector(uint32_t SecAddr, bool Async)
+{
+#ifdef DEBUG
+    printf("spi flash flush: %06x %d\n", SecAddr, Async);
+#endif
+    FinishJob();
+
+#ifdef ENABLE_FLASH_COMMIT
+    if (Enabled && SecAddr < COMMIT_END)
+    {
+        StartCommit(SecAddr);
+        if (!Async)
+        {
+            FinishJob();
+        }
+        return;
+    }
+#endif
+
+    uint32_t Changed[SECTOR_SIZE / LINE_SIZE / 32] = {0};
+    const bool Erase = MergeLines(SecAddr, Changed);
+
+    // Without an erase, runs of adjacent changed lines go out in one
+    // program each (split at pages), a sequential write costs one per page
+    for (uint32_t Line = 0; !Erase && Line < SECTOR_SIZE / LINE_SIZE;)
+    {
+        uint32_t End = Line;
+        while (End < SECTOR_SIZE / LINE_SIZE && (Changed[End / 32] & (1u << (End % 32))))
+        {
+            End++;
+        }
+
+        if (End > Line)
+        {
+            SectorProgram(SecAddr + Line * LINE_SIZE, SectorCache + Line * LINE_SIZE, (End - Line) * LINE_SIZE);
+            Line = End;
+        }
+        else
+        {
+            Line++;
+        }
+    }
+
+    if (Erase)
+    {
+        StartJob(SecAddr, SecAddr, true);
+        if (!Async)
+        {
+            FinishJob();
+        }
+    }
+}
+
+static void WriteBuffer(uint32_t Address, const void *pBuffer, uint32_t Size, bool Append)
+{
+#ifdef DEBUG
+    printf("spi flash write: %06x %ld %d\n", Address, Size, Append);
+#endif
+    // Append only spared programming the tail of an erased sector, the
+    // flush skips blank pages instead
+    (void)Append;
+
+    const uint8_t *pData = pBuffer;
+    while (Size)
+    {
+        const uint32_t LineAddr = Address - (Address % LINE_SIZE);
+        const uint32_t Off = Address - LineAddr;
+        uint32_t Count = LINE_SIZE - Off;
+        if (Count > Size)
+        {
+            Count = Size;
+        }
+
+        Line_t *pLine = FindLine(LineAddr);
+        if (!pLine)
+        {
+            uint8_t Current[LINE_SIZE];
+            if (SectorCacheAddr == LineAddr - (LineAddr % SECTOR_SIZE))
+            {
+                memcpy(Current, SectorCache + (LineAddr % SECTOR_SIZE), LINE_SIZE);
+            }
+            else
+            {
+                ReadBuffer(LineAddr, Current, LINE_SIZE);
+            }
+
+            if (0 != memcmp(Current + Off, pData, Count))
+            {
+                if (DirtyLines == LINE_COUNT)
+                {
+                    FlushSector(BusiestSector(), true);
+                }
+                pLine = Lines + DirtyLines++;
+                pLine->Addr = LineAddr;
+                memcpy(pLine->Data, Current, LINE_SIZE);
+            }
+        }
+
+        if (pLine)
+        {
+            memcpy(pLine->Data + Off, pData, Count);
+            FlushIdle_500ms = FLUSH_IDLE_500MS;
+            if (!FlushAge_500ms)
+            {
+                FlushAge_500ms = FLUSH_AGE_500MS;
+            }
+        }
+
+        Address += Count;
+        pData += Count;
+        Size -= Count;
+    }
+}
+#else
+static void WriteBuffer(uint32_t Address, const void *pBuffer, uint32_t Size, bool Append)
+{
+#ifdef DEBUG
+    printf("spi flash write: %06x %ld %d\n", Address, Size, Append);
+#endif
+    uint32_t SecIndex = Address / SECTOR_SIZE;
+    uint32_t SecAddr = SecIndex * SECTOR_SIZE;
+    uint32_t SecOffset = Address % SECTOR_SIZE;
+    uint32_t SecSize = SECTOR_SIZE - SecOffset;
+
+    while (Size)
+    {
+        if (Size < SecSize)
+        {
+            SecSize = Size;
+        }
+
+        if (SecAddr != SectorCacheAddr)
+        {
+#ifdef ENABLE_BOOT_SNAPSHOT
+            SNAPSHOT_Release();
+#endif
+            PY25Q16_ReadBuffer(SecAddr, SectorCache, SECTOR_SIZE);
+            SectorCacheAddr = SecAddr;
+        }
+
+        if (0 != memcmp(pBuffer, (char *)SectorCache + SecOffset, SecSize))
+        {
+            bool Erase = false;
+            for (uint32_t i = 0; i < SecSize; i++)
+            {
+                if (0xff != SectorCache[SecOffset + i])
+                {
+                    Erase = true;
+                    break;
+                }
+            }
+
+            memcpy(SectorCache + SecOffset, pBuffer, SecSize);
+
+            if (Erase)
+            {
+                SectorErase(SecAddr);
+                if (Append)
+                {
+                    SectorProgram(SecAddr, SectorCache, SecOffset + SecSize);
+                    memset(SectorCache + SecOffset + SecSize, 0xff, SECTOR_SIZE - SecOffset - SecSize);
+                }
+                else
+                {
+                    SectorProgram(SecAddr, SectorCache, SECTOR_SIZE);
+                }
+            }
+            else
+            {
+                SectorProgram(Address, pBuffer, SecSize);
+            }
+        }
+
+        Address += SecSize;
+        pBuffer += SecSize;
+        Size -= SecSize;
+
+        SecAddr += SECTOR_SIZE;
+        SecOffset = 0;
+        SecSize = SECTOR_SIZE;
+    } // while
+}
+#endif
+
+static inline void WriteAddr(uint32_t Addr)
+{
+    SPI_WriteByte(0xff & (Addr >> 16));
+    SPI_WriteByte(0xff & (Addr >> 8));
+    SPI_WriteByte(0xff & Addr);
+}
+
+static uint8_t ReadStatusReg(uint32_t Which)
+{
+    uint8_t Cmd;
+    switch (Which)
+    {
+    case 0:
+        Cmd = 0x5;
+        break;
+    case 1:
+        Cmd = 0x35;
+        break;
+    case 2:
+        Cmd = 0x15;
+        break;
+    default:
+        return 0;
+    }
+
+    CS_Assert();
+    SPI_WriteByte(Cmd);
+    uint8_t Value = SPI_WriteByte(0xff);
+    CS_Release();
+
+    return Value;
+}
+
+static void WaitWIP()
+{
+    for (int i = 0; i < 1000000; i++)
+    {
+        uint8_t Status = ReadStatusReg(0);
+        if (1 & Status) // WIP
+        {
+            SYSTICK_DelayUs(10);
+            continue;
+        }
+        break;
+    }
+}
+
+static void WriteEnable()
+{
+    CS_Assert();
+    SPI_WriteByte(0x6);
+    CS_Release();
+}
+
+static void SectorErase(uint32_t Addr)
+{
+#ifdef ENABLE_FLASH_WRITE_BACK
+    FinishJob();
+#endif
+    StartSectorErase(Addr);
+    WaitWIP();
+}
+
+static void StartSectorErase(uint32_t Addr)
+{
+#ifdef DEBUG
+    printf("spi flash sector erase: %06x\n", Addr);
+#endif
+    WriteEnable();
+    WaitWIP();
+
+    CS_Assert();
+    SPI_WriteByte(0x20);
+    WriteAddr(Addr);
+    CS_Release();
+}
+
+static void SectorProgram(uint32_t Addr, const uint8_t *Buf, uint32_t Size)
+{
+    uint32_t Size1 = PAGE_SIZE - (Addr % PAGE_SIZE);
+
+    while (Size)
+    {
+        if (Size < Size1)
+        {
+            Size1 = Size;
+        }
+
+        PageProgram(Addr, Buf, Size1);
+
+        Addr += Size1;
         Buf += Size1;
         Size -= Size1;
 
@@ -418,6 +1904,15 @@ static void SectorProgram(uint32_t Addr, const uint8_t *Buf, uint32_t Size)
 
 static void PageProgram(uint32_t Addr, const uint8_t *Buf, uint32_t Size)
 {
+#ifdef ENABLE_FLASH_WRITE_BACK
+    FinishJob();
+#endif
+    StartPageProgram(Addr, Buf, Size);
+    WaitWIP();
+}
+
+static void StartPageProgram(uint32_t Addr, const uint8_t *Buf, uint32_t Size)
+{
 #ifdef DEBUG
     printf("spi flash page program: %06x %ld\n", Addr, Size);
 #endif
@@ -443,8 +1938,6 @@ static void PageProgram(uint32_t Addr, const uint8_t *Buf, uint32_t Size)
     }
 
     CS_Release();
-
-    WaitWIP();
 }
 
 void DMA1_Channel4_5_6_7_IRQHandler()
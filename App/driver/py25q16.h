@@ -25,4 +25,43 @@ void PY25Q16_ReadBuffer(uint32_t Address, void *pBuffer, uint32_t Size);
 void PY25Q16_WriteBuffer(uint32_t Address, const void *pBuffer, uint32_t Size, bool Append);
 void PY25Q16_SectorErase(uint32_t Address);
 
+typedef struct
+{
+    uint32_t Address;
+    void *pBuffer;
+    uint32_t Size;
+} PY25Q16_Segment_t;
+
+// Reads several fields at once. Segments in ascending order with only a
+// few bytes between them share one read command (one CS cycle).
+void PY25Q16_ReadScatter(const PY25Q16_Segment_t *pSegments, uint32_t Count);
+
+#ifdef ENABLE_FLASH_WRITE_BACK
+// Writes all dirty lines and waits for the flash, a fence before
+// power-off, reset or TX
+void PY25Q16_Flush(void);
+void PY25Q16_TimeSlice10ms(void);
+// Makes room for Count more dirty lines (flushing if needed), so that a
+// write of up to Count lines is not split by a flush
+void PY25Q16_ReserveLines(uint8_t Count);
+#endif
+#if defined(ENABLE_FLASH_WRITE_BACK) || defined(ENABLE_BOOT_SNAPSHOT)
+void PY25Q16_TimeSlice500ms(void);
+#endif
+#ifdef ENABLE_UART_BULK
+// Replaces a whole sector: PY25Q16_BeginSector() erases it (or takes an
+// erased spare in the commit area), then PY25Q16_WriteSector() programs
+// its content in order, each byte once. The sector is done with its last
+// byte; until then the commit area keeps serving the old content. A new
+// PY25Q16_BeginSector() drops a write left unfinished.
+void PY25Q16_BeginSector(uint32_t Address);
+void PY25Q16_WriteSector(const void *pBuffer, uint32_t Size);
+#endif
+#ifdef ENABLE_FLASH_COMMIT
+// Copies a sector a commit has mapped to a spare back home, or else
+// erases a freed spare, so that the next commit only programs. Call when
+// the radio is idle.
+void PY25Q16_EraseSpares(void);
+#endif
+
 #endif
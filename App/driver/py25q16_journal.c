@@ -0,0 +1,404 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "driver/crc.h"
+#include "driver/py25q16_journal.h"
+
+// Journal pool: 4 sectors above the EEPROM emulation (which ends at
+// 0x011000), used round robin. Each sector starts with a header slot
+// holding a sequence number, the one with the highest valid sequence is
+// the active journal. When it fills up, the next sector is erased and
+// gets a snapshot of the whole image, then its header. A sector whose
+// compaction was cut short has no header and is ignored at mount.
+//
+// The header also holds a CRC of the home windows as the journal found
+// them. A build without the journal writes the home sectors instead, so
+// when they no longer match the journal is dropped and the home content
+// wins. The pool is only taken over when it is blank or already ours.
+#define POOL_ADDR       0x012000
+#define POOL_SECTORS    4
+#define SECTOR_SIZE     0x1000
+
+#define MAGIC           0x4C4E524Au // "JRNL"
+
+typedef struct
+{
+    uint32_t Addr;      // home address of Data, MAGIC in a header
+    uint8_t  Data[8];   // header: sequence number, home windows CRC
+    uint16_t Reserved;
+    uint16_t Crc;       // over the fields above
+} Record_t;
+
+#define SLOTS           (SECTOR_SIZE / sizeof(Record_t))
+
+typedef struct
+{
+    uint32_t Addr;
+    uint16_t Size;
+} Window_t;
+
+// Used part of each settings sector, as in eeprom_compat.c, sorted.
+// Every window is 8 byte aligned and sized, one record covers 8 bytes.
+static const Window_t WINDOWS[] = {
+    {0x003000, 0x28}, // 0x0E40 FM channels
+    {0x004000, 0x10}, // 0x0E70 settings
+    {0x005000, 0x08}, // 0x0E80 VFO indices
+    {0x006000, 0x08}, // 0x0E88 FM
+    {0x007000, 0x50}, // 0x0E90 settings, logo lines
+    {0x008000, 0x38}, // 0x0EE0 DTMF
+    {0x009000, 0x08}, // 0x0F18 scan lists
+    {0x00a000, 0x10}, // 0x0F30 AES key
+    {0x00b000, 0x08}, // 0x0F40 F lock, TX enables
+    {0x00c000, 0x10}, // 0x1FF0 F4HWN settings, resume state
+};
+
+#define WINDOW_COUNT    (sizeof(WINDOWS) / sizeof(WINDOWS[0]))
+#define WINDOW_END      (WINDOWS[WINDOW_COUNT - 1].Addr + WINDOWS[WINDOW_COUNT - 1].Size)
+
+static uint8_t  Image[JOURNAL_IMAGE_SIZE]; // all windows back to back
+static bool     Enabled;        // false when the pool holds something else
+static uint16_t HomeCrc;        // of the home windows, they do not change while journaled
+static uint32_t Sequence;
+static uint8_t  ActiveSector;
+static uint16_t NextSlot;       // SLOTS when the active sector is full or there is none
+
+static inline uint32_t SlotAddr(uint8_t Sector, uint32_t Slot)
+{
+    return POOL_ADDR + Sector * SECTOR_SIZE + Slot * sizeof(Record_t);
+}
+
+static uint16_t RecordCrc(const Record_t *pRecord)
+{
+    return CRC_Calculate(pRecord, offsetof(Record_t, Crc));
+}
+
+static void MakeRecord(Record_t *pRecord, uint32_t Addr, const uint8_t *pData)
+{
+    pRecord->Addr     = Addr;
+    memcpy(pRecord->Data, pData, sizeof(pRecord->Data));
+    pRecord->Reserved = 0xFFFF;
+    pRecord->Crc      = RecordCrc(pRecord);
+}
+
+static bool IsFree(const Record_t *pRecord)
+{
+    const uint8_t *p = (const uint8_t *)pRecord;
+    for (uint32_t i = 0; i < sizeof(Record_t); i++)
+    {
+        if (0xff != p[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint8_t *Locate(uint32_t Address)
+{
+    uint8_t *p = Image;
+    for (uint32_t i = 0; i < WINDOW_COUNT; i++)
+    {
+        const Window_t *w = WINDOWS + i;
+        if (w->Addr <= Address && Address < w->Addr + w->Size)
+        {
+            return p + (Address - w->Addr);
+        }
+        p += w->Size;
+    }
+    return NULL;
+}
+
+static void Compact(void)
+{
+    const uint8_t Sector = (ActiveSector + 1) % POOL_SECTORS;
+    Record_t Batch[4];
+    uint32_t Slot = 1;
+    uint32_t Count = 0;
+    const uint8_t *pImage = Image;
+
+    PY25Q16_RawSectorErase(SlotAddr(Sector, 0));
+
+    for (uint32_t i = 0; i < WINDOW_COUNT; i++)
+    {
+        for (uint32_t Off = 0; Off < WINDOWS[i].Size; Off += 8)
+        {
+            MakeRecord(&Batch[Count++], WINDOWS[i].Addr + Off, pImage + Off);
+            if (Count == 4)
+            {
+                PY25Q16_RawProgram(SlotAddr(Sector, Slot), Batch, sizeof(Batch));
+                Slot += Count;
+                Count = 0;
+            }
+        }
+        pImage += WINDOWS[i].Size;
+    }
+
+    if (Count)
+    {
+        PY25Q16_RawProgram(SlotAddr(Sector, Slot), Batch, Count * sizeof(Record_t));
+        Slot += Count;
+    }
+
+    // Header last, the snapshot only counts once it is complete
+    uint8_t Seq[8];
+    Sequence++;
+    memset(Seq, 0xff, sizeof(Seq));
+    memcpy(Seq, &Sequence, sizeof(Sequence));
+    memcpy(Seq + 4, &HomeCrc, sizeof(HomeCrc));
+    MakeRecord(&Batch[0], MAGIC, Seq);
+    PY25Q16_RawProgram(SlotAddr(Sector, 0), &Batch[0], sizeof(Record_t));
+
+    ActiveSector = Sector;
+    NextSlot     = Slot;
+}
+
+static void Append(uint32_t Address, const uint8_t *pData)
+{
+    if (NextSlot >= SLOTS)
+    {
+        // The snapshot carries this change too
+        Compact();
+        return;
+    }
+
+    Record_t Record;
+    MakeRecord(&Record, Address, pData);
+    PY25Q16_RawProgram(SlotAddr(ActiveSector, NextSlot), &Record, sizeof(Record));
+    NextSlot++;
+}
+
+// Blank, or left by one of our compactions: with a header, or cut short
+// before it with the first record in place
+static bool IsClaimable(uint8_t Sector)
+{
+    Record_t Chunk[4];
+
+    PY25Q16_RawRead(SlotAddr(Sector, 0), Chunk, 2 * sizeof(Record_t));
+    if (MAGIC == Chunk[0].Addr)
+    {
+        return true;
+    }
+
+    if (!IsFree(&Chunk[0]))
+    {
+        return false;
+    }
+
+    if (WINDOWS[0].Addr == Chunk[1].Addr && RecordCrc(&Chunk[1]) == Chunk[1].Crc)
+    {
+        return true;
+    }
+
+    for (uint32_t Slot = 1; Slot < SLOTS; Slot += 4)
+    {
+        PY25Q16_RawRead(SlotAddr(Sector, Slot), Chunk, sizeof(Chunk));
+        for (uint32_t i = 0; i < 4 && Slot + i < SLOTS; i++)
+        {
+            if (!IsFree(Chunk + i))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void JOURNAL_Mount(void)
+{
+    // Home sectors first: all there is before the first save, and the
+    // baseline for windows added after the journal was written
+    uint8_t *pImage = Image;
+    for (uint32_t i = 0; i < WINDOW_COUNT; i++)
+    {
+        PY25Q16_RawRead(WINDOWS[i].Addr, pImage, WINDOWS[i].Size);
+        pImage += WINDOWS[i].Size;
+    }
+
+    bool     Found = false;
+    uint16_t Crc   = 0;
+    Enabled      = true;
+    HomeCrc      = CRC_Calculate(Image, sizeof(Image));
+    Sequence     = 0;
+    ActiveSector = POOL_SECTORS - 1; // so that the first save starts at sector 0
+    NextSlot     = SLOTS;
+
+    for (uint8_t i = 0; i < POOL_SECTORS; i++)
+    {
+        Record_t Header;
+        uint32_t Seq;
+
+        PY25Q16_RawRead(SlotAddr(i, 0), &Header, sizeof(Header));
+        if (MAGIC != Header.Addr || RecordCrc(&Header) != Header.Crc)
+        {
+            continue;
+        }
+
+        memcpy(&Seq, Header.Data, sizeof(Seq));
+        if (!Found || (int32_t)(Seq - Sequence) > 0)
+        {
+            Found        = true;
+            Sequence     = Seq;
+            ActiveSector = i;
+            memcpy(&Crc, Header.Data + 4, sizeof(Crc));
+        }
+    }
+
+    if (!Found)
+    {
+        for (uint8_t i = 0; i < POOL_SECTORS; i++)
+        {
+            if (!IsClaimable(i))
+            {
+                Enabled = false;
+                return;
+            }
+        }
+        return;
+    }
+
+    // The home windows were written since, the journal is stale. The
+    // next save compacts into a new sector, with a higher sequence.
+    if (Crc != HomeCrc)
+    {
+        return;
+    }
+
+    Record_t Chunk[8];
+    for (uint32_t Slot = 1; Slot < SLOTS; Slot += 8)
+    {
+        const uint32_t Count = (SLOTS - Slot) < 8 ? (SLOTS - Slot) : 8;
+
+        PY25Q16_RawRead(SlotAddr(ActiveSector, Slot), Chunk, Count * sizeof(Record_t));
+        for (uint32_t i = 0; i < Count; i++)
+        {
+            const Record_t *pRecord = Chunk + i;
+            if (IsFree(pRecord))
+            {
+                NextSlot = Slot + i;
+                return;
+            }
+
+            // A record torn by a power cut fails its CRC and is skipped
+            uint8_t *p = Locate(pRecord->Addr);
+            if (p && 0 == (pRecord->Addr & 7) && RecordCrc(pRecord) == pRecord->Crc)
+            {
+                memcpy(p, pRecord->Data, sizeof(pRecord->Data));
+            }
+        }
+    }
+}
+
+void JOURNAL_GetState(JOURNAL_State_t *pState)
+{
+    pState->Sequence     = Sequence;
+    pState->ActiveSector = ActiveSector;
+    pState->bEnabled     = Enabled;
+    pState->NextSlot     = NextSlot;
+    pState->HomeCrc      = HomeCrc;
+    pState->Reserved     = 0xffff;
+}
+
+void JOURNAL_Restore(const uint8_t *pImage, const JOURNAL_State_t *pState)
+{
+    memcpy(Image, pImage, sizeof(Image));
+    Sequence     = pState->Sequence;
+    ActiveSector = pState->ActiveSector;
+    Enabled      = pState->bEnabled;
+    HomeCrc      = pState->HomeCrc;
+    NextSlot     = pState->NextSlot;
+}
+
+uint32_t JOURNAL_Span(uint32_t Address, uint32_t Size, bool *pJournaled)
+{
+    *pJournaled = false;
+
+    if (!Enabled || Address >= WINDOW_END || Address + Size <= WINDOWS[0].Addr)
+    {
+        return Size;
+    }
+
+    for (uint32_t i = 0; i < WINDOW_COUNT; i++)
+    {
+        const Window_t *w = WINDOWS + i;
+        uint32_t Span;
+
+        if (Address < w->Addr)
+        {
+            Span = w->Addr - Address;
+        }
+        else if (Address < w->Addr + w->Size)
+        {
+            *pJournaled = true;
+            Span = w->Addr + w->Size - Address;
+        }
+        else
+        {
+            continue;
+        }
+
+        return Size < Span ? Size : Span;
+    }
+
+    return Size;
+}
+
+void JOURNAL_Read(uint32_t Address, void *pBuffer, uint32_t Size)
+{
+    memcpy(pBuffer, Locate(Address), Size);
+}
+
+void JOURNAL_Write(uint32_t Address, const void *pBuffer, uint32_t Size)
+{
+    const uint8_t *pData = pBuffer;
+
+    // Log only the 8 byte records that really change
+    while (Size)
+    {
+        const uint32_t Record = Address & ~7u;
+        uint32_t       Count  = 8 - (Address - Record);
+        if (Count > Size)
+        {
+            Count = Size;
+        }
+
+        uint8_t *p = Locate(Address);
+        if (0 != memcmp(p, pData, Count))
+        {
+            memcpy(p, pData, Count);
+            Append(Record, Locate(Record));
+        }
+
+        Address += Count;
+        pData   += Count;
+        Size    -= Count;
+    }
+}
+
+bool JOURNAL_SectorErase(uint32_t Address)
+{
+    static const uint8_t Blank[8] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+
+    if (!Enabled)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < WINDOW_COUNT; i++)
+    {
+        const Window_t *w = WINDOWS + i;
+        if (w->Addr / SECTOR_SIZE != Address / SECTOR_SIZE)
+        {
+            continue;
+        }
+
+        // The rest of a settings sector is unused, no need to erase it
+        for (uint32_t Off = 0; Off < w->Size; Off += 8)
+        {
+            JOURNAL_Write(w->Addr + Off, Blank, 8);
+        }
+        return true;
+    }
+
+    return false;
+}
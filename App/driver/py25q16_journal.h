@@ -0,0 +1,46 @@
+#ifndef DRIVER_PY25Q16_JOURNAL_H
+#define DRIVER_PY25Q16_JOURNAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// The settings sectors (0x003000 - 0x00c000) only use their first few
+// bytes. Their content is mirrored in RAM and every change is appended to
+// a rotating pool of flash sectors as (address, 8 bytes) records, instead
+// of erasing and reprogramming the home sector. See py25q16_journal.c.
+
+// All windows back to back, in address order
+#define JOURNAL_IMAGE_SIZE 0x100
+
+typedef struct
+{
+    uint32_t Sequence;
+    uint8_t  ActiveSector;
+    uint8_t  bEnabled;
+    uint16_t NextSlot;
+    uint16_t HomeCrc;
+    uint16_t Reserved;
+} JOURNAL_State_t;
+
+void     JOURNAL_Mount(void);
+
+// Sets up the journal as a mount would, from an image and a state taken
+// while nothing was appended since, without reading the pool. See
+// py25q16_snapshot.c.
+void     JOURNAL_GetState(JOURNAL_State_t *pState);
+void     JOURNAL_Restore(const uint8_t *pImage, const JOURNAL_State_t *pState);
+
+// Number of bytes from Address on that are all journaled or all not,
+// which one is returned in *pJournaled.
+uint32_t JOURNAL_Span(uint32_t Address, uint32_t Size, bool *pJournaled);
+
+void     JOURNAL_Read(uint32_t Address, void *pBuffer, uint32_t Size);
+void     JOURNAL_Write(uint32_t Address, const void *pBuffer, uint32_t Size);
+bool     JOURNAL_SectorErase(uint32_t Address);
+
+// Provided by py25q16.c, flash access that bypasses the journal
+void     PY25Q16_RawRead(uint32_t Address, void *pBuffer, uint32_t Size);
+void     PY25Q16_RawProgram(uint32_t Address, const void *pBuffer, uint32_t Size);
+void     PY25Q16_RawSectorErase(uint32_t Address);
+
+#endif
@@ -0,0 +1,316 @@
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef ENABLE_BOOT_SNAPSHOT
+    #include "driver/crc.h"
+#endif
+#include "driver/py25q16.h"
+#include "driver/py25q16_snapshot.h"
+#ifdef ENABLE_SETTINGS_JOURNAL
+    #include "driver/py25q16_journal.h"
+#endif
+
+// The regions below are what SETTINGS_InitEEPROM() and
+// SETTINGS_LoadCalibration() read, some 30 reads of 4 to 16 bytes. The
+// snapshot holds them back to back, followed by the journal state when
+// the journal is built in, so that its pool is not read at boot either.
+//
+// The snapshot sector has 5 slots: a table of headers at its start and the
+// data of slot i at 0x100 + i * 0x300. A save programs the data of the
+// next slot, then its header; the sector is erased once all slots are
+// used. The first write that changes a region after a save clears the
+// State of the header (a program, no erase) before the change reaches the
+// flash, so a valid snapshot always matches the flash. A snapshot whose
+// header, CRC or layout does not check out is ignored and the regions are
+// read where they are.
+//
+// Builds without ENABLE_BOOT_SNAPSHOT keep only the clearing part, so
+// that a snapshot left by another build goes stale with their writes too.
+
+#define SNAP_ADDR       0x016000
+#define SECTOR_SIZE     0x1000
+#define SLOT_COUNT      5
+#define SLOT_SIZE       0x300
+#define DATA_ADDR(Slot) (SNAP_ADDR + 0x100 + (Slot) * SLOT_SIZE)
+
+#define MAGIC           0x50414E53u // "SNAP"
+#define STATE_VALID     0xA5
+#define STATE_CLEARED   0x00
+
+#define SAVE_IDLE_500MS 4
+
+// Bump when REGIONS changes
+#define VERSION         1
+#ifdef ENABLE_SETTINGS_JOURNAL
+    #define LAYOUT      (VERSION | 0x80)
+#else
+    #define LAYOUT      VERSION
+#endif
+
+typedef struct
+{
+    uint32_t Magic;
+    uint8_t  Layout;
+    uint8_t  Reserved;
+    uint16_t Size;
+    uint16_t DataCrc;
+    uint16_t Crc;       // over the fields above
+    uint8_t  State;     // cleared in place when the snapshot goes stale
+    uint8_t  Reserved2[3];
+} Header_t;
+
+typedef struct
+{
+    uint32_t Addr;
+    uint16_t Size;
+} Region_t;
+
+// Sorted. The settings windows are those of py25q16_journal.c, in the
+// same order, so that they are the journal image as they stand.
+static const Region_t REGIONS[] = {
+    {0x002000, 0xd0}, // 0x0D60 channel attributes
+    {0x003000, 0x28}, // 0x0E40 FM channels
+    {0x004000, 0x10}, // 0x0E70 settings
+    {0x005000, 0x08}, // 0x0E80 VFO indices
+    {0x006000, 0x08}, // 0x0E88 FM
+    {0x007000, 0x50}, // 0x0E90 settings, logo lines
+    {0x008000, 0x38}, // 0x0EE0 DTMF
+    {0x009000, 0x08}, // 0x0F18 scan lists
+    {0x00a000, 0x10}, // 0x0F30 AES key
+    {0x00b000, 0x08}, // 0x0F40 F lock, TX enables
+    {0x00c000, 0x10}, // 0x1FF0 F4HWN settings, resume state
+    {0x0100c0, 0xd0}, // 0x1EC0 RSSI, battery and VOX calibration, misc
+};
+
+#define REGION_COUNT    (sizeof(REGIONS) / sizeof(REGIONS[0]))
+#define WINDOWS_OFFSET  0xd0
+#define REGIONS_SIZE    0x2a0
+
+#ifdef ENABLE_SETTINGS_JOURNAL
+    #define DATA_SIZE   (REGIONS_SIZE + sizeof(JOURNAL_State_t))
+    static_assert(WINDOWS_OFFSET + JOURNAL_IMAGE_SIZE <= REGIONS_SIZE);
+#else
+    #define DATA_SIZE   REGIONS_SIZE
+#endif
+
+static_assert(sizeof(Header_t) == 16);
+static_assert(SLOT_COUNT * sizeof(Header_t) <= 0x100);
+static_assert(0x100 + SLOT_COUNT * SLOT_SIZE <= SECTOR_SIZE);
+static_assert(DATA_SIZE <= SNAPSHOT_SIZE && SNAPSHOT_SIZE <= SLOT_SIZE);
+
+static bool          Valid;     // the newest header is valid
+static uint8_t       NextSlot;  // SLOT_COUNT when the sector is full
+#ifdef ENABLE_BOOT_SNAPSHOT
+static const uint8_t *pLoaded;  // the snapshot while it is lent a buffer
+static bool          Stale;     // there is no valid snapshot, save one
+static uint8_t       Idle_500ms;
+
+static uint16_t HeaderCrc(const Header_t *pHeader)
+{
+    return CRC_Calculate(pHeader, offsetof(Header_t, Crc));
+}
+#endif
+
+// Reads the header table, the newest header is the last one written to.
+// NULL if the table is empty.
+static const Header_t *Newest(Header_t *pHeaders)
+{
+    PY25Q16_RawRead(SNAP_ADDR, pHeaders, SLOT_COUNT * sizeof(Header_t));
+    NextSlot = 0;
+    while (NextSlot < SLOT_COUNT && 0xffffffff != pHeaders[NextSlot].Magic)
+    {
+        NextSlot++;
+    }
+
+    return NextSlot ? &pHeaders[NextSlot - 1] : NULL;
+}
+
+static bool Overlaps(uint32_t Address, uint32_t Size)
+{
+    for (uint32_t i = 0; i < REGION_COUNT; i++)
+    {
+        if (Address < REGIONS[i].Addr + REGIONS[i].Size && REGIONS[i].Addr < Address + Size)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool Differs(uint32_t Address, const uint8_t *pData, uint32_t Size)
+{
+    while (Size)
+    {
+        uint8_t        Current[16];
+        const uint32_t Count = Size < sizeof(Current) ? Size : sizeof(Current);
+
+        PY25Q16_ReadBuffer(Address, Current, Count);
+        if (0 != memcmp(Current, pData, Count))
+        {
+            return true;
+        }
+
+        Address += Count;
+        pData   += Count;
+        Size    -= Count;
+    }
+    return false;
+}
+
+#ifndef ENABLE_BOOT_SNAPSHOT
+void SNAPSHOT_Probe(void)
+{
+    Header_t Headers[SLOT_COUNT];
+
+    // Whatever its layout, a build with the snapshot may load it
+    const Header_t *pHeader = Newest(Headers);
+    Valid = pHeader && MAGIC == pHeader->Magic && STATE_VALID == pHeader->State;
+}
+#else
+bool SNAPSHOT_Load(uint8_t *pBuffer)
+{
+    Header_t Headers[SLOT_COUNT];
+
+    Valid = false;
+    Stale = true;
+
+    const Header_t *pHeader = Newest(Headers);
+    if (!pHeader)
+    {
+        return false;
+    }
+
+    if (MAGIC != pHeader->Magic || LAYOUT != pHeader->Layout || DATA_SIZE != pHeader->Size ||
+        HeaderCrc(pHeader) != pHeader->Crc || STATE_VALID != pHeader->State)
+    {
+        return false;
+    }
+
+    PY25Q16_RawRead(DATA_ADDR(NextSlot - 1), pBuffer, DATA_SIZE);
+    if (CRC_Calculate(pBuffer, DATA_SIZE) != pHeader->DataCrc)
+    {
+        return false;
+    }
+
+#ifdef ENABLE_SETTINGS_JOURNAL
+    JOURNAL_State_t State;
+    memcpy(&State, pBuffer + REGIONS_SIZE, sizeof(State));
+    JOURNAL_Restore(pBuffer + WINDOWS_OFFSET, &State);
+#endif
+
+    pLoaded = pBuffer;
+    Valid   = true;
+    Stale   = false;
+    return true;
+}
+
+void SNAPSHOT_Release(void)
+{
+    pLoaded = NULL;
+}
+
+bool SNAPSHOT_Read(uint32_t Address, void *pBuffer, uint32_t Size)
+{
+    if (!pLoaded)
+    {
+        return false;
+    }
+
+    const uint8_t *p = pLoaded;
+    for (uint32_t i = 0; i < REGION_COUNT; i++)
+    {
+        const Region_t *r = REGIONS + i;
+        if (r->Addr <= Address && Address + Size <= r->Addr + r->Size)
+        {
+            memcpy(pBuffer, p + (Address - r->Addr), Size);
+            return true;
+        }
+        p += r->Size;
+    }
+    return false;
+}
+#endif
+
+void SNAPSHOT_Write(uint32_t Address, const void *pData, uint32_t Size)
+{
+    if (!Overlaps(Address, Size))
+    {
+        return;
+    }
+
+#ifdef ENABLE_BOOT_SNAPSHOT
+    Idle_500ms = 0;
+#endif
+    if (!Valid || (pData && !Differs(Address, pData, Size)))
+    {
+        return;
+    }
+
+    static const uint8_t Cleared = STATE_CLEARED;
+    PY25Q16_RawProgram(SNAP_ADDR + (NextSlot - 1) * sizeof(Header_t) + offsetof(Header_t, State), &Cleared, 1);
+
+    Valid   = false;
+#ifdef ENABLE_BOOT_SNAPSHOT
+    pLoaded = NULL;
+    Stale   = true;
+#endif
+}
+
+#ifdef ENABLE_BOOT_SNAPSHOT
+bool SNAPSHOT_Due(void)
+{
+    if (!Stale)
+    {
+        return false;
+    }
+
+    if (Idle_500ms < SAVE_IDLE_500MS)
+    {
+        Idle_500ms++;
+        return false;
+    }
+
+    return true;
+}
+
+void SNAPSHOT_Save(uint8_t *pBuffer)
+{
+    uint8_t *p = pBuffer;
+
+    pLoaded = NULL;
+    for (uint32_t i = 0; i < REGION_COUNT; i++)
+    {
+        PY25Q16_ReadBuffer(REGIONS[i].Addr, p, REGIONS[i].Size);
+        p += REGIONS[i].Size;
+    }
+#ifdef ENABLE_SETTINGS_JOURNAL
+    JOURNAL_State_t State;
+    JOURNAL_GetState(&State);
+    memcpy(p, &State, sizeof(State));
+#endif
+
+    if (NextSlot >= SLOT_COUNT)
+    {
+        PY25Q16_RawSectorErase(SNAP_ADDR);
+        NextSlot = 0;
+    }
+
+    // Header last, the snapshot only counts once its data is complete
+    Header_t Header;
+    memset(&Header, 0xff, sizeof(Header));
+    Header.Magic   = MAGIC;
+    Header.Layout  = LAYOUT;
+    Header.Size    = DATA_SIZE;
+    Header.DataCrc = CRC_Calculate(pBuffer, DATA_SIZE);
+    Header.Crc     = HeaderCrc(&Header);
+    Header.State   = STATE_VALID;
+
+    PY25Q16_RawProgram(DATA_ADDR(NextSlot), pBuffer, DATA_SIZE);
+    PY25Q16_RawProgram(SNAP_ADDR + NextSlot * sizeof(Header_t), &Header, sizeof(Header));
+    NextSlot++;
+
+    Valid = true;
+    Stale = false;
+}
+#endif
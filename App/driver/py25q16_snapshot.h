@@ -0,0 +1,40 @@
+#ifndef DRIVER_PY25Q16_SNAPSHOT_H
+#define DRIVER_PY25Q16_SNAPSHOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// The flash read at every boot (channel attributes, settings sectors,
+// calibration) packed into one CRC protected record, so that a boot reads
+// it with one command. See py25q16_snapshot.c.
+
+// Reads the snapshot into pBuffer, which is lent until SNAPSHOT_Release().
+// False if there is none that matches the flash.
+bool SNAPSHOT_Load(uint8_t *pBuffer);
+void SNAPSHOT_Release(void);
+
+// Serves a read from the loaded snapshot, if it holds all of it
+bool SNAPSHOT_Read(uint32_t Address, void *pBuffer, uint32_t Size);
+
+// To be called before a write (pData) or an erase (pData NULL) reaches
+// the flash, clears the snapshot if it changes what it holds. Built
+// without ENABLE_BOOT_SNAPSHOT as well.
+void SNAPSHOT_Write(uint32_t Address, const void *pData, uint32_t Size);
+
+// At boot in builds without ENABLE_BOOT_SNAPSHOT, finds a snapshot for
+// SNAPSHOT_Write() to clear
+void SNAPSHOT_Probe(void);
+
+// Every 500 ms, true once a new snapshot should be saved
+bool SNAPSHOT_Due(void);
+// pBuffer is scratch of at least SNAPSHOT_SIZE bytes
+void SNAPSHOT_Save(uint8_t *pBuffer);
+
+#define SNAPSHOT_SIZE 0x2b0
+
+// Provided by py25q16.c, flash access that bypasses the journal
+void PY25Q16_RawRead(uint32_t Address, void *pBuffer, uint32_t Size);
+void PY25Q16_RawProgram(uint32_t Address, const void *pBuffer, uint32_t Size);
+void PY25Q16_RawSectorErase(uint32_t Address);
+
+#endif
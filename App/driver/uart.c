@@ -22,6 +22,7 @@
 #include "py32f071_ll_dma.h"
 #include "py32f071_ll_gpio.h"
 #include "py32f071_ll_usart.h"
+#include "driver/systick.h"
 #include "driver/uart.h"
 
 #define USARTx USART1
@@ -30,6 +31,104 @@
 static bool UART_IsLogEnabled;
 uint8_t UART_DMA_Buffer[256];
 
+#ifdef ENABLE_UART_TX_DMA
+// Transmit goes through a ring buffer drained by DMA channel 1, one
+// contiguous run per transfer. Only the main loop moves TxHead and only the
+// DMA interrupt moves TxTail. TxRun is the length of the run in flight, 0
+// when the channel is idle: the main loop starts a transfer only then, and
+// the interrupt chains the next one, so the two never start one each.
+// Sized for a screenshot frame of 64 blocks (5 + 64 * 9 + 1 bytes), a
+// full screen goes out in two of them.
+#define CHANNEL_TX      LL_DMA_CHANNEL_1
+#define TX_BUFFER_SIZE  640
+
+static uint8_t           TxBuffer[TX_BUFFER_SIZE];
+static volatile uint16_t TxHead;
+static volatile uint16_t TxTail;
+static volatile uint16_t TxRun;
+
+UART_TxStats_t gUART_TxStats = {.Size = TX_BUFFER_SIZE - 1};
+
+static uint32_t TxQueued(void)
+{
+    return (TxHead + TX_BUFFER_SIZE - TxTail) % TX_BUFFER_SIZE;
+}
+
+static uint32_t TxFree(void)
+{
+    return TX_BUFFER_SIZE - 1 - TxQueued();
+}
+
+// A full ring drains in some 170 ms at 38400 baud, longer means the
+// channel has stopped
+#define TX_TIMEOUT_US   500000
+
+// Gives the DMA interrupt time to free room, false once TX_TIMEOUT_US
+// have gone by
+static bool TxWait(uint32_t *pWaited)
+{
+    if (*pWaited >= TX_TIMEOUT_US)
+        return false;
+
+    SYSTICK_DelayUs(10);
+    *pWaited += 10;
+    return true;
+}
+
+static void StartRun(void)
+{
+    const uint16_t Head = TxHead;
+    const uint16_t Tail = TxTail;
+
+    if (Head == Tail)
+    {
+        TxRun = 0;
+        return;
+    }
+
+    TxRun = (Head > Tail ? Head : TX_BUFFER_SIZE) - Tail;
+
+    LL_DMA_DisableChannel(DMA1, CHANNEL_TX);
+    LL_DMA_SetMemoryAddress(DMA1, CHANNEL_TX, (uint32_t)(TxBuffer + Tail));
+    LL_DMA_SetDataLength(DMA1, CHANNEL_TX, TxRun);
+    LL_DMA_EnableChannel(DMA1, CHANNEL_TX);
+    LL_USART_EnableDMAReq_TX(USARTx);
+}
+
+static void Queue(const uint8_t *pData, uint32_t Size)
+{
+    uint32_t Head = TxHead;
+    uint32_t Count = TX_BUFFER_SIZE - Head;
+
+    if (Count > Size)
+        Count = Size;
+
+    memcpy(TxBuffer + Head, pData, Count);
+    memcpy(TxBuffer, pData + Count, Size - Count);
+    TxHead = (Head + Size) % TX_BUFFER_SIZE;
+
+    gUART_TxStats.Queued += Size;
+    if (gUART_TxStats.Peak < TxQueued())
+        gUART_TxStats.Peak = TxQueued();
+
+    // TxHead first: a run that ends in between picks up the new bytes
+    if (0 == TxRun)
+        StartRun();
+}
+
+void DMA1_Channel1_IRQHandler(void)
+{
+    if (!LL_DMA_IsActiveFlag_TC1(DMA1))
+        return;
+
+    LL_DMA_ClearFlag_GI1(DMA1);
+    LL_USART_DisableDMAReq_TX(USARTx);
+
+    TxTail = (TxTail + TxRun) % TX_BUFFER_SIZE;
+    StartRun();
+}
+#endif
+
 void UART_Init(void)
 {
     // PA9 TX
@@ -91,7 +190,7 @@ void UART_Init(void)
         LL_USART_InitTypeDef USART_InitStruct;
         LL_USART_StructInit(&USART_InitStruct);
 
-        USART_InitStruct.BaudRate = 38400;
+        USART_InitStruct.BaudRate = UART_BAUD_RATE;
         USART_InitStruct.TransferDirection = LL_USART_DIRECTION_TX_RX;
         LL_USART_Init(USARTx, &USART_InitStruct);
 
@@ -99,11 +198,104 @@ void UART_Init(void)
 
     } while (0);
 
+#ifdef ENABLE_UART_TX_DMA
+    do
+    {
+        LL_DMA_DisableChannel(DMA1, CHANNEL_TX);
+
+        LL_DMA_InitTypeDef DMA_InitStruct;
+        LL_DMA_StructInit(&DMA_InitStruct);
+
+        DMA_InitStruct.Direction = LL_DMA_DIRECTION_MEMORY_TO_PERIPH;
+        DMA_InitStruct.Mode = LL_DMA_MODE_NORMAL;
+        DMA_InitStruct.PeriphOrM2MSrcAddress = LL_USART_DMA_GetRegAddr(USARTx);
+        DMA_InitStruct.PeriphOrM2MSrcIncMode = LL_DMA_PERIPH_NOINCREMENT;
+        DMA_InitStruct.PeriphOrM2MSrcDataSize = LL_DMA_PDATAALIGN_BYTE;
+        DMA_InitStruct.MemoryOrM2MDstAddress = (uint32_t)TxBuffer;
+        DMA_InitStruct.MemoryOrM2MDstDataSize = LL_DMA_MDATAALIGN_BYTE;
+        DMA_InitStruct.MemoryOrM2MDstIncMode = LL_DMA_MEMORY_INCREMENT;
+        DMA_InitStruct.NbData = 0;
+        DMA_InitStruct.Priority = LL_DMA_PRIORITY_LOW;
+
+        LL_DMA_Init(DMA1, CHANNEL_TX, &DMA_InitStruct);
+
+        LL_SYSCFG_SetDMARemap(DMA1, CHANNEL_TX, LL_SYSCFG_DMA_MAP_USART1_WR);
+
+        LL_DMA_ClearFlag_GI1(DMA1);
+        LL_DMA_EnableIT_TC(DMA1, CHANNEL_TX);
+
+        NVIC_SetPriority(DMA1_Channel1_IRQn, 2);
+        NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+    } while (0);
+#endif
+
     LL_DMA_EnableChannel(DMA1, DMA_CHANNEL);
     LL_USART_Enable(USARTx);
     LL_USART_TransmitData8(USARTx, 0);
 }
 
+#ifdef ENABLE_UART_TX_DMA
+// Waits for room rather than lose bytes of a reply
+void UART_Send(const void *pBuffer, uint32_t Size)
+{
+    const uint8_t *pData = (const uint8_t *)pBuffer;
+    uint32_t       Waited = 0;
+
+    if (TxFree() < Size)
+        gUART_TxStats.Stalls++;
+
+    while (Size)
+    {
+        uint32_t Count = TxFree();
+
+        if (0 == Count)
+        {
+            if (!TxWait(&Waited))
+            {
+                gUART_TxStats.Dropped++;
+                return;
+            }
+            continue;
+        }
+
+        if (Count > Size)
+            Count = Size;
+
+        Queue(pData, Count);
+        pData += Count;
+        Size  -= Count;
+        Waited = 0;
+    }
+}
+
+bool UART_TrySend(const void *pBuffer, uint32_t Size)
+{
+    if (TxFree() < Size)
+    {
+        gUART_TxStats.Dropped++;
+        return false;
+    }
+
+    Queue((const uint8_t *)pBuffer, Size);
+    return true;
+}
+
+uint32_t UART_TxRoom(void)
+{
+    return TxFree();
+}
+
+void UART_Flush(void)
+{
+    uint32_t Waited = 0;
+
+    while (TxRun && TxWait(&Waited))
+        ;
+
+    while (!LL_USART_IsActiveFlag_TC(USARTx) && TxWait(&Waited))
+        ;
+}
+#else
 void UART_Send(const void *pBuffer, uint32_t Size)
 {
     const uint8_t *pData = (const uint8_t *)pBuffer;
@@ -117,10 +309,41 @@ void UART_Send(const void *pBuffer, uint32_t Size)
     }
 }
 
+bool UART_TrySend(const void *pBuffer, uint32_t Size)
+{
+    UART_Send(pBuffer, Size);
+    return true;
+}
+#endif
+
+#ifdef ENABLE_UART_HIGH_SPEED
+void UART_SetBaudRate(uint32_t BaudRate)
+{
+    // Whatever is queued goes out at the rate it was meant for
+#ifdef ENABLE_UART_TX_DMA
+    UART_Flush();
+#else
+    while (!LL_USART_IsActiveFlag_TC(USARTx))
+        ;
+#endif
+
+    // The receive DMA keeps running, only BRR changes
+    LL_USART_Disable(USARTx);
+
+    LL_USART_InitTypeDef USART_InitStruct;
+    LL_USART_StructInit(&USART_InitStruct);
+    USART_InitStruct.BaudRate = BaudRate;
+    USART_InitStruct.TransferDirection = LL_USART_DIRECTION_TX_RX;
+    LL_USART_Init(USARTx, &USART_InitStruct);
+
+    LL_USART_Enable(USARTx);
+}
+#endif
+
 void UART_LogSend(const void *pBuffer, uint32_t Size)
 {
     if (UART_IsLogEnabled) {
-        UART_Send(pBuffer, Size);
+        UART_TrySend(pBuffer, Size);
     }
 }
 
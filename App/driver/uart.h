@@ -21,12 +21,41 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// What the stock firmware, CHIRP and the tools start with
+#define UART_BAUD_RATE 38400
+
 extern uint8_t UART_DMA_Buffer[256];
 
 void UART_Init(void);
+// Queues a whole message, waiting for room if the transmit buffer is full.
+// Gives up on the rest if the buffer does not drain within half a second.
 void UART_Send(const void *pBuffer, uint32_t Size);
+// Queues a whole message, or drops it if it does not fit right now
+bool UART_TrySend(const void *pBuffer, uint32_t Size);
 void UART_LogSend(const void *pBuffer, uint32_t Size);
 
+#ifdef ENABLE_UART_TX_DMA
+    typedef struct {
+        uint32_t Queued;    // bytes accepted since boot
+        uint32_t Dropped;   // messages UART_TrySend() had no room for or UART_Send() gave up on
+        uint32_t Stalls;    // UART_Send() calls that had to wait for room
+        uint16_t Peak;      // most bytes ever waiting
+        uint16_t Size;      // room in the buffer
+    } UART_TxStats_t;
+
+    extern UART_TxStats_t gUART_TxStats;
+
+    // Bytes UART_Send() takes now without waiting
+    uint32_t UART_TxRoom(void);
+    // Returns once the last queued byte is on the wire
+    void UART_Flush(void);
+#endif
+
+#ifdef ENABLE_UART_HIGH_SPEED
+    // Waits for the queued bytes to go out first
+    void UART_SetBaudRate(uint32_t BaudRate);
+#endif
+
 #ifdef ENABLE_FEAT_F4HWN_SCREENSHOT
     bool UART_IsCableConnected(void);
 #endif
@@ -17,6 +17,7 @@
 #ifndef _DRIVER_VCP_H
 #define _DRIVER_VCP_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 #include "usb_config.h"
@@ -46,4 +47,10 @@ static inline void VCP_SendAsync(const uint8_t *Buf, uint32_t Size)
     cdc_acm_data_send_with_dtr_async(Buf, Size);
 }
 
+// True until the last transfer has gone out
+static inline bool VCP_IsSendBusy(void)
+{
+    return cdc_acm_data_send_busy();
+}
+
 #endif // _DRIVER_VCP_H
@@ -28,6 +28,7 @@
 #endif
 #include "driver/bk4819.h"
 #include "driver/gpio.h"
+#include "driver/py25q16.h"
 #include "driver/system.h"
 #include "driver/st7565.h"
 #include "frequencies.h"
@@ -135,6 +136,11 @@ void FUNCTION_PowerSave() {
 
     gMonitor = false;
 
+#ifdef ENABLE_FLASH_WRITE_BACK
+    // The radio may be switched off from here on
+    PY25Q16_Flush();
+#endif
+
     BK4819_DisableVox();
     BK4819_Sleep();
 
@@ -148,6 +154,11 @@ void FUNCTION_PowerSave() {
 
 void FUNCTION_Transmit()
 {
+#ifdef ENABLE_FLASH_WRITE_BACK
+    // Not while the PA draws current and the supply sags
+    PY25Q16_Flush();
+#endif
+
     // if DTMF is enabled when TX'ing, it changes the TX audio filtering !! .. 1of11
     BK4819_DisableDTMF();
 
@@ -18,6 +18,9 @@
 
 #include "battery.h"
 #include "driver/backlight.h"
+#ifdef ENABLE_FLASH_WRITE_BACK
+    #include "driver/py25q16.h"
+#endif
 #include "driver/st7565.h"
 #include "functions.h"
 #include "misc.h"
@@ -194,6 +197,10 @@ void BATTERY_GetReadings(const bool bDisplayBatteryLevel)
         else if (gBatteryDisplayLevel < 2)
         {
             gLowBattery = true;
+#ifdef ENABLE_FLASH_WRITE_BACK
+            // The battery may give out before the next idle flush
+            PY25Q16_Flush();
+#endif
         }
         else
         {
@@ -258,6 +265,11 @@ void BATTERY_TimeSlice500ms(void)
     AUDIO_PlaySingleVoice(true);
 #endif
 
+#ifdef ENABLE_FLASH_WRITE_BACK
+    // Flat battery, nothing may stay in RAM
+    PY25Q16_Flush();
+#endif
+
     gReducedService = true;
 
     FUNCTION_Select(FUNCTION_POWER_SAVE);
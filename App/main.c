@@ -24,11 +24,20 @@
 
 #include "audio.h"
 #include "board.h"
+#ifdef ENABLE_CHANNEL_DB
+    #include "chdb.h"
+#endif
+#include "memstats.h"
 #include "misc.h"
+#include "profile.h"
 #include "radio.h"
 #include "settings.h"
 #include "version.h"
 
+#ifdef ENABLE_SIM
+    #include "sim.h"
+#endif
+
 #ifdef ENABLE_FEAT_F4HWN
     #ifdef ENABLE_FMRADIO
         #include "app/action.h"
@@ -75,6 +84,10 @@ void _putchar(__attribute__((unused)) char c)
 
 void Main(void)
 {
+#ifdef ENABLE_MEMORY_STATS
+    MEMSTATS_PaintStack();
+#endif
+
     SYSTICK_Init();
     BOARD_Init();
 
@@ -107,6 +120,10 @@ void Main(void)
     SETTINGS_WriteBuildOptions();
     SETTINGS_LoadCalibration();
 
+#ifdef ENABLE_CHANNEL_DB
+    CHDB_Init();
+#endif
+
     RADIO_ConfigureChannel(0, VFO_CONFIGURE_RELOAD);
     RADIO_ConfigureChannel(1, VFO_CONFIGURE_RELOAD);
 
@@ -358,14 +375,25 @@ void Main(void)
     #endif
         
     while (true) {
+#ifdef ENABLE_SIM
+        SIM_Idle();
+#endif
+        PROFILE_ENTER(PROFILE_APP_UPDATE);
         APP_Update();
+        PROFILE_EXIT(PROFILE_APP_UPDATE);
 
         if (gNextTimeslice) {
 
+            PROFILE_TIMESLICE();
+
+            PROFILE_ENTER(PROFILE_TIMESLICE_10MS);
             APP_TimeSlice10ms();
+            PROFILE_EXIT(PROFILE_TIMESLICE_10MS);
 
             if (gNextTimeslice_500ms) {
+                PROFILE_ENTER(PROFILE_TIMESLICE_500MS);
                 APP_TimeSlice500ms();
+                PROFILE_EXIT(PROFILE_TIMESLICE_500MS);
             }
         }
     }
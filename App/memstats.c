@@ -0,0 +1,64 @@
+#include <stdint.h>
+
+#include "memstats.h"
+
+#ifdef ENABLE_SIM
+    #include "sim.h"
+#endif
+
+#define PAINT        0xC5C5C5C5u
+#define PAINT_MARGIN 128    // bytes left alone below the painter's own frame
+
+#ifdef ENABLE_SIM
+    // Main() runs on a stack of its own there, see Sim/Src/main.c
+    #define STACK_BOTTOM ((uint32_t *)gSimStackBottom)
+    #define STACK_TOP    ((uint32_t *)gSimStackTop)
+#else
+    // from the linker script
+    extern uint32_t _sdata[], _edata[], _sbss[], _ebss[], _estack[];
+
+    #define STACK_BOTTOM _ebss
+    #define STACK_TOP    _estack
+#endif
+
+MEMSTATS_t gMemStats;
+
+// lowest word found dirty so far, everything below it still holds PAINT
+static uint32_t *pLowWater;
+
+// Must run first thing in Main(), before anything deep has used the stack.
+void MEMSTATS_PaintStack(void)
+{
+    volatile uint32_t Marker;
+    uint32_t         *pEnd = (uint32_t *)(((uintptr_t)&Marker - PAINT_MARGIN) & ~3u);
+
+    for (uint32_t *p = STACK_BOTTOM; p < pEnd; p++)
+        *p = PAINT;
+
+    pLowWater = pEnd;
+
+#ifdef ENABLE_SIM
+    gMemStats.RamSize   = (uintptr_t)STACK_TOP - (uintptr_t)STACK_BOTTOM;
+#else
+    gMemStats.RamSize   = (uintptr_t)_estack - (uintptr_t)_sdata;
+    gMemStats.DataSize  = (uintptr_t)_edata  - (uintptr_t)_sdata;
+    gMemStats.BssSize   = (uintptr_t)_ebss   - (uintptr_t)_sbss;
+#endif
+    gMemStats.StackSize = (uintptr_t)STACK_TOP - (uintptr_t)STACK_BOTTOM;
+
+    MEMSTATS_Update();
+}
+
+// Only the still clean words below the last mark are read, so the cost
+// shrinks as the stack gets used.
+void MEMSTATS_Update(void)
+{
+    uint32_t *p = STACK_BOTTOM;
+
+    while (p < pLowWater && *p == PAINT)
+        p++;
+
+    pLowWater = p;
+
+    gMemStats.StackPeak = (uintptr_t)STACK_TOP - (uintptr_t)pLowWater;
+}
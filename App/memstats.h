@@ -0,0 +1,24 @@
+#ifndef MEMSTATS_H
+#define MEMSTATS_H
+
+#include <stdint.h>
+
+// RAM split as laid out by Core/py32f071xb.ld: .data and .bss from the
+// bottom, the stack grows down from the top towards them. The heap
+// reserve is never used (no malloc) and counts as stack.
+typedef struct {
+    uint32_t RamSize;
+    uint32_t DataSize;
+    uint32_t BssSize;
+    uint32_t StackSize;     // everything above .bss
+    uint32_t StackPeak;     // deepest stack use seen since boot
+} MEMSTATS_t;
+
+#ifdef ENABLE_MEMORY_STATS
+    extern MEMSTATS_t gMemStats;
+
+    void MEMSTATS_PaintStack(void);
+    void MEMSTATS_Update(void);
+#endif
+
+#endif
@@ -165,6 +165,7 @@ uint16_t          gEEPROM_1F8C;
 
 ChannelAttributes_t gMR_ChannelAttributes[FREQ_CHANNEL_LAST + 1];
 bool                gMR_ChannelExclude[FREQ_CHANNEL_LAST + 1];
+ChannelIndex_t      gMR_ChannelIndex;
 
 volatile uint16_t gBatterySaveCountdown_10ms = battery_save_count_10ms;
 
@@ -232,6 +232,16 @@ typedef union {
 extern ChannelAttributes_t   gMR_ChannelAttributes[207];
 extern bool                  gMR_ChannelExclude[207];
 
+// What lookups and lists need of the memory channels, kept in RAM so they
+// do no flash I/O (1000 bytes). Loaded at boot and updated on every save
+// by settings.c.
+typedef struct {
+    uint32_t Frequency[MR_CHANNEL_LAST + 1]; // RX, as stored: 0xFFFFFFFF if never saved
+    uint8_t  NameHash[MR_CHANNEL_LAST + 1];  // 0 if the channel has no name
+} ChannelIndex_t;
+
+extern ChannelIndex_t        gMR_ChannelIndex;
+
 extern volatile uint16_t     gBatterySaveCountdown_10ms;
 
 extern volatile bool         gPowerSaveCountdownExpired;
@@ -0,0 +1,103 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "profile.h"
+
+#define MAX_DEPTH 8
+
+PROFILE_Stats_t  gProfileStats[PROFILE_COUNT];
+PROFILE_Jitter_t gProfileJitter;
+
+// Cycles spent in nested probes, per nesting level, so a probe can be
+// charged its self time when looking for the slice's worst offender.
+static uint32_t ChildCycles[MAX_DEPTH + 1];
+static uint8_t  Depth;
+
+static uint8_t  WindowProbe;
+static uint32_t WindowCycles;
+
+static uint32_t LastSlice;
+static bool     bHaveLastSlice;
+
+uint32_t PROFILE_Enter(void)
+{
+    if (++Depth <= MAX_DEPTH)
+        ChildCycles[Depth] = 0;
+
+    return SCHEDULER_GetCycles();
+}
+
+void PROFILE_Record(PROFILE_Probe_t Probe, uint32_t Start)
+{
+    const uint32_t   Cycles = SCHEDULER_GetCycles() - Start;
+    PROFILE_Stats_t *pStats = &gProfileStats[Probe];
+
+    if (Cycles < pStats->Min || pStats->Count == 0)
+        pStats->Min = Cycles;
+    if (Cycles > pStats->Max)
+        pStats->Max = Cycles;
+
+    pStats->Total[0] += Cycles;
+    if (pStats->Total[0] < Cycles)
+        pStats->Total[1]++;
+
+    pStats->Count++;
+
+    const uint32_t Self = Cycles - (Depth <= MAX_DEPTH ? ChildCycles[Depth] : 0);
+    if (Self > WindowCycles) {
+        WindowCycles = Self;
+        WindowProbe  = Probe;
+    }
+
+    if (--Depth > 0 && Depth <= MAX_DEPTH)
+        ChildCycles[Depth] += Cycles;
+}
+
+void PROFILE_Timeslice(void)
+{
+    const uint32_t Now    = SCHEDULER_GetCycles();
+    const uint32_t Period = Now - LastSlice;
+
+    LastSlice = Now;
+
+    if (!bHaveLastSlice) {
+        bHaveLastSlice = true;
+        WindowCycles   = 0;
+        return;
+    }
+
+    PROFILE_Jitter_t *pJitter = &gProfileJitter;
+
+    int Bin = 31 - __builtin_clz(Period | 1) - PROFILE_HISTOGRAM_SHIFT;
+    if (Bin < 0)
+        Bin = 0;
+    else if (Bin >= PROFILE_HISTOGRAM_BINS)
+        Bin = PROFILE_HISTOGRAM_BINS - 1;
+
+    pJitter->Histogram[Bin]++;
+
+    if (Period < pJitter->MinPeriod || pJitter->Slices == 0)
+        pJitter->MinPeriod = Period;
+
+    if (Period > pJitter->MaxPeriod) {
+        pJitter->MaxPeriod   = Period;
+        pJitter->WorstProbe  = WindowProbe;
+        pJitter->WorstCycles = WindowCycles;
+    }
+
+    pJitter->Slices++;
+
+    WindowCycles = 0;
+}
+
+// Only the tables are cleared, the nesting state belongs to probes that
+// may still be open (the serial command runs from inside them).
+void PROFILE_Reset(void)
+{
+    memset(gProfileStats, 0, sizeof(gProfileStats));
+}
+
+void PROFILE_ResetJitter(void)
+{
+    memset(&gProfileJitter, 0, sizeof(gProfileJitter));
+}
@@ -0,0 +1,65 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+#include "scheduler.h"
+
+// Hot-path probes. Each one keeps the min / max / count / total of the CPU
+// cycles spent between PROFILE_ENTER and PROFILE_EXIT, nested probes
+// included. The order here is the order of the serial dump.
+typedef enum {
+    PROFILE_APP_UPDATE = 0,
+    PROFILE_TIMESLICE_10MS,
+    PROFILE_TIMESLICE_500MS,
+    PROFILE_DISPLAY_SCREEN,
+    PROFILE_SETUP_REGISTERS,
+    PROFILE_RADIO_INTERRUPTS,
+    PROFILE_SPECTRUM_TICK,
+    PROFILE_COUNT
+} PROFILE_Probe_t;
+
+typedef struct {
+    uint32_t Min;
+    uint32_t Max;
+    uint32_t Count;
+    uint32_t Total[2];  // 64 bit, low word first, keeps the struct at 20 bytes
+} PROFILE_Stats_t;
+
+// Bin n counts periods of [2^(n + 12), 2^(n + 13)) cycles, the first and
+// last bins are open ended. A clean 10 ms slice (480000 cycles) lands in 6.
+#define PROFILE_HISTOGRAM_BINS  16
+#define PROFILE_HISTOGRAM_SHIFT 12
+
+// Period between two APP_TimeSlice10ms() calls
+typedef struct {
+    uint32_t MissedTicks;   // SysTick found the previous slice still pending
+    uint32_t Slices;
+    uint32_t MinPeriod;
+    uint32_t MaxPeriod;
+    uint32_t Histogram[PROFILE_HISTOGRAM_BINS];
+    uint32_t WorstCycles;   // longest self time of a probe during MaxPeriod
+    uint8_t  WorstProbe;
+    uint8_t  Padding[3];
+} PROFILE_Jitter_t;
+
+#ifdef ENABLE_PROFILER
+    extern PROFILE_Stats_t  gProfileStats[PROFILE_COUNT];
+    extern PROFILE_Jitter_t gProfileJitter;
+
+    uint32_t PROFILE_Enter(void);
+    void     PROFILE_Record(PROFILE_Probe_t Probe, uint32_t Start);
+    void     PROFILE_Timeslice(void);
+    void     PROFILE_Reset(void);
+    void     PROFILE_ResetJitter(void);
+
+    #define PROFILE_ENTER(Probe) const uint32_t Profile_##Probe = PROFILE_Enter()
+    #define PROFILE_EXIT(Probe)  PROFILE_Record(Probe, Profile_##Probe)
+    #define PROFILE_TIMESLICE()  PROFILE_Timeslice()
+#else
+    #define PROFILE_ENTER(Probe)
+    #define PROFILE_EXIT(Probe)
+    #define PROFILE_TIMESLICE()
+#endif
+
+#endif
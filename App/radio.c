@@ -32,6 +32,7 @@
 #include "functions.h"
 #include "helper/battery.h"
 #include "misc.h"
+#include "profile.h"
 #include "radio.h"
 #include "settings.h"
 #include "ui/menu.h"
@@ -250,10 +251,19 @@ void RADIO_ConfigureChannel(const unsigned int VFO, const unsigned int configure
     {
         uint8_t tmp;
         uint8_t data[8];
+        struct {
+            uint32_t Frequency;
+            uint32_t Offset;
+        } __attribute__((packed)) info;
+
+        const PY25Q16_Segment_t segments[] = {
+            {base,     &info, sizeof(info)},
+            {base + 8, data,  sizeof(data)},
+        };
+        PY25Q16_ReadScatter(segments, ARRAY_SIZE(segments));
         
         // ***************
 
-        PY25Q16_ReadBuffer(base + 8, data, sizeof(data));
 
         tmp = data[3] & 0x0F;
         if (tmp > TX_OFFSET_FREQUENCY_DIRECTION_SUB)
@@ -362,11 +372,6 @@ void RADIO_ConfigureChannel(const unsigned int VFO, const unsigned int configure
 
         // ***************
 
-        struct {
-            uint32_t Frequency;
-            uint32_t Offset;
-        } __attribute__((packed)) info;
-        PY25Q16_ReadBuffer(base, &info, sizeof(info));
         if(info.Frequency==0xFFFFFFFF)
             pVfo->freq_config_RX.Frequency = frequencyBandTable[band].lower;
         else
@@ -466,14 +471,17 @@ void RADIO_ConfigureSquelchAndOutputPower(VFO_Info_t *pInfo)
     {   // squelch >= 1
         Base += gEeprom.SQUELCH_LEVEL;                                        // my eeprom squelch-1
                                                                               // VHF   UHF
-        PY25Q16_ReadBuffer(Base + 0x00, &pInfo->SquelchOpenRSSIThresh,    1);  //  50    10
-        PY25Q16_ReadBuffer(Base + 0x10, &pInfo->SquelchCloseRSSIThresh,   1);  //  40     5
+        const PY25Q16_Segment_t segments[] = {                                // VHF   UHF
+            {Base + 0x00, &pInfo->SquelchOpenRSSIThresh,    1},                //  50    10
+            {Base + 0x10, &pInfo->SquelchCloseRSSIThresh,   1},                //  40     5
 
-        PY25Q16_ReadBuffer(Base + 0x20, &pInfo->SquelchOpenNoiseThresh,   1);  //  65    90
-        PY25Q16_ReadBuffer(Base + 0x30, &pInfo->SquelchCloseNoiseThresh,  1);  //  70   100
+            {Base + 0x20, &pInfo->SquelchOpenNoiseThresh,   1},                //  65    90
+            {Base + 0x30, &pInfo->SquelchCloseNoiseThresh,  1},                //  70   100
 
-        PY25Q16_ReadBuffer(Base + 0x40, &pInfo->SquelchCloseGlitchThresh, 1);  //  90    90
-        PY25Q16_ReadBuffer(Base + 0x50, &pInfo->SquelchOpenGlitchThresh,  1);  // 100   100
+            {Base + 0x40, &pInfo->SquelchCloseGlitchThresh, 1},                //  90    90
+            {Base + 0x50, &pInfo->SquelchOpenGlitchThresh,  1},                // 100   100
+        };
+        PY25Q16_ReadScatter(segments, ARRAY_SIZE(segments));
 
 
         uint16_t noise_open   = pInfo->SquelchOpenNoiseThresh;
@@ -684,6 +692,8 @@ void RADIO_SelectVfos(void)
 
 void RADIO_SetupRegisters(bool switchToForeground)
 {
+    PROFILE_ENTER(PROFILE_SETUP_REGISTERS);
+
     BK4819_FilterBandwidth_t Bandwidth = gRxVfo->CHANNEL_BANDWIDTH;
 
     #ifdef ENABLE_FEAT_F4HWN_NARROWER
@@ -727,12 +737,8 @@ void RADIO_SetupRegisters(bool switchToForeground)
 
     BK4819_ToggleGpioOut(BK4819_GPIO1_PIN29_PA_ENABLE, false);
 
-    while (1)
+    while (BK4819_IsInterruptPending())
     {
-        const uint16_t Status = BK4819_ReadRegister(BK4819_REG_0C);
-        if ((Status & 1u) == 0) // INTERRUPT REQUEST
-            break;
-
         BK4819_WriteRegister(BK4819_REG_02, 0);
         SYSTEM_DelayMs(1);
     }
@@ -877,6 +883,8 @@ void RADIO_SetupRegisters(bool switchToForeground)
 
     if (switchToForeground)
         FUNCTION_Select(FUNCTION_FOREGROUND);
+
+    PROFILE_EXIT(PROFILE_SETUP_REGISTERS);
 }
 
 #ifdef ENABLE_NOAA
@@ -24,6 +24,7 @@
 #include "functions.h"
 #include "helper/battery.h"
 #include "misc.h"
+#include "profile.h"
 #include "settings.h"
 
 #include "driver/backlight.h"
@@ -44,10 +45,43 @@
 
 static volatile uint32_t gGlobalSysTickCounter;
 
+#ifdef ENABLE_PROFILER
+// Free-running CPU cycle count, wraps every ~89 s at 48 MHz. A reload that
+// has happened but not been counted yet shows up as a pending SysTick, e.g.
+// when called from a critical section.
+uint32_t SCHEDULER_GetCycles(void)
+{
+    uint32_t Ticks;
+    uint32_t Value;
+    bool     bPending;
+
+    do {
+        Ticks    = gGlobalSysTickCounter;
+        Value    = SysTick->VAL;
+        bPending = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0;
+    } while (Ticks != gGlobalSysTickCounter);
+
+    if (bPending) {
+        Value = SysTick->VAL;
+        Ticks++;
+    }
+
+    const uint32_t Reload = SysTick->LOAD;
+
+    return Ticks * (Reload + 1) + (Reload - Value);
+}
+#endif
+
 // we come here every 10ms
 void SysTick_Handler(void)
 {
     gGlobalSysTickCounter++;
+
+#ifdef ENABLE_PROFILER
+    // the main loop has not got to the last slice yet, this one merges into it
+    if (gNextTimeslice)
+        gProfileJitter.MissedTicks++;
+#endif
     
     gNextTimeslice = true;
 
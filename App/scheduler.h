@@ -28,4 +28,8 @@ static void inline SCHEDULER_Disable()
     NVIC_DisableIRQ(SysTick_IRQn);
 }
 
+#ifdef ENABLE_PROFILER
+    uint32_t SCHEDULER_GetCycles(void);
+#endif
+
 #endif
@@ -20,18 +20,37 @@
 #include "misc.h"
 
 // RAM optimization: Only keep previousFrame static (1024 bytes)
-// Build currentFrame on-the-fly and send delta blocks immediately
+// Build each block of the current frame on-the-fly and send delta blocks immediately
 static uint8_t previousFrame[1024] = {0};
 static uint8_t forcedBlock = 0;
+static uint8_t forcedFrom = 128;  // First block of a forced update still to send
 static uint8_t keepAlive = 10;
 
-void getScreenShot(bool force)
+// Blocks per delta frame: a full update goes out in two frames, each one
+// fits the UART transmit ring whole
+#define FRAME_BLOCKS 64
+
+// Block n of the frame: bit layer (n / 2) % 8 of display line n / 16
+// (status line first), columns from 64 * (n % 2), one bit per column
+static void getBlock(uint8_t block, uint8_t *out)
 {
-    static uint8_t currentFrame[1024];  // Reused static buffer
-    uint16_t index = 0;
-    uint8_t acc = 0;
-    uint8_t bitCount = 0;
+    const uint8_t *line = (block < 16) ? gStatusLine : gFrameBuffer[block / 16 - 1];
+    const uint8_t b = (block / 2) % 8;
+
+    line += (block % 2) * 64;
+
+    for (uint8_t j = 0; j < 8; j++) {
+        uint8_t acc = 0;
+        for (uint8_t bitCount = 0; bitCount < 8; bitCount++) {
+            uint8_t bit = (line[j * 8 + bitCount] >> b) & 0x01;
+            acc |= (bit << bitCount);
+        }
+        out[j] = acc;
+    }
+}
 
+void getScreenShot(bool force)
+{
     if (gUART_LockScreenshot > 0) {
         gUART_LockScreenshot--;
         return;
@@ -47,75 +66,55 @@ void getScreenShot(bool force)
         return;
     }
 
-    // ==== Build currentFrame (exact same logic as original) ====
-    // Status line: 8 bit layers × 128 columns
-    for (uint8_t b = 0; b < 8; b++) {
-        for (uint8_t i = 0; i < 128; i++) {
-            uint8_t bit = (gStatusLine[i] >> b) & 0x01;
-            acc |= (bit << bitCount++);
-            if (bitCount == 8) {
-                currentFrame[index++] = acc;
-                acc = 0;
-                bitCount = 0;
-            }
-        }
-    }
-
-    // Frame buffer: 7 lines × 8 bit layers × 128 columns
-    for (uint8_t l = 0; l < 7; l++) {
-        for (uint8_t b = 0; b < 8; b++) {
-            for (uint8_t i = 0; i < 128; i++) {
-                uint8_t bit = (gFrameBuffer[l][i] >> b) & 0x01;
-                acc |= (bit << bitCount++);
-                if (bitCount == 8) {
-                    currentFrame[index++] = acc;
-                    acc = 0;
-                    bitCount = 0;
-                }
-            }
-        }
-    }
-
-    if (bitCount > 0)
-        currentFrame[index++] = acc;
-
-    if (index != 1024)
-        return; // Frame size mismatch, abort
+    if (force)
+        forcedFrom = 0;
 
     // ==== Generate delta frame ====
+    // Header, delta and end marker in one buffer so that the frame is
+    // queued whole or not at all. Blocks past FRAME_BLOCKS changes are
+    // left for the next frame.
     uint16_t deltaLen = 0;
-    uint8_t deltaFrame[128 * 9];  // Worst case: all 128 blocks changed
+    uint8_t frame[5 + FRAME_BLOCKS * 9 + 1];
+    uint8_t *deltaFrame = &frame[5];
+    uint8_t block;
 
-    for (uint8_t block = 0; block < 128; block++) {
-        uint8_t *cur = &currentFrame[block * 8];
-        uint8_t *prev = &previousFrame[block * 8];
+    for (block = 0; block < 128 && deltaLen < FRAME_BLOCKS * 9; block++) {
+        uint8_t *cur = &deltaFrame[deltaLen + 1];
 
-        bool changed = memcmp(cur, prev, 8) != 0;
+        getBlock(block, cur);
+
+        bool changed = memcmp(cur, &previousFrame[block * 8], 8) != 0;
         bool isForced = (block == forcedBlock);
-        bool fullUpdate = force;
+        bool fullUpdate = (block >= forcedFrom);
 
         if (changed || isForced || fullUpdate) {
-            deltaFrame[deltaLen++] = block;
-            memcpy(&deltaFrame[deltaLen], cur, 8);
-            deltaLen += 8;
-            memcpy(prev, cur, 8); // Update stored frame
+            deltaFrame[deltaLen] = block;
+            deltaLen += 9;
         }
     }
 
-    forcedBlock = (forcedBlock + 1) % 128;
-
     if (deltaLen == 0)
         return; // No update needed
 
     // ==== Send frame ====
-    uint8_t header[5] = {
-        0xAA, 0x55, 0x02,
-        (uint8_t)(deltaLen >> 8),
-        (uint8_t)(deltaLen & 0xFF)
-    };
-
-    UART_Send(header, 5);
-    UART_Send(deltaFrame, deltaLen);
-    uint8_t end = 0x0A;
-    UART_Send(&end, 1);
-}
\ No newline at end of file
+    frame[0] = 0xAA;
+    frame[1] = 0x55;
+    frame[2] = 0x02;
+    frame[3] = (uint8_t)(deltaLen >> 8);
+    frame[4] = (uint8_t)(deltaLen & 0xFF);
+    deltaFrame[deltaLen] = 0x0A;
+
+    // The link is still busy with an earlier frame: skip this one, the
+    // next delta then covers its changes too
+    if (!UART_TrySend(frame, 5 + deltaLen + 1))
+        return;
+
+    for (uint16_t i = 0; i < deltaLen; i += 9)
+        memcpy(&previousFrame[deltaFrame[i] * 8], &deltaFrame[i + 1], 8); // Update stored frame
+
+    // A forced update goes on from the first block not sent
+    if (forcedFrom < block)
+        forcedFrom = block;
+
+    forcedBlock = (forcedBlock + 1) % 128;
+}
@@ -327,6 +327,8 @@ void SETTINGS_InitEEPROM(void)
         gMR_ChannelExclude[i] = false;
     }
 
+    SETTINGS_LoadChannelIndex();
+
         // 0F30..0F3F
         PY25Q16_ReadBuffer(0x00a000, gCustomAesKey, sizeof(gCustomAesKey));
         bHasCustomAesKey = false;
@@ -461,8 +463,95 @@ void SETTINGS_LoadCalibration(void)
     }
 }
 
+void SETTINGS_TrimChannelName(char *s)
+{
+    int i;
+    for (i = 0; i < 10; i++)
+        if (s[i] < 32 || s[i] > 127)
+            break;                // invalid char
+
+    s[i--] = 0;                   // null term
+
+    while (i >= 0 && s[i] == 32)  // trim trailing spaces
+        s[i--] = 0;               // null term
+}
+
+// FNV-1a folded to 16 bits, 0 is kept for "no name"
+static uint8_t HashName(const char *s)
+{
+    if (s[0] == 0)
+        return 0;
+
+    uint32_t hash = 2166136261u;
+    while (*s)
+        hash = (hash ^ (uint8_t)*s++) * 16777619u;
+
+    hash ^= hash >> 16;
+    hash ^= hash >> 8;
+    return (hash & 0xFF) ? (hash & 0xFF) : 1;
+}
+
+void SETTINGS_LoadChannelIndex(void)
+{
+    // 16 channels per read, frequencies from 0x0000, names from 0x0F50
+    uint8_t buf[16 * 16];
+
+    for (unsigned int first = MR_CHANNEL_FIRST; first <= MR_CHANNEL_LAST; first += 16)
+    {
+        const unsigned int count = MIN(16u, MR_CHANNEL_LAST + 1u - first);
+
+        PY25Q16_ReadBuffer(first * 16, buf, count * 16);
+        for (unsigned int i = 0; i < count; i++)
+            memcpy(&gMR_ChannelIndex.Frequency[first + i], buf + i * 16, 4);
+
+        PY25Q16_ReadBuffer(0x00e000 + (first * 16), buf, count * 16);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            char name[11];
+            memcpy(name, buf + i * 16, 10);
+            SETTINGS_TrimChannelName(name);
+            gMR_ChannelIndex.NameHash[first + i] = HashName(name);
+        }
+    }
+}
+
+void SETTINGS_UpdateChannelIndex(uint32_t Address, uint32_t Size)
+{
+    // Frequencies from 0x0000, names from 0x0F50 in the flash
+    static const uint32_t Bases[] = { 0x000000, 0x00e000 };
+
+    for (unsigned int b = 0; b < ARRAY_SIZE(Bases); b++)
+    {
+        const uint32_t Begin = Bases[b];
+        const uint32_t End   = Begin + (MR_CHANNEL_LAST + 1) * 16;
+
+        if (Address >= End || Address + Size <= Begin)
+            continue;
+
+        const unsigned int first = Address > Begin ? (Address - Begin) / 16 : 0;
+        const unsigned int last  = (MIN(Address + Size, End) - 1 - Begin) / 16;
+
+        for (unsigned int i = first; i <= last; i++)
+        {
+            if (b == 0)
+            {
+                PY25Q16_ReadBuffer(i * 16, &gMR_ChannelIndex.Frequency[i], 4);
+                continue;
+            }
+
+            char name[11];
+            PY25Q16_ReadBuffer(0x00e000 + (i * 16), name, 10);
+            SETTINGS_TrimChannelName(name);
+            gMR_ChannelIndex.NameHash[i] = HashName(name);
+        }
+    }
+}
+
 uint32_t SETTINGS_FetchChannelFrequency(const int channel)
 {
+    if (IS_MR_CHANNEL(channel))
+        return gMR_ChannelIndex.Frequency[channel];
+
     struct
     {
         uint32_t frequency;
@@ -487,18 +576,22 @@ void SETTINGS_FetchChannelName(char *s, const int channel)
     if (!RADIO_CheckValidChannel(channel, false, 0))
         return;
 
+    if (gMR_ChannelIndex.NameHash[channel] == 0)
+        return;
+
     // 0x0F50
     PY25Q16_ReadBuffer(0x00e000 + (channel * 16), s, 10);
 
-    int i;
-    for (i = 0; i < 10; i++)
-        if (s[i] < 32 || s[i] > 127)
-            break;                // invalid char
+    SETTINGS_TrimChannelName(s);
+}
 
-    s[i--] = 0;                   // null term
+int SETTINGS_FindChannel(uint32_t frequency)
+{
+    for (unsigned int i = MR_CHANNEL_FIRST; IS_MR_CHANNEL(i); i++)
+        if (gMR_ChannelIndex.Frequency[i] == frequency && RADIO_CheckValidChannel(i, false, 0))
+            return i;
 
-    while (i >= 0 && s[i] == 32)  // trim trailing spaces
-        s[i--] = 0;               // null term
+    return -1;
 }
 
 void SETTINGS_FactoryReset(bool bIsAll)
@@ -552,6 +645,8 @@ void SETTINGS_FactoryReset(bool bIsAll)
     }
     // 1c00 - 1d00 : keep
 
+    SETTINGS_LoadChannelIndex();
+
     if (bIsAll)
     {
         RADIO_InitInfo(gRxVfo, FREQ_CHANNEL_FIRST + BAND6_400MHz, 43350000);
@@ -930,6 +1025,10 @@ void SETTINGS_SaveChannel(uint8_t Channel, uint8_t VFO, const VFO_Info_t *pVFO,
     }
 
     if (Mode >= 2 || IS_FREQ_CHANNEL(Channel)) { // copy VFO to a channel
+#ifdef ENABLE_FLASH_COMMIT
+        // channel, attributes and name go out in one commit
+        PY25Q16_ReserveLines(4);
+#endif
         typedef union {
             uint8_t _8[8];
             uint32_t _32[2];
@@ -968,6 +1067,9 @@ void SETTINGS_SaveChannel(uint8_t Channel, uint8_t VFO, const VFO_Info_t *pVFO,
 
         PY25Q16_WriteBuffer(OffsetVFO, Buf, 0x10, false);
 
+        if (IS_MR_CHANNEL(Channel))
+            gMR_ChannelIndex.Frequency[Channel] = pVFO->freq_config_RX.Frequency;
+
         SETTINGS_UpdateChannel(Channel, pVFO, true, true, true);
 
         if (IS_MR_CHANNEL(Channel)) {
@@ -997,6 +1099,14 @@ void SETTINGS_SaveChannelName(uint8_t channel, const char * name)
     memcpy(buf, name, MIN(strlen(name), 10u));
     // 0x0F50
     PY25Q16_WriteBuffer(0x00e000 + offset, buf, 0x10, false);
+
+    if (IS_MR_CHANNEL(channel))
+    {
+        char trimmed[11];
+        memcpy(trimmed, buf, 10);
+        SETTINGS_TrimChannelName(trimmed);
+        gMR_ChannelIndex.NameHash[channel] = HashName(trimmed);
+    }
 }
 
 void SETTINGS_UpdateChannel(uint8_t channel, const VFO_Info_t *pVFO, bool keep, bool check, bool save)
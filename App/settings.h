@@ -308,8 +308,17 @@ extern EEPROM_Config_t gEeprom;
 
 void     SETTINGS_InitEEPROM(void);
 void     SETTINGS_LoadCalibration(void);
+void     SETTINGS_LoadChannelIndex(void);
+// Rereads the index entries of the channels whose frequency or name lies in
+// the Size bytes written at flash Address, for writes that bypass
+// SETTINGS_SaveChannel()
+void     SETTINGS_UpdateChannelIndex(uint32_t Address, uint32_t Size);
 uint32_t SETTINGS_FetchChannelFrequency(const int channel);
 void     SETTINGS_FetchChannelName(char *s, const int channel);
+// Cuts a raw 10 byte name at the first invalid char and trims trailing
+// spaces, s must have room for the terminator
+void     SETTINGS_TrimChannelName(char *s);
+int      SETTINGS_FindChannel(uint32_t frequency);
 void     SETTINGS_FactoryReset(bool bIsAll);
 #ifdef ENABLE_FMRADIO
     void SETTINGS_SaveFM(void);
@@ -29,6 +29,7 @@
 #include "../external/printf/printf.h"
 #include "../frequencies.h"
 #include "../helper/battery.h"
+#include "../memstats.h"
 #include "../misc.h"
 #include "../settings.h"
 
@@ -183,6 +184,9 @@ const t_menu_item MenuList[] =
 #endif
     {"BatCal",      MENU_BATCAL        }, // battery voltage calibration
     {"BatTyp",      MENU_BATTYP        }, // battery type 1600/2200mAh
+#ifdef ENABLE_MEMORY_STATS
+    {"MemInf",      MENU_MEM_INF       }, // stack high-water mark
+#endif
     {"Reset",       MENU_RESET         }, // might be better to move this to the hidden menu items ?
 
     {"",                              0xff               }  // end of list - DO NOT delete or move this this
@@ -1058,6 +1062,15 @@ void UI_DisplayMenu(void)
             strcpy(String, gSubMenu_BATTYP[gSubMenuSelection]);
             break;
 
+#ifdef ENABLE_MEMORY_STATS
+        case MENU_MEM_INF:
+            MEMSTATS_Update();
+            sprintf(String, "STACK\n%u/%u\nDATA %u",
+                (unsigned)gMemStats.StackPeak, (unsigned)gMemStats.StackSize,
+                (unsigned)(gMemStats.DataSize + gMemStats.BssSize));
+            break;
+#endif
+
         case MENU_F1SHRT:
         case MENU_F1LONG:
         case MENU_F2SHRT:
@@ -158,7 +158,10 @@ enum
     MENU_F2SHRT,
     MENU_F2LONG,
     MENU_MLONG,
-    MENU_BATTYP
+    MENU_BATTYP,
+#ifdef ENABLE_MEMORY_STATS
+    MENU_MEM_INF,
+#endif
 };
 
 extern const uint8_t FIRST_HIDDEN_MENU_ITEM;
@@ -24,6 +24,7 @@
 #endif
 #include "driver/keyboard.h"
 #include "misc.h"
+#include "profile.h"
 #ifdef ENABLE_AIRCOPY
     #include "ui/aircopy.h"
 #endif
@@ -70,9 +71,13 @@ static_assert(ARRAY_SIZE(UI_DisplayFunctions) == DISPLAY_N_ELEM);
 
 void GUI_DisplayScreen(void)
 {
+    PROFILE_ENTER(PROFILE_DISPLAY_SCREEN);
+
     if (gScreenToDisplay != DISPLAY_INVALID) {
         UI_DisplayFunctions[gScreenToDisplay]();
     }
+
+    PROFILE_EXIT(PROFILE_DISPLAY_SCREEN);
 }
 
 void GUI_SelectNextDisplay(GUI_DisplayType_t Display)
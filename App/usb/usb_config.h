@@ -80,6 +80,7 @@
 
 
 /* ================ USB Device Port Configuration ================*/
+#include <stdbool.h>
 #include "py32f0xx.h"
 
 #define USBD_IRQn       USB_IRQn
@@ -96,5 +97,6 @@ typedef struct
 void cdc_acm_init(cdc_acm_rx_buf_t rx_buf);
 void cdc_acm_data_send_with_dtr(const uint8_t *buf, uint32_t size);
 void cdc_acm_data_send_with_dtr_async(const uint8_t *buf, uint32_t size);
+bool cdc_acm_data_send_busy(void);
 
 #endif
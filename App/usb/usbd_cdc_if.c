@@ -199,6 +199,12 @@ void cdc_acm_data_send_with_dtr_async(const uint8_t *buf, uint32_t size)
 {
     if (0 != size)
     {
+        ep_tx_busy_flag = true;
         usbd_ep_start_write(CDC_IN_EP, buf, size);
     }
 }
+
+bool cdc_acm_data_send_busy(void)
+{
+    return ep_tx_busy_flag;
+}
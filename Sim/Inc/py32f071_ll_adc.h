@@ -0,0 +1,40 @@
+#ifndef SIM_PY32F071_LL_ADC_H
+#define SIM_PY32F071_LL_ADC_H
+
+#include "py32f0xx.h"
+
+#define LL_ADC_PATH_INTERNAL_NONE           0x00000000U
+#define LL_ADC_RESOLUTION_12B               0x00000000U
+#define LL_ADC_DATA_ALIGN_RIGHT             0x00000000U
+#define LL_ADC_SEQ_SCAN_DISABLE             0x00000000U
+#define LL_ADC_REG_TRIG_SOFTWARE            0x00000000U
+#define LL_ADC_REG_CONV_SINGLE              0x00000000U
+#define LL_ADC_REG_DMA_TRANSFER_NONE        0x00000000U
+#define LL_ADC_REG_SEQ_SCAN_DISABLE         0x00000000U
+#define LL_ADC_REG_SEQ_DISCONT_DISABLE      0x00000000U
+#define LL_ADC_REG_RANK_1                   0x00000000U
+#define LL_ADC_CHANNEL_8                    0x00000008U
+#define LL_ADC_SAMPLINGTIME_41CYCLES_5      0x00000004U
+
+// The only conversion App performs is the battery divider on PB0 / channel 8
+
+#define LL_ADC_SetCommonPathInternalCh(ADCxy_COMMON, PathInternal)  ((void)(PathInternal))
+#define LL_ADC_SetResolution(ADCx, Resolution)                      ((void)(Resolution))
+#define LL_ADC_SetDataAlignment(ADCx, DataAlignment)                ((void)(DataAlignment))
+#define LL_ADC_SetSequencersScanMode(ADCx, ScanMode)                ((void)(ScanMode))
+#define LL_ADC_REG_SetTriggerSource(ADCx, TriggerSource)            ((void)(TriggerSource))
+#define LL_ADC_REG_SetContinuousMode(ADCx, Continuous)              ((void)(Continuous))
+#define LL_ADC_REG_SetDMATransfer(ADCx, DMATransfer)                ((void)(DMATransfer))
+#define LL_ADC_REG_SetSequencerLength(ADCx, SequencerNbRanks)       ((void)(SequencerNbRanks))
+#define LL_ADC_REG_SetSequencerDiscont(ADCx, SeqDiscont)            ((void)(SeqDiscont))
+#define LL_ADC_REG_SetSequencerRanks(ADCx, Rank, Channel)           ((void)(Rank), (void)(Channel))
+#define LL_ADC_SetChannelSamplingTime(ADCx, Channel, SamplingTime)  ((void)(Channel), (void)(SamplingTime))
+#define LL_ADC_StartCalibration(ADCx)                               ((void)0)
+#define LL_ADC_IsCalibrationOnGoing(ADCx)                           (0U)
+#define LL_ADC_Enable(ADCx)                                         ((void)0)
+#define LL_ADC_REG_StartConversionSWStart(ADCx)                     SIM_Advance(216)
+#define LL_ADC_IsActiveFlag_EOS(ADCx)                               (1U)
+#define LL_ADC_ClearFlag_JEOS(ADCx)                                 ((void)0)
+#define LL_ADC_REG_ReadConversionData12(ADCx)                       SIM_ADC_Read()
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef SIM_PY32F071_LL_BUS_H
+#define SIM_PY32F071_LL_BUS_H
+
+#include "py32f0xx.h"
+
+// Clock gating and peripheral resets have no effect on the models
+
+#define LL_IOP_GRP1_PERIPH_GPIOA    0x00000001U
+#define LL_IOP_GRP1_PERIPH_GPIOB    0x00000002U
+#define LL_IOP_GRP1_PERIPH_GPIOC    0x00000004U
+#define LL_IOP_GRP1_PERIPH_GPIOF    0x00000020U
+
+#define LL_AHB1_GRP1_PERIPH_DMA1    0x00000001U
+
+#define LL_APB1_GRP1_PERIPH_TIM6    0x00000010U
+#define LL_APB1_GRP1_PERIPH_TIM7    0x00000020U
+#define LL_APB1_GRP1_PERIPH_SPI2    0x00004000U
+#define LL_APB1_GRP1_PERIPH_USBD    0x00800000U
+#define LL_APB1_GRP1_PERIPH_DAC1    0x20000000U
+
+#define LL_APB1_GRP2_PERIPH_SYSCFG  0x00000001U
+#define LL_APB1_GRP2_PERIPH_ADC1    0x00000200U
+#define LL_APB1_GRP2_PERIPH_SPI1    0x00001000U
+#define LL_APB1_GRP2_PERIPH_USART1  0x00004000U
+
+#define LL_IOP_GRP1_EnableClock(Periphs)    ((void)(Periphs))
+#define LL_AHB1_GRP1_EnableClock(Periphs)   ((void)(Periphs))
+#define LL_APB1_GRP1_EnableClock(Periphs)   ((void)(Periphs))
+#define LL_APB1_GRP2_EnableClock(Periphs)   ((void)(Periphs))
+#define LL_APB1_GRP1_ForceReset(Periphs)    ((void)(Periphs))
+#define LL_APB1_GRP1_ReleaseReset(Periphs)  ((void)(Periphs))
+#define LL_APB1_GRP2_ForceReset(Periphs)    ((void)(Periphs))
+#define LL_APB1_GRP2_ReleaseReset(Periphs)  ((void)(Periphs))
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef SIM_PY32F071_LL_DMA_H
+#define SIM_PY32F071_LL_DMA_H
+
+#include "py32f0xx.h"
+
+#define LL_DMA_CHANNEL_1                    1U
+#define LL_DMA_CHANNEL_2                    2U
+#define LL_DMA_CHANNEL_3                    3U
+#define LL_DMA_CHANNEL_4                    4U
+#define LL_DMA_CHANNEL_5                    5U
+#define LL_DMA_CHANNEL_6                    6U
+#define LL_DMA_CHANNEL_7                    7U
+
+// Same bit layout as DMA_CCRx
+#define LL_DMA_DIRECTION_PERIPH_TO_MEMORY   0x00000000U
+#define LL_DMA_DIRECTION_MEMORY_TO_PERIPH   0x00000010U
+#define LL_DMA_DIRECTION_MEMORY_TO_MEMORY   0x00004000U
+#define LL_DMA_MODE_NORMAL                  0x00000000U
+#define LL_DMA_MODE_CIRCULAR                0x00000020U
+#define LL_DMA_PERIPH_NOINCREMENT           0x00000000U
+#define LL_DMA_PERIPH_INCREMENT             0x00000040U
+#define LL_DMA_MEMORY_NOINCREMENT           0x00000000U
+#define LL_DMA_MEMORY_INCREMENT             0x00000080U
+#define LL_DMA_PDATAALIGN_BYTE              0x00000000U
+#define LL_DMA_PDATAALIGN_HALFWORD          0x00000100U
+#define LL_DMA_PDATAALIGN_WORD              0x00000200U
+#define LL_DMA_MDATAALIGN_BYTE              0x00000000U
+#define LL_DMA_MDATAALIGN_HALFWORD          0x00000400U
+#define LL_DMA_MDATAALIGN_WORD              0x00000800U
+#define LL_DMA_PRIORITY_LOW                 0x00000000U
+#define LL_DMA_PRIORITY_MEDIUM              0x00001000U
+#define LL_DMA_PRIORITY_HIGH                0x00002000U
+#define LL_DMA_PRIORITY_VERYHIGH            0x00003000U
+
+// Per-channel interrupt / flag bits, as in DMA_ISR >> (4 * (Channel - 1))
+#define SIM_DMA_FLAG_GI                     0x1U
+#define SIM_DMA_FLAG_TC                     0x2U
+#define SIM_DMA_FLAG_HT                     0x4U
+#define SIM_DMA_FLAG_TE                     0x8U
+
+typedef struct
+{
+    uint32_t PeriphOrM2MSrcAddress;
+    uint32_t MemoryOrM2MDstAddress;
+    uint32_t Direction;
+    uint32_t Mode;
+    uint32_t PeriphOrM2MSrcIncMode;
+    uint32_t MemoryOrM2MDstIncMode;
+    uint32_t PeriphOrM2MSrcDataSize;
+    uint32_t MemoryOrM2MDstDataSize;
+    uint32_t NbData;
+    uint32_t Priority;
+} LL_DMA_InitTypeDef;
+
+static inline void LL_DMA_StructInit(LL_DMA_InitTypeDef *DMA_InitStruct)
+{
+    DMA_InitStruct->PeriphOrM2MSrcAddress  = 0;
+    DMA_InitStruct->MemoryOrM2MDstAddress  = 0;
+    DMA_InitStruct->Direction              = LL_DMA_DIRECTION_PERIPH_TO_MEMORY;
+    DMA_InitStruct->Mode                   = LL_DMA_MODE_NORMAL;
+    DMA_InitStruct->PeriphOrM2MSrcIncMode  = LL_DMA_PERIPH_NOINCREMENT;
+    DMA_InitStruct->MemoryOrM2MDstIncMode  = LL_DMA_MEMORY_NOINCREMENT;
+    DMA_InitStruct->PeriphOrM2MSrcDataSize = LL_DMA_PDATAALIGN_BYTE;
+    DMA_InitStruct->MemoryOrM2MDstDataSize = LL_DMA_MDATAALIGN_BYTE;
+    DMA_InitStruct->NbData                 = 0;
+    DMA_InitStruct->Priority               = LL_DMA_PRIORITY_LOW;
+}
+
+static inline uint32_t LL_DMA_Init(DMA_TypeDef *DMAx, uint32_t Channel, LL_DMA_InitTypeDef *DMA_InitStruct)
+{
+    (void)DMAx;
+    SIM_DMA_SetConfig(Channel, DMA_InitStruct->Direction
+                               | DMA_InitStruct->Mode
+                               | DMA_InitStruct->PeriphOrM2MSrcIncMode
+                               | DMA_InitStruct->MemoryOrM2MDstIncMode
+                               | DMA_InitStruct->PeriphOrM2MSrcDataSize
+                               | DMA_InitStruct->MemoryOrM2MDstDataSize
+                               | DMA_InitStruct->Priority);
+    SIM_DMA_SetMemoryAddress(Channel, DMA_InitStruct->MemoryOrM2MDstAddress);
+    SIM_DMA_SetDataLength(Channel, DMA_InitStruct->NbData);
+    return 0;
+}
+
+static inline void LL_DMA_ConfigTransfer(DMA_TypeDef *DMAx, uint32_t Channel, uint32_t Configuration)
+{
+    (void)DMAx;
+    SIM_DMA_SetConfig(Channel, Configuration);
+}
+
+static inline void LL_DMA_ConfigAddresses(DMA_TypeDef *DMAx, uint32_t Channel, uint32_t SrcAddress, uint32_t DstAddress, uint32_t Direction)
+{
+    (void)DMAx;
+    SIM_DMA_SetMemoryAddress(Channel, Direction == LL_DMA_DIRECTION_MEMORY_TO_PERIPH ? SrcAddress : DstAddress);
+}
+
+static inline void LL_DMA_SetMemoryAddress(DMA_TypeDef *DMAx, uint32_t Channel, uint32_t MemoryAddress)
+{
+    (void)DMAx;
+    SIM_DMA_SetMemoryAddress(Channel, MemoryAddress);
+}
+
+static inline void LL_DMA_SetPeriphAddress(DMA_TypeDef *DMAx, uint32_t Channel, uint32_t PeriphAddress)
+{
+    (void)DMAx;
+    (void)Channel;
+    (void)PeriphAddress;
+}
+
+static inline void LL_DMA_SetDataLength(DMA_TypeDef *DMAx, uint32_t Channel, uint32_t NbData)
+{
+    (void)DMAx;
+    SIM_DMA_SetDataLength(Channel, NbData);
+}
+
+static inline uint32_t LL_DMA_GetDataLength(DMA_TypeDef *DMAx, uint32_t Channel)
+{
+    (void)DMAx;
+    return SIM_DMA_GetDataLength(Channel);
+}
+
+static inline void LL_DMA_EnableChannel(DMA_TypeDef *DMAx, uint32_t Channel)
+{
+    (void)DMAx;
+    SIM_DMA_Enable(Channel, true);
+}
+
+static inline void LL_DMA_DisableChannel(DMA_TypeDef *DMAx, uint32_t Channel)
+{
+    (void)DMAx;
+    SIM_DMA_Enable(Channel, false);
+}
+
+static inline uint32_t LL_DMA_IsEnabledChannel(DMA_TypeDef *DMAx, uint32_t Channel)
+{
+    (void)DMAx;
+    return SIM_DMA_IsEnabled(Channel);
+}
+
+static inline void LL_DMA_EnableIT_TC(DMA_TypeDef *DMAx, uint32_t Channel)
+{
+    (void)DMAx;
+    SIM_DMA_EnableIT(Channel, SIM_DMA_FLAG_TC, true);
+}
+
+static inline void LL_DMA_DisableIT_TC(DMA_TypeDef *DMAx, uint32_t Channel)
+{
+    (void)DMAx;
+    SIM_DMA_EnableIT(Channel, SIM_DMA_FLAG_TC, false);
+}
+
+static inline void LL_DMA_EnableIT_HT(DMA_TypeDef *DMAx, uint32_t Channel)
+{
+    (void)DMAx;
+    SIM_DMA_EnableIT(Channel, SIM_DMA_FLAG_HT, true);
+}
+
+static inline void LL_DMA_DisableIT_HT(DMA_TypeDef *DMAx, uint32_t Channel)
+{
+    (void)DMAx;
+    SIM_DMA_EnableIT(Channel, SIM_DMA_FLAG_HT, false);
+}
+
+static inline uint32_t LL_DMA_IsEnabledIT_TC(DMA_TypeDef *DMAx, uint32_t Channel)
+{
+    (void)DMAx;
+    return SIM_DMA_IsEnabledIT(Channel, SIM_DMA_FLAG_TC);
+}
+
+#define SIM_DMA_FLAG_FUNCS(n)                                                   \
+    static inline uint32_t LL_DMA_IsActiveFlag_TC##n(DMA_TypeDef *DMAx)         \
+    { (void)DMAx; return SIM_DMA_IsActiveFlag(n, SIM_DMA_FLAG_TC); }            \
+    static inline uint32_t LL_DMA_IsActiveFlag_HT##n(DMA_TypeDef *DMAx)         \
+    { (void)DMAx; return SIM_DMA_IsActiveFlag(n, SIM_DMA_FLAG_HT); }            \
+    static inline void LL_DMA_ClearFlag_GI##n(DMA_TypeDef *DMAx)                \
+    { (void)DMAx; SIM_DMA_ClearFlag(n, SIM_DMA_FLAG_GI | SIM_DMA_FLAG_TC        \
+                                       | SIM_DMA_FLAG_HT | SIM_DMA_FLAG_TE); }  \
+    static inline void LL_DMA_ClearFlag_TC##n(DMA_TypeDef *DMAx)                \
+    { (void)DMAx; SIM_DMA_ClearFlag(n, SIM_DMA_FLAG_TC); }                      \
+    static inline void LL_DMA_ClearFlag_HT##n(DMA_TypeDef *DMAx)                \
+    { (void)DMAx; SIM_DMA_ClearFlag(n, SIM_DMA_FLAG_HT); }
+
+SIM_DMA_FLAG_FUNCS(1)
+SIM_DMA_FLAG_FUNCS(2)
+SIM_DMA_FLAG_FUNCS(3)
+SIM_DMA_FLAG_FUNCS(4)
+SIM_DMA_FLAG_FUNCS(5)
+SIM_DMA_FLAG_FUNCS(6)
+SIM_DMA_FLAG_FUNCS(7)
+
+#endif
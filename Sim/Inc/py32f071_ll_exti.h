@@ -0,0 +1,92 @@
+#ifndef SIM_PY32F071_LL_EXTI_H
+#define SIM_PY32F071_LL_EXTI_H
+
+#include "py32f0xx.h"
+
+// Lines 0-15 only, the GPIO ones. LL_EXTI_CONFIG_LINEx is the line number
+// here rather than the packed EXTICR field of the real header.
+#define LL_EXTI_LINE_0              0x0001U
+#define LL_EXTI_LINE_1              0x0002U
+#define LL_EXTI_LINE_2              0x0004U
+#define LL_EXTI_LINE_3              0x0008U
+#define LL_EXTI_LINE_4              0x0010U
+#define LL_EXTI_LINE_5              0x0020U
+#define LL_EXTI_LINE_6              0x0040U
+#define LL_EXTI_LINE_7              0x0080U
+#define LL_EXTI_LINE_8              0x0100U
+#define LL_EXTI_LINE_9              0x0200U
+#define LL_EXTI_LINE_10             0x0400U
+#define LL_EXTI_LINE_11             0x0800U
+#define LL_EXTI_LINE_12             0x1000U
+#define LL_EXTI_LINE_13             0x2000U
+#define LL_EXTI_LINE_14             0x4000U
+#define LL_EXTI_LINE_15             0x8000U
+
+#define LL_EXTI_CONFIG_PORTA        SIM_PORT_A
+#define LL_EXTI_CONFIG_PORTB        SIM_PORT_B
+#define LL_EXTI_CONFIG_PORTC        SIM_PORT_C
+#define LL_EXTI_CONFIG_PORTF        SIM_PORT_F
+
+#define LL_EXTI_CONFIG_LINE0        0U
+#define LL_EXTI_CONFIG_LINE1        1U
+#define LL_EXTI_CONFIG_LINE2        2U
+#define LL_EXTI_CONFIG_LINE3        3U
+#define LL_EXTI_CONFIG_LINE4        4U
+#define LL_EXTI_CONFIG_LINE5        5U
+#define LL_EXTI_CONFIG_LINE6        6U
+#define LL_EXTI_CONFIG_LINE7        7U
+#define LL_EXTI_CONFIG_LINE8        8U
+#define LL_EXTI_CONFIG_LINE9        9U
+#define LL_EXTI_CONFIG_LINE10       10U
+#define LL_EXTI_CONFIG_LINE11       11U
+#define LL_EXTI_CONFIG_LINE12       12U
+#define LL_EXTI_CONFIG_LINE13       13U
+#define LL_EXTI_CONFIG_LINE14       14U
+#define LL_EXTI_CONFIG_LINE15       15U
+
+static inline void LL_EXTI_SetEXTISource(uint32_t Port, uint32_t Line)
+{
+    SIM_EXTI_SetSource(Line, Port);
+}
+
+static inline void LL_EXTI_EnableIT(uint32_t ExtiLine)
+{
+    SIM_EXTI_Configure(SIM_EXTI_IMR, ExtiLine, true);
+}
+
+static inline void LL_EXTI_DisableIT(uint32_t ExtiLine)
+{
+    SIM_EXTI_Configure(SIM_EXTI_IMR, ExtiLine, false);
+}
+
+static inline void LL_EXTI_EnableRisingTrig(uint32_t ExtiLine)
+{
+    SIM_EXTI_Configure(SIM_EXTI_RTSR, ExtiLine, true);
+}
+
+static inline void LL_EXTI_DisableRisingTrig(uint32_t ExtiLine)
+{
+    SIM_EXTI_Configure(SIM_EXTI_RTSR, ExtiLine, false);
+}
+
+static inline void LL_EXTI_EnableFallingTrig(uint32_t ExtiLine)
+{
+    SIM_EXTI_Configure(SIM_EXTI_FTSR, ExtiLine, true);
+}
+
+static inline void LL_EXTI_DisableFallingTrig(uint32_t ExtiLine)
+{
+    SIM_EXTI_Configure(SIM_EXTI_FTSR, ExtiLine, false);
+}
+
+static inline uint32_t LL_EXTI_IsActiveFlag(uint32_t ExtiLine)
+{
+    return (SIM_EXTI_Pending() & ExtiLine) == ExtiLine;
+}
+
+static inline void LL_EXTI_ClearFlag(uint32_t ExtiLine)
+{
+    SIM_EXTI_ClearPending(ExtiLine);
+}
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef SIM_PY32F071_LL_GPIO_H
+#define SIM_PY32F071_LL_GPIO_H
+
+#include "py32f0xx.h"
+
+#define LL_GPIO_PIN_0               0x0001U
+#define LL_GPIO_PIN_1               0x0002U
+#define LL_GPIO_PIN_2               0x0004U
+#define LL_GPIO_PIN_3               0x0008U
+#define LL_GPIO_PIN_4               0x0010U
+#define LL_GPIO_PIN_5               0x0020U
+#define LL_GPIO_PIN_6               0x0040U
+#define LL_GPIO_PIN_7               0x0080U
+#define LL_GPIO_PIN_8               0x0100U
+#define LL_GPIO_PIN_9               0x0200U
+#define LL_GPIO_PIN_10              0x0400U
+#define LL_GPIO_PIN_11              0x0800U
+#define LL_GPIO_PIN_12              0x1000U
+#define LL_GPIO_PIN_13              0x2000U
+#define LL_GPIO_PIN_14              0x4000U
+#define LL_GPIO_PIN_15              0x8000U
+#define LL_GPIO_PIN_ALL             0xFFFFU
+
+#define LL_GPIO_MODE_INPUT          0x0U
+#define LL_GPIO_MODE_OUTPUT         0x1U
+#define LL_GPIO_MODE_ALTERNATE      0x2U
+#define LL_GPIO_MODE_ANALOG         0x3U
+
+#define LL_GPIO_OUTPUT_PUSHPULL     0x0U
+#define LL_GPIO_OUTPUT_OPENDRAIN    0x1U
+
+#define LL_GPIO_SPEED_FREQ_LOW      0x0U
+#define LL_GPIO_SPEED_FREQ_MEDIUM   0x1U
+#define LL_GPIO_SPEED_FREQ_HIGH     0x2U
+#define LL_GPIO_SPEED_FREQ_VERY_HIGH 0x3U
+
+#define LL_GPIO_PULL_NO             0x0U
+#define LL_GPIO_PULL_UP             0x1U
+#define LL_GPIO_PULL_DOWN           0x2U
+
+#define LL_GPIO_AF_0                0x0U
+#define LL_GPIO_AF_1                0x1U
+#define LL_GPIO_AF_8                0x8U
+#define LL_GPIO_AF_9                0x9U
+#define LL_GPIO_AF0_SPI1            LL_GPIO_AF_0
+#define LL_GPIO_AF1_USART1          LL_GPIO_AF_1
+#define LL_GPIO_AF8_SPI2            LL_GPIO_AF_8
+#define LL_GPIO_AF9_SPI2            LL_GPIO_AF_9
+
+typedef struct
+{
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Speed;
+    uint32_t OutputType;
+    uint32_t Pull;
+    uint32_t Alternate;
+} LL_GPIO_InitTypeDef;
+
+static inline void LL_GPIO_SetOutputPin(GPIO_TypeDef *GPIOx, uint32_t PinMask)
+{
+    SIM_GPIO_Write(SIM_GPIO_Port(GPIOx), PinMask, 0);
+}
+
+static inline void LL_GPIO_ResetOutputPin(GPIO_TypeDef *GPIOx, uint32_t PinMask)
+{
+    SIM_GPIO_Write(SIM_GPIO_Port(GPIOx), 0, PinMask);
+}
+
+static inline void LL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint32_t PinMask)
+{
+    const unsigned Port = SIM_GPIO_Port(GPIOx);
+    const uint32_t Odr = SIM_GPIO_ReadOutput(Port);
+    SIM_GPIO_Write(Port, ~Odr & PinMask, Odr & PinMask);
+}
+
+static inline uint32_t LL_GPIO_IsInputPinSet(GPIO_TypeDef *GPIOx, uint32_t PinMask)
+{
+    return (SIM_GPIO_ReadInput(SIM_GPIO_Port(GPIOx)) & PinMask) == PinMask;
+}
+
+static inline uint32_t LL_GPIO_IsOutputPinSet(GPIO_TypeDef *GPIOx, uint32_t PinMask)
+{
+    return (SIM_GPIO_ReadOutput(SIM_GPIO_Port(GPIOx)) & PinMask) == PinMask;
+}
+
+static inline uint32_t LL_GPIO_ReadInputPort(GPIO_TypeDef *GPIOx)
+{
+    return SIM_GPIO_ReadInput(SIM_GPIO_Port(GPIOx));
+}
+
+static inline void LL_GPIO_SetPinMode(GPIO_TypeDef *GPIOx, uint32_t Pin, uint32_t Mode)
+{
+    SIM_GPIO_SetMode(SIM_GPIO_Port(GPIOx), Pin, Mode);
+}
+
+static inline void LL_GPIO_StructInit(LL_GPIO_InitTypeDef *GPIO_InitStruct)
+{
+    GPIO_InitStruct->Pin        = LL_GPIO_PIN_ALL;
+    GPIO_InitStruct->Mode       = LL_GPIO_MODE_ANALOG;
+    GPIO_InitStruct->Speed      = LL_GPIO_SPEED_FREQ_LOW;
+    GPIO_InitStruct->OutputType = LL_GPIO_OUTPUT_PUSHPULL;
+    GPIO_InitStruct->Pull       = LL_GPIO_PULL_NO;
+    GPIO_InitStruct->Alternate  = LL_GPIO_AF_0;
+}
+
+static inline uint32_t LL_GPIO_Init(GPIO_TypeDef *GPIOx, LL_GPIO_InitTypeDef *GPIO_InitStruct)
+{
+    SIM_GPIO_SetMode(SIM_GPIO_Port(GPIOx), GPIO_InitStruct->Pin, GPIO_InitStruct->Mode);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef SIM_PY32F071_LL_RCC_H
+#define SIM_PY32F071_LL_RCC_H
+
+#include "py32f0xx.h"
+
+#define LL_RCC_ADC_CLKSOURCE_PCLK_DIV4  0x00000002U
+
+#define LL_RCC_SetADCClockSource(Source)    ((void)(Source))
+
+#endif
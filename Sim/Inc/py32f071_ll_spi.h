@@ -0,0 +1,154 @@
+#ifndef SIM_PY32F071_LL_SPI_H
+#define SIM_PY32F071_LL_SPI_H
+
+#include "py32f0xx.h"
+
+#define LL_SPI_FULL_DUPLEX                  0x00000000U
+#define LL_SPI_MODE_MASTER                  0x00000104U
+#define LL_SPI_MODE_SLAVE                   0x00000000U
+#define LL_SPI_DATAWIDTH_8BIT               0x00000000U
+#define LL_SPI_DATAWIDTH_16BIT              0x00000800U
+#define LL_SPI_POLARITY_LOW                 0x00000000U
+#define LL_SPI_POLARITY_HIGH                0x00000002U
+#define LL_SPI_PHASE_1EDGE                  0x00000000U
+#define LL_SPI_PHASE_2EDGE                  0x00000001U
+#define LL_SPI_NSS_SOFT                     0x00000200U
+#define LL_SPI_MSB_FIRST                    0x00000000U
+#define LL_SPI_LSB_FIRST                    0x00000080U
+#define LL_SPI_CRCCALCULATION_DISABLE       0x00000000U
+
+// Prescaler values are encoded as the actual division factor
+#define LL_SPI_BAUDRATEPRESCALER_DIV2       2U
+#define LL_SPI_BAUDRATEPRESCALER_DIV4       4U
+#define LL_SPI_BAUDRATEPRESCALER_DIV8       8U
+#define LL_SPI_BAUDRATEPRESCALER_DIV16      16U
+#define LL_SPI_BAUDRATEPRESCALER_DIV32      32U
+#define LL_SPI_BAUDRATEPRESCALER_DIV64      64U
+#define LL_SPI_BAUDRATEPRESCALER_DIV128     128U
+#define LL_SPI_BAUDRATEPRESCALER_DIV256     256U
+
+#define LL_SPI_TX_FIFO_EMPTY                0x00000000U
+#define LL_SPI_RX_FIFO_EMPTY                0x00000000U
+
+typedef struct
+{
+    uint32_t TransferDirection;
+    uint32_t Mode;
+    uint32_t DataWidth;
+    uint32_t ClockPolarity;
+    uint32_t ClockPhase;
+    uint32_t NSS;
+    uint32_t BaudRate;
+    uint32_t BitOrder;
+    uint32_t CRCCalculation;
+    uint32_t CRCPoly;
+} LL_SPI_InitTypeDef;
+
+static inline void LL_SPI_StructInit(LL_SPI_InitTypeDef *SPI_InitStruct)
+{
+    SPI_InitStruct->TransferDirection = LL_SPI_FULL_DUPLEX;
+    SPI_InitStruct->Mode              = LL_SPI_MODE_SLAVE;
+    SPI_InitStruct->DataWidth         = LL_SPI_DATAWIDTH_8BIT;
+    SPI_InitStruct->ClockPolarity     = LL_SPI_POLARITY_LOW;
+    SPI_InitStruct->ClockPhase        = LL_SPI_PHASE_1EDGE;
+    SPI_InitStruct->NSS               = LL_SPI_NSS_SOFT;
+    SPI_InitStruct->BaudRate          = LL_SPI_BAUDRATEPRESCALER_DIV2;
+    SPI_InitStruct->BitOrder          = LL_SPI_MSB_FIRST;
+    SPI_InitStruct->CRCCalculation    = LL_SPI_CRCCALCULATION_DISABLE;
+    SPI_InitStruct->CRCPoly           = 7U;
+}
+
+static inline uint32_t LL_SPI_Init(SPI_TypeDef *SPIx, LL_SPI_InitTypeDef *SPI_InitStruct)
+{
+    SIM_SPI_SetPrescaler(SIM_SPI_Index(SPIx), SPI_InitStruct->BaudRate);
+    return 0;
+}
+
+static inline void LL_SPI_SetBaudRatePrescaler(SPI_TypeDef *SPIx, uint32_t BaudRate)
+{
+    SIM_SPI_SetPrescaler(SIM_SPI_Index(SPIx), BaudRate);
+}
+
+static inline void LL_SPI_Enable(SPI_TypeDef *SPIx)
+{
+    (void)SPIx;
+}
+
+static inline void LL_SPI_Disable(SPI_TypeDef *SPIx)
+{
+    (void)SPIx;
+}
+
+static inline uint32_t LL_SPI_IsActiveFlag_TXE(SPI_TypeDef *SPIx)
+{
+    (void)SPIx;
+    SIM_Advance(SIM_COST_PERIPH);
+    return 1;
+}
+
+static inline uint32_t LL_SPI_IsActiveFlag_RXNE(SPI_TypeDef *SPIx)
+{
+    (void)SPIx;
+    SIM_Advance(SIM_COST_PERIPH);
+    return 1;
+}
+
+static inline uint32_t LL_SPI_IsActiveFlag_BSY(SPI_TypeDef *SPIx)
+{
+    (void)SPIx;
+    return 0;
+}
+
+static inline uint32_t LL_SPI_GetTxFIFOLevel(SPI_TypeDef *SPIx)
+{
+    (void)SPIx;
+    return LL_SPI_TX_FIFO_EMPTY;
+}
+
+static inline uint32_t LL_SPI_GetRxFIFOLevel(SPI_TypeDef *SPIx)
+{
+    (void)SPIx;
+    return LL_SPI_RX_FIFO_EMPTY;
+}
+
+// The exchange happens on transmit; the received byte is latched until read
+extern uint8_t gSimSpiRx[SIM_SPI_COUNT];
+
+static inline void LL_SPI_TransmitData8(SPI_TypeDef *SPIx, uint8_t TxData)
+{
+    const unsigned Spi = SIM_SPI_Index(SPIx);
+    gSimSpiRx[Spi] = SIM_SPI_Transfer(Spi, TxData);
+}
+
+static inline uint8_t LL_SPI_ReceiveData8(SPI_TypeDef *SPIx)
+{
+    return gSimSpiRx[SIM_SPI_Index(SPIx)];
+}
+
+static inline void LL_SPI_EnableDMAReq_RX(SPI_TypeDef *SPIx)
+{
+    (void)SPIx;
+}
+
+static inline void LL_SPI_DisableDMAReq_RX(SPI_TypeDef *SPIx)
+{
+    (void)SPIx;
+}
+
+// Drivers enable the TX request last, which is what starts the clock
+static inline void LL_SPI_EnableDMAReq_TX(SPI_TypeDef *SPIx)
+{
+    SIM_SPI_StartDMA(SIM_SPI_Index(SPIx));
+}
+
+static inline void LL_SPI_DisableDMAReq_TX(SPI_TypeDef *SPIx)
+{
+    (void)SPIx;
+}
+
+static inline uint32_t LL_SPI_DMA_GetRegAddr(SPI_TypeDef *SPIx)
+{
+    return (uint32_t)(uintptr_t)&SPIx->DR;
+}
+
+#endif
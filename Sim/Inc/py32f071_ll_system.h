@@ -0,0 +1,22 @@
+#ifndef SIM_PY32F071_LL_SYSTEM_H
+#define SIM_PY32F071_LL_SYSTEM_H
+
+#include "py32f0xx.h"
+
+#define LL_SYSCFG_DMA_MAP_ADC1          0x00000000U
+#define LL_SYSCFG_DMA_MAP_SPI1_RD       0x00000001U
+#define LL_SYSCFG_DMA_MAP_SPI1_WR       0x00000002U
+#define LL_SYSCFG_DMA_MAP_SPI2_RD       0x00000003U
+#define LL_SYSCFG_DMA_MAP_SPI2_WR       0x00000004U
+#define LL_SYSCFG_DMA_MAP_USART1_RD     0x00000005U
+#define LL_SYSCFG_DMA_MAP_USART1_WR     0x00000006U
+#define LL_SYSCFG_DMA_MAP_DAC1          0x0000000DU
+#define LL_SYSCFG_DMA_MAP_TIM7_UP       0x00000021U
+
+static inline void LL_SYSCFG_SetDMARemap(DMA_TypeDef *DMAx, uint32_t Channel, uint32_t Request)
+{
+    (void)DMAx;
+    SIM_DMA_SetRemap(Channel, Request);
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef SIM_PY32F071_LL_TIM_H
+#define SIM_PY32F071_LL_TIM_H
+
+#include "py32f0xx.h"
+
+#define LL_TIM_TRGO_UPDATE  0x00000020U
+
+// Timers only pace DMA into the backlight port and the DAC, neither of
+// which is modelled, so only the counter enable bit is kept.
+
+static inline void LL_TIM_EnableCounter(TIM_TypeDef *TIMx)              { SIM_TIM(TIMx)->CR1 |= 1U; }
+static inline void LL_TIM_DisableCounter(TIM_TypeDef *TIMx)             { SIM_TIM(TIMx)->CR1 &= ~1U; }
+static inline uint32_t LL_TIM_IsEnabledCounter(TIM_TypeDef *TIMx)       { return SIM_TIM(TIMx)->CR1 & 1U; }
+static inline void LL_TIM_SetPrescaler(TIM_TypeDef *TIMx, uint32_t v)   { (void)TIMx; (void)v; }
+static inline void LL_TIM_SetAutoReload(TIM_TypeDef *TIMx, uint32_t v)  { SIM_TIM(TIMx)->ARR = v; }
+static inline void LL_TIM_EnableARRPreload(TIM_TypeDef *TIMx)           { (void)TIMx; }
+static inline void LL_TIM_EnableDMAReq_UPDATE(TIM_TypeDef *TIMx)        { (void)TIMx; }
+static inline void LL_TIM_EnableUpdateEvent(TIM_TypeDef *TIMx)          { (void)TIMx; }
+static inline void LL_TIM_SetTriggerOutput(TIM_TypeDef *TIMx, uint32_t v) { (void)TIMx; (void)v; }
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef SIM_PY32F071_LL_USART_H
+#define SIM_PY32F071_LL_USART_H
+
+#include "py32f0xx.h"
+
+#define LL_USART_DIRECTION_NONE         0x00000000U
+#define LL_USART_DIRECTION_RX           0x00000004U
+#define LL_USART_DIRECTION_TX           0x00000008U
+#define LL_USART_DIRECTION_TX_RX        0x0000000CU
+#define LL_USART_DATAWIDTH_8B           0x00000000U
+#define LL_USART_STOPBITS_1             0x00000000U
+#define LL_USART_PARITY_NONE            0x00000000U
+#define LL_USART_HWCONTROL_NONE         0x00000000U
+#define LL_USART_OVERSAMPLING_16        0x00000000U
+
+typedef struct
+{
+    uint32_t BaudRate;
+    uint32_t DataWidth;
+    uint32_t StopBits;
+    uint32_t Parity;
+    uint32_t TransferDirection;
+    uint32_t HardwareFlowControl;
+    uint32_t OverSampling;
+} LL_USART_InitTypeDef;
+
+static inline void LL_USART_StructInit(LL_USART_InitTypeDef *USART_InitStruct)
+{
+    USART_InitStruct->BaudRate            = 9600U;
+    USART_InitStruct->DataWidth           = LL_USART_DATAWIDTH_8B;
+    USART_InitStruct->StopBits            = LL_USART_STOPBITS_1;
+    USART_InitStruct->Parity              = LL_USART_PARITY_NONE;
+    USART_InitStruct->TransferDirection   = LL_USART_DIRECTION_TX_RX;
+    USART_InitStruct->HardwareFlowControl = LL_USART_HWCONTROL_NONE;
+    USART_InitStruct->OverSampling        = LL_USART_OVERSAMPLING_16;
+}
+
+static inline uint32_t LL_USART_Init(USART_TypeDef *USARTx, LL_USART_InitTypeDef *USART_InitStruct)
+{
+    (void)USARTx;
+    SIM_USART_SetBaudRate(USART_InitStruct->BaudRate);
+    return 0;
+}
+
+static inline void LL_USART_Enable(USART_TypeDef *USARTx)
+{
+    (void)USARTx;
+}
+
+static inline void LL_USART_Disable(USART_TypeDef *USARTx)
+{
+    (void)USARTx;
+}
+
+static inline void LL_USART_EnableDMAReq_RX(USART_TypeDef *USARTx)
+{
+    (void)USARTx;
+}
+
+static inline void LL_USART_EnableDMAReq_TX(USART_TypeDef *USARTx)
+{
+    (void)USARTx;
+    SIM_USART_StartDMA();
+}
+
+static inline void LL_USART_DisableDMAReq_TX(USART_TypeDef *USARTx)
+{
+    (void)USARTx;
+}
+
+static inline uint32_t LL_USART_IsActiveFlag_TXE(USART_TypeDef *USARTx)
+{
+    (void)USARTx;
+    return SIM_USART_IsTxEmpty();
+}
+
+static inline uint32_t LL_USART_IsActiveFlag_TC(USART_TypeDef *USARTx)
+{
+    (void)USARTx;
+    return SIM_USART_IsTxEmpty();
+}
+
+static inline void LL_USART_TransmitData8(USART_TypeDef *USARTx, uint8_t Value)
+{
+    (void)USARTx;
+    SIM_USART_Transmit(Value);
+}
+
+static inline uint32_t LL_USART_DMA_GetRegAddr(USART_TypeDef *USARTx)
+{
+    return (uint32_t)(uintptr_t)&USARTx->DR;
+}
+
+#endif
@@ -0,0 +1,166 @@
+// Host stand-in for the PY32F071 device header.
+//
+// Peripheral instances keep their real base addresses so that App code
+// (GPIO_MAKE_PIN and friends) compiles unchanged, but they are never
+// dereferenced: every register access goes through the LL shims, which
+// forward to the device models in Sim/Src.
+
+#ifndef SIM_PY32F0XX_H
+#define SIM_PY32F0XX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sim.h"
+
+#define __I  volatile const
+#define __O  volatile
+#define __IO volatile
+
+#define __UNUSED __attribute__((unused))
+
+#define __NOP()         SIM_Advance(1)
+#define __DSB()         do {} while (0)
+#define __disable_irq() SIM_DisableIRQ()
+#define __enable_irq()  SIM_EnableIRQ()
+
+typedef enum
+{
+    NonMaskableInt_IRQn      = -14,
+    HardFault_IRQn           = -13,
+    SVCall_IRQn              = -5,
+    PendSV_IRQn              = -2,
+    SysTick_IRQn             = -1,
+    WWDG_IRQn                = 0,
+    PVD_IRQn                 = 1,
+    RTC_IRQn                 = 2,
+    FLASH_IRQn               = 3,
+    RCC_CTC_IRQn             = 4,
+    EXTI0_1_IRQn             = 5,
+    EXTI2_3_IRQn             = 6,
+    EXTI4_15_IRQn            = 7,
+    LCD_IRQn                 = 8,
+    DMA1_Channel1_IRQn       = 9,
+    DMA1_Channel2_3_IRQn     = 10,
+    DMA1_Channel4_5_6_7_IRQn = 11,
+    ADC_COMP_IRQn            = 12,
+    TIM1_BRK_UP_TRG_COM_IRQn = 13,
+    TIM1_CC_IRQn             = 14,
+    TIM2_IRQn                = 15,
+    TIM3_IRQn                = 16,
+    TIM6_LPTIM1_DAC_IRQn     = 17,
+    TIM7_IRQn                = 18,
+    TIM14_IRQn               = 19,
+    TIM15_IRQn               = 20,
+    TIM16_IRQn               = 21,
+    TIM17_IRQn               = 22,
+    I2C1_IRQn                = 23,
+    I2C2_IRQn                = 24,
+    SPI1_IRQn                = 25,
+    SPI2_IRQn                = 26,
+    USART1_IRQn              = 27,
+    USART2_IRQn              = 28,
+    USART3_4_IRQn            = 29,
+    CAN_IRQn                 = 30,
+    USB_IRQn                 = 31,
+} IRQn_Type;
+
+typedef struct
+{
+    __IO uint32_t CTRL;
+    __IO uint32_t LOAD;
+    __IO uint32_t VAL;
+    __I  uint32_t CALIB;
+} SysTick_Type;
+
+#define SysTick_CTRL_COUNTFLAG_Pos 16U
+#define SysTick_CTRL_COUNTFLAG_Msk (1UL << SysTick_CTRL_COUNTFLAG_Pos)
+#define SysTick_CTRL_ENABLE_Msk    (1UL)
+#define SysTick_LOAD_RELOAD_Msk    (0xFFFFFFUL)
+#define SysTick_VAL_CURRENT_Msk    (0xFFFFFFUL)
+
+// Every read of SysTick refreshes VAL from the virtual clock, the same way
+// the real down-counter keeps running between two reads.
+#define SysTick ((SysTick_Type *)SIM_SysTick())
+
+typedef struct
+{
+    __I  uint32_t CPUID;
+    __IO uint32_t ICSR;
+} SCB_Type;
+
+#define SCB_ICSR_PENDSTSET_Pos 26U
+#define SCB_ICSR_PENDSTSET_Msk (1UL << SCB_ICSR_PENDSTSET_Pos)
+
+// Only ICSR is modelled, PENDSTSET follows a SysTick held off by a
+// critical section.
+#define SCB ((SCB_Type *)SIM_SCB())
+
+typedef struct
+{
+    __IO uint32_t MODER;
+    __IO uint32_t OTYPER;
+    __IO uint32_t OSPEEDR;
+    __IO uint32_t PUPDR;
+    __IO uint32_t IDR;
+    __IO uint32_t ODR;
+    __IO uint32_t BSRR;
+    __IO uint32_t LCKR;
+    __IO uint32_t AFR[2];
+    __IO uint32_t BRR;
+} GPIO_TypeDef;
+
+typedef struct { __IO uint32_t SR; __IO uint32_t DR; } SPI_TypeDef;
+typedef struct { __IO uint32_t SR; __IO uint32_t DR; } USART_TypeDef;
+typedef struct { __IO uint32_t ISR; __IO uint32_t IFCR; } DMA_TypeDef;
+typedef struct { __IO uint32_t ISR; __IO uint32_t DR; } ADC_TypeDef;
+typedef struct { __IO uint32_t CCR; } ADC_Common_TypeDef;
+typedef struct { __IO uint32_t CR1; __IO uint32_t ARR; } TIM_TypeDef;
+typedef struct { __IO uint32_t CR; __IO uint32_t DHR12R1; } DAC_TypeDef;
+
+#define PERIPH_BASE     0x40000000UL
+#define APBPERIPH_BASE  (PERIPH_BASE)
+#define AHBPERIPH_BASE  (PERIPH_BASE + 0x00020000UL)
+#define IOPORT_BASE     0x50000000UL
+
+#define TIM6_BASE       (APBPERIPH_BASE + 0x00001000UL)
+#define TIM7_BASE       (APBPERIPH_BASE + 0x00001400UL)
+#define SPI2_BASE       (APBPERIPH_BASE + 0x00003800UL)
+#define DAC1_BASE       (APBPERIPH_BASE + 0x00007400UL)
+#define ADC1_BASE       (APBPERIPH_BASE + 0x00012400UL)
+#define ADC_BASE        (APBPERIPH_BASE + 0x00012708UL)
+#define SPI1_BASE       (APBPERIPH_BASE + 0x00013000UL)
+#define USART1_BASE     (APBPERIPH_BASE + 0x00013800UL)
+#define DMA1_BASE       (AHBPERIPH_BASE + 0x00000000UL)
+
+#define GPIOA_BASE      (IOPORT_BASE + 0x00000000UL)
+#define GPIOB_BASE      (IOPORT_BASE + 0x00000400UL)
+#define GPIOC_BASE      (IOPORT_BASE + 0x00000800UL)
+#define GPIOF_BASE      (IOPORT_BASE + 0x00001400UL)
+
+#define TIM6            ((TIM_TypeDef *) TIM6_BASE)
+#define TIM7            ((TIM_TypeDef *) TIM7_BASE)
+#define SPI1            ((SPI_TypeDef *) SPI1_BASE)
+#define SPI2            ((SPI_TypeDef *) SPI2_BASE)
+#define DAC1            ((DAC_TypeDef *) DAC1_BASE)
+#define ADC1            ((ADC_TypeDef *) ADC1_BASE)
+#define ADC1_COMMON     ((ADC_Common_TypeDef *) ADC_BASE)
+#define USART1          ((USART_TypeDef *) USART1_BASE)
+#define DMA1            ((DMA_TypeDef *) DMA1_BASE)
+#define GPIOA           ((GPIO_TypeDef *) GPIOA_BASE)
+#define GPIOB           ((GPIO_TypeDef *) GPIOB_BASE)
+#define GPIOC           ((GPIO_TypeDef *) GPIOC_BASE)
+#define GPIOF           ((GPIO_TypeDef *) GPIOF_BASE)
+
+TIM_TypeDef *SIM_TIM(const TIM_TypeDef *TIMx);
+
+extern uint32_t SystemCoreClock;
+
+uint32_t SysTick_Config(uint32_t ticks);
+
+void NVIC_EnableIRQ(IRQn_Type IRQn);
+void NVIC_DisableIRQ(IRQn_Type IRQn);
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority);
+void NVIC_SystemReset(void) __attribute__((noreturn));
+
+#endif
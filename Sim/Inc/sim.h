@@ -0,0 +1,148 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+// Virtual CPU clock, same as the real HCLK after SystemClock_Config()
+#define SIM_CPU_CLOCK 48000000u
+
+#define SIM_US_TO_CYCLES(us) ((uint64_t)(us) * (SIM_CPU_CLOCK / 1000000u))
+#define SIM_MS_TO_CYCLES(ms) ((uint64_t)(ms) * (SIM_CPU_CLOCK / 1000u))
+
+// Rough cost, in CPU cycles, of the operations the shims stand in for
+#define SIM_COST_SYSTICK_READ   6
+#define SIM_COST_GPIO           3
+#define SIM_COST_PERIPH         4
+
+enum
+{
+    SIM_PORT_A = 0,
+    SIM_PORT_B,
+    SIM_PORT_C,
+    SIM_PORT_F,
+    SIM_PORT_COUNT
+};
+
+enum
+{
+    SIM_EXTI_IMR = 0,
+    SIM_EXTI_RTSR,
+    SIM_EXTI_FTSR,
+    SIM_EXTI_REG_COUNT
+};
+
+enum
+{
+    SIM_SPI_1 = 0,
+    SIM_SPI_2,
+    SIM_SPI_COUNT
+};
+
+typedef struct
+{
+    uint64_t EndCycles;         // 0 = run forever
+    uint32_t LoopCycles;        // charged per Main() loop pass
+    bool     RealTime;          // pace the virtual clock to the wall clock
+    bool     DumpScreen;        // print the LCD when the run ends
+    bool     BusReport;         // charge BK4819 bus time to call sites
+    const char *pFlashFile;     // PY25Q16 image, loaded at start and saved at exit
+    uint64_t PowerCut;          // cut power during this PY25Q16 program / erase, 0 = never
+} SIM_Config_t;
+
+extern SIM_Config_t gSimConfig;
+extern uint64_t     gSimCycles;
+extern uint64_t     gSimLoopPasses;
+extern uintptr_t    gSimStackBottom;    // Main() stack, see main.c
+extern uintptr_t    gSimStackTop;
+
+// clock.c
+void     SIM_Advance(uint32_t Cycles);
+void    *SIM_SysTick(void);
+void     SIM_SysTickConfig(uint32_t Reload);
+void    *SIM_SCB(void);
+void     SIM_DisableIRQ(void);
+void     SIM_EnableIRQ(void);
+void     SIM_SetIRQEnabled(int IRQn, bool Enabled);
+bool     SIM_IsIRQEnabled(int IRQn);
+void     SIM_Idle(void);
+void     SIM_Exit(int Code) __attribute__((noreturn));
+
+// gpio.c
+unsigned SIM_GPIO_Port(const void *GPIOx);
+void     SIM_GPIO_Write(unsigned Port, uint32_t Set, uint32_t Reset);
+void     SIM_GPIO_SetMode(unsigned Port, uint32_t Pins, uint32_t Mode);
+uint32_t SIM_GPIO_ReadInput(unsigned Port);
+uint32_t SIM_GPIO_ReadOutput(unsigned Port);
+bool     SIM_GPIO_IsOutput(unsigned Port, uint32_t Pin);
+void     SIM_EXTI_SetSource(unsigned Line, unsigned Port);
+void     SIM_EXTI_Configure(unsigned Reg, uint32_t Lines, bool Set);
+uint32_t SIM_EXTI_Pending(void);
+void     SIM_EXTI_ClearPending(uint32_t Lines);
+void     SIM_EXTI_Update(void);
+
+// periph.c
+unsigned SIM_SPI_Index(const void *SPIx);
+void     SIM_SPI_SetPrescaler(unsigned Spi, uint32_t Prescaler);
+uint8_t  SIM_SPI_Transfer(unsigned Spi, uint8_t Value);
+void     SIM_DMA_SetConfig(unsigned Channel, uint32_t Config);
+uint32_t SIM_DMA_GetConfig(unsigned Channel);
+void     SIM_DMA_SetMemoryAddress(unsigned Channel, uint32_t Address);
+void     SIM_DMA_SetDataLength(unsigned Channel, uint32_t Length);
+uint32_t SIM_DMA_GetDataLength(unsigned Channel);
+void     SIM_DMA_Enable(unsigned Channel, bool Enable);
+bool     SIM_DMA_IsEnabled(unsigned Channel);
+void     SIM_DMA_EnableIT(unsigned Channel, uint32_t Mask, bool Enable);
+bool     SIM_DMA_IsEnabledIT(unsigned Channel, uint32_t Mask);
+bool     SIM_DMA_IsActiveFlag(unsigned Channel, uint32_t Mask);
+void     SIM_DMA_ClearFlag(unsigned Channel, uint32_t Mask);
+void     SIM_DMA_SetRemap(unsigned Channel, uint32_t Request);
+void     SIM_SPI_StartDMA(unsigned Spi);
+void     SIM_USART_SetBaudRate(uint32_t BaudRate);
+void     SIM_USART_Transmit(uint8_t Value);
+bool     SIM_USART_IsTxEmpty(void);
+void     SIM_USART_StartDMA(void);
+void     SIM_USART_Update(void);
+void     SIM_USART_Receive(uint8_t Value);
+uint16_t SIM_ADC_Read(void);
+
+// Device models
+void     SIM_BK4819_Init(void);
+bool     SIM_BK4819_Parse(const char *pArg);
+bool     SIM_BK4819_LoadTrace(const char *pFile);
+bool     SIM_BK4819_OpenLog(const char *pFile);
+void     SIM_BK4819_Pins(bool Cs, bool Scl, bool Sda);
+bool     SIM_BK4819_Sda(void);
+bool     SIM_BK4819_Irq(void);
+void     SIM_BK4819_Report(FILE *pFile);
+
+void     SIM_ST7565_Select(bool Selected);
+void     SIM_ST7565_Write(uint8_t Value, bool Data);
+void     SIM_ST7565_Dump(FILE *pFile);
+
+void     SIM_PY25Q16_Init(const char *pFile);
+void     SIM_PY25Q16_Save(const char *pFile);
+void     SIM_PY25Q16_Select(bool Selected);
+uint8_t  SIM_PY25Q16_Transfer(uint8_t Value);
+void     SIM_PY25Q16_Report(FILE *pFile);
+
+bool     SIM_Keypad_Parse(const char *pArg);
+uint32_t SIM_Keypad_Rows(uint32_t PortB);
+void     SIM_Keypad_Update(void);
+
+const char *SIM_Symbol_Lookup(uintptr_t Address);
+
+bool     SIM_UART_OpenPty(void);
+void     SIM_UART_Tx(uint8_t Value);
+void     SIM_UART_Poll(void);
+
+// Firmware entry points
+void Main(void);
+void SysTick_Handler(void);
+void DMA1_Channel4_5_6_7_IRQHandler(void);
+void EXTI0_1_IRQHandler(void);
+void EXTI2_3_IRQHandler(void);
+void EXTI4_15_IRQHandler(void);
+
+#endif
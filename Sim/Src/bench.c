@@ -0,0 +1,383 @@
+// Host micro-benchmarks for the pure-compute kernels. Links the same App
+// objects as the simulator, calls them in a tight loop and reports ns/op
+// plus a rough Cortex-M0+ cycle estimate, so that optimisation work on
+// these paths can be argued with numbers.
+//
+// The estimate is host cycles (from a dependent add chain, 1 cycle per add
+// on any current core) times --scale, the M0+ cycles one host cycle is
+// worth for this kind of code. The default is a guess for integer code
+// running from flash with one wait state; calibrate it against a probe
+// read back with "serialtool profile" when the numbers matter.
+
+#define _GNU_SOURCE
+#include <getopt.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "py32f0xx.h"
+
+#include "dcs.h"
+#include "driver/crc.h"
+#include "driver/eeprom.h"
+#include "driver/st7565.h"
+#include "driver/uart.h"
+#include "frequencies.h"
+#include "helper/battery.h"
+#include "misc.h"
+#include "settings.h"
+#include "ui/helper.h"
+
+#ifdef ENABLE_FEAT_F4HWN_SCREENSHOT
+    #include "screenshot.h"
+#endif
+
+#define DEFAULT_SCALE   2.5
+#define MIN_RUN_NS      20000000ull     // grow the batch until a run takes this long
+#define RUNS            5               // best of
+
+uintptr_t gSimStackBottom;
+uintptr_t gSimStackTop;
+
+typedef struct
+{
+    const char *pName;
+    void      (*pSetup)(void);
+    uint32_t  (*pRun)(uint32_t i);
+} Bench_t;
+
+static volatile uint32_t Sink;
+static double            Scale = DEFAULT_SCALE;
+
+static uint8_t  CrcBuffer[128];
+static uint32_t GolayWords[ARRAY_SIZE(DCS_Options)];
+
+void SIM_Exit(int Code)
+{
+    exit(Code);
+}
+
+static uint64_t Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// ---------------------------------------------------------------------------
+//  Kernels
+
+static void CrcSetup(void)
+{
+    for (unsigned i = 0; i < sizeof(CrcBuffer); i++)
+        CrcBuffer[i] = i * 37 + 11;
+}
+
+static uint32_t CrcRun(uint32_t i)
+{
+    CrcBuffer[0] = i;
+    return CRC_Calculate(CrcBuffer, sizeof(CrcBuffer));
+}
+
+static uint32_t GolayRun(uint32_t i)
+{
+    return DCS_GetGolayCodeWord(CODE_TYPE_DIGITAL, i % ARRAY_SIZE(DCS_Options));
+}
+
+// Received words arrive at any of the 23 rotations, as BK4819 reports them
+static void CdcssSetup(void)
+{
+    for (unsigned i = 0; i < ARRAY_SIZE(GolayWords); i++)
+    {
+        const uint32_t Word = DCS_GetGolayCodeWord(CODE_TYPE_DIGITAL, i);
+        const unsigned Rot  = i % 23;
+
+        GolayWords[i] = Rot ? ((Word >> Rot) | (Word << (23 - Rot))) & 0x7FFFFFu : Word;
+    }
+}
+
+static uint32_t CdcssRun(uint32_t i)
+{
+    return DCS_GetCdcssCode(GolayWords[i % ARRAY_SIZE(GolayWords)]);
+}
+
+#ifdef ENABLE_FEAT_F4HWN_SCREENSHOT
+static void ScreenShotSetup(void)
+{
+    // Not timing the wire: one byte every 10 cycles keeps UART_Send() from
+    // spinning on TXE.
+    SIM_USART_SetBaudRate(SIM_CPU_CLOCK);
+
+    for (unsigned l = 0; l < FRAME_LINES; l++)
+        for (unsigned i = 0; i < LCD_WIDTH; i++)
+            gFrameBuffer[l][i] = (l * 29 + i * 7) ^ i;
+
+    getScreenShot(true);
+}
+
+// Steady frame: the bit transpose and the delta scan, plus the one forced
+// block that goes out every call.
+static uint32_t ScreenShotRun(uint32_t i)
+{
+    (void)i;
+    UART_DMA_Buffer[0] = 0x55;  // keep the cable "connected"
+    getScreenShot(false);
+    return gFrameBuffer[0][0];
+}
+#endif
+
+static uint32_t PrintStringRun(uint32_t i)
+{
+    UI_PrintString("145.52500", 0, 127, i & 3, 8);
+    return gFrameBuffer[0][0];
+}
+
+static uint32_t PrintSmallNormalRun(uint32_t i)
+{
+    UI_PrintStringSmallNormal("VFO A  12.5K  FM", 0, 127, i & 7);
+    return gFrameBuffer[0][0];
+}
+
+static uint32_t PrintSmallBoldRun(uint32_t i)
+{
+    UI_PrintStringSmallBold("VFO A  12.5K  FM", 0, 127, i & 7);
+    return gFrameBuffer[0][0];
+}
+
+#ifdef ENABLE_FEAT_F4HWN
+static uint32_t SmallestRun(uint32_t i)
+{
+    GUI_DisplaySmallest("RX 145.525 S9+20", 0, 8 * (i & 3), false, true);
+    return gFrameBuffer[0][0];
+}
+#endif
+
+#ifdef BENCH_AM_FIX_TABLE
+// Mirrors t_gain_table in am_fix.c
+typedef struct
+{
+    uint16_t reg_val;
+    int8_t   gain_dB;
+} __attribute__((packed)) GainEntry_t;
+
+extern GainEntry_t gain_table[100];
+extern uint8_t     gain_table_size;
+
+void CreateTable(void);
+
+// settings.c only has it with the feature on, am_fix.c wants it regardless
+bool gSetting_AM_fix;
+
+// Includes restoring the single seed entry the firmware boots with
+static uint32_t AmFixTableRun(uint32_t i)
+{
+    (void)i;
+    memset(gain_table, 0, sizeof(gain_table));
+    gain_table[0] = (GainEntry_t){ 0x03BE, -7 };
+    CreateTable();
+    return gain_table_size;
+}
+#endif
+
+static uint32_t RoundToStepRun(uint32_t i)
+{
+    static const uint16_t Steps[] = { 250, 500, 625, 833, 1000, 1250, 2500, 10000 };
+
+    return FREQUENCY_RoundToStep(14400000 + i * 137, Steps[i & 7]);
+}
+
+// Sweep 18 - 1300 MHz so every band and lock branch gets its share
+static uint32_t TxFreqCheckRun(uint32_t i)
+{
+    return TX_freq_check(1800000 + (i * 104729u) % 128200000u);
+}
+
+#if defined(ENABLE_AIRCOPY) || defined(ENABLE_UART) || defined(ENABLE_USB)
+// 8 byte steps over the whole map, as CMD_051B and aircopy walk it
+static uint32_t EepromTranslateRun(uint32_t i)
+{
+    uint32_t Addr;
+    uint16_t Size;
+    bool     End;
+
+    EEPROM_Translate((i * 8) & 0x1FFF, 8, &Addr, &Size, &End);
+    return Addr + Size;
+}
+#endif
+
+static uint32_t VoltsToPercentRun(uint32_t i)
+{
+    gEeprom.BATTERY_TYPE = (i >> 8) % BATTERY_TYPE_UNKNOWN;
+    return BATTERY_VoltsToPercent(600 + i % 260);
+}
+
+static const Bench_t Benches[] = {
+    { "CRC_Calculate/128",          CrcSetup,        CrcRun              },
+    { "DCS_GetGolayCodeWord",       NULL,            GolayRun            },
+    { "DCS_GetCdcssCode",           CdcssSetup,      CdcssRun            },
+#ifdef ENABLE_FEAT_F4HWN_SCREENSHOT
+    { "getScreenShot",              ScreenShotSetup, ScreenShotRun       },
+#endif
+    { "UI_PrintString",             NULL,            PrintStringRun      },
+    { "UI_PrintStringSmallNormal",  NULL,            PrintSmallNormalRun },
+    { "UI_PrintStringSmallBold",    NULL,            PrintSmallBoldRun   },
+#ifdef ENABLE_FEAT_F4HWN
+    { "GUI_DisplaySmallest",        NULL,            SmallestRun         },
+#endif
+#ifdef BENCH_AM_FIX_TABLE
+    { "AM fix CreateTable",         NULL,            AmFixTableRun       },
+#endif
+    { "FREQUENCY_RoundToStep",      NULL,            RoundToStepRun      },
+    { "TX_freq_check",              NULL,            TxFreqCheckRun      },
+    { "BATTERY_VoltsToPercent",     NULL,            VoltsToPercentRun   },
+#if defined(ENABLE_AIRCOPY) || defined(ENABLE_UART) || defined(ENABLE_USB)
+    { "EEPROM_Translate",           NULL,            EepromTranslateRun  },
+#endif
+};
+
+// ---------------------------------------------------------------------------
+
+// Host cycles per ns, from a chain of dependent adds. Optimised whatever
+// the build type, a Debug build would time the stack spills instead.
+__attribute__((optimize("O2")))
+static double HostClock(void)
+{
+    const uint32_t Count = 200000000u;
+    double         Best  = 0;
+
+    for (int r = 0; r < RUNS; r++)
+    {
+        uint32_t       x     = 0;
+        const uint64_t Start = Now();
+
+        for (uint32_t i = 0; i < Count; i++)
+        {
+            x += i;
+            __asm__ volatile("" : "+r"(x));
+        }
+
+        const double Rate = (double)Count / (Now() - Start);
+        if (Rate > Best)
+            Best = Rate;
+        Sink = x;
+    }
+
+    return Best;
+}
+
+static double Measure(const Bench_t *pBench, uint64_t *pOps)
+{
+    uint32_t Batch = 64;
+    uint64_t Elapsed;
+    uint32_t Acc = 0;
+
+    for (;;)
+    {
+        const uint64_t Start = Now();
+        for (uint32_t i = 0; i < Batch; i++)
+            Acc += pBench->pRun(i);
+        Elapsed = Now() - Start;
+
+        if (Elapsed >= MIN_RUN_NS || Batch >= (1u << 30))
+            break;
+        Batch *= 2;
+    }
+
+    double Best = (double)Elapsed / Batch;
+    for (int r = 1; r < RUNS; r++)
+    {
+        const uint64_t Start = Now();
+        for (uint32_t i = 0; i < Batch; i++)
+            Acc += pBench->pRun(i);
+
+        const double Ns = (double)(Now() - Start) / Batch;
+        if (Ns < Best)
+            Best = Ns;
+    }
+
+    Sink = Acc;
+    *pOps = Batch;
+    return Best;
+}
+
+static void Usage(const char *pName)
+{
+    fprintf(stderr,
+        "usage: %s [options] [NAME...]\n"
+        "  -s, --scale F   M0+ cycles per host cycle (default %.1f)\n"
+        "  -l, --list      list the benchmarks and exit\n"
+        "  NAME            only run benchmarks whose name contains NAME\n",
+        pName, DEFAULT_SCALE);
+}
+
+static bool Selected(const char *pName, int argc, char *argv[])
+{
+    if (optind >= argc)
+        return true;
+
+    for (int i = optind; i < argc; i++)
+        if (strstr(pName, argv[i]))
+            return true;
+
+    return false;
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option Options[] = {
+        { "scale", required_argument, NULL, 's' },
+        { "list",  no_argument,       NULL, 'l' },
+        { "help",  no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    int c;
+
+    while ((c = getopt_long(argc, argv, "s:lh", Options, NULL)) != -1)
+    {
+        switch (c)
+        {
+        case 's':
+            Scale = strtod(optarg, NULL);
+            if (Scale <= 0)
+            {
+                fprintf(stderr, "bench: bad scale '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'l':
+            for (unsigned i = 0; i < ARRAY_SIZE(Benches); i++)
+                printf("%s\n", Benches[i].pName);
+            return 0;
+        default:
+            Usage(argv[0]);
+            return c == 'h' ? 0 : 1;
+        }
+    }
+
+    const double Clock = HostClock();
+
+    printf("host: %.2f GHz, M0+ estimate at %.1f cycles per host cycle, %u MHz\n\n",
+           Clock, Scale, SIM_CPU_CLOCK / 1000000u);
+    printf("%-28s%12s%10s%12s%10s\n", "Kernel", "ops", "ns/op", "M0+ cyc", "M0+ us");
+
+    for (unsigned i = 0; i < ARRAY_SIZE(Benches); i++)
+    {
+        const Bench_t *pBench = &Benches[i];
+        uint64_t       Ops;
+
+        if (!Selected(pBench->pName, argc, argv))
+            continue;
+
+        if (pBench->pSetup)
+            pBench->pSetup();
+
+        const double Ns     = Measure(pBench, &Ops);
+        const double Cycles = Ns * Clock * Scale;
+
+        printf("%-28s%12llu%10.1f%12.0f%10.2f\n", pBench->pName, (unsigned long long)Ops,
+               Ns, Cycles, Cycles / (SIM_CPU_CLOCK / 1000000u));
+    }
+
+    return 0;
+}
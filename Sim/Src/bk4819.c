@@ -0,0 +1,523 @@
+// BK4819 / BK4829 seen from its 3-wire bus.
+//
+// The chip samples SDA on the rising edge of SCL. A transaction is 8 bits
+// of address (bit 7 set for a read) followed by 16 bits of data, shifted
+// out by the chip on the rising edges of a read.
+//
+// What the receiver reports (RSSI, noise, glitch, interrupts) comes from a
+// script of timed events, given with --bk or read from a --bk-trace file:
+//
+//   TIME_MS:NAME:VALUE     or     TIME_MS NAME VALUE
+//
+// NAME is rssi (REG_67), noise (REG_65), glitch (REG_63), irq (flags to
+// raise through REG_0C / REG_02) or a register number such as 0x7E.
+//
+// With --bus-report every transaction is timed on the virtual clock, from
+// the bus leaving idle (CSN and SCL high) to it returning there, and the
+// time is charged to the functions on the call stack at that moment.
+//
+// --bk-log writes every register write, in order, as "REG VALUE" lines.
+// Diffing the logs of two builds over the same script shows exactly which
+// register programming a change altered.
+//
+// SDA must be stable for SETUP_CYCLES before the rising edge of SCL, or the
+// chip latches the previous level, so too short a bus delay corrupts data
+// here the way it would on the radio.
+
+#include <execinfo.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "py32f0xx.h"
+#include "driver/bk4819-regs.h"
+
+#define MAX_EVENTS  4096
+#define MAX_FRAMES  48
+#define MAX_SITES   1024    // power of 2
+
+#define SETUP_CYCLES 5      // ~100 ns, SDA change to SCL rise
+
+typedef struct
+{
+    uint64_t Time;
+    int16_t  Reg;           // -1 for irq
+    uint16_t Mask;
+    uint16_t Value;
+} Event_t;
+
+typedef struct
+{
+    const char *pName;
+    uint64_t    Txns;
+    uint64_t    Cycles;
+    uint64_t    SelfTxns;   // transactions issued directly from this function
+    uint64_t    SelfCycles;
+} Site_t;
+
+typedef struct
+{
+    uint16_t Regs[128];
+
+    // Interrupt flags raised but not yet latched by a write to REG_02
+    uint16_t Pending;
+    uint16_t Latched;
+
+    uint64_t Reads;
+    uint64_t Writes;
+    uint64_t Ignored;       // transactions cut short by CS
+} Chip_t;
+
+static Chip_t Chip;
+
+static Event_t  Events[MAX_EVENTS];
+static unsigned EventCount;
+static unsigned NextEvent;
+
+static Site_t   Sites[MAX_SITES];
+static unsigned SiteCount;
+static uint64_t BusCycles;
+static uint64_t BusStart;
+static bool     BusIdle;
+static bool     BusSynced;  // pins start low, nothing to time until idle once
+
+static bool     BusCs = true;
+static bool     BusScl = true;
+static unsigned BusBit;
+static uint8_t  BusAddr;
+static uint16_t BusData;
+static bool     SdaOut = true;
+
+static FILE    *WriteLog;
+
+static bool     BusSda = true;
+static bool     BusSdaPrev = true;
+static uint64_t BusSdaChanged;
+
+static void Reset(void)
+{
+    memset(Chip.Regs, 0, sizeof(Chip.Regs));
+
+    // Quiet channel: low RSSI, high noise and glitch, squelch stays closed
+    Chip.Regs[BK4819_REG_67] = 0x0050;
+    Chip.Regs[BK4819_REG_65] = 0x007F;
+    Chip.Regs[BK4819_REG_63] = 0x00FF;
+
+    Chip.Pending = 0;
+    Chip.Latched = 0;
+}
+
+static void ApplyEvents(void)
+{
+    while (NextEvent < EventCount && Events[NextEvent].Time <= gSimCycles)
+    {
+        const Event_t *pEvent = &Events[NextEvent++];
+
+        if (pEvent->Reg < 0)
+            Chip.Pending |= pEvent->Value;
+        else
+            Chip.Regs[pEvent->Reg] = (Chip.Regs[pEvent->Reg] & ~pEvent->Mask) | (pEvent->Value & pEvent->Mask);
+    }
+}
+
+static uint16_t ReadRegister(uint8_t Reg)
+{
+    Chip.Reads++;
+
+    ApplyEvents();
+
+    switch (Reg)
+    {
+    case BK4819_REG_02:
+        return Chip.Latched;
+    case BK4819_REG_0C:
+        return (Chip.Regs[BK4819_REG_0C] & ~1U) | (Chip.Pending ? 1U : 0U);
+    default:
+        return Chip.Regs[Reg];
+    }
+}
+
+static void WriteRegister(uint8_t Reg, uint16_t Value)
+{
+    Chip.Writes++;
+
+    if (WriteLog)
+        fprintf(WriteLog, "%02X %04X\n", Reg, Value);
+
+    switch (Reg)
+    {
+    case BK4819_REG_00:
+        if (Value & 0x8000)
+            Reset();
+        break;
+    case BK4819_REG_02:
+        // Any write acknowledges the request and latches what is pending
+        Chip.Latched = Chip.Pending & Chip.Regs[BK4819_REG_3F];
+        Chip.Pending = 0;
+        break;
+    default:
+        Chip.Regs[Reg] = Value;
+        break;
+    }
+}
+
+static int CompareEvents(const void *a, const void *b)
+{
+    const Event_t *pA = a;
+    const Event_t *pB = b;
+
+    return (pA->Time > pB->Time) - (pA->Time < pB->Time);
+}
+
+void SIM_BK4819_Init(void)
+{
+    Reset();
+
+    // Stable, so events given for the same time keep their order
+    for (unsigned i = 1; i < EventCount; i++)
+    {
+        for (unsigned j = i; j > 0 && CompareEvents(&Events[j - 1], &Events[j]) > 0; j--)
+        {
+            const Event_t Tmp = Events[j];
+            Events[j]     = Events[j - 1];
+            Events[j - 1] = Tmp;
+        }
+    }
+}
+
+bool SIM_BK4819_Parse(const char *pArg)
+{
+    unsigned long Time;
+    char          Name[16];
+    long          Value;
+
+    if (sscanf(pArg, "%lu%*[ \t:]%15[^ \t:]%*[ \t:]%li", &Time, Name, &Value) != 3 || EventCount >= MAX_EVENTS)
+        return false;
+
+    Event_t *pEvent = &Events[EventCount];
+    pEvent->Time  = SIM_MS_TO_CYCLES(Time);
+    pEvent->Value = (uint16_t)Value;
+    pEvent->Mask  = 0xFFFF;
+
+    if (strcasecmp(Name, "rssi") == 0)
+    {
+        pEvent->Reg  = BK4819_REG_67;
+        pEvent->Mask = 0x01FF;
+    }
+    else if (strcasecmp(Name, "noise") == 0)
+    {
+        pEvent->Reg  = BK4819_REG_65;
+        pEvent->Mask = 0x007F;
+    }
+    else if (strcasecmp(Name, "glitch") == 0)
+    {
+        pEvent->Reg  = BK4819_REG_63;
+        pEvent->Mask = 0x00FF;
+    }
+    else if (strcasecmp(Name, "irq") == 0)
+    {
+        pEvent->Reg  = -1;
+    }
+    else
+    {
+        char *pEnd;
+        const unsigned long Reg = strtoul(strncasecmp(Name, "REG_", 4) == 0 ? Name + 4 : Name, &pEnd, 16);
+        if (*pEnd || Reg > 0x7F)
+            return false;
+
+        pEvent->Reg = Reg;
+    }
+
+    EventCount++;
+    return true;
+}
+
+bool SIM_BK4819_OpenLog(const char *pFile)
+{
+    WriteLog = fopen(pFile, "w");
+    if (!WriteLog)
+    {
+        perror(pFile);
+        return false;
+    }
+
+    return true;
+}
+
+bool SIM_BK4819_LoadTrace(const char *pFile)
+{
+    FILE *f = fopen(pFile, "r");
+    if (!f)
+    {
+        perror(pFile);
+        return false;
+    }
+
+    char     Line[128];
+    unsigned LineNo = 0;
+    bool     Ok     = true;
+
+    while (Ok && fgets(Line, sizeof(Line), f))
+    {
+        LineNo++;
+
+        const char *p = Line + strspn(Line, " \t");
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == 0)
+            continue;
+
+        if (!SIM_BK4819_Parse(p))
+        {
+            fprintf(stderr, "%s:%u: bad event\n", pFile, LineNo);
+            Ok = false;
+        }
+    }
+
+    fclose(f);
+    return Ok;
+}
+
+// Everything between the caller and the pins: these frames say nothing
+// about who asked for the transaction.
+static bool IsBusFrame(const char *pName)
+{
+    static const char *const BusFunctions[] = {
+        "BK4819_ReadRegister", "BK4819_WriteRegister", "BK4819_ReadBus",
+        "BK4819_WriteBus", "BK4819_BusDelay", "BK4819_BurstWrite", "BK4819_BurstEnd",
+        "BK4819_ReadU16", "BK4819_WriteU8", "BK4819_WriteU16",
+        "CS_Assert", "CS_Release", "SCL_Set", "SCL_Reset",
+        "SDA_Set", "SDA_Reset", "SDA_SetDir", "SDA_ReadInput",
+    };
+
+    for (unsigned i = 0; i < sizeof(BusFunctions) / sizeof(BusFunctions[0]); i++)
+        if (strcmp(pName, BusFunctions[i]) == 0)
+            return true;
+
+    return strncmp(pName, "GPIO_", 5) == 0 || strncmp(pName, "LL_GPIO_", 8) == 0;
+}
+
+static Site_t *FindSite(const char *pName)
+{
+    unsigned i = ((uintptr_t)pName >> 3) & (MAX_SITES - 1);
+
+    while (Sites[i].pName && Sites[i].pName != pName)
+        i = (i + 1) & (MAX_SITES - 1);
+
+    if (!Sites[i].pName)
+    {
+        if (SiteCount >= MAX_SITES - 1)
+            return NULL;
+
+        Sites[i].pName = pName;
+        SiteCount++;
+    }
+
+    return &Sites[i];
+}
+
+static void Attribute(uint64_t Cycles)
+{
+    void *Frames[MAX_FRAMES];
+    const char *Names[MAX_FRAMES];
+    unsigned Count = 0;
+
+    const int Depth = backtrace(Frames, MAX_FRAMES);
+    bool InFirmware = false;
+
+    for (int i = 0; i < Depth; i++)
+    {
+        const char *pName = SIM_Symbol_Lookup((uintptr_t)Frames[i] - 1);
+        if (!pName || strcmp(pName, "FirmwareEntry") == 0)
+            continue;
+
+        // Skip the simulator's own frames, up to the driver
+        InFirmware = InFirmware || IsBusFrame(pName);
+        if (!InFirmware)
+            continue;
+
+        // Recursion is charged once
+        bool Seen = false;
+        for (unsigned j = 0; j < Count && !Seen; j++)
+            Seen = Names[j] == pName;
+
+        if (!Seen)
+            Names[Count++] = pName;
+    }
+
+    bool Self = true;
+    for (unsigned i = 0; i < Count; i++)
+    {
+        if (IsBusFrame(Names[i]))
+            continue;
+
+        Site_t *pSite = FindSite(Names[i]);
+        if (!pSite)
+            break;
+
+        pSite->Txns++;
+        pSite->Cycles += Cycles;
+
+        if (Self)
+        {
+            pSite->SelfTxns++;
+            pSite->SelfCycles += Cycles;
+            Self = false;
+        }
+    }
+}
+
+static void Account(bool Cs, bool Scl)
+{
+    const bool Idle = Cs && Scl;
+    if (Idle == BusIdle)
+        return;
+
+    BusIdle = Idle;
+
+    if (!Idle)
+    {
+        BusStart = gSimCycles;
+        return;
+    }
+
+    if (!BusSynced)
+    {
+        BusSynced = true;
+        return;
+    }
+
+    const uint64_t Cycles = gSimCycles - BusStart;
+    BusCycles += Cycles;
+
+    if (gSimConfig.BusReport)
+        Attribute(Cycles);
+}
+
+void SIM_BK4819_Pins(bool Cs, bool Scl, bool Sda)
+{
+    Account(Cs, Scl);
+
+    if (Sda != BusSda)
+    {
+        BusSdaPrev    = BusSda;
+        BusSda        = Sda;
+        BusSdaChanged = gSimCycles;
+    }
+
+    // Setup time violated: the chip still sees the old level
+    if (gSimCycles - BusSdaChanged < SETUP_CYCLES)
+        Sda = BusSdaPrev;
+
+    if (Cs != BusCs)
+    {
+        if (!Cs)
+        {
+            BusBit  = 0;
+            BusAddr = 0;
+            BusData = 0;
+        }
+        else if (BusBit != 0 && BusBit != 24)
+        {
+            Chip.Ignored++;
+        }
+
+        SdaOut = true;
+    }
+    else if (!Cs && Scl && !BusScl)
+    {
+        if (BusBit < 8)
+        {
+            BusAddr = (BusAddr << 1) | Sda;
+            if (++BusBit == 8 && (BusAddr & 0x80))
+            {
+                BusData = ReadRegister(BusAddr & 0x7F);
+                SdaOut  = (BusData >> 15) & 1;
+            }
+        }
+        else if (BusBit < 24)
+        {
+            if (BusAddr & 0x80)
+            {
+                BusData <<= 1;
+                SdaOut = (BusData >> 15) & 1;
+            }
+            else
+            {
+                BusData = (BusData << 1) | Sda;
+                if (BusBit == 23)
+                    WriteRegister(BusAddr & 0x7F, BusData);
+            }
+
+            BusBit++;
+        }
+    }
+
+    BusCs  = Cs;
+    BusScl = Scl;
+}
+
+bool SIM_BK4819_Sda(void)
+{
+    return SdaOut;
+}
+
+// The interrupt request pin follows REG_0C<0>
+bool SIM_BK4819_Irq(void)
+{
+    ApplyEvents();
+
+    return Chip.Pending != 0;
+}
+
+static int CompareSites(const void *a, const void *b)
+{
+    const Site_t *pA = a;
+    const Site_t *pB = b;
+
+    return (pA->Cycles < pB->Cycles) - (pA->Cycles > pB->Cycles);
+}
+
+void SIM_BK4819_Report(FILE *pFile)
+{
+    const double Slices = (double)gSimCycles / SIM_MS_TO_CYCLES(10);
+
+    fprintf(pFile, "bk4819: %llu reads, %llu writes, %llu aborted, %.1f ms on the bus (%.1f%%)\n",
+            (unsigned long long)Chip.Reads,
+            (unsigned long long)Chip.Writes,
+            (unsigned long long)Chip.Ignored,
+            BusCycles / (double)SIM_MS_TO_CYCLES(1),
+            gSimCycles ? 100.0 * BusCycles / gSimCycles : 0.0);
+
+    if (!gSimConfig.BusReport || !SiteCount)
+        return;
+
+    Site_t *pSorted = malloc(SiteCount * sizeof(Site_t));
+    if (!pSorted)
+        return;
+
+    unsigned n = 0;
+    for (unsigned i = 0; i < MAX_SITES; i++)
+        if (Sites[i].pName)
+            pSorted[n++] = Sites[i];
+
+    qsort(pSorted, n, sizeof(Site_t), CompareSites);
+
+    // incl: issued anywhere below the function, self: issued by it directly
+    fprintf(pFile, "bk4819 bus time by function, per 10 ms timeslice:\n");
+    fprintf(pFile, "  %-40s %10s %12s %10s %10s %12s\n",
+            "function", "txns", "incl us", "us/slice", "self txns", "self us");
+
+    for (unsigned i = 0; i < n; i++)
+    {
+        const Site_t *pSite = &pSorted[i];
+
+        fprintf(pFile, "  %-40s %10llu %12.0f %10.1f %10llu %12.0f\n",
+                pSite->pName,
+                (unsigned long long)pSite->Txns,
+                pSite->Cycles / (double)SIM_US_TO_CYCLES(1),
+                Slices > 0 ? pSite->Cycles / (double)SIM_US_TO_CYCLES(1) / Slices : 0.0,
+                (unsigned long long)pSite->SelfTxns,
+                pSite->SelfCycles / (double)SIM_US_TO_CYCLES(1));
+    }
+
+    free(pSorted);
+}
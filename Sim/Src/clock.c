@@ -0,0 +1,216 @@
+// Deterministic virtual clock.
+//
+// Time only moves when the firmware does something that would take time on
+// the radio: reading SysTick, toggling a pin, clocking a byte out of an SPI
+// port, or going once around the Main() loop. Whenever the clock crosses a
+// SysTick reload boundary the handler in scheduler.c runs, exactly as the
+// real interrupt would preempt whatever code happens to be executing.
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "py32f0xx.h"
+
+SIM_Config_t gSimConfig = {
+    .LoopCycles = 256,
+};
+
+uint64_t gSimCycles;
+uint64_t gSimLoopPasses;
+
+uint32_t SystemCoreClock = SIM_CPU_CLOCK;
+
+static SysTick_Type SysTickRegs;
+static SCB_Type     ScbRegs;
+static uint64_t     SysTickNext;
+static bool         SysTickEnabled;
+static bool         SysTickPending;
+static bool         InHandler;
+static unsigned     IrqDisableDepth;
+static uint32_t     IrqEnabled;
+
+static struct timespec WallStart;
+
+static void RealTimePace(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    const int64_t wall_us = (int64_t)(now.tv_sec - WallStart.tv_sec) * 1000000
+                          + (now.tv_nsec - WallStart.tv_nsec) / 1000;
+    const int64_t virt_us = (int64_t)(gSimCycles / (SIM_CPU_CLOCK / 1000000u));
+
+    if (virt_us > wall_us + 1000)
+    {
+        const int64_t ahead = virt_us - wall_us;
+        struct timespec ts = { ahead / 1000000, (ahead % 1000000) * 1000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+static void DeliverSysTick(void)
+{
+    if (InHandler || IrqDisableDepth || !SysTickEnabled)
+        return;
+
+    InHandler = true;
+    while (SysTickPending)
+    {
+        SysTickPending = false;
+        SysTick_Handler();
+    }
+    InHandler = false;
+}
+
+// DMA completions that depend on time rather than on the call that
+// started the transfer, taken like SysTick when interrupts are allowed
+static void DeliverPeripherals(void)
+{
+    if (InHandler || IrqDisableDepth)
+        return;
+
+    InHandler = true;
+    SIM_USART_Update();
+    InHandler = false;
+}
+
+void SIM_Advance(uint32_t Cycles)
+{
+    gSimCycles += Cycles;
+
+    if (SysTickRegs.LOAD && gSimCycles >= SysTickNext)
+    {
+        const uint64_t period = (uint64_t)SysTickRegs.LOAD + 1;
+        while (gSimCycles >= SysTickNext)
+        {
+            SysTickNext += period;
+            SysTickPending = true;
+        }
+
+        SIM_UART_Poll();
+        SIM_Keypad_Update();
+
+        if (gSimConfig.RealTime)
+            RealTimePace();
+
+        if (gSimConfig.EndCycles && gSimCycles >= gSimConfig.EndCycles)
+            SIM_Exit(0);
+    }
+
+    DeliverPeripherals();
+
+    if (SysTickPending)
+        DeliverSysTick();
+}
+
+void *SIM_SysTick(void)
+{
+    SIM_Advance(SIM_COST_SYSTICK_READ);
+
+    if (SysTickRegs.LOAD)
+    {
+        const uint64_t period = (uint64_t)SysTickRegs.LOAD + 1;
+        SysTickRegs.VAL = (uint32_t)((SysTickNext - gSimCycles - 1) % period);
+    }
+
+    return &SysTickRegs;
+}
+
+void *SIM_SCB(void)
+{
+    SIM_Advance(SIM_COST_PERIPH);
+
+    ScbRegs.ICSR = SysTickPending ? SCB_ICSR_PENDSTSET_Msk : 0;
+
+    return &ScbRegs;
+}
+
+void SIM_SysTickConfig(uint32_t Reload)
+{
+    clock_gettime(CLOCK_MONOTONIC, &WallStart);
+
+    SysTickRegs.LOAD = Reload;
+    SysTickRegs.VAL  = Reload;
+    SysTickRegs.CTRL = 7;
+    SysTickNext      = gSimCycles + Reload + 1;
+    SysTickEnabled   = true;
+}
+
+uint32_t SysTick_Config(uint32_t ticks)
+{
+    if ((ticks - 1UL) > SysTick_LOAD_RELOAD_Msk)
+        return 1;
+
+    SIM_SysTickConfig(ticks - 1UL);
+    return 0;
+}
+
+void SIM_DisableIRQ(void)
+{
+    IrqDisableDepth = 1;
+}
+
+void SIM_EnableIRQ(void)
+{
+    IrqDisableDepth = 0;
+    DeliverPeripherals();
+    if (SysTickPending)
+        DeliverSysTick();
+}
+
+void SIM_SetIRQEnabled(int IRQn, bool Enabled)
+{
+    if (IRQn == SysTick_IRQn)
+    {
+        SysTickEnabled = Enabled;
+        if (Enabled && SysTickPending)
+            DeliverSysTick();
+        return;
+    }
+
+    if (IRQn >= 0 && IRQn < 32)
+    {
+        if (Enabled)
+            IrqEnabled |= 1U << IRQn;
+        else
+            IrqEnabled &= ~(1U << IRQn);
+    }
+}
+
+bool SIM_IsIRQEnabled(int IRQn)
+{
+    if (IRQn == SysTick_IRQn)
+        return SysTickEnabled;
+
+    return IRQn >= 0 && IRQn < 32 && !IrqDisableDepth && (IrqEnabled & (1U << IRQn));
+}
+
+void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    SIM_SetIRQEnabled(IRQn, true);
+}
+
+void NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    SIM_SetIRQEnabled(IRQn, false);
+}
+
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+    (void)IRQn;
+    (void)priority;
+}
+
+void NVIC_SystemReset(void)
+{
+    fprintf(stderr, "sim: NVIC_SystemReset() at %llu ms\n",
+            (unsigned long long)(gSimCycles / (SIM_CPU_CLOCK / 1000u)));
+    SIM_Exit(0);
+}
+
+void SIM_Idle(void)
+{
+    gSimLoopPasses++;
+    SIM_Advance(gSimConfig.LoopCycles);
+    SIM_EXTI_Update();
+}
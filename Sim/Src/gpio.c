@@ -0,0 +1,204 @@
+// GPIO ports and the wiring between them and the device models.
+//
+//   PF9 / PB8 / PB9   BK4819 CSN / SCL / SDA (bit-banged 3-wire)
+//   PA3               PY25Q16 CS (SPI2)
+//   PB2 / PA6         ST7565 CS / A0 (SPI1)
+//   PB15:12 / PB6:3   keypad rows (in) / cols (out)
+//   PB10              PTT (in, active low)
+//   PB7               BK4819 interrupt request (in, active high), only on
+//                     boards modified for ENABLE_BK4819_IRQ_EXTI
+
+#include "py32f0xx.h"
+#include "py32f071_ll_gpio.h"
+
+typedef struct
+{
+    uint32_t Odr;
+    uint32_t Moder;     // 2 bits per pin, LL_GPIO_MODE_*
+} Port_t;
+
+typedef struct
+{
+    uint8_t  Source[16];    // port per line, EXTICR
+    uint32_t Regs[SIM_EXTI_REG_COUNT];
+    uint32_t Pending;
+    uint32_t Level;         // line levels at the last update
+} Exti_t;
+
+static Port_t Ports[SIM_PORT_COUNT];
+static Exti_t Exti;
+
+__attribute__((weak)) void EXTI0_1_IRQHandler(void) {}
+__attribute__((weak)) void EXTI2_3_IRQHandler(void) {}
+__attribute__((weak)) void EXTI4_15_IRQHandler(void) {}
+
+static inline bool OutBit(unsigned Port, unsigned Pin)
+{
+    return (Ports[Port].Odr >> Pin) & 1;
+}
+
+static void NotifyDevices(unsigned Port, uint32_t Changed)
+{
+    if ((Port == SIM_PORT_B && (Changed & (LL_GPIO_PIN_8 | LL_GPIO_PIN_9)))
+        || (Port == SIM_PORT_F && (Changed & LL_GPIO_PIN_9)))
+    {
+        SIM_BK4819_Pins(OutBit(SIM_PORT_F, 9), OutBit(SIM_PORT_B, 8),
+                        SIM_GPIO_IsOutput(SIM_PORT_B, LL_GPIO_PIN_9) ? OutBit(SIM_PORT_B, 9) : true);
+    }
+
+    if (Port == SIM_PORT_A && (Changed & LL_GPIO_PIN_3))
+        SIM_PY25Q16_Select(!OutBit(SIM_PORT_A, 3));
+
+    if (Port == SIM_PORT_B && (Changed & LL_GPIO_PIN_2))
+        SIM_ST7565_Select(!OutBit(SIM_PORT_B, 2));
+}
+
+unsigned SIM_GPIO_Port(const void *GPIOx)
+{
+    switch ((uintptr_t)GPIOx)
+    {
+    case GPIOA_BASE:
+        return SIM_PORT_A;
+    case GPIOB_BASE:
+        return SIM_PORT_B;
+    case GPIOC_BASE:
+        return SIM_PORT_C;
+    case GPIOF_BASE:
+        return SIM_PORT_F;
+    default:
+        fprintf(stderr, "sim: access to unknown GPIO port %p\n", GPIOx);
+        SIM_Exit(1);
+    }
+}
+
+void SIM_GPIO_Write(unsigned Port, uint32_t Set, uint32_t Reset)
+{
+    SIM_Advance(SIM_COST_GPIO);
+
+    const uint32_t Old = Ports[Port].Odr;
+    Ports[Port].Odr = (Old & ~Reset) | Set;
+
+    const uint32_t Changed = Old ^ Ports[Port].Odr;
+    if (Changed)
+        NotifyDevices(Port, Changed);
+}
+
+void SIM_GPIO_SetMode(unsigned Port, uint32_t Pins, uint32_t Mode)
+{
+    SIM_Advance(SIM_COST_GPIO);
+
+    for (unsigned i = 0; i < 16; i++)
+    {
+        if (Pins & (1U << i))
+        {
+            Ports[Port].Moder &= ~(3U << (i * 2));
+            Ports[Port].Moder |= (Mode & 3U) << (i * 2);
+        }
+    }
+
+    // Releasing SDA hands the line to the BK4819
+    NotifyDevices(Port, Pins);
+}
+
+bool SIM_GPIO_IsOutput(unsigned Port, uint32_t Pin)
+{
+    for (unsigned i = 0; i < 16; i++)
+        if (Pin == (1U << i))
+            return ((Ports[Port].Moder >> (i * 2)) & 3U) == LL_GPIO_MODE_OUTPUT;
+
+    return false;
+}
+
+uint32_t SIM_GPIO_ReadOutput(unsigned Port)
+{
+    return Ports[Port].Odr;
+}
+
+static uint32_t InputLevels(unsigned Port)
+{
+    // Output pins read back their latch, everything else floats high on
+    // its pull-up unless a device pulls it down.
+    uint32_t Input = 0xFFFF;
+    for (unsigned i = 0; i < 16; i++)
+        if (((Ports[Port].Moder >> (i * 2)) & 3U) == LL_GPIO_MODE_OUTPUT)
+            Input = (Input & ~(1U << i)) | (Ports[Port].Odr & (1U << i));
+
+    if (Port == SIM_PORT_B)
+    {
+        Input &= SIM_Keypad_Rows(Ports[Port].Odr);
+
+        if (!SIM_GPIO_IsOutput(SIM_PORT_B, LL_GPIO_PIN_9) && !SIM_BK4819_Sda())
+            Input &= ~LL_GPIO_PIN_9;
+
+        if (!SIM_GPIO_IsOutput(SIM_PORT_B, LL_GPIO_PIN_7) && !SIM_BK4819_Irq())
+            Input &= ~LL_GPIO_PIN_7;
+    }
+
+    return Input;
+}
+
+uint32_t SIM_GPIO_ReadInput(unsigned Port)
+{
+    SIM_Advance(SIM_COST_GPIO);
+
+    return InputLevels(Port);
+}
+
+// ---------------------------------------------------------------------------
+//  EXTI, lines 0-15
+
+static inline bool LineLevel(unsigned Line)
+{
+    return (InputLevels(Exti.Source[Line]) >> Line) & 1;
+}
+
+void SIM_EXTI_SetSource(unsigned Line, unsigned Port)
+{
+    Exti.Source[Line] = Port;
+    Exti.Level = (Exti.Level & ~(1U << Line)) | ((uint32_t)LineLevel(Line) << Line);
+}
+
+void SIM_EXTI_Configure(unsigned Reg, uint32_t Lines, bool Set)
+{
+    if (Set)
+        Exti.Regs[Reg] |= Lines;
+    else
+        Exti.Regs[Reg] &= ~Lines;
+}
+
+uint32_t SIM_EXTI_Pending(void)
+{
+    return Exti.Pending;
+}
+
+void SIM_EXTI_ClearPending(uint32_t Lines)
+{
+    Exti.Pending &= ~Lines;
+}
+
+// Sample the lines once per Main() loop pass, so an edge is seen with the
+// latency of one pass rather than at the exact cycle it happened.
+void SIM_EXTI_Update(void)
+{
+    const uint32_t Armed = Exti.Regs[SIM_EXTI_IMR];
+    if (!Armed)
+        return;
+
+    uint32_t Level = 0;
+    for (unsigned i = 0; i < 16; i++)
+        if (Armed & (1U << i))
+            Level |= (uint32_t)LineLevel(i) << i;
+
+    const uint32_t Rising  = Level & ~Exti.Level;
+    const uint32_t Falling = ~Level & Exti.Level;
+
+    Exti.Level    = (Exti.Level & ~Armed) | Level;
+    Exti.Pending |= ((Rising & Exti.Regs[SIM_EXTI_RTSR]) | (Falling & Exti.Regs[SIM_EXTI_FTSR])) & Armed;
+
+    if ((Exti.Pending & 0x0003) && SIM_IsIRQEnabled(EXTI0_1_IRQn))
+        EXTI0_1_IRQHandler();
+    if ((Exti.Pending & 0x000C) && SIM_IsIRQEnabled(EXTI2_3_IRQn))
+        EXTI2_3_IRQHandler();
+    if ((Exti.Pending & 0xFFF0) && SIM_IsIRQEnabled(EXTI4_15_IRQn))
+        EXTI4_15_IRQHandler();
+}
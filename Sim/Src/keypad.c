@@ -0,0 +1,106 @@
+// Keypad matrix and PTT, driven from a --key script.
+//
+// Each entry is TIME_MS:KEY[:HOLD_MS], e.g. "1000:MENU" or "2500:PTT:3000".
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "py32f0xx.h"
+#include "py32f071_ll_gpio.h"
+
+#define MAX_EVENTS 256
+
+typedef struct
+{
+    const char *pName;
+    int8_t      Col;        // 0 = grounded column (side keys), -1 = PTT
+    uint8_t     Row;
+} Key_t;
+
+static const Key_t Keys[] = {
+    { "SIDE1", 0, 0 }, { "SIDE2", 0, 1 },
+    { "MENU",  1, 0 }, { "1",     1, 1 }, { "4", 1, 2 }, { "7", 1, 3 },
+    { "UP",    2, 0 }, { "2",     2, 1 }, { "5", 2, 2 }, { "8", 2, 3 },
+    { "DOWN",  3, 0 }, { "3",     3, 1 }, { "6", 3, 2 }, { "9", 3, 3 },
+    { "EXIT",  4, 0 }, { "STAR",  4, 1 }, { "0", 4, 2 }, { "F", 4, 3 },
+    { "PTT",  -1, 0 },
+};
+
+typedef struct
+{
+    uint64_t Start;
+    uint64_t End;
+    const Key_t *pKey;
+} Event_t;
+
+static Event_t  Events[MAX_EVENTS];
+static unsigned EventCount;
+
+static uint32_t Pressed;    // bit per Keys[] entry
+
+bool SIM_Keypad_Parse(const char *pArg)
+{
+    char Name[8];
+    unsigned long Time, Hold = 100;
+
+    const char *p = strchr(pArg, ':');
+    if (!p || EventCount >= MAX_EVENTS)
+        return false;
+
+    Time = strtoul(pArg, NULL, 10);
+
+    const char *q = strchr(p + 1, ':');
+    const size_t Len = q ? (size_t)(q - p - 1) : strlen(p + 1);
+    if (Len == 0 || Len >= sizeof(Name))
+        return false;
+
+    memcpy(Name, p + 1, Len);
+    Name[Len] = 0;
+
+    if (q)
+        Hold = strtoul(q + 1, NULL, 10);
+
+    for (unsigned i = 0; i < sizeof(Keys) / sizeof(Keys[0]); i++)
+    {
+        if (strcasecmp(Name, Keys[i].pName) == 0)
+        {
+            Events[EventCount].Start = SIM_MS_TO_CYCLES(Time);
+            Events[EventCount].End   = SIM_MS_TO_CYCLES(Time + Hold);
+            Events[EventCount].pKey  = &Keys[i];
+            EventCount++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SIM_Keypad_Update(void)
+{
+    Pressed = 0;
+
+    for (unsigned i = 0; i < EventCount; i++)
+        if (gSimCycles >= Events[i].Start && gSimCycles < Events[i].End)
+            Pressed |= 1U << (Events[i].pKey - Keys);
+}
+
+uint32_t SIM_Keypad_Rows(uint32_t PortB)
+{
+    uint32_t Mask = 0xFFFF;
+
+    for (unsigned i = 0; Pressed >> i; i++)
+    {
+        if (!(Pressed & (1U << i)))
+            continue;
+
+        const Key_t *pKey = &Keys[i];
+
+        if (pKey->Col < 0)
+            Mask &= ~LL_GPIO_PIN_10;
+        else if (pKey->Col == 0 || !(PortB & (1U << (7 - pKey->Col))))
+            Mask &= ~(1U << (15 - pKey->Row));
+    }
+
+    return Mask;
+}
@@ -0,0 +1,184 @@
+// Host entry point: parse the command line, bring up the device models and
+// run the unmodified Main() on a low stack under the virtual clock.
+
+#define _GNU_SOURCE
+#include <getopt.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <ucontext.h>
+
+#include "py32f0xx.h"
+
+#define STACK_SIZE (256 * 1024)
+
+uintptr_t gSimStackBottom;
+uintptr_t gSimStackTop;
+
+static ucontext_t HostContext;
+static ucontext_t FirmwareContext;
+static struct timespec WallStart;
+
+static void Usage(const char *pName)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -t, --time MS          stop after MS of virtual time (default: run forever)\n"
+        "  -k, --key T:KEY[:HOLD] press KEY at T ms for HOLD ms (default 100), repeatable\n"
+        "                         keys: 0-9 MENU UP DOWN EXIT STAR F PTT SIDE1 SIDE2\n"
+        "  -b, --bk T:NAME:VALUE  set BK4819 rssi, noise, glitch, irq or a register at T ms\n"
+        "  -B, --bk-trace FILE    read --bk events from FILE, one per line\n"
+        "      --bus-report       print BK4819 bus time per calling function\n"
+        "  -L, --bk-log FILE      write every BK4819 register write to FILE\n"
+        "  -f, --flash FILE       PY25Q16 image, loaded at start and written back at exit\n"
+        "  -c, --power-cut N      cut power halfway through the Nth flash program or erase\n"
+        "  -l, --loop-cycles N    CPU cycles charged per Main() loop pass (default %u)\n"
+        "  -s, --screen           print the LCD when the run ends\n"
+        "  -p, --pty              expose USART1 on a pseudo-terminal\n"
+        "  -r, --realtime         pace virtual time to the wall clock\n",
+        pName, gSimConfig.LoopCycles);
+}
+
+static void Report(FILE *pFile)
+{
+    struct timespec Now;
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+
+    const double Wall = (Now.tv_sec - WallStart.tv_sec) + (Now.tv_nsec - WallStart.tv_nsec) / 1e9;
+    const double Virt = (double)gSimCycles / SIM_CPU_CLOCK;
+
+    fprintf(pFile, "sim: %.3f s virtual in %.3f s wall (%.1fx), %llu main loop passes\n",
+            Virt, Wall, Wall > 0 ? Virt / Wall : 0.0, (unsigned long long)gSimLoopPasses);
+
+    SIM_BK4819_Report(pFile);
+    SIM_PY25Q16_Report(pFile);
+}
+
+void SIM_Exit(int Code)
+{
+    if (gSimConfig.DumpScreen)
+    {
+        SIM_ST7565_Dump(stdout);
+        fflush(stdout);
+    }
+
+    Report(stderr);
+    SIM_PY25Q16_Save(gSimConfig.pFlashFile);
+
+    exit(Code);
+}
+
+static void FirmwareEntry(void)
+{
+    Main();
+}
+
+int main(int argc, char *argv[])
+{
+    static const struct option Options[] = {
+        { "time",        required_argument, NULL, 't' },
+        { "key",         required_argument, NULL, 'k' },
+        { "bk",          required_argument, NULL, 'b' },
+        { "bk-trace",    required_argument, NULL, 'B' },
+        { "bus-report",  no_argument,       NULL, 'R' },
+        { "bk-log",      required_argument, NULL, 'L' },
+        { "flash",       required_argument, NULL, 'f' },
+        { "power-cut",   required_argument, NULL, 'c' },
+        { "loop-cycles", required_argument, NULL, 'l' },
+        { "screen",      no_argument,       NULL, 's' },
+        { "pty",         no_argument,       NULL, 'p' },
+        { "realtime",    no_argument,       NULL, 'r' },
+        { "help",        no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    bool Pty = false;
+    int c;
+
+    while ((c = getopt_long(argc, argv, "t:k:b:B:L:f:c:l:sprh", Options, NULL)) != -1)
+    {
+        switch (c)
+        {
+        case 't':
+            gSimConfig.EndCycles = SIM_MS_TO_CYCLES(strtoull(optarg, NULL, 10));
+            break;
+        case 'k':
+            if (!SIM_Keypad_Parse(optarg))
+            {
+                fprintf(stderr, "sim: bad key event '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'b':
+            if (!SIM_BK4819_Parse(optarg))
+            {
+                fprintf(stderr, "sim: bad BK4819 event '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'B':
+            if (!SIM_BK4819_LoadTrace(optarg))
+                return 1;
+            break;
+        case 'R':
+            gSimConfig.BusReport = true;
+            break;
+        case 'L':
+            if (!SIM_BK4819_OpenLog(optarg))
+                return 1;
+            break;
+        case 'f':
+            gSimConfig.pFlashFile = optarg;
+            break;
+        case 'c':
+            gSimConfig.PowerCut = strtoull(optarg, NULL, 10);
+            break;
+        case 'l':
+            gSimConfig.LoopCycles = strtoul(optarg, NULL, 10);
+            break;
+        case 's':
+            gSimConfig.DumpScreen = true;
+            break;
+        case 'p':
+            Pty = true;
+            break;
+        case 'r':
+            gSimConfig.RealTime = true;
+            break;
+        default:
+            Usage(argv[0]);
+            return c == 'h' ? 0 : 1;
+        }
+    }
+
+    SIM_BK4819_Init();
+    SIM_PY25Q16_Init(gSimConfig.pFlashFile);
+
+    if (Pty && !SIM_UART_OpenPty())
+        return 1;
+
+    // Keep the firmware stack addressable through a uint32_t, like on the MCU
+    void *pStack = mmap(NULL, STACK_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (pStack == MAP_FAILED)
+    {
+        perror("sim: mmap");
+        return 1;
+    }
+
+    gSimStackBottom = (uintptr_t)pStack;
+    gSimStackTop    = (uintptr_t)pStack + STACK_SIZE;
+
+    getcontext(&FirmwareContext);
+    FirmwareContext.uc_stack.ss_sp   = pStack;
+    FirmwareContext.uc_stack.ss_size = STACK_SIZE;
+    FirmwareContext.uc_link          = &HostContext;
+    makecontext(&FirmwareContext, FirmwareEntry, 0);
+
+    clock_gettime(CLOCK_MONOTONIC, &WallStart);
+    swapcontext(&HostContext, &FirmwareContext);
+
+    // Main() never returns
+    SIM_Exit(1);
+}
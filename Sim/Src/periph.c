@@ -0,0 +1,304 @@
+// SPI, DMA, USART, ADC and TIM behind the LL shims.
+//
+// DMA channels carry real firmware addresses. The simulator is linked
+// non-PIE and runs Main() on a stack mapped below 4 GB, so the (uint32_t)
+// casts the drivers apply to buffer pointers round-trip losslessly.
+
+#include <string.h>
+
+#include "py32f0xx.h"
+#include "py32f071_ll_dma.h"
+#include "py32f071_ll_system.h"
+
+#define DMA_CHANNELS 7
+
+typedef struct
+{
+    uint32_t Config;
+    uint32_t Memory;
+    uint32_t Length;
+    uint32_t Remaining;
+    uint32_t Index;         // next element, for circular channels
+    uint32_t Request;
+    uint32_t Flags;
+    uint32_t ItMask;
+    bool     Enabled;
+} Channel_t;
+
+static Channel_t Channels[DMA_CHANNELS + 1];
+static uint32_t  SpiPrescaler[SIM_SPI_COUNT] = { 256, 256 };
+static uint32_t  UartBaudRate = 9600;
+static uint64_t  UartTxBusyUntil;
+static Channel_t *pUartTxDma;   // transfer in flight, done at UartTxBusyUntil
+static TIM_TypeDef Timers[2];
+
+uint8_t gSimSpiRx[SIM_SPI_COUNT];
+
+__attribute__((weak)) void DMA1_Channel1_IRQHandler(void) {}
+__attribute__((weak)) void DMA1_Channel2_3_IRQHandler(void) {}
+__attribute__((weak)) void DMA1_Channel4_5_6_7_IRQHandler(void) {}
+
+static void RaiseIRQ(unsigned Channel)
+{
+    if (!(Channels[Channel].Flags & Channels[Channel].ItMask))
+        return;
+
+    if (Channel == 1)
+    {
+        if (SIM_IsIRQEnabled(DMA1_Channel1_IRQn))
+            DMA1_Channel1_IRQHandler();
+    }
+    else if (Channel <= 3)
+    {
+        if (SIM_IsIRQEnabled(DMA1_Channel2_3_IRQn))
+            DMA1_Channel2_3_IRQHandler();
+    }
+    else
+    {
+        if (SIM_IsIRQEnabled(DMA1_Channel4_5_6_7_IRQn))
+            DMA1_Channel4_5_6_7_IRQHandler();
+    }
+}
+
+static Channel_t *FindChannel(uint32_t Request)
+{
+    for (unsigned i = 1; i <= DMA_CHANNELS; i++)
+        if (Channels[i].Enabled && Channels[i].Request == Request)
+            return &Channels[i];
+
+    return NULL;
+}
+
+static inline uint8_t *MemoryAt(const Channel_t *pChannel, uint32_t Index)
+{
+    const uint32_t Step = (pChannel->Config & LL_DMA_MEMORY_INCREMENT) ? 1 : 0;
+    return (uint8_t *)(uintptr_t)pChannel->Memory + Index * Step;
+}
+
+static void Complete(Channel_t *pChannel)
+{
+    pChannel->Flags |= SIM_DMA_FLAG_GI | SIM_DMA_FLAG_TC;
+    RaiseIRQ(pChannel - Channels);
+}
+
+// ---------------------------------------------------------------------------
+//  DMA
+
+void SIM_DMA_SetConfig(unsigned Channel, uint32_t Config)
+{
+    Channels[Channel].Config = Config;
+}
+
+uint32_t SIM_DMA_GetConfig(unsigned Channel)
+{
+    return Channels[Channel].Config;
+}
+
+void SIM_DMA_SetMemoryAddress(unsigned Channel, uint32_t Address)
+{
+    Channels[Channel].Memory = Address;
+}
+
+void SIM_DMA_SetDataLength(unsigned Channel, uint32_t Length)
+{
+    Channels[Channel].Length    = Length;
+    Channels[Channel].Remaining = Length;
+    Channels[Channel].Index     = 0;
+}
+
+uint32_t SIM_DMA_GetDataLength(unsigned Channel)
+{
+    SIM_Advance(SIM_COST_PERIPH);
+    return Channels[Channel].Remaining;
+}
+
+void SIM_DMA_Enable(unsigned Channel, bool Enable)
+{
+    Channels[Channel].Enabled = Enable;
+}
+
+bool SIM_DMA_IsEnabled(unsigned Channel)
+{
+    return Channels[Channel].Enabled;
+}
+
+void SIM_DMA_EnableIT(unsigned Channel, uint32_t Mask, bool Enable)
+{
+    if (Enable)
+        Channels[Channel].ItMask |= Mask;
+    else
+        Channels[Channel].ItMask &= ~Mask;
+}
+
+bool SIM_DMA_IsEnabledIT(unsigned Channel, uint32_t Mask)
+{
+    return (Channels[Channel].ItMask & Mask) != 0;
+}
+
+bool SIM_DMA_IsActiveFlag(unsigned Channel, uint32_t Mask)
+{
+    return (Channels[Channel].Flags & Mask) != 0;
+}
+
+void SIM_DMA_ClearFlag(unsigned Channel, uint32_t Mask)
+{
+    Channels[Channel].Flags &= ~Mask;
+}
+
+void SIM_DMA_SetRemap(unsigned Channel, uint32_t Request)
+{
+    Channels[Channel].Request = Request;
+}
+
+// ---------------------------------------------------------------------------
+//  SPI
+
+unsigned SIM_SPI_Index(const void *SPIx)
+{
+    return (uintptr_t)SPIx == SPI1_BASE ? SIM_SPI_1 : SIM_SPI_2;
+}
+
+void SIM_SPI_SetPrescaler(unsigned Spi, uint32_t Prescaler)
+{
+    SpiPrescaler[Spi] = Prescaler;
+}
+
+static uint8_t Exchange(unsigned Spi, uint8_t Value)
+{
+    if (Spi == SIM_SPI_1)
+    {
+        // A0 (PA6) selects command / display data
+        SIM_ST7565_Write(Value, SIM_GPIO_ReadOutput(SIM_PORT_A) & (1U << 6));
+        return 0xFF;
+    }
+
+    return SIM_PY25Q16_Transfer(Value);
+}
+
+uint8_t SIM_SPI_Transfer(unsigned Spi, uint8_t Value)
+{
+    SIM_Advance(8 * SpiPrescaler[Spi] + SIM_COST_PERIPH);
+    return Exchange(Spi, Value);
+}
+
+void SIM_SPI_StartDMA(unsigned Spi)
+{
+    const uint32_t ReqRd = Spi == SIM_SPI_1 ? LL_SYSCFG_DMA_MAP_SPI1_RD : LL_SYSCFG_DMA_MAP_SPI2_RD;
+    const uint32_t ReqWr = Spi == SIM_SPI_1 ? LL_SYSCFG_DMA_MAP_SPI1_WR : LL_SYSCFG_DMA_MAP_SPI2_WR;
+
+    Channel_t *pRd = FindChannel(ReqRd);
+    Channel_t *pWr = FindChannel(ReqWr);
+    if (!pWr)
+        return;
+
+    const uint32_t Size = pWr->Remaining;
+    for (uint32_t i = 0; i < Size; i++)
+    {
+        const uint8_t Rx = Exchange(Spi, *MemoryAt(pWr, i));
+        if (pRd && i < pRd->Remaining)
+            *MemoryAt(pRd, i) = Rx;
+    }
+
+    // The bus, not the DMA engine, is the bottleneck
+    SIM_Advance(Size * 8 * SpiPrescaler[Spi]);
+
+    pWr->Remaining = 0;
+    Complete(pWr);
+
+    if (pRd)
+    {
+        pRd->Remaining = 0;
+        Complete(pRd);
+    }
+}
+
+// ---------------------------------------------------------------------------
+//  USART1
+
+void SIM_USART_SetBaudRate(uint32_t BaudRate)
+{
+    static bool Configured;
+
+    // Report the switches a host negotiates, not the one at boot
+    if (Configured && BaudRate != UartBaudRate)
+        fprintf(stderr, "sim: USART1 at %u baud at %llu ms\n", (unsigned)BaudRate,
+                (unsigned long long)(gSimCycles / (SIM_CPU_CLOCK / 1000u)));
+
+    UartBaudRate = BaudRate;
+    Configured   = true;
+}
+
+bool SIM_USART_IsTxEmpty(void)
+{
+    SIM_Advance(SIM_COST_PERIPH);
+    return gSimCycles >= UartTxBusyUntil;
+}
+
+void SIM_USART_Transmit(uint8_t Value)
+{
+    // 1 start + 8 data + 1 stop
+    const uint64_t Start = gSimCycles > UartTxBusyUntil ? gSimCycles : UartTxBusyUntil;
+    UartTxBusyUntil = Start + 10ULL * SIM_CPU_CLOCK / UartBaudRate;
+
+    SIM_UART_Tx(Value);
+}
+
+// The bytes go out at once, the channel completes when the last of them
+// would have left the shift register.
+void SIM_USART_StartDMA(void)
+{
+    Channel_t *pChannel = FindChannel(LL_SYSCFG_DMA_MAP_USART1_WR);
+    if (!pChannel || pUartTxDma)
+        return;
+
+    for (uint32_t i = 0; i < pChannel->Remaining; i++)
+        SIM_USART_Transmit(*MemoryAt(pChannel, i));
+
+    pUartTxDma = pChannel;
+}
+
+void SIM_USART_Update(void)
+{
+    if (!pUartTxDma || gSimCycles < UartTxBusyUntil)
+        return;
+
+    Channel_t *pChannel = pUartTxDma;
+    pUartTxDma = NULL;
+    pChannel->Remaining = 0;
+    Complete(pChannel);
+}
+
+void SIM_USART_Receive(uint8_t Value)
+{
+    Channel_t *pChannel = FindChannel(LL_SYSCFG_DMA_MAP_USART1_RD);
+    if (!pChannel || !pChannel->Length)
+        return;
+
+    *MemoryAt(pChannel, pChannel->Index) = Value;
+
+    if (++pChannel->Index == pChannel->Length || --pChannel->Remaining == 0)
+    {
+        pChannel->Index = 0;
+        pChannel->Remaining = pChannel->Length;
+        Complete(pChannel);
+    }
+    else if (pChannel->Index == pChannel->Length / 2)
+    {
+        pChannel->Flags |= SIM_DMA_FLAG_GI | SIM_DMA_FLAG_HT;
+        RaiseIRQ(pChannel - Channels);
+    }
+}
+
+// ---------------------------------------------------------------------------
+//  ADC1 / TIM
+
+uint16_t SIM_ADC_Read(void)
+{
+    // Battery divider around 7.8 V with the seeded calibration (py25q16.c)
+    return 2050;
+}
+
+TIM_TypeDef *SIM_TIM(const TIM_TypeDef *TIMx)
+{
+    return &Timers[(uintptr_t)TIMx == TIM6_BASE ? 0 : 1];
+}
@@ -0,0 +1,251 @@
+// PY25Q16 2 MB SPI NOR flash.
+//
+// Programming can only clear bits and erases are sector (4 KB) or block
+// granular, like the real part. WIP stays set for the datasheet typical
+// program / erase time so the driver's WaitWIP() polling costs what it
+// costs on the radio.
+//
+// With --power-cut N the Nth program or erase is torn: a program keeps
+// only the first half of its bytes, an erase only clears the first half
+// of the sector. The run then ends as if power had gone, the image is
+// written back for the next boot to recover.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "py32f0xx.h"
+
+#define FLASH_SIZE  0x200000
+#define PAGE_SIZE   0x100
+
+#define T_PP_US     600
+#define T_SE_US     45000
+#define T_BE32_US   150000
+#define T_BE64_US   250000
+
+static uint8_t  *pMemory;
+static bool     Selected;
+static unsigned Count;          // bytes clocked in this transaction
+static uint8_t  Opcode;
+static uint32_t Address;
+static bool     WriteEnabled;
+static uint64_t BusyUntil;
+static uint64_t Operations;     // programs and erases, for --power-cut
+static uint8_t  PageBefore[PAGE_SIZE];
+
+static uint64_t StatReadBytes;
+static uint64_t StatProgramBytes;
+static uint64_t StatPrograms;
+static uint64_t StatErases;
+static uint64_t StatTransactions;
+
+// A radio always leaves the factory with a battery calibration (0x1F40),
+// without it the firmware sees a flat battery and never lights the display.
+static void SeedCalibration(void)
+{
+    static const uint16_t Battery[6] = { 1368, 1813, 1905, 2000, 2029, 2300 };
+
+    memcpy(pMemory + 0x010000 + 0x140, Battery, sizeof(Battery));
+}
+
+void SIM_PY25Q16_Init(const char *pFile)
+{
+    pMemory = malloc(FLASH_SIZE);
+    memset(pMemory, 0xFF, FLASH_SIZE);
+
+    FILE *f = pFile ? fopen(pFile, "rb") : NULL;
+    if (f)
+    {
+        size_t n = fread(pMemory, 1, FLASH_SIZE, f);
+        fclose(f);
+        fprintf(stderr, "sim: loaded %zu bytes of flash from %s\n", n, pFile);
+    }
+    else
+    {
+        SeedCalibration();
+    }
+}
+
+void SIM_PY25Q16_Save(const char *pFile)
+{
+    if (!pFile || !pMemory)
+        return;
+
+    FILE *f = fopen(pFile, "wb");
+    if (!f)
+    {
+        perror(pFile);
+        return;
+    }
+
+    fwrite(pMemory, 1, FLASH_SIZE, f);
+    fclose(f);
+}
+
+static inline bool IsBusy(void)
+{
+    return gSimCycles < BusyUntil;
+}
+
+static bool IsCut(void)
+{
+    return ++Operations == gSimConfig.PowerCut;
+}
+
+static void PowerCut(void)
+{
+    fprintf(stderr, "sim: power cut at flash operation %llu\n", (unsigned long long)Operations);
+    SIM_Exit(0);
+}
+
+static void Erase(uint32_t Addr, uint32_t Size, uint32_t Time)
+{
+    if (!WriteEnabled || IsBusy())
+        return;
+
+    Addr &= ~(Size - 1) & (FLASH_SIZE - 1);
+    if (IsCut())
+    {
+        memset(pMemory + Addr, 0xFF, Size / 2);
+        PowerCut();
+    }
+    memset(pMemory + Addr, 0xFF, Size);
+
+    StatErases++;
+    WriteEnabled = false;
+    BusyUntil = gSimCycles + SIM_US_TO_CYCLES(Time);
+}
+
+void SIM_PY25Q16_Select(bool Sel)
+{
+    if (Selected && !Sel)
+    {
+        // Commands that execute on CS going high
+        switch (Opcode)
+        {
+        case 0x20:
+            if (Count >= 4)
+                Erase(Address, 0x1000, T_SE_US);
+            break;
+        case 0x52:
+            if (Count >= 4)
+                Erase(Address, 0x8000, T_BE32_US);
+            break;
+        case 0xD8:
+            if (Count >= 4)
+                Erase(Address, 0x10000, T_BE64_US);
+            break;
+        case 0x02:
+            if (Count > 4 && WriteEnabled)
+            {
+                if (IsCut())
+                {
+                    const uint32_t Page = Address & ~(PAGE_SIZE - 1) & (FLASH_SIZE - 1);
+                    const unsigned Bytes = Count - 4 < PAGE_SIZE ? Count - 4 : PAGE_SIZE;
+                    for (unsigned i = Bytes / 2; i < Bytes; i++)
+                    {
+                        const uint32_t Offset = (Address + i) & (PAGE_SIZE - 1);
+                        pMemory[Page + Offset] = PageBefore[Offset];
+                    }
+                    PowerCut();
+                }
+                StatPrograms++;
+                WriteEnabled = false;
+                BusyUntil = gSimCycles + SIM_US_TO_CYCLES(T_PP_US);
+            }
+            break;
+        }
+
+        StatTransactions++;
+    }
+
+    if (Sel)
+    {
+        Count = 0;
+        Opcode = 0;
+        Address = 0;
+    }
+
+    Selected = Sel;
+}
+
+uint8_t SIM_PY25Q16_Transfer(uint8_t Value)
+{
+    if (!Selected)
+        return 0xFF;
+
+    const unsigned Index = Count++;
+
+    if (Index == 0)
+    {
+        Opcode = Value;
+
+        switch (Opcode)
+        {
+        case 0x06:
+            if (!IsBusy())
+                WriteEnabled = true;
+            break;
+        case 0x04:
+            WriteEnabled = false;
+            break;
+        }
+
+        return 0xFF;
+    }
+
+    switch (Opcode)
+    {
+    case 0x05:  // RDSR
+        return (IsBusy() ? 0x01 : 0x00) | (WriteEnabled ? 0x02 : 0x00);
+    case 0x35:
+    case 0x15:
+        return 0x00;
+    case 0x9F:  // JEDEC ID
+        return (const uint8_t[]){0x85, 0x40, 0x15}[(Index - 1) % 3];
+    }
+
+    if (Index <= 3)
+    {
+        Address = (Address << 8) | Value;
+        return 0xFF;
+    }
+
+    switch (Opcode)
+    {
+    case 0x03:  // Read
+        if (IsBusy())
+            return 0xFF;
+        StatReadBytes++;
+        return pMemory[(Address + Index - 4) & (FLASH_SIZE - 1)];
+
+    case 0x0B:  // Fast read, one dummy byte
+        if (Index == 4 || IsBusy())
+            return 0xFF;
+        StatReadBytes++;
+        return pMemory[(Address + Index - 5) & (FLASH_SIZE - 1)];
+
+    case 0x02:  // Page program, wraps inside the page
+        if (WriteEnabled && !IsBusy())
+        {
+            const uint32_t Page = Address & ~(PAGE_SIZE - 1) & (FLASH_SIZE - 1);
+            if (Index == 4)
+                memcpy(PageBefore, pMemory + Page, PAGE_SIZE);
+            pMemory[Page + ((Address + Index - 4) & (PAGE_SIZE - 1))] &= Value;
+            StatProgramBytes++;
+        }
+        return 0xFF;
+    }
+
+    return 0xFF;
+}
+
+void SIM_PY25Q16_Report(FILE *pFile)
+{
+    fprintf(pFile, "py25q16: %llu transactions, %llu bytes read, %llu page programs (%llu bytes), %llu erases\n",
+            (unsigned long long)StatTransactions,
+            (unsigned long long)StatReadBytes,
+            (unsigned long long)StatPrograms,
+            (unsigned long long)StatProgramBytes,
+            (unsigned long long)StatErases);
+}
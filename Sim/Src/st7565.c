@@ -0,0 +1,90 @@
+// ST7565 display RAM, fed from SPI1 with A0 selecting data or command.
+
+#include <string.h>
+
+#include "py32f0xx.h"
+
+#define PAGES   8
+#define COLUMNS 132
+#define OFFSET  4   // the firmware skips the first 4 RAM columns
+
+static uint8_t  Ram[PAGES][COLUMNS];
+static unsigned Page;
+static unsigned Column;
+static bool     Selected;
+static bool     ExpectParam;
+static bool     Inverse;
+static bool     On;
+
+void SIM_ST7565_Select(bool Sel)
+{
+    Selected = Sel;
+}
+
+static void Command(uint8_t Value)
+{
+    if (ExpectParam)
+    {
+        // Electronic volume level after 0x81
+        ExpectParam = false;
+        return;
+    }
+
+    if ((Value & 0xF0) == 0xB0)
+        Page = Value & 0x0F;
+    else if ((Value & 0xF0) == 0x10)
+        Column = (Column & 0x0F) | ((Value & 0x0F) << 4);
+    else if ((Value & 0xF0) == 0x00)
+        Column = (Column & 0xF0) | (Value & 0x0F);
+    else if (Value == 0x81)
+        ExpectParam = true;
+    else if ((Value & 0xFE) == 0xA6)
+        Inverse = Value & 1;
+    else if ((Value & 0xFE) == 0xAE)
+        On = Value & 1;
+    else if (Value == 0xE2)
+        Page = Column = 0;
+}
+
+void SIM_ST7565_Write(uint8_t Value, bool Data)
+{
+    if (!Selected)
+        return;
+
+    if (!Data)
+    {
+        Command(Value);
+        return;
+    }
+
+    if (Page < PAGES && Column < COLUMNS)
+        Ram[Page][Column] = Value;
+
+    if (Column < COLUMNS)
+        Column++;
+}
+
+void SIM_ST7565_Dump(FILE *pFile)
+{
+    fprintf(pFile, "+");
+    for (unsigned x = OFFSET; x < COLUMNS; x++)
+        fputc('-', pFile);
+    fprintf(pFile, "+%s\n", On ? "" : " (display off)");
+
+    for (unsigned y = 0; y < PAGES * 8; y += 2)
+    {
+        fputc('|', pFile);
+        for (unsigned x = OFFSET; x < COLUMNS; x++)
+        {
+            const bool Top = ((Ram[y / 8][x] >> (y % 8)) & 1) ^ Inverse;
+            const bool Bot = ((Ram[y / 8][x] >> (y % 8 + 1)) & 1) ^ Inverse;
+            fputs(Top ? (Bot ? "█" : "▀") : (Bot ? "▄" : " "), pFile);
+        }
+        fputs("|\n", pFile);
+    }
+
+    fprintf(pFile, "+");
+    for (unsigned x = OFFSET; x < COLUMNS; x++)
+        fputc('-', pFile);
+    fprintf(pFile, "+\n");
+}
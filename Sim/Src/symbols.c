@@ -0,0 +1,106 @@
+// Address to function name, straight from the ELF symbol table of our own
+// executable. Unlike dladdr() this also knows static functions such as
+// spectrum.c's Scan(), which is what the per-call-site reports need.
+
+#include <elf.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+typedef struct
+{
+    uintptr_t   Start;
+    uintptr_t   End;
+    const char *pName;
+} Symbol_t;
+
+static Symbol_t *pSymbols;
+static size_t    SymbolCount;
+static char     *pImage;
+
+static int CompareSymbols(const void *a, const void *b)
+{
+    const Symbol_t *pA = a;
+    const Symbol_t *pB = b;
+
+    return (pA->Start > pB->Start) - (pA->Start < pB->Start);
+}
+
+static void Load(void)
+{
+    FILE *f = fopen("/proc/self/exe", "rb");
+    if (!f)
+        return;
+
+    fseek(f, 0, SEEK_END);
+    const long Size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    pImage = malloc(Size);
+    if (!pImage || fread(pImage, 1, Size, f) != (size_t)Size)
+    {
+        fclose(f);
+        return;
+    }
+    fclose(f);
+
+    const Elf64_Ehdr *pEhdr = (const Elf64_Ehdr *)pImage;
+    if (memcmp(pEhdr->e_ident, ELFMAG, SELFMAG) != 0 || pEhdr->e_ident[EI_CLASS] != ELFCLASS64)
+        return;
+
+    const Elf64_Shdr *pShdr = (const Elf64_Shdr *)(pImage + pEhdr->e_shoff);
+    for (unsigned i = 0; i < pEhdr->e_shnum; i++)
+    {
+        if (pShdr[i].sh_type != SHT_SYMTAB)
+            continue;
+
+        const Elf64_Sym *pSym  = (const Elf64_Sym *)(pImage + pShdr[i].sh_offset);
+        const char      *pStr  = pImage + pShdr[pShdr[i].sh_link].sh_offset;
+        const size_t     Count = pShdr[i].sh_size / sizeof(Elf64_Sym);
+
+        pSymbols = calloc(Count, sizeof(Symbol_t));
+        if (!pSymbols)
+            return;
+
+        for (size_t j = 0; j < Count; j++)
+        {
+            if (ELF64_ST_TYPE(pSym[j].st_info) != STT_FUNC || !pSym[j].st_value)
+                continue;
+
+            pSymbols[SymbolCount].Start = pSym[j].st_value;
+            pSymbols[SymbolCount].End   = pSym[j].st_value + (pSym[j].st_size ? pSym[j].st_size : 1);
+            pSymbols[SymbolCount].pName = pStr + pSym[j].st_name;
+            SymbolCount++;
+        }
+        break;
+    }
+
+    qsort(pSymbols, SymbolCount, sizeof(Symbol_t), CompareSymbols);
+}
+
+const char *SIM_Symbol_Lookup(uintptr_t Address)
+{
+    static bool Loaded;
+    if (!Loaded)
+    {
+        Loaded = true;
+        Load();
+    }
+
+    size_t Lo = 0;
+    size_t Hi = SymbolCount;
+    while (Lo < Hi)
+    {
+        const size_t Mid = (Lo + Hi) / 2;
+        if (pSymbols[Mid].Start <= Address)
+            Lo = Mid + 1;
+        else
+            Hi = Mid;
+    }
+
+    if (Lo && Address < pSymbols[Lo - 1].End)
+        return pSymbols[Lo - 1].pName;
+
+    return NULL;
+}
@@ -0,0 +1,62 @@
+// USART1 on a pseudo-terminal, so serialtool / k5viewer / CHIRP can talk to
+// the simulator exactly as they would to a cable. Run with --realtime when
+// a host tool is attached, otherwise its timeouts are meaningless.
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+static int PtyFd = -1;
+
+static uint64_t StatTxBytes;
+static uint64_t StatRxBytes;
+
+bool SIM_UART_OpenPty(void)
+{
+    PtyFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (PtyFd < 0 || grantpt(PtyFd) || unlockpt(PtyFd))
+    {
+        perror("sim: pty");
+        return false;
+    }
+
+    struct termios Tio;
+    tcgetattr(PtyFd, &Tio);
+    cfmakeraw(&Tio);
+    tcsetattr(PtyFd, TCSANOW, &Tio);
+
+    fcntl(PtyFd, F_SETFL, fcntl(PtyFd, F_GETFL) | O_NONBLOCK);
+
+    fprintf(stderr, "sim: UART on %s\n", ptsname(PtyFd));
+    return true;
+}
+
+void SIM_UART_Tx(uint8_t Value)
+{
+    StatTxBytes++;
+
+    if (PtyFd >= 0)
+    {
+        ssize_t n = write(PtyFd, &Value, 1);
+        (void)n;
+    }
+}
+
+void SIM_UART_Poll(void)
+{
+    if (PtyFd < 0)
+        return;
+
+    uint8_t Buf[64];
+    ssize_t n = read(PtyFd, Buf, sizeof(Buf));
+    for (ssize_t i = 0; i < n; i++)
+    {
+        StatRxBytes++;
+        SIM_USART_Receive(Buf[i]);
+    }
+}
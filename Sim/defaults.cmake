@@ -0,0 +1,44 @@
+
+# Feature set for a bare "cmake -S . -B build" host configure, mirroring the
+# "default" preset. Values already in the cache (presets, -D) take priority.
+
+foreach(feature
+    ENABLE_UART
+    ENABLE_VOX
+    ENABLE_TX1750
+    ENABLE_FLASHLIGHT
+    ENABLE_BIG_FREQ
+    ENABLE_SMALL_BOLD
+    ENABLE_CUSTOM_MENU_LAYOUT
+    ENABLE_KEEP_MEM_NAME
+    ENABLE_WIDE_RX
+    ENABLE_NO_CODE_SCAN_TIMEOUT
+    ENABLE_SQUELCH_MORE_SENSITIVE
+    ENABLE_FASTER_CHANNEL_SCAN
+    ENABLE_RSSI_BAR
+    ENABLE_AUDIO_BAR
+    ENABLE_COPY_CHAN_TO_VFO
+    ENABLE_SCAN_RANGES
+    ENABLE_NAVIG_LEFT_RIGHT
+    ENABLE_FLASH_WRITE_BACK
+    ENABLE_UART_TX_DMA
+    ENABLE_UART_HIGH_SPEED
+    ENABLE_UART_BULK
+    ENABLE_UART_PIPELINE
+    ENABLE_UART_DELTA
+    ENABLE_FEAT_F4HWN
+    ENABLE_FEAT_F4HWN_SPECTRUM
+    ENABLE_FEAT_F4HWN_RX_TX_TIMER
+    ENABLE_FEAT_F4HWN_SLEEP
+    ENABLE_FEAT_F4HWN_RESUME_STATE
+    ENABLE_FEAT_F4HWN_NARROWER
+    ENABLE_FEAT_F4HWN_INV
+    ENABLE_FEAT_F4HWN_CTR
+    ENABLE_FEAT_F4HWN_CA
+)
+    set(${feature} ON CACHE BOOL "")
+endforeach()
+
+set(VERSION_STRING_1 "v0.22" CACHE STRING "")
+set(VERSION_STRING_2 "v4.3.2" CACHE STRING "")
+set(EDITION_STRING "Simulator" CACHE STRING "")
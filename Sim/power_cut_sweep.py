@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""Power cut sweep of a channel save, for builds with ENABLE_FLASH_COMMIT.
+
+Saves VFO A to a memory channel with the keys, once without a cut to
+count the flash programs and erases it takes, then once with
+--power-cut N for each of them. Every logical sector of 0x000000 to
+0x011000, read through the commit map the way the firmware reads it,
+must match the image before the save or the one after: right after the
+cut, and again once the next boot has copied the sectors back home.
+
+usage: power_cut_sweep.py FIRMWARE [WORKDIR]
+"""
+
+import os
+import re
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+
+SECTOR = 0x1000
+LOGICAL = 17  # COMMIT_END / SECTOR_SIZE
+LOGS = (0x11, 0x17)
+FOLD = 0x80
+LAYOUT = 2
+MAP_MAGIC = 0x50414D43
+COMMIT_MAGIC = 0x54494D43
+
+# Checkpoint_t and Commit_t of App/driver/py25q16.c
+CHECKPOINT = struct.Struct("<II17H17BB2xH")
+COMMIT = struct.Struct("<I8HB8B8B25xH")
+SLOTS = SECTOR // COMMIT.size
+
+# MENU 17 is ChSave, the channel comes up selected
+SAVE_KEYS = ["2000:MENU", "2300:1", "2600:7", "3000:MENU", "3400:{}", "3800:MENU", "4200:MENU", "4600:EXIT"]
+RUN_MS = 8000
+
+
+def crc16(data: bytes) -> int:
+    """CRC_Calculate()"""
+    crc = 0
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def checkpoint(img: bytes, log: int):
+    raw = img[log * SECTOR : log * SECTOR + CHECKPOINT.size]
+    f = CHECKPOINT.unpack(raw)
+    if f[0] != MAP_MAGIC or crc16(raw[:-2]) != f[-1] or f[-2] != LAYOUT:
+        return None
+    return f[1], list(f[2 : 2 + LOGICAL]), list(f[2 + LOGICAL : 2 + 2 * LOGICAL])
+
+
+def logical(img: bytes) -> list[bytes]:
+    """The sectors as LoadMap() maps them"""
+    mp = list(range(LOGICAL))
+    home_crc = [0] * LOGICAL
+    folding = set()
+
+    cps = {log: checkpoint(img, log) for log in LOGS}
+    valid = [log for log in LOGS if cps[log]]
+    if valid:
+        if len(valid) == 2:
+            a, b = cps[LOGS[0]][0], cps[LOGS[1]][0]
+            log = LOGS[0] if 0 < (a - b) & 0xFFFFFFFF < 0x80000000 else LOGS[1]
+        else:
+            log = valid[0]
+        _, home_crc, raw_map = cps[log]
+        mp = [s & ~FOLD for s in raw_map]
+        folding = {i for i, s in enumerate(raw_map) if s & FOLD}
+
+        for slot in range(1, SLOTS):
+            raw = img[log * SECTOR + slot * COMMIT.size :][: COMMIT.size]
+            f = COMMIT.unpack(raw)
+            count = f[9]
+            if f[0] != COMMIT_MAGIC or not 1 <= count <= 8 or crc16(raw[:-2]) != f[-1]:
+                continue
+            for k in range(count):
+                home, sector, crc = f[10 + k], f[18 + k], f[1 + k]
+                if sector & FOLD:
+                    folding.add(home)
+                    continue
+                mp[home] = sector
+                home_crc[home] = crc
+                if sector == home:
+                    folding.discard(home)
+
+    away = [i for i in range(LOGICAL) if mp[i] != i and i not in folding]
+    if any(crc16(img[i * SECTOR : (i + 1) * SECTOR]) != home_crc[i] for i in away):
+        for i in away:
+            mp[i] = i
+
+    return [img[s * SECTOR : (s + 1) * SECTOR] for s in mp]
+
+
+def run(fw: str, img: str, keys: list[str], cut: int = 0) -> str:
+    args = [fw, "-t", str(RUN_MS), "-f", img]
+    for k in keys:
+        args += ["-k", k]
+    if cut:
+        args += ["-c", str(cut)]
+    out = subprocess.run(args, capture_output=True, text=True, timeout=120)
+    return out.stdout + out.stderr
+
+
+def operations(report: str) -> int:
+    m = re.search(r"(\d+) page programs .* (\d+) erases", report)
+    return int(m.group(1)) + int(m.group(2))
+
+
+def check(what: str, img: bytes, before: list[bytes], after: list[bytes]) -> int:
+    bad = 0
+    for i, sector in enumerate(logical(img)):
+        if sector != before[i] and sector != after[i]:
+            print("{}: sector {:06x} is neither the old nor the new one".format(what, i * SECTOR))
+            bad += 1
+    return bad
+
+
+def main() -> int:
+    fw = os.path.abspath(sys.argv[1])
+    work = sys.argv[2] if len(sys.argv) > 2 else tempfile.mkdtemp(prefix="power_cut_")
+    os.makedirs(work, exist_ok=True)
+    base = os.path.join(work, "base.bin")
+    img = os.path.join(work, "cut.bin")
+
+    # A first save, so that the sweep starts from a log in use
+    if os.path.exists(base):
+        os.remove(base)
+    run(fw, base, [k.format("DOWN") for k in SAVE_KEYS])
+    keys = [k.format("UP") for k in SAVE_KEYS]
+
+    shutil.copy(base, img)
+    total = operations(run(fw, img, keys))
+    with open(base, "rb") as f:
+        before = logical(f.read())
+    with open(img, "rb") as f:
+        after = logical(f.read())
+    if before == after:
+        print("the save changed nothing")
+        return 1
+
+    bad = 0
+    for n in range(1, total + 1):
+        shutil.copy(base, img)
+        if "power cut" not in run(fw, img, keys, n):
+            print("{}: no cut".format(n))
+            bad += 1
+            continue
+        with open(img, "rb") as f:
+            bad += check("cut {}".format(n), f.read(), before, after)
+
+        run(fw, img, [])
+        with open(img, "rb") as f:
+            data = f.read()
+        bad += check("cut {}, next boot".format(n), data, before, after)
+        homes = [data[i * SECTOR : (i + 1) * SECTOR] for i in range(LOGICAL)]
+        if homes != logical(data):
+            print("cut {}, next boot: sectors left away from home".format(n))
+            bad += 1
+
+    print("{} power cuts, {} failures".format(total, bad))
+    return 1 if bad else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
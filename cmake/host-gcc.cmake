@@ -0,0 +1,8 @@
+# Native toolchain for the host simulator (see Sim/)
+
+set(CMAKE_C_COMPILER                gcc)
+set(CMAKE_ASM_COMPILER              ${CMAKE_C_COMPILER})
+
+set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -Wall")
+set(CMAKE_C_FLAGS_DEBUG "-O0 -g3")
+set(CMAKE_C_FLAGS_RELEASE "-O2 -g0")
@@ -19,6 +19,9 @@ VERSION = '1.0'
 DEFAULT_PORT = '/dev/ttyUSB0'  # Change if needed (/dev/cu.usbserial-11130)
 BAUDRATE = 38400
 TIMEOUT = 0.5
+HIGH_SPEED_BAUDRATES = (115200, 230400, 460800, 921600)
+BAUD_KEEPALIVE = 1.0    # the radio falls back to 38400 after 3 s without a command
+BAUD_LOST = 3.5         # no frame at the high rate for this long: the radio fell back
 
 # Screen configuration
 WIDTH, HEIGHT = 128, 64
@@ -49,6 +52,50 @@ def send_keepalive(ser: serial.Serial):
     except serial.SerialException:
         pass
 
+# Command frames (ENABLE_UART_HIGH_SPEED), see App/app/uart.c
+MSG_BAUD = 0x0537
+MSG_BAUD_RESP = 0x0538
+OBFUSCATION = bytes.fromhex('166c14e62e910d402135d5401303e980')
+
+def crc16(data: bytes) -> int:
+    crc = 0
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021 if crc & 0x8000 else crc << 1) & 0xFFFF
+    return crc
+
+def obfuscate(data: bytes) -> bytes:
+    return bytes(b ^ OBFUSCATION[i % 16] for i, b in enumerate(data))
+
+def send_baud_request(ser: serial.Serial, baud: int):
+    msg = MSG_BAUD.to_bytes(2, 'little') + (4).to_bytes(2, 'little') + baud.to_bytes(4, 'little')
+    body = obfuscate(msg + crc16(msg).to_bytes(2, 'little'))
+    try:
+        ser.write(b'\xAB\xCD' + len(msg).to_bytes(2, 'little') + body + b'\xDC\xBA')
+    except serial.SerialException:
+        pass
+
+def switch_baud(ser: serial.Serial, baud: int) -> bool:
+    # Ask at the current rate, follow once the radio acknowledges
+    send_baud_request(ser, baud)
+    buf = bytearray()
+    end = time.monotonic() + 1.0
+    while time.monotonic() < end:
+        buf += ser.read(ser.in_waiting or 1)
+        i = buf.find(b'\xAB\xCD\x0C\x00')
+        if i < 0 or len(buf) < i + 18:
+            continue
+        reply = obfuscate(buf[i + 4:i + 16])
+        if int.from_bytes(reply[0:2], 'little') != MSG_BAUD_RESP:
+            del buf[:i + 2]
+            continue
+        if not reply[8]:
+            return False
+        ser.baudrate = baud
+        return True
+    return False
+
 def read_frame(ser: serial.Serial) -> bytearray:
     global framebuffer
     while True:
@@ -124,6 +171,15 @@ def run_viewer(args: argparse.Namespace, ser: serial.Serial):
     frame_lost = 0
     last_time = time.monotonic()
 
+    baud = BAUDRATE
+    if args.baud != BAUDRATE:
+        if switch_baud(ser, args.baud):
+            baud = args.baud
+            print(f"[✔] Link at {baud} baud")
+        else:
+            print(f"[!] The radio did not switch, staying at {BAUDRATE} baud")
+    last_keepalive = last_frame = time.monotonic()
+
     while True:
         for event in pygame.event.get():
             if event.type == pygame.QUIT:
@@ -160,6 +216,17 @@ def run_viewer(args: argparse.Namespace, ser: serial.Serial):
                 if pressed_key in COLOR_SETS.keys():
                     fg_color, bg_color = COLOR_SETS[pressed_key][1:]
         frame = read_frame(ser)
+        if baud != BAUDRATE:
+            now = time.monotonic()
+            if frame:
+                last_frame = now
+            if now - last_frame > BAUD_LOST:
+                # The cable could not keep up, or the radio timed out
+                baud = ser.baudrate = BAUDRATE
+                print(f"[!] No frames at {args.baud} baud, back to {BAUDRATE}")
+            elif now - last_keepalive > BAUD_KEEPALIVE:
+                send_baud_request(ser, baud)
+                last_keepalive = now
         if frame:
             last_surface = draw_frame(screen, framebuffer, bg_color, fg_color, pixel_size, pixel_lcd)
             frame_count += 1
@@ -199,6 +266,8 @@ def main():
     )
     parser.add_argument("--list-ports", action="store_true", help="list available ports and exit")
     parser.add_argument("--port", type=str, help="serial port to use (in place of 'DEFAULT_PORT')")
+    parser.add_argument("--baud", type=int, choices=(BAUDRATE,) + HIGH_SPEED_BAUDRATES, default=BAUDRATE,
+                        help="ask the radio for a faster link (firmware built with ENABLE_UART_HIGH_SPEED)")
     parser.add_argument("--version", action="version", version=f"%(prog)s {VERSION}", help="show program's version number and exit")
 
     args = parser.parse_args()
@@ -0,0 +1,119 @@
+from serial import Serial
+from time import monotonic
+import msg as mm
+
+MSG_BAUD = 0x0537
+MSG_BAUD_RESP = 0x0538
+
+DEFAULT_BAUD = 38400
+BAUD_RATES = (115200, 230400, 460800, 921600)
+
+_ACK_TIMEOUT = 1.0
+_CHECK_TIMEOUT = 0.5
+_RETRIES = 3
+
+# The radio goes back to 38400 once no valid frame has come for this long
+# (HIGH_SPEED_TIMEOUT_500MS in App/app/uart.c)
+_FALLBACK_TIMEOUT = 3.5
+
+
+class BaudSwitch:
+    """Asks the radio for another baud rate, follows it once it acknowledges
+    and checks the link with a version request at the new rate. If that
+    gets no answer the port goes back to 38400 and the radio is left to
+    time out to it too."""
+
+    def __init__(self, ser: Serial, baud: int, timestamp: int):
+        self._ser = ser
+        self._baud = baud
+        self._timestamp = timestamp
+        self._rx_buf = bytearray(256)
+        self._msg_buf = bytearray()
+        self._step = self._request
+        self._tries = 0
+        self._sent_at = 0.0
+
+    # True while busy
+    def loop(self) -> bool:
+        return self._step()
+
+    def _request(self) -> bool:
+        if self._tries == _RETRIES:
+            # The radio may have switched with the acknowledgement lost
+            print("No answer, staying at {} baud".format(DEFAULT_BAUD))
+            self._sent_at = monotonic()
+            self._step = self._wait_fallback
+            return True
+
+        print("Switching to {} baud..".format(self._baud))
+        msg = mm.Msg(8)
+        msg.set_msg_type(MSG_BAUD)
+        msg.set_word_LE(4, self._baud)
+        self._send(msg)
+        self._tries += 1
+        self._step = self._wait_ack
+        return True
+
+    def _wait_ack(self) -> bool:
+        msg = self._recv()
+        if not msg or MSG_BAUD_RESP != msg.get_msg_type():
+            if monotonic() - self._sent_at > _ACK_TIMEOUT:
+                self._step = self._request
+            return True
+
+        baud = msg.get_word_LE(4)
+        if not msg.buf[8]:
+            print("Rejected, the radio stays at {} baud".format(baud))
+            return False
+
+        self._ser.baudrate = baud
+        self._tries = 0
+        self._step = self._check
+        return True
+
+    def _check(self) -> bool:
+        if self._tries == _RETRIES:
+            print("No answer at {} baud, back to {}".format(self._baud, DEFAULT_BAUD))
+            self._ser.baudrate = DEFAULT_BAUD
+            self._sent_at = monotonic()
+            self._step = self._wait_fallback
+            return True
+
+        msg = mm.Msg(8)
+        msg.set_msg_type(0x0514)
+        msg.set_word_LE(4, self._timestamp)
+        self._send(msg)
+        self._tries += 1
+        self._step = self._wait_check
+        return True
+
+    def _wait_check(self) -> bool:
+        msg = self._recv()
+        if not msg or 0x0515 != msg.get_msg_type():
+            if monotonic() - self._sent_at > _CHECK_TIMEOUT:
+                self._step = self._check
+            return True
+
+        print("Link at {} baud".format(self._baud))
+        return False
+
+    def _wait_fallback(self) -> bool:
+        if monotonic() - self._sent_at < _FALLBACK_TIMEOUT:
+            return True
+
+        self._ser.reset_input_buffer()
+        return False
+
+    def _send(self, msg: mm.Msg):
+        self._ser.write(mm.make_packet(msg.buf))
+        self._ser.flush()
+        self._sent_at = monotonic()
+
+    def _recv(self) -> mm.Msg:
+        while True:
+            len1 = self._ser.readinto(self._rx_buf)
+            if len1 > 0:
+                self._msg_buf.extend(memoryview(self._rx_buf)[:len1])
+            if len1 < len(self._rx_buf):
+                break
+        return mm.fetch(self._msg_buf)
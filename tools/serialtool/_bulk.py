@@ -0,0 +1,350 @@
+from serial import Serial
+from time import monotonic
+import msg as mm
+import _lz as lz
+
+MSG_READ = 0x0539
+MSG_READ_RESP = 0x053A
+MSG_WRITE = 0x053B
+MSG_WRITE_RESP = 0x053C
+
+# ENABLE_UART_DELTA: sector hashes, and the above LZ encoded
+MSG_HASH = 0x053F
+MSG_HASH_RESP = 0x0540
+MSG_PACKED_WRITE = 0x0541
+MSG_PACKED_WRITE_RESP = 0x0542
+MSG_PACKED_READ = 0x0543
+MSG_PACKED_READ_RESP = 0x0544
+
+SECTOR_SIZE = 0x1000
+
+# A write frame has to fit the 256 byte receive buffer of the radio
+CHUNK_SIZE = 224
+
+# A sector takes about 1.1 s at 38400 baud
+_READ_TIMEOUT = 3.0
+_WRITE_TIMEOUT = 1.0
+_RETRIES = 3
+
+# EEPROM address ranges and the flash sector windows they live in, as in
+# ADDR_MAPPING_LIST of App/driver/eeprom_compat.c. None is a hole, read
+# as 0xFF and not written.
+EEPROM_MAPPINGS = (
+    (0x000000, 0x0000, 0x0C80),
+    (0x001000, 0x0C80, 0x0D60),
+    (0x002000, 0x0D60, 0x0E30),
+    (None, 0x0E30, 0x0E40),
+    (0x003000, 0x0E40, 0x0E68),
+    (None, 0x0E68, 0x0E70),
+    (0x004000, 0x0E70, 0x0E80),
+    (0x005000, 0x0E80, 0x0E88),
+    (0x006000, 0x0E88, 0x0E90),
+    (0x007000, 0x0E90, 0x0EE0),
+    (0x008000, 0x0EE0, 0x0F18),
+    (0x009000, 0x0F18, 0x0F20),
+    (None, 0x0F20, 0x0F30),
+    (0x00A000, 0x0F30, 0x0F40),
+    (0x00B000, 0x0F40, 0x0F48),
+    (None, 0x0F48, 0x0F50),
+    (0x00E000, 0x0F50, 0x1BD0),
+    (None, 0x1BD0, 0x1C00),
+    (0x00F000, 0x1C00, 0x1D00),
+    (None, 0x1D00, 0x1E00),
+    (0x010000, 0x1E00, 0x1F90),
+    (None, 0x1F90, 0x1FF0),
+    (0x00C000, 0x1FF0, 0x2000),
+)
+
+
+def _windows(off: int, size: int):
+    """(flash address, offset in the EEPROM range, length) of each part of
+    the range that is not a hole"""
+    end = off + size
+    for addr, begin, stop in EEPROM_MAPPINGS:
+        lo = max(off, begin)
+        hi = min(end, stop)
+        if addr is not None and lo < hi:
+            yield addr + lo - begin, lo - off, hi - lo
+
+
+def sectors_of(off: int, size: int) -> list[int]:
+    """Sectors that hold the EEPROM range"""
+    return sorted({a - a % SECTOR_SIZE for a, _, _ in _windows(off, size)})
+
+
+def to_eeprom(sectors: dict, off: int, size: int) -> bytearray:
+    data = bytearray(b"\xff" * size)
+    for addr, pos, n in _windows(off, size):
+        sec = sectors[addr - addr % SECTOR_SIZE]
+        begin = addr % SECTOR_SIZE
+        data[pos : pos + n] = sec[begin : begin + n]
+    return data
+
+
+def from_eeprom(sectors: dict, off: int, data: bytes):
+    """Puts the EEPROM range into the sectors, in place. Parts in sectors
+    not given are left out."""
+    for addr, pos, n in _windows(off, len(data)):
+        sec = sectors.get(addr - addr % SECTOR_SIZE)
+        if sec is None:
+            continue
+        begin = addr % SECTOR_SIZE
+        sec[begin : begin + n] = data[pos : pos + n]
+
+
+def fnv1a(data: bytes) -> int:
+    """The sector hash of the radio"""
+    h = 2166136261
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def _chunks(data: bytes, packed: bool) -> list[tuple[int, bytes]]:
+    """(offset in the sector, payload) of each write frame. LZ tokens are
+    not cut, the offset of a packed frame counts decoded bytes."""
+    if not packed:
+        return [(o, data[o : o + CHUNK_SIZE]) for o in range(0, len(data), CHUNK_SIZE)]
+
+    chunks = []
+    off = 0
+    size = 0
+    payload = bytearray()
+    for token in lz.encode(data):
+        if len(payload) + len(token) > CHUNK_SIZE:
+            chunks.append((off, bytes(payload)))
+            off += size
+            size = 0
+            payload.clear()
+        payload += token
+        size += lz.decoded_size(token)
+    chunks.append((off, bytes(payload)))
+    return chunks
+
+
+
+class _Transfer:
+
+    def __init__(self, ser: Serial, timestamp: int):
+        self._ser = ser
+        self._timestamp = timestamp
+        self._rx_buf = bytearray(256)
+        self._msg_buf = bytearray()
+        self._sent_at = 0.0
+        self._tries = 0
+        self.ok = False
+
+    def _send(self, msg: mm.Msg):
+        self._ser.write(mm.make_packet(msg.buf))
+        self._ser.flush()
+        self._sent_at = monotonic()
+
+    def _recv(self) -> mm.Msg:
+        while True:
+            len1 = self._ser.readinto(self._rx_buf)
+            if len1 > 0:
+                self._msg_buf.extend(memoryview(self._rx_buf)[:len1])
+            if len1 < len(self._rx_buf):
+                break
+        return mm.fetch(self._msg_buf)
+
+
+class SectorHashes(_Transfer):
+    """Asks for the hashes of the sectors from the first to the last of
+    `addrs` (ENABLE_UART_DELTA). The result is in `hashes`, by address."""
+
+    def __init__(self, ser: Serial, timestamp: int, addrs: list[int]):
+        super().__init__(ser, timestamp)
+        self.hashes = {}
+        self._first = min(addrs)
+        self._count = (max(addrs) - self._first) // SECTOR_SIZE + 1
+        self._step = self._request
+
+    # True while busy
+    def loop(self) -> bool:
+        return self._step()
+
+    def _request(self) -> bool:
+        if self._tries == _RETRIES:
+            print("No answer, giving up")
+            return False
+
+        print("Comparing sectors..")
+        msg = mm.Msg(16)
+        msg.set_msg_type(MSG_HASH)
+        msg.set_word_LE(4, self._timestamp)
+        msg.set_word_LE(8, self._first)
+        msg.set_hw_LE(12, self._count)
+        self._send(msg)
+        self._tries += 1
+        self._step = self._wait
+        return True
+
+    def _wait(self) -> bool:
+        msg = self._recv()
+        if not msg or MSG_HASH_RESP != msg.get_msg_type():
+            if monotonic() - self._sent_at > _WRITE_TIMEOUT:
+                self._step = self._request
+            return True
+
+        if msg.get_data_len() != 4 + 4 * self._count:
+            print("Hashes from sector {:06x} refused".format(self._first))
+            return False
+
+        for i in range(self._count):
+            self.hashes[self._first + i * SECTOR_SIZE] = msg.get_word_LE(8 + 4 * i)
+        self.ok = True
+        return False
+
+
+class SectorRead(_Transfer):
+    """Reads whole sectors, a run of adjacent ones per request, LZ encoded
+    if packed (ENABLE_UART_DELTA). The result is in `sectors`, by
+    address."""
+
+    def __init__(
+        self, ser: Serial, timestamp: int, addrs: list[int], packed: bool = False
+    ):
+        super().__init__(ser, timestamp)
+        self.sectors = {}
+        self._pending = sorted(addrs)
+        self._total = len(addrs)
+        self._run_end = 0
+        self._packed = packed
+        self._step = self._request
+
+    # True while busy
+    def loop(self) -> bool:
+        return self._step()
+
+    def _request(self) -> bool:
+        if not self._pending:
+            self.ok = True
+            return False
+        if self._tries == _RETRIES:
+            print("No answer, giving up")
+            return False
+
+        first = self._pending[0]
+        count = 1
+        while first + count * SECTOR_SIZE in self._pending:
+            count += 1
+
+        self._run_end = first + count * SECTOR_SIZE
+
+        msg = mm.Msg(16)
+        msg.set_msg_type(MSG_PACKED_READ if self._packed else MSG_READ)
+        msg.set_word_LE(4, self._timestamp)
+        msg.set_word_LE(8, first)
+        msg.set_hw_LE(12, count)
+        self._send(msg)
+        self._tries += 1
+        self._step = self._wait
+        return True
+
+    def _wait(self) -> bool:
+        resp = MSG_PACKED_READ_RESP if self._packed else MSG_READ_RESP
+        msg = self._recv()
+        if not msg or resp != msg.get_msg_type():
+            if monotonic() - self._sent_at > _READ_TIMEOUT:
+                self._step = self._request
+            return True
+
+        addr = msg.get_word_LE(4)
+        if 4 == msg.get_data_len():
+            print("Read of sector {:06x} refused".format(addr))
+            return False
+
+        self._sent_at = monotonic()
+        data = None
+        if msg.crc == mm.calc_CRC(msg.buf, 0, len(msg.buf)):
+            data = lz.decode(msg.buf[8:]) if self._packed else msg.buf[8:]
+        if not data or len(data) != SECTOR_SIZE:
+            print("Sector {:06x}: CRC error. Retry..".format(addr))
+            return True
+        if addr not in self._pending:
+            return True
+
+        self.sectors[addr] = bytearray(data)
+        self._pending.remove(addr)
+        self._tries = 0
+        per = len(self.sectors) * 100 // self._total
+        print(f"Fetching sectors.. {per}%")
+
+        if addr + SECTOR_SIZE == self._run_end:
+            self._step = self._request
+        return True
+
+
+class SectorWrite(_Transfer):
+    """Writes whole sectors, in the order given, CHUNK_SIZE bytes per frame,
+    LZ encoded if packed (ENABLE_UART_DELTA). A sector the radio refuses a
+    chunk of is started over."""
+
+    def __init__(
+        self,
+        ser: Serial,
+        timestamp: int,
+        sectors: list[tuple[int, bytes]],
+        packed: bool = False,
+    ):
+        super().__init__(ser, timestamp)
+        self._sectors = [(addr, _chunks(data, packed)) for addr, data in sectors]
+        self._packed = packed
+        self._index = 0
+        self._chunk = 0
+        self._step = self._request
+
+    # True while busy
+    def loop(self) -> bool:
+        return self._step()
+
+    def _request(self) -> bool:
+        if self._index == len(self._sectors):
+            self.ok = True
+            return False
+        if self._tries == _RETRIES:
+            print("No answer, giving up")
+            return False
+
+        addr, chunks = self._sectors[self._index]
+        if 0 == self._chunk:
+            per = self._index * 100 // len(self._sectors)
+            print(f"Writing sector {addr:06x}.. {per}%")
+
+        off, payload = chunks[self._chunk]
+        msg = mm.Msg(12 + len(payload))
+        msg.set_msg_type(MSG_PACKED_WRITE if self._packed else MSG_WRITE)
+        msg.set_word_LE(4, self._timestamp)
+        msg.set_word_LE(8, addr + off)
+        msg.buf[12:] = payload
+        self._send(msg)
+        self._tries += 1
+        self._step = self._wait
+        return True
+
+    def _wait(self) -> bool:
+        resp = MSG_PACKED_WRITE_RESP if self._packed else MSG_WRITE_RESP
+        msg = self._recv()
+        if not msg or resp != msg.get_msg_type():
+            if monotonic() - self._sent_at > _WRITE_TIMEOUT:
+                self._chunk = 0
+                self._step = self._request
+            return True
+
+        addr, chunks = self._sectors[self._index]
+        off = chunks[self._chunk][0]
+        end = chunks[self._chunk + 1][0] if self._chunk + 1 < len(chunks) else SECTOR_SIZE
+        if not msg.buf[8] or msg.get_word_LE(4) != addr + end:
+            print("Chunk {:06x} refused. Retry..".format(addr + off))
+            self._chunk = 0
+            self._step = self._request
+            return True
+
+        self._tries = 0
+        self._chunk += 1
+        if len(chunks) == self._chunk:
+            self._index += 1
+            self._chunk = 0
+        self._step = self._request
+        return True
@@ -0,0 +1,388 @@
+from serial import Serial
+from datetime import datetime
+import csv
+import struct
+import msg as mm
+import _baud as bd
+import _pipe as pp
+
+MSG_READ = 0x0545
+MSG_READ_RESP = 0x0546
+MSG_WRITE = 0x0547
+MSG_WRITE_RESP = 0x0548
+MSG_FIND = 0x0549
+MSG_FIND_RESP = 0x054A
+
+# CHDB_BANK_SIZE and CHDB_COUNT of App/chdb.h, bank 0 are the memory
+# channels the usual way
+BANK_SIZE = 200
+COUNT = BANK_SIZE * 20
+
+# Records per frame, CHDB_PAGE in App/app/uart.c
+PAGE = 4
+
+# CHDB_Record_t
+_RECORD = struct.Struct("<II8s10sB5s")
+RECORD_SIZE = _RECORD.size
+
+_PREFIX_SIZE = 12
+
+COLUMNS = ("id", "rx_mhz", "offset_mhz", "name", "data", "attributes")
+
+EXPORT = 1
+IMPORT = 2
+FIND = 3
+
+
+def _mhz(freq: int) -> str:
+    return "{:.5f}".format(freq / 100000)
+
+
+def parse_mhz(mhz: str) -> int:
+    return round(float(mhz) * 100000)
+
+
+def is_used(record: bytes) -> bool:
+    # band of the attributes, BAND7_470MHz at most
+    return record[26] & 7 <= 6
+
+
+def to_row(id: int, record: bytes) -> list[str]:
+    freq, offset, data, name, attr, _ = _RECORD.unpack(record)
+    name = name.split(b"\0")[0].split(b"\xff")[0].decode("ascii", "replace")
+    return [str(id), _mhz(freq), _mhz(offset), name, data.hex(), "{:02x}".format(attr)]
+
+
+def from_row(row: dict) -> bytes:
+    """The record of a CSV row, a free one if it has no RX frequency"""
+    if not row["rx_mhz"].strip():
+        return b"\xff" * RECORD_SIZE
+
+    name = row["name"].encode("ascii")[:10]
+    return _RECORD.pack(
+        parse_mhz(row["rx_mhz"]),
+        parse_mhz(row["offset_mhz"] or "0"),
+        bytes.fromhex(row["data"] or "00" * 8).ljust(8, b"\0"),
+        name.ljust(10, b"\0"),
+        int(row["attributes"] or "00", 16),
+        b"\xff" * 5,
+    )
+
+
+class ChannelDb:
+    """Reads, writes and looks up the channels of the database in the
+    radio flash (firmware built with ENABLE_CHANNEL_DB). Banks 1 and up
+    only, bank 0 are the memory channels of dump and restore."""
+
+    def __init__(
+        self,
+        ser: Serial,
+        action: int,
+        file: str = None,
+        baud: int = bd.DEFAULT_BAUD,
+        lower: int = 0,
+        upper: int = 0,
+        prefix: str = "",
+    ):
+        self._ser = ser
+        self._action = action
+        self._file = file
+        self._baud = baud
+        self._lower = lower
+        self._upper = upper
+        self._prefix = prefix
+        self._state = _Init(self)
+
+    def loop(self) -> bool:
+        next = self._state.loop()
+        if isinstance(next, bool):
+            return next
+        elif next:
+            self._state = next
+
+        return True
+
+
+class _State:
+    def __init__(self, db: ChannelDb):
+        self.db = db
+        self.ser = db._ser
+        self.rx_buf = bytearray(256)
+        self.msg_buf = bytearray()
+
+    def loop(self) -> bool | object:
+        raise NotImplementedError()
+
+    def send_msg(self, msg: mm.Msg):
+        self.ser.write(mm.make_packet(msg.buf))
+        self.ser.flush()
+
+    def recv_msg(self) -> mm.Msg:
+        while True:
+            len1 = self.ser.readinto(self.rx_buf)
+            if len1 > 0:
+                self.msg_buf.extend(memoryview(self.rx_buf)[:len1])
+            if len1 < len(self.rx_buf):
+                break
+        return mm.fetch(self.msg_buf)
+
+
+class _Init(_State):
+    def loop(self) -> _State:
+        if self.ser.readinto(self.rx_buf):
+            print(".", end="")
+            return self
+
+        print()
+        return _Session(self.db)
+
+
+class _Session(_State):
+    """Opens the session the database commands ask for"""
+
+    def __init__(self, db):
+        super().__init__(db)
+        self.timestamp = int(datetime.now().timestamp()) & 0xFFFFFFFF
+        self.expect_resp = False
+
+    def loop(self) -> _State:
+        if not self.expect_resp:
+            print("Examing device info..")
+            msg = mm.Msg(8)
+            msg.set_msg_type(0x0514)
+            msg.set_word_LE(4, self.timestamp)
+            self.send_msg(msg)
+            self.expect_resp = True
+            return
+
+        msg = self.recv_msg()
+        if not msg or 0x0515 != msg.get_msg_type():
+            return
+
+        if bd.DEFAULT_BAUD != self.db._baud:
+            return _SwitchBaud(self.db, self.timestamp)
+        return _action(self.db, self.timestamp)
+
+
+def _action(db: ChannelDb, timestamp: int) -> _State:
+    if EXPORT == db._action:
+        return _Export(db, timestamp)
+    if IMPORT == db._action:
+        return _Import(db, timestamp)
+    return _Find(db, timestamp)
+
+
+class _SwitchBaud(_State):
+
+    def __init__(self, db: ChannelDb, timestamp: int):
+        super().__init__(db)
+        self.timestamp = timestamp
+        self.switch = bd.BaudSwitch(self.ser, db._baud, timestamp)
+
+    def loop(self) -> _State:
+        if self.switch.loop():
+            return
+
+        return _action(self.db, self.timestamp)
+
+
+class _Export(_State):
+    """Reads banks 1 and up, PAGE records per request, and saves the used
+    ones as CSV"""
+
+    def __init__(self, db, timestamp: int):
+        super().__init__(db)
+        self.timestamp = timestamp
+        self.pipe = pp.Pipeline(self.ser)
+        self.todo = list(range(BANK_SIZE, COUNT, PAGE))
+        self.records = {}
+
+    def loop(self) -> bool | _State:
+        if self.pipe.failed:
+            print("No answer, giving up")
+            return False
+
+        while self.todo:
+            msg = mm.Msg(12)
+            msg.set_msg_type(MSG_READ)
+            msg.set_word_LE(4, self.timestamp)
+            msg.set_hw_LE(8, self.todo[0])
+            msg.set_hw_LE(10, PAGE)
+            if not self.pipe.ready(msg):
+                break
+            self.pipe.send(msg, self.todo.pop(0))
+
+        while True:
+            reply = self.pipe.poll()
+            if not reply:
+                break
+
+            id, msg = reply
+            if (
+                MSG_READ_RESP != msg.get_msg_type()
+                or msg.get_hw_LE(4) != id
+                or msg.get_hw_LE(6) != PAGE
+            ):
+                print("Channels from {} refused".format(id))
+                return False
+
+            for i in range(PAGE):
+                off = 8 + i * RECORD_SIZE
+                self.records[id + i] = bytes(msg.buf[off : off + RECORD_SIZE])
+
+            per = len(self.records) * 100 // (COUNT - BANK_SIZE)
+            print(f"Fetching channels.. {per}%")
+
+        if len(self.records) < COUNT - BANK_SIZE:
+            return
+
+        used = 0
+        with open(self.db._file, "w", newline="") as fd:
+            w = csv.writer(fd)
+            w.writerow(COLUMNS)
+            for id in sorted(self.records):
+                if is_used(self.records[id]):
+                    w.writerow(to_row(id, self.records[id]))
+                    used += 1
+
+        print("{} channels saved to {}".format(used, self.db._file))
+        return False
+
+
+class _Import(_State):
+    """Writes the channels of a CSV file, runs of neighbouring Ids PAGE
+    per request. Channels not in the file are left as they are."""
+
+    def __init__(self, db, timestamp: int):
+        super().__init__(db)
+        self.timestamp = timestamp
+        self.pipe = pp.Pipeline(self.ser)
+        self.todo = []
+        self.done = 0
+
+        records = {}
+        with open(db._file, newline="") as fd:
+            for row in csv.DictReader(fd):
+                id = int(row["id"])
+                if BANK_SIZE <= id < COUNT:
+                    records[id] = from_row(row)
+                else:
+                    print("Channel {} skipped, not in banks 1 and up".format(id))
+
+        for id in sorted(records):
+            run = self.todo[-1] if self.todo else None
+            if run and run[0] + len(run[1]) == id and len(run[1]) < PAGE:
+                run[1].append(records[id])
+            else:
+                self.todo.append((id, [records[id]]))
+
+        self.total = len(records)
+
+    def loop(self) -> bool | _State:
+        if self.pipe.failed:
+            print("No answer, giving up")
+            return False
+
+        while self.todo:
+            id, records = self.todo[0]
+            msg = mm.Msg(12 + RECORD_SIZE * len(records))
+            msg.set_msg_type(MSG_WRITE)
+            msg.set_word_LE(4, self.timestamp)
+            msg.set_hw_LE(8, id)
+            msg.set_hw_LE(10, len(records))
+            msg.buf[12:] = b"".join(records)
+            if not self.pipe.ready(msg):
+                break
+            self.pipe.send(msg, self.todo.pop(0))
+
+        while True:
+            reply = self.pipe.poll()
+            if not reply:
+                break
+
+            (id, records), msg = reply
+            if (
+                MSG_WRITE_RESP != msg.get_msg_type()
+                or msg.get_hw_LE(4) != id
+                or msg.get_hw_LE(6) != len(records)
+            ):
+                print("Channels from {} refused".format(id))
+                return False
+
+            self.done += len(records)
+            print(f"Writing channels.. {self.done * 100 // max(self.total, 1)}%")
+
+        if self.todo or not self.pipe.idle():
+            return
+
+        print("{} channels written".format(self.done))
+        return False
+
+
+class _Find(_State):
+    """Looks channels up in every bank by RX frequency or name, and reads
+    the ones found"""
+
+    def __init__(self, db, timestamp: int):
+        super().__init__(db)
+        self.timestamp = timestamp
+        self.pipe = pp.Pipeline(self.ser)
+        self.ids = None
+        self.todo = []
+        self.rows = {}
+
+        msg = mm.Msg(16 + _PREFIX_SIZE)
+        msg.set_msg_type(MSG_FIND)
+        msg.set_word_LE(4, timestamp)
+        msg.set_word_LE(8, db._lower)
+        msg.set_word_LE(12, db._upper)
+        prefix = db._prefix.encode("ascii")[: _PREFIX_SIZE - 1]
+        msg.buf[16 : 16 + len(prefix)] = prefix
+        self.pipe.send(msg, None)
+
+    def loop(self) -> bool | _State:
+        if self.pipe.failed:
+            print("No answer, giving up")
+            return False
+
+        while self.todo:
+            msg = mm.Msg(12)
+            msg.set_msg_type(MSG_READ)
+            msg.set_word_LE(4, self.timestamp)
+            msg.set_hw_LE(8, self.ids[self.todo[0]])
+            msg.set_hw_LE(10, 1)
+            if not self.pipe.ready(msg):
+                break
+            self.pipe.send(msg, self.todo.pop(0))
+
+        reply = self.pipe.poll()
+        if not reply:
+            return
+
+        i, msg = reply
+        if i is None:
+            if MSG_FIND_RESP != msg.get_msg_type():
+                print("Lookup refused")
+                return False
+
+            count = msg.get_hw_LE(4)
+            self.ids = [msg.get_hw_LE(6 + 2 * n) for n in range(count)]
+            if not self.ids:
+                print("No channel found")
+                return False
+
+            self.todo = list(range(len(self.ids)))
+            return
+
+        if MSG_READ_RESP != msg.get_msg_type() or msg.get_hw_LE(6) != 1:
+            print("Channel {} refused".format(self.ids[i]))
+            return False
+
+        self.rows[i] = to_row(self.ids[i], msg.buf[8 : 8 + RECORD_SIZE])
+        if len(self.rows) < len(self.ids):
+            return
+
+        print(",".join(COLUMNS))
+        for n in range(len(self.ids)):
+            print(",".join(self.rows[n]))
+        return False
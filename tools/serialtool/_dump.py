@@ -16,6 +16,9 @@
 from serial import Serial
 from datetime import datetime
 import msg as mm
+import _baud as bd
+import _bulk as bk
+import _pipe as pp
 
 DUMP_CONFIG = 1
 DUMP_CALIB = 2
@@ -24,10 +27,21 @@ DUMP_ALL = 0xFF
 
 class EepromDump:
 
-    def __init__(self, ser: Serial, dump_what: int, dump_file: str):
+    def __init__(
+        self,
+        ser: Serial,
+        dump_what: int,
+        dump_file: str,
+        baud: int = bd.DEFAULT_BAUD,
+        bulk: bool = False,
+        delta: bool = False,
+    ):
         self._ser = ser
         self._dump_what = dump_what
         self._dump_file = dump_file
+        self._baud = baud
+        self._bulk = bulk
+        self._delta = delta
         self._state = _Init(self)
         # self._dev_info = None
 
@@ -153,7 +167,9 @@ class _DeviceInfo(_State):
         )
 
         # return _AccessRequest(self.dump, dev_info, self.timestamp)
-        return _DumpEeprom(self.dump, self.timestamp)
+        if bd.DEFAULT_BAUD != self.dump._baud:
+            return _SwitchBaud(self.dump, self.timestamp)
+        return _transfer(self.dump, self.timestamp)
 
     def send_request(self):
 
@@ -166,6 +182,28 @@ class _DeviceInfo(_State):
         self.send_msg(msg)
 
 
+def _transfer(dump: EepromDump, timestamp: int) -> _State:
+    if dump._delta:
+        return _BulkDump(dump, timestamp, packed=True)
+    if dump._bulk:
+        return _BulkDump(dump, timestamp)
+    return _DumpEeprom(dump, timestamp)
+
+
+class _SwitchBaud(_State):
+
+    def __init__(self, dump: EepromDump, timestamp: int):
+        super().__init__(dump)
+        self.timestamp = timestamp
+        self.switch = bd.BaudSwitch(self.ser, dump._baud, timestamp)
+
+    def loop(self) -> _State:
+        if self.switch.loop():
+            return
+
+        return _transfer(self.dump, self.timestamp)
+
+
 class _AccessRequest(_State):
 
     def __init__(self, dump, dev_info: _DevInfo, timestamp: int):
@@ -197,7 +235,7 @@ class _AccessRequest(_State):
             return False
 
         print("Access granted")
-        return _DumpEeprom(self.dump, self.timestamp)
+        return _transfer(self.dump, self.timestamp)
 
     def send_request(self, AES_resp):
         msg = mm.Msg(20)
@@ -210,6 +248,8 @@ class _AccessRequest(_State):
 
 
 class _DumpEeprom(_State):
+    """Reads the range 16 bytes per request, as many requests in flight as
+    the radio takes"""
 
     def __init__(self, dump: EepromDump, timestamp: int):
         super().__init__(dump)
@@ -228,55 +268,90 @@ class _DumpEeprom(_State):
 
         self.offset = off
         self.size = size
-        self.expect_resp = False
+        self.pipe = pp.Pipeline(self.ser)
+        self.todo = list(range(off, off + size, 16))
+        self.blocks = {}
         self.data = bytearray()
 
     def loop(self) -> bool | _State:
 
-        if not self.expect_resp:
-            per = len(self.data) * 100 // (len(self.data) + self.size)
-            print(f"Fetching data.. {per}%")
-            self.send_request()
-            self.expect_resp = True
-            return
-
-        msg = self.recv_msg()
-        if not msg:
-            return
-
-        if 0x051C != msg.get_msg_type():
-            return
+        if self.pipe.failed:
+            print("No answer, giving up")
+            return False
 
-        off = msg.get_hw_LE(4)
-        size = msg.buf[6]
+        while self.todo:
+            msg = self.make_request(self.todo[0])
+            if not self.pipe.ready(msg):
+                break
+            self.pipe.send(msg, self.todo.pop(0))
 
-        if off != self.offset or size != 16:
-            print("Invalid response. Retry..")
-            self.expect_resp = False
-            return
+        while True:
+            reply = self.pipe.poll()
+            if not reply:
+                break
 
-        self.data.extend(msg.buf[8:24])
-        self.offset += 16
-        self.size -= 16
-        self.expect_resp = False
+            off, msg = reply
+            if (
+                0x051C != msg.get_msg_type()
+                or msg.get_hw_LE(4) != off
+                or msg.buf[6] != 16
+            ):
+                print("Invalid response. Retry..")
+                self.todo.append(off)
+                continue
+
+            self.blocks[off] = msg.buf[8:24]
+            per = len(self.blocks) * 1600 // self.size
+            print(f"Fetching data.. {per}%")
 
-        if self.size > 0:
+        if len(self.blocks) * 16 < self.size:
             return
 
         # Finished ------
 
         print("Done")
 
+        for off in sorted(self.blocks):
+            self.data.extend(self.blocks[off])
+
         file = self.dump._dump_file
         open(file, "wb").write(self.data)
         print("Data successfully saved to " + file)
         return False
 
-    def send_request(self):
+    def make_request(self, off: int) -> mm.Msg:
 
         msg = mm.Msg(12)
         msg.set_msg_type(0x051B)
-        msg.set_hw_LE(4, self.offset)
+        msg.set_hw_LE(4, off)
         msg.set_hw_LE(6, 16)
         msg.set_word_LE(8, self.timestamp)
-        self.send_msg(msg)
+        return msg
+
+
+class _BulkDump(_DumpEeprom):
+    """Reads the sectors that hold the range with bulk reads
+    (ENABLE_UART_BULK), LZ encoded if packed (ENABLE_UART_DELTA), and cuts
+    the dump out of them"""
+
+    def __init__(self, dump: EepromDump, timestamp: int, packed: bool = False):
+        super().__init__(dump, timestamp)
+        self.read = bk.SectorRead(
+            self.ser, timestamp, bk.sectors_of(self.offset, self.size), packed
+        )
+
+    def loop(self) -> bool | _State:
+
+        if self.read.loop():
+            return
+
+        if not self.read.ok:
+            return False
+
+        print("Done")
+
+        self.data = bk.to_eeprom(self.read.sectors, self.offset, self.size)
+        file = self.dump._dump_file
+        open(file, "wb").write(self.data)
+        print("Data successfully saved to " + file)
+        return False
@@ -0,0 +1,115 @@
+"""
+LZ77 with run fills, as App/driver/lz.h: a control byte per token
+
+  0nnnnnnn                    literal, n + 1 bytes follow
+  10nnnnnn nnnnnnnn vvvvvvvv  fill, n + 1 bytes of v
+  11nnnnnn dddddddd           match, n + 3 bytes from d + 1 back
+"""
+
+WINDOW = 256
+MAX_LITERAL = 128
+MAX_FILL = 0x4000
+MIN_MATCH = 3
+MAX_MATCH = MIN_MATCH + 0x3F
+
+# Runs shorter than this are not worth a fill
+_MIN_FILL = 4
+
+
+def _run(data: bytes, i: int) -> int:
+    end = min(len(data), i + MAX_FILL)
+    n = i + 1
+    while n < end and data[n] == data[i]:
+        n += 1
+    return n - i
+
+
+def _match(data: bytes, i: int) -> tuple[int, int]:
+    """(length, distance) of the longest match at i, (0, 0) if none"""
+    best = (0, 0)
+    end = min(len(data), i + MAX_MATCH)
+    for dist in range(1, min(i, WINDOW) + 1):
+        n = 0
+        while i + n < end and data[i + n] == data[i + n - dist]:
+            n += 1
+        if n > best[0]:
+            best = (n, dist)
+            if i + n == end:
+                break
+    return best if best[0] >= MIN_MATCH else (0, 0)
+
+
+def encode(data: bytes) -> list[bytes]:
+    """The tokens, each on its own so they can be cut into frames"""
+    tokens = []
+    literal = bytearray()
+
+    def flush():
+        if literal:
+            tokens.append(bytes([len(literal) - 1]) + literal)
+            literal.clear()
+
+    i = 0
+    while i < len(data):
+        run = _run(data, i)
+        if run >= _MIN_FILL:
+            flush()
+            n = run - 1
+            tokens.append(bytes([0x80 | (n >> 8), n & 0xFF, data[i]]))
+            i += run
+            continue
+
+        length, dist = _match(data, i)
+        if length:
+            flush()
+            tokens.append(bytes([0xC0 | (length - MIN_MATCH), dist - 1]))
+            i += length
+            continue
+
+        literal.append(data[i])
+        if MAX_LITERAL == len(literal):
+            flush()
+        i += 1
+
+    flush()
+    return tokens
+
+
+def decoded_size(token: bytes) -> int:
+    c = token[0]
+    if c < 0x80:
+        return c + 1
+    if c < 0xC0:
+        return (((c & 0x3F) << 8) | token[1]) + 1
+    return (c & 0x3F) + MIN_MATCH
+
+
+def decode(packed: bytes) -> bytearray | None:
+    """None if the tokens are broken"""
+    out = bytearray()
+    i = 0
+    while i < len(packed):
+        c = packed[i]
+        if c < 0x80:
+            n = c + 1
+            if i + 1 + n > len(packed):
+                return None
+            out += packed[i + 1 : i + 1 + n]
+            i += 1 + n
+        elif c < 0xC0:
+            if i + 3 > len(packed):
+                return None
+            n = (((c & 0x3F) << 8) | packed[i + 1]) + 1
+            out += bytes([packed[i + 2]]) * n
+            i += 3
+        else:
+            if i + 2 > len(packed):
+                return None
+            n = (c & 0x3F) + MIN_MATCH
+            dist = packed[i + 1] + 1
+            if dist > len(out):
+                return None
+            for _ in range(n):
+                out.append(out[-dist])
+            i += 2
+    return out
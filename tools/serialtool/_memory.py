@@ -0,0 +1,232 @@
+from serial import Serial
+from time import monotonic
+import re
+import msg as mm
+
+MSG_MEMORY = 0x0533
+MSG_MEMORY_RESP = 0x0534
+
+# MEMSTATS_t in App/memstats.h
+_MEMSTATS_SIZE = 20
+_RETRY_TIMEOUT = 1.0
+
+
+class MemoryDump:
+
+    def __init__(self, ser: Serial):
+        self._ser = ser
+        self._state = _Init(self)
+
+    def loop(self) -> bool:
+        next = self._state.loop()
+        if isinstance(next, bool):
+            return next
+        elif next:
+            self._state = next
+
+        return True
+
+
+class _State:
+    def __init__(self, dump: MemoryDump):
+        self.dump = dump
+        self.ser = dump._ser
+        self.rx_buf = bytearray(256)
+        self.msg_buf = bytearray()
+
+    def loop(self) -> bool | object:
+        raise NotImplementedError()
+
+    def send_msg(self, msg: mm.Msg):
+        pack = mm.make_packet(msg.buf)
+        ser = self.dump._ser
+        ser.write(pack)
+        ser.flush()
+
+    def recv_msg(self) -> mm.Msg:
+        self._rx()
+        return mm.fetch(self.msg_buf)
+
+    def _rx(self) -> int:
+
+        len1 = 0
+        buf = self.rx_buf
+        while True:
+            len2 = self.ser.readinto(buf)
+            if len2 > 0:
+                self.msg_buf.extend(memoryview(buf)[:len2])
+                len1 += len2
+            if len2 < len(buf):
+                break
+
+        return len1
+
+
+class _Init(_State):
+    def __init__(self, dump):
+        super().__init__(dump)
+
+    def loop(self) -> _State:
+        if self._rx():
+            print(".", end="")
+            return self
+
+        print()
+        return _FetchMemory(self.dump)
+
+    def _rx(self) -> int:
+        return self.ser.readinto(self.rx_buf)
+
+
+class _FetchMemory(_State):
+
+    def __init__(self, dump):
+        super().__init__(dump)
+        self.expect_resp = False
+        self.sent_at = 0.0
+
+    def loop(self) -> bool | _State:
+
+        if not self.expect_resp:
+            print("Fetching memory usage..")
+            self.send_request()
+            self.expect_resp = True
+            self.sent_at = monotonic()
+            return
+
+        msg = self.recv_msg()
+        if not msg:
+            if monotonic() - self.sent_at > _RETRY_TIMEOUT:
+                print("No response. Retry..")
+                self.expect_resp = False
+            return
+
+        if MSG_MEMORY_RESP != msg.get_msg_type():
+            return
+
+        if msg.get_data_len() < _MEMSTATS_SIZE:
+            print("Invalid response. Retry..")
+            self.expect_resp = False
+            return
+
+        print_memstats(msg)
+        return False
+
+    def send_request(self):
+        msg = mm.Msg(4)
+        msg.set_msg_type(MSG_MEMORY)
+        self.send_msg(msg)
+
+
+def print_memstats(msg: mm.Msg):
+
+    ram = msg.get_word_LE(4)
+    data = msg.get_word_LE(8)
+    bss = msg.get_word_LE(12)
+    stack = msg.get_word_LE(16)
+    peak = msg.get_word_LE(20)
+
+    print(f"RAM:         {ram:>6} bytes")
+    print(f"  .data      {data:>6}")
+    print(f"  .bss       {bss:>6}")
+    print(f"  stack      {stack:>6}  (heap reserve included)")
+    print(f"Stack peak:  {peak:>6}  ({peak * 100 // max(stack, 1)}%)")
+    print(f"Stack left:  {stack - peak:>6}")
+
+
+# ---------------------------------------------------------------------------
+#  RAM budget from the linker map (-Wl,-Map, written next to the .elf)
+
+_RAM_SECTIONS = (".data", ".bss")
+
+_OUT_SECTION = re.compile(r"^(\.\S+)(?:\s+0x([0-9a-f]+)\s+0x([0-9a-f]+))?")
+_IN_SECTION = re.compile(r"^ (\S+)(?:\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(.*))?$")
+_IN_SECTION_CONT = re.compile(r"^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(.*)$")
+
+
+def _module(obj: str) -> str:
+    obj = obj.strip()
+
+    # CMakeFiles/firmware.dir/App/settings.c.obj -> App/settings.c
+    m = re.search(r"CMakeFiles/[^/]+\.dir/(.*?)(\.obj|\.o)$", obj)
+    if m:
+        return m.group(1)
+
+    # /usr/.../libc_nano.a(lib_a-memset.o) -> libc_nano.a
+    m = re.search(r"([^/]+\.a)\(", obj)
+    if m:
+        return m.group(1)
+
+    return obj.rsplit("/", 1)[-1]
+
+
+def ram_by_module(map_file: str) -> dict[str, dict[str, int]]:
+
+    budget: dict[str, dict[str, int]] = {}
+    section = None
+    pending = None
+
+    def add(name: str, size: int, obj: str):
+        kind = ".bss" if name == "COMMON" or name.startswith(".bss") else section
+        mod = "(padding)" if name == "*fill*" else _module(obj)
+        entry = budget.setdefault(mod, {s: 0 for s in _RAM_SECTIONS})
+        entry[kind] += size
+
+    with open(map_file, "r", errors="replace") as fd:
+        for line in fd:
+            line = line.rstrip("\n")
+
+            m = _OUT_SECTION.match(line)
+            if m:
+                name = m.group(1)
+                section = name if name in _RAM_SECTIONS else None
+                pending = None
+                continue
+
+            if not section or not line.strip():
+                continue
+
+            if pending:
+                m = _IN_SECTION_CONT.match(line)
+                if m:
+                    add(pending, int(m.group(2), 16), m.group(3))
+                pending = None
+                continue
+
+            m = _IN_SECTION.match(line)
+            if not m:
+                continue
+
+            name = m.group(1)
+            if name.startswith("*(") or name.startswith("0x"):
+                continue
+
+            if m.group(2) is None:
+                # long section names push address and size to the next line
+                pending = name
+                continue
+
+            size = int(m.group(3), 16)
+            if size:
+                add(name, size, m.group(4) or "")
+
+    return budget
+
+
+def print_budget(map_file: str, top: int = 0):
+
+    budget = ram_by_module(map_file)
+    rows = sorted(budget.items(), key=lambda kv: -sum(kv[1].values()))
+    total = {s: sum(v[s] for v in budget.values()) for s in _RAM_SECTIONS}
+
+    print(f"{'Module':<40}{'.data':>8}{'.bss':>8}{'Total':>8}")
+    for i, (mod, sizes) in enumerate(rows):
+        if top and i >= top:
+            break
+        print(
+            f"{mod:<40}{sizes['.data']:>8}{sizes['.bss']:>8}{sum(sizes.values()):>8}"
+        )
+
+    print(
+        f"{'Total':<40}{total['.data']:>8}{total['.bss']:>8}{sum(total.values()):>8}"
+    )
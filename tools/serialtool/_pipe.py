@@ -0,0 +1,122 @@
+from serial import Serial
+from time import monotonic
+import msg as mm
+
+MSG_SEQ = 0x053D
+MSG_SEQ_RESP = 0x053E
+
+# Bytes of the frames in flight. The radio buffers them in a 256 byte
+# receive ring, which must not wrap over one not yet read.
+WINDOW_SIZE = 240
+
+_TIMEOUT = 1.0
+_PROBE_TIMEOUT = 0.5
+_RETRIES = 3
+
+
+class Pipeline:
+    """Keeps as many commands in flight as fit the receive ring of the
+    radio, each wrapped with a sequence number (ENABLE_UART_PIPELINE), and
+    matches the replies by it, whatever their order. A command left without
+    a reply is sent again.
+
+    The first command goes alone. If it gets no reply, the radio does not
+    know the wrapper: it is sent again bare, and so are the rest, one at a
+    time."""
+
+    def __init__(self, ser: Serial):
+        self._ser = ser
+        self._rx_buf = bytearray(256)
+        self._msg_buf = bytearray()
+        self._seq = 0
+        self._flight = {}  # sequence: [tag, message, packet, sent at, tries]
+        self._wrap = None  # None until the first reply tells
+        self.failed = False
+
+    def idle(self) -> bool:
+        return not self._flight
+
+    # True if the message can go now
+    def ready(self, msg: mm.Msg) -> bool:
+        if not self._wrap:
+            return not self._flight
+
+        used = sum(len(f[2]) for f in self._flight.values())
+        return used + len(self._pack(msg, 0)) <= WINDOW_SIZE
+
+    def send(self, msg: mm.Msg, tag):
+        seq = self._seq
+        self._seq = (seq + 1) & 0xFFFF
+        self._flight[seq] = [tag, msg, None, 0.0, 0]
+        self._transmit(seq)
+
+    # (tag, reply) of the next reply in, None if there is none yet
+    def poll(self) -> tuple | None:
+        self._check_timeouts()
+
+        while True:
+            len1 = self._ser.readinto(self._rx_buf)
+            if len1 > 0:
+                self._msg_buf.extend(memoryview(self._rx_buf)[:len1])
+            if len1 < len(self._rx_buf):
+                break
+
+        msg = mm.fetch(self._msg_buf)
+        if not msg:
+            return None
+
+        wrapped = MSG_SEQ_RESP == msg.get_msg_type()
+        if self._wrap is None and wrapped:
+            self._wrap = True
+
+        if not self._wrap:
+            # Only the one command in flight to answer
+            if self._wrap is None or wrapped or not self._flight:
+                return None
+            seq = next(iter(self._flight))
+            return self._flight.pop(seq)[0], msg
+
+        if not wrapped or msg.get_data_len() < 8:
+            return None
+
+        seq = msg.get_hw_LE(4)
+        if seq not in self._flight:
+            # Answers a command sent again meanwhile
+            return None
+
+        return self._flight.pop(seq)[0], mm.Msg(msg.buf[8:])
+
+    def _check_timeouts(self):
+        now = monotonic()
+        timeout = _TIMEOUT if self._wrap is not None else _PROBE_TIMEOUT
+        for seq, f in list(self._flight.items()):
+            if now - f[3] < timeout:
+                continue
+
+            if self._wrap is None:
+                print("Radio takes one command at a time")
+                self._wrap = False
+                f[4] = 0
+            elif f[4] == _RETRIES:
+                self.failed = True
+                return
+
+            self._transmit(seq)
+
+    def _transmit(self, seq: int):
+        f = self._flight[seq]
+        f[2] = self._pack(f[1], seq)
+        f[3] = monotonic()
+        f[4] += 1
+        self._ser.write(f[2])
+        self._ser.flush()
+
+    def _pack(self, msg: mm.Msg, seq: int) -> bytes:
+        if self._wrap is False:
+            return mm.make_packet(msg.buf)
+
+        wrap = mm.Msg(8 + len(msg.buf))
+        wrap.set_msg_type(MSG_SEQ)
+        wrap.set_hw_LE(4, seq)
+        wrap.buf[8:] = msg.buf
+        return mm.make_packet(wrap.buf)
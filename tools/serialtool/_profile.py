@@ -0,0 +1,252 @@
+from serial import Serial
+from time import monotonic
+import msg as mm
+
+MSG_PROFILE = 0x052B
+MSG_PROFILE_RESP = 0x052C
+MSG_JITTER = 0x0531
+MSG_JITTER_RESP = 0x0532
+
+# Same order as PROFILE_Probe_t in App/profile.h
+PROBE_NAMES = (
+    "APP_Update",
+    "APP_TimeSlice10ms",
+    "APP_TimeSlice500ms",
+    "GUI_DisplayScreen",
+    "RADIO_SetupRegisters",
+    "CheckRadioInterrupts",
+    "spectrum Tick",
+)
+
+# SysTick runs from HCLK
+CPU_CLOCK_MHZ = 48
+
+_PROBE_SIZE = 20
+
+# PROFILE_Jitter_t
+_HISTOGRAM_BINS = 16
+_HISTOGRAM_SHIFT = 12
+_JITTER_SIZE = 16 + 4 * _HISTOGRAM_BINS + 8
+_RETRY_TIMEOUT = 1.0
+
+
+class ProfileDump:
+
+    def __init__(self, ser: Serial, reset: bool):
+        self._ser = ser
+        self._reset = reset
+        self._state = _Init(self)
+
+    def loop(self) -> bool:
+        next = self._state.loop()
+        if isinstance(next, bool):
+            return next
+        elif next:
+            self._state = next
+
+        return True
+
+
+class _State:
+    def __init__(self, dump: ProfileDump):
+        self.dump = dump
+        self.ser = dump._ser
+        self.rx_buf = bytearray(256)
+        self.msg_buf = bytearray()
+
+    def loop(self) -> bool | object:
+        raise NotImplementedError()
+
+    def send_msg(self, msg: mm.Msg):
+        pack = mm.make_packet(msg.buf)
+        ser = self.dump._ser
+        ser.write(pack)
+        ser.flush()
+
+    def recv_msg(self) -> mm.Msg:
+        self._rx()
+        return mm.fetch(self.msg_buf)
+
+    def _rx(self) -> int:
+
+        len1 = 0
+        buf = self.rx_buf
+        while True:
+            len2 = self.ser.readinto(buf)
+            if len2 > 0:
+                self.msg_buf.extend(memoryview(buf)[:len2])
+                len1 += len2
+            if len2 < len(buf):
+                break
+
+        return len1
+
+
+class _Init(_State):
+    def __init__(self, dump):
+        super().__init__(dump)
+
+    def loop(self) -> _State:
+        if self._rx():
+            print(".", end="")
+            return self
+
+        print()
+        return _FetchProfile(self.dump)
+
+    def _rx(self) -> int:
+        return self.ser.readinto(self.rx_buf)
+
+
+class _Fetch(_State):
+
+    MSG_TYPE = 0
+    RESP_TYPE = 0
+    WHAT = ""
+
+    def __init__(self, dump):
+        super().__init__(dump)
+        self.expect_resp = False
+        self.sent_at = 0.0
+
+    def loop(self) -> bool | _State:
+
+        if not self.expect_resp:
+            print(f"Fetching {self.WHAT}..")
+            self.send_request()
+            self.expect_resp = True
+            self.sent_at = monotonic()
+            return
+
+        msg = self.recv_msg()
+        if not msg:
+            if monotonic() - self.sent_at > _RETRY_TIMEOUT:
+                print("No response. Retry..")
+                self.expect_resp = False
+            return
+
+        if self.RESP_TYPE != msg.get_msg_type():
+            return
+
+        if not self.valid(msg):
+            print("Invalid response. Retry..")
+            self.expect_resp = False
+            return
+
+        return self.done(msg)
+
+    def valid(self, msg: mm.Msg) -> bool:
+        raise NotImplementedError()
+
+    def done(self, msg: mm.Msg) -> bool | _State:
+        raise NotImplementedError()
+
+    def send_request(self):
+
+        msg = mm.Msg(8)
+        msg.set_msg_type(self.MSG_TYPE)
+        msg.buf[4] = 1 if self.dump._reset else 0
+        self.send_msg(msg)
+
+
+class _FetchProfile(_Fetch):
+
+    MSG_TYPE = MSG_PROFILE
+    RESP_TYPE = MSG_PROFILE_RESP
+    WHAT = "profile"
+
+    def valid(self, msg: mm.Msg) -> bool:
+        return msg.get_data_len() >= _PROBE_SIZE
+
+    def done(self, msg: mm.Msg) -> _State:
+        print_table(msg, msg.get_data_len() // _PROBE_SIZE)
+        return _FetchJitter(self.dump)
+
+
+class _FetchJitter(_Fetch):
+
+    MSG_TYPE = MSG_JITTER
+    RESP_TYPE = MSG_JITTER_RESP
+    WHAT = "timeslice jitter"
+
+    def valid(self, msg: mm.Msg) -> bool:
+        return msg.get_data_len() >= _JITTER_SIZE
+
+    def done(self, msg: mm.Msg) -> bool:
+        print_jitter(msg)
+
+        if self.dump._reset:
+            print("Profiler reset")
+
+        return False
+
+
+def _us(cycles: int) -> str:
+    return f"{cycles / CPU_CLOCK_MHZ:10.1f}"
+
+
+def print_table(msg: mm.Msg, count: int):
+
+    print(
+        f"{'Probe':<22}{'Count':>10}{'Min us':>10}{'Avg us':>10}{'Max us':>10}{'Total ms':>12}"
+    )
+
+    for i in range(count):
+        off = 4 + i * _PROBE_SIZE
+        min_ = msg.get_word_LE(off)
+        max_ = msg.get_word_LE(off + 4)
+        calls = msg.get_word_LE(off + 8)
+        total = msg.get_word_LE(off + 12) | (msg.get_word_LE(off + 16) << 32)
+
+        name = PROBE_NAMES[i] if i < len(PROBE_NAMES) else f"probe {i}"
+        if 0 == calls:
+            print(f"{name:<22}{0:>10}{'-':>10}{'-':>10}{'-':>10}{'-':>12}")
+            continue
+
+        print(
+            f"{name:<22}{calls:>10}{_us(min_)}{_us(total // calls)}{_us(max_)}"
+            f"{total / CPU_CLOCK_MHZ / 1000:12.1f}"
+        )
+
+
+def _ms(cycles: int) -> str:
+    return f"{cycles / CPU_CLOCK_MHZ / 1000:.2f} ms"
+
+
+def print_jitter(msg: mm.Msg):
+
+    missed = msg.get_word_LE(4)
+    slices = msg.get_word_LE(8)
+    min_ = msg.get_word_LE(12)
+    max_ = msg.get_word_LE(16)
+    bins = [msg.get_word_LE(20 + 4 * i) for i in range(_HISTOGRAM_BINS)]
+    worst_cycles = msg.get_word_LE(20 + 4 * _HISTOGRAM_BINS)
+    worst_probe = msg.buf[24 + 4 * _HISTOGRAM_BINS]
+
+    print(f"Timeslices: {slices}, missed SysTicks: {missed}")
+    if 0 == slices:
+        return
+
+    print(f"Period: min {_ms(min_)}, max {_ms(max_)}")
+    if worst_cycles:
+        name = (
+            PROBE_NAMES[worst_probe]
+            if worst_probe < len(PROBE_NAMES)
+            else f"probe {worst_probe}"
+        )
+        print(f"Worst slice spent {_ms(worst_cycles)} in {name}")
+
+    top = max(bins)
+    for i, n in enumerate(bins):
+        if 0 == n:
+            continue
+
+        lo = 0 if 0 == i else 1 << (i + _HISTOGRAM_SHIFT)
+        hi = 1 << (i + _HISTOGRAM_SHIFT + 1)
+        if i == _HISTOGRAM_BINS - 1:
+            span = f">= {_ms(lo)}"
+        else:
+            span = f"{lo / CPU_CLOCK_MHZ / 1000:7.2f} - {_ms(hi)}"
+
+        bar = "#" * max(1, n * 40 // top)
+        print(f"  {span:>22} {n:>8} {bar}")
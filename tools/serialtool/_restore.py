@@ -16,6 +16,9 @@
 from serial import Serial
 from datetime import datetime
 import msg as mm
+import _baud as bd
+import _bulk as bk
+import _pipe as pp
 
 DUMP_CONFIG = 1
 DUMP_CALIB = 2
@@ -24,10 +27,21 @@ DUMP_ALL = 0xFF
 
 class EepromDump:
 
-    def __init__(self, ser: Serial, dump_what: int, dump_file: str):
+    def __init__(
+        self,
+        ser: Serial,
+        dump_what: int,
+        dump_file: str,
+        baud: int = bd.DEFAULT_BAUD,
+        bulk: bool = False,
+        delta: bool = False,
+    ):
         self._ser = ser
         self._dump_what = dump_what
         self._dump_file = dump_file
+        self._baud = baud
+        self._bulk = bulk
+        self._delta = delta
         self._state = _Init(self)
         # self._dev_info = None
 
@@ -153,8 +167,10 @@ class _DeviceInfo(_State):
         )
 
         # return _AccessRequest(self.dump, dev_info, self.timestamp)
+        if bd.DEFAULT_BAUD != self.dump._baud:
+            return _SwitchBaud(self.dump, self.timestamp)
         try:
-            return _DumpEeprom(self.dump, self.timestamp)
+            return _transfer(self.dump, self.timestamp)
         except:
             #
             return False
@@ -170,6 +186,32 @@ class _DeviceInfo(_State):
         self.send_msg(msg)
 
 
+def _transfer(dump: EepromDump, timestamp: int) -> _State:
+    if dump._delta:
+        return _DeltaRestore(dump, timestamp)
+    if dump._bulk:
+        return _BulkRestore(dump, timestamp)
+    return _DumpEeprom(dump, timestamp)
+
+
+class _SwitchBaud(_State):
+
+    def __init__(self, dump: EepromDump, timestamp: int):
+        super().__init__(dump)
+        self.timestamp = timestamp
+        self.switch = bd.BaudSwitch(self.ser, dump._baud, timestamp)
+
+    def loop(self) -> _State:
+        if self.switch.loop():
+            return
+
+        try:
+            return _transfer(self.dump, self.timestamp)
+        except:
+            #
+            return False
+
+
 class _AccessRequest(_State):
 
     def __init__(self, dump, dev_info: _DevInfo, timestamp: int):
@@ -203,7 +245,7 @@ class _AccessRequest(_State):
         print("Access granted")
 
         try:
-            return _DumpEeprom(self.dump, self.timestamp)
+            return _transfer(self.dump, self.timestamp)
         except:
             #
             return False
@@ -219,6 +261,8 @@ class _AccessRequest(_State):
 
 
 class _DumpEeprom(_State):
+    """Writes the range 16 bytes per request, as many requests in flight as
+    the radio takes"""
 
     def __init__(self, dump: EepromDump, timestamp: int):
         super().__init__(dump)
@@ -256,68 +300,50 @@ class _DumpEeprom(_State):
 
         data.extend(data1)
 
-        self.expect_resp = False
-        self.AES_key = None
+        # The AES key goes last, after everything else is in
+        self.AES_off = None
+        if off <= 0x0F30 < off + size:
+            self.AES_off = 0x0F30
 
-    def loop(self) -> bool | _State:
+        self.pipe = pp.Pipeline(self.ser)
+        self.todo = [o for o in range(off, off + size, 16) if o != self.AES_off]
+        self.done = 0
 
-        if not self.expect_resp:
+    def loop(self) -> bool | _State:
 
-            # AES key
-            if 0 == self.size and self.AES_key is not None:
-                print("Writting data.. 100%")
-                self.send_request(0x0F30, self.AES_key)
-                self.expect_resp = True
-                return
-
-            off1 = len(self.data) - self.size
-
-            # Check AES key
-            if 0x0F30 == self.offset:
-                self.AES_key = self.data[off1 : off1 + 16]
-                self.offset += 16
-                self.size -= 16
-                return
-            else:
-                per = off1 * 100 // len(self.data)
-                print(f"Writting data.. {per}%")
-                self.send_request(self.offset, self.data[off1 : off1 + 16])
-                self.expect_resp = True
-                return
+        if self.pipe.failed:
+            print("No answer, giving up")
+            return False
 
-        # Receive resposne ----------
+        if not self.todo and self.pipe.idle() and self.AES_off is not None:
+            print("Writting data.. 100%")
+            self.todo.append(self.AES_off)
+            self.AES_off = None
 
-        msg = self.recv_msg()
-        if not msg:
-            return
-
-        if 0x051E != msg.get_msg_type():
-            return
+        while self.todo:
+            msg = self.make_request(self.todo[0])
+            if not self.pipe.ready(msg):
+                break
+            self.pipe.send(msg, self.todo.pop(0))
 
-        off = msg.get_hw_LE(4)
+        while True:
+            reply = self.pipe.poll()
+            if not reply:
+                break
 
-        # AES key
-        if 0 == self.size and (self.AES_key is not None):
-            if off != 0x0F30:
+            off, msg = reply
+            if 0x051E != msg.get_msg_type() or msg.get_hw_LE(4) != off:
                 print("Invalid response. Retry..")
                 # print(f"{off:04x}")
-                self.expect_resp = False
-                return
-            else:
-                # Mark as done
-                self.AES_key = None
-        else:
-            if off != self.offset:
-                print("Invalid response. Retry..")
-                self.expect_resp = False
-                return
-            else:
-                self.offset += 16
-                self.size -= 16
+                self.todo.append(off)
+                continue
 
-        self.expect_resp = False
+            self.done += 16
+            if self.done < self.size:
+                per = self.done * 100 // self.size
+                print(f"Writting data.. {per}%")
 
-        if self.size > 0 or self.AES_key is not None:
+        if self.done < self.size:
             return
 
         # Finished ------
@@ -325,16 +351,108 @@ class _DumpEeprom(_State):
         print("Done")
         return _Reboot(self.dump)
 
-    def send_request(self, off: int, data: bytes):
+    def make_request(self, off: int) -> mm.Msg:
 
+        off1 = off - self.offset
         msg = mm.Msg(28)
         msg.set_msg_type(0x051D)
         msg.set_hw_LE(4, off)
         msg.set_hw_LE(6, 16)  # size
         msg.buf[7] = 1  # allow password
         msg.set_word_LE(8, self.timestamp)
-        msg.buf[12:28] = data[:16]
-        self.send_msg(msg)
+        msg.buf[12:28] = self.data[off1 : off1 + 16]
+        return msg
+
+
+class _BulkRestore(_DumpEeprom):
+    """Restores with bulk sector transfers (ENABLE_UART_BULK): the sectors
+    that hold the range are read, the dump goes into them and those that
+    change are written back whole, the one with the AES key last"""
+
+    def __init__(self, dump: EepromDump, timestamp: int):
+        super().__init__(dump, timestamp)
+        self.transfer = bk.SectorRead(
+            self.ser, timestamp, bk.sectors_of(self.offset, self.size)
+        )
+        self.writing = False
+
+    def loop(self) -> bool | _State:
+
+        if self.transfer.loop():
+            return
+
+        if not self.transfer.ok:
+            return False
+
+        if self.writing:
+            print("Done")
+            return _Reboot(self.dump)
+
+        old = self.transfer.sectors
+        new = {addr: bytearray(sec) for addr, sec in old.items()}
+        bk.from_eeprom(new, self.offset, self.data)
+
+        changed = [
+            (addr, new[addr])
+            for addr in sorted(new, key=lambda a: (0x00A000 == a, a))
+            if new[addr] != old[addr]
+        ]
+        print(f"{len(changed)} of {len(new)} sectors differ")
+
+        self.transfer = bk.SectorWrite(self.ser, self.timestamp, changed)
+        self.writing = True
+
+
+class _DeltaRestore(_DumpEeprom):
+    """Restores with sector hashes and LZ encoded transfers
+    (ENABLE_UART_DELTA): a sector whose hash matches the dump on a blank
+    sector is left alone, the others are read, the dump goes into them and
+    those that change are written back, the one with the AES key last"""
+
+    def __init__(self, dump: EepromDump, timestamp: int):
+        super().__init__(dump, timestamp)
+        addrs = bk.sectors_of(self.offset, self.size)
+        self.blank = {addr: bytearray(b"\xff" * bk.SECTOR_SIZE) for addr in addrs}
+        bk.from_eeprom(self.blank, self.offset, self.data)
+        self.transfer = bk.SectorHashes(self.ser, timestamp, addrs)
+        self.step = self._compare
+
+    def loop(self) -> bool | _State:
+
+        if self.transfer.loop():
+            return
+
+        if not self.transfer.ok:
+            return False
+
+        return self.step()
+
+    def _compare(self):
+        hashes = self.transfer.hashes
+        differ = [a for a, sec in self.blank.items() if hashes[a] != bk.fnv1a(sec)]
+        print(f"{len(self.blank) - len(differ)} of {len(self.blank)} sectors match")
+
+        self.transfer = bk.SectorRead(self.ser, self.timestamp, differ, packed=True)
+        self.step = self._patch
+
+    def _patch(self):
+        old = self.transfer.sectors
+        new = {addr: bytearray(sec) for addr, sec in old.items()}
+        bk.from_eeprom(new, self.offset, self.data)
+
+        changed = [
+            (addr, new[addr])
+            for addr in sorted(new, key=lambda a: (0x00A000 == a, a))
+            if new[addr] != old[addr]
+        ]
+        print(f"{len(changed)} of {len(self.blank)} sectors differ")
+
+        self.transfer = bk.SectorWrite(self.ser, self.timestamp, changed, packed=True)
+        self.step = self._done
+
+    def _done(self) -> _State:
+        print("Done")
+        return _Reboot(self.dump)
 
 
 class _Reboot(_State):
@@ -0,0 +1,131 @@
+from serial import Serial
+from time import monotonic
+import msg as mm
+
+MSG_UART_TX = 0x0535
+MSG_UART_TX_RESP = 0x0536
+
+# UART_TxStats_t in App/driver/uart.h
+_TX_STATS_SIZE = 16
+_RETRY_TIMEOUT = 1.0
+
+
+class UartTxDump:
+
+    def __init__(self, ser: Serial):
+        self._ser = ser
+        self._state = _Init(self)
+
+    def loop(self) -> bool:
+        next = self._state.loop()
+        if isinstance(next, bool):
+            return next
+        elif next:
+            self._state = next
+
+        return True
+
+
+class _State:
+    def __init__(self, dump: UartTxDump):
+        self.dump = dump
+        self.ser = dump._ser
+        self.rx_buf = bytearray(256)
+        self.msg_buf = bytearray()
+
+    def loop(self) -> bool | object:
+        raise NotImplementedError()
+
+    def send_msg(self, msg: mm.Msg):
+        pack = mm.make_packet(msg.buf)
+        ser = self.dump._ser
+        ser.write(pack)
+        ser.flush()
+
+    def recv_msg(self) -> mm.Msg:
+        self._rx()
+        return mm.fetch(self.msg_buf)
+
+    def _rx(self) -> int:
+
+        len1 = 0
+        buf = self.rx_buf
+        while True:
+            len2 = self.ser.readinto(buf)
+            if len2 > 0:
+                self.msg_buf.extend(memoryview(buf)[:len2])
+                len1 += len2
+            if len2 < len(buf):
+                break
+
+        return len1
+
+
+class _Init(_State):
+    def __init__(self, dump):
+        super().__init__(dump)
+
+    def loop(self) -> _State:
+        if self._rx():
+            print(".", end="")
+            return self
+
+        print()
+        return _FetchStats(self.dump)
+
+    def _rx(self) -> int:
+        return self.ser.readinto(self.rx_buf)
+
+
+class _FetchStats(_State):
+
+    def __init__(self, dump):
+        super().__init__(dump)
+        self.expect_resp = False
+        self.sent_at = 0.0
+
+    def loop(self) -> bool | _State:
+
+        if not self.expect_resp:
+            print("Fetching UART transmit counters..")
+            self.send_request()
+            self.expect_resp = True
+            self.sent_at = monotonic()
+            return
+
+        msg = self.recv_msg()
+        if not msg:
+            if monotonic() - self.sent_at > _RETRY_TIMEOUT:
+                print("No response. Retry..")
+                self.expect_resp = False
+            return
+
+        if MSG_UART_TX_RESP != msg.get_msg_type():
+            return
+
+        if msg.get_data_len() < _TX_STATS_SIZE:
+            print("Invalid response. Retry..")
+            self.expect_resp = False
+            return
+
+        print_tx_stats(msg)
+        return False
+
+    def send_request(self):
+        msg = mm.Msg(4)
+        msg.set_msg_type(MSG_UART_TX)
+        self.send_msg(msg)
+
+
+def print_tx_stats(msg: mm.Msg):
+
+    queued = msg.get_word_LE(4)
+    dropped = msg.get_word_LE(8)
+    stalls = msg.get_word_LE(12)
+    peak = msg.get_hw_LE(16)
+    size = msg.get_hw_LE(18)
+
+    print(f"Queued:      {queued:>10} bytes")
+    print(f"Dropped:     {dropped:>10} log lines / screenshot frames")
+    print(f"Stalls:      {stalls:>10} replies that waited for room")
+    print(f"Peak:        {peak:>10} of {size} bytes ({peak * 100 // max(size, 1)}%)")
@@ -25,6 +25,11 @@ import os
 import _prog as pp
 import _dump as dd
 import _restore as rr
+import _profile as pf
+import _memory as mem
+import _uart as ut
+import _baud as bd
+import _chdb as cd
 
 
 def load_image(file: str) -> bytes:
@@ -68,7 +73,7 @@ def main_dump(args, ser: serial.Serial):
 
     signal.signal(signal.SIGINT, quit_handler)
 
-    dump = dd.EepromDump(ser, dump_what, dump_file)
+    dump = dd.EepromDump(ser, dump_what, dump_file, args.baud, args.bulk, args.delta)
     while (not quit_flag) and dump.loop():
         sleep(0)
 
@@ -100,11 +105,96 @@ def main_restore(args, ser: serial.Serial):
 
     signal.signal(signal.SIGINT, quit_handler)
 
-    dump = rr.EepromDump(ser, dump_what, dump_file)
+    dump = rr.EepromDump(ser, dump_what, dump_file, args.baud, args.bulk, args.delta)
     while (not quit_flag) and dump.loop():
         sleep(0)
 
 
+def main_profile(args, ser: serial.Serial):
+
+    quit_flag = False
+
+    def quit_handler(sig, frame):
+        nonlocal quit_flag
+        quit_flag = True
+
+    signal.signal(signal.SIGINT, quit_handler)
+
+    dump = pf.ProfileDump(ser, args.reset)
+    while (not quit_flag) and dump.loop():
+        sleep(0)
+
+
+def main_memory(args, ser: serial.Serial):
+
+    quit_flag = False
+
+    def quit_handler(sig, frame):
+        nonlocal quit_flag
+        quit_flag = True
+
+    signal.signal(signal.SIGINT, quit_handler)
+
+    dump = mem.MemoryDump(ser)
+    while (not quit_flag) and dump.loop():
+        sleep(0)
+
+
+def main_uart(args, ser: serial.Serial):
+
+    quit_flag = False
+
+    def quit_handler(sig, frame):
+        nonlocal quit_flag
+        quit_flag = True
+
+    signal.signal(signal.SIGINT, quit_handler)
+
+    dump = ut.UartTxDump(ser)
+    while (not quit_flag) and dump.loop():
+        sleep(0)
+
+
+def main_chdb(args, ser: serial.Serial):
+
+    lower = upper = 0
+    prefix = ""
+    match args.action:
+        case "export":
+            action = cd.EXPORT
+        case "import":
+            action = cd.IMPORT
+            if not os.path.exists(args.file):
+                print("File not exist: {}".format(args.file))
+                return
+        case "find":
+            action = cd.FIND
+            if args.name:
+                prefix = args.name
+            else:
+                try:
+                    lo, _, hi = args.freq.partition(":")
+                    lower = cd.parse_mhz(lo)
+                    upper = cd.parse_mhz(hi) if hi else lower
+                except ValueError:
+                    print("Invalid frequency '{}'".format(args.freq))
+                    return
+
+    quit_flag = False
+
+    def quit_handler(sig, frame):
+        nonlocal quit_flag
+        quit_flag = True
+
+    signal.signal(signal.SIGINT, quit_handler)
+
+    db = cd.ChannelDb(
+        ser, action, getattr(args, "file", None), args.baud, lower, upper, prefix
+    )
+    while (not quit_flag) and db.loop():
+        sleep(0)
+
+
 def main_flash(args, ser: serial.Serial):
 
     bl_ver: str = args.bl_ver
@@ -139,13 +229,41 @@ def main_flash(args, ser: serial.Serial):
         sleep(0)
 
 
+def add_baud_argument(ap: argparse.ArgumentParser):
+    ap.add_argument(
+        "--baud",
+        "-b",
+        type=int,
+        choices=(bd.DEFAULT_BAUD,) + bd.BAUD_RATES,
+        default=bd.DEFAULT_BAUD,
+        help="switch the link to this baud rate first (firmware built with ENABLE_UART_HIGH_SPEED)."
+        " Falls back to 38400 if the cable cannot keep up",
+    )
+
+
+def add_bulk_argument(ap: argparse.ArgumentParser):
+    ap.add_argument(
+        "--bulk",
+        action="store_true",
+        help="move whole 4 KB flash sectors per frame (firmware built with ENABLE_UART_BULK)",
+    )
+
+
+def add_delta_argument(ap: argparse.ArgumentParser, help: str):
+    ap.add_argument("--delta", action="store_true", help=help)
+
+
 def main():
 
     # Usage:
     # serialtool.py --port <port> subcmd ..
     # serialtool.py .. flash [--bl-ver <ver>] <file>
-    # serialtool.py .. dump {--config | --calib [| --all]} file
-    # serialtool.py .. restore {--config | --calib [| --all]} file
+    # serialtool.py .. dump {--config | --calib [| --all]} [--baud <rate>] [--bulk | --delta] file
+    # serialtool.py .. restore {--config | --calib [| --all]} [--baud <rate>] [--bulk | --delta] file
+    # serialtool.py .. profile [--reset]
+    # serialtool.py .. chdb {export | import} [--baud <rate>] file
+    # serialtool.py .. chdb find {--freq <MHz>[:<MHz>] | --name <prefix>}
+    # serialtool.py [--port <port>] memory [--map <file>]
     ap = argparse.ArgumentParser(description="UV-K5 V2 serial tool")
 
     # TODO: have to add option to each of subcommands ??
@@ -180,6 +298,12 @@ def main():
         help="dump both configuration and calibration data. This is default",
     )
     ap_dump.add_argument("file", help="output dump file")
+    add_baud_argument(ap_dump)
+    add_bulk_argument(ap_dump)
+    add_delta_argument(
+        ap_dump,
+        "as --bulk, the sectors LZ encoded (firmware built with ENABLE_UART_DELTA)",
+    )
 
     ap_restore = sp.add_parser(
         "restore", help="restore configuration or calibration data from previous dump"
@@ -197,12 +321,81 @@ def main():
         help="restore both configuration and calibration data. This is default",
     )
     ap_restore.add_argument("file", help="input dump file")
+    add_baud_argument(ap_restore)
+    add_bulk_argument(ap_restore)
+    add_delta_argument(
+        ap_restore,
+        "as --bulk, moving only the sectors whose hash differs, LZ encoded"
+        " (firmware built with ENABLE_UART_DELTA)",
+    )
+
+    ap_profile = sp.add_parser(
+        "profile", help="show hot-path timing (firmware built with ENABLE_PROFILER)"
+    )
+    ap_profile.add_argument(
+        "--port", "-p", help="serial port, eg., '/dev/ttyUSB0'", required=True
+    )
+    ap_profile.add_argument(
+        "--reset", action="store_true", help="clear the table after reading it"
+    )
+
+    ap_memory = sp.add_parser(
+        "memory",
+        help="show RAM layout and stack high-water mark (firmware built with ENABLE_MEMORY_STATS)",
+    )
+    ap_memory.add_argument(
+        "--port",
+        "-p",
+        help="serial port, eg., '/dev/ttyUSB0'. Without it only the map is read",
+        required=False,
+    )
+    ap_memory.add_argument(
+        "--map", help="linker map file, to print the RAM budget by module"
+    )
+
+    ap_uart = sp.add_parser(
+        "uart",
+        help="show transmit buffer counters (firmware built with ENABLE_UART_TX_DMA)",
+    )
+    ap_uart.add_argument(
+        "--port", "-p", help="serial port, eg., '/dev/ttyUSB0'", required=True
+    )
+
+    ap_chdb = sp.add_parser(
+        "chdb",
+        help="channels of banks 1 and up (firmware built with ENABLE_CHANNEL_DB)",
+    )
+    ap_chdb.add_argument(
+        "--port", "-p", help="serial port, eg., '/dev/ttyUSB0'", required=True
+    )
+    add_baud_argument(ap_chdb)
+    sp_chdb = ap_chdb.add_subparsers(required=True, dest="action")
+    ap_export = sp_chdb.add_parser("export", help="save the used channels as CSV")
+    ap_export.add_argument("file", help="output CSV file")
+    ap_import = sp_chdb.add_parser(
+        "import",
+        help="write the channels of a CSV file as written by export. A row"
+        " with an empty rx_mhz deletes the channel, channels not in the file"
+        " stay",
+    )
+    ap_import.add_argument("file", help="input CSV file")
+    ap_find = sp_chdb.add_parser("find", help="look channels up in every bank")
+    ag = ap_find.add_mutually_exclusive_group(required=True)
+    ag.add_argument("--freq", help="RX frequency or range in MHz, eg. '145.5:146'")
+    ag.add_argument("--name", help="start of the name, any case")
 
     args = ap.parse_args()
     port: str = args.port
     sub_name: str = args.subcommand
 
     print(ap.description)
+
+    if "memory" == sub_name:
+        if args.map:
+            mem.print_budget(args.map)
+        if not port:
+            return
+
     # print("Press Ctrl-C to quit")
 
     try:
@@ -218,6 +411,14 @@ def main():
             main_dump(args, ser)
         case "restore":
             main_restore(args, ser)
+        case "profile":
+            main_profile(args, ser)
+        case "memory":
+            main_memory(args, ser)
+        case "uart":
+            main_uart(args, ser)
+        case "chdb":
+            main_chdb(args, ser)
 
     ser.close()
     print("Quit")
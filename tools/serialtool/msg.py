@@ -86,6 +86,10 @@ def fetch(buf: bytearray) -> Msg | None:
     msg_len = _get_hw_LE(buf, pack_begin + 2)
     pack_end = pack_begin + 6 + msg_len
 
+    if len(buf) < pack_end + 2:
+        # Wait for the rest of the packet
+        return None
+
     if not buf.startswith(b"\xdc\xba", pack_end):
         # We've got wrong beginning
         del buf[: pack_begin + 2]
@@ -109,8 +113,9 @@ def fetch(buf: bytearray) -> Msg | None:
 
     del buf[: pack_end + 2]
 
-    # Validate CRC: don't. Messages from device do not apply correct CRC
-    crc += 0
+    # Validate CRC: don't. Messages from device do not apply correct CRC,
+    # only the bulk sector reads (0x053A) do
+    msg.crc = crc
 
     return msg
 